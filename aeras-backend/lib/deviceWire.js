@@ -0,0 +1,189 @@
+// AERAS - Compact device wire format
+// The ESP32 firmwares talk MessagePack with one-letter tags instead of
+// verbose JSON. A request body is decoded when it is sent as
+// application/msgpack; a reply is encoded when the device Accepts
+// application/msgpack. Everyone else (web app, admin pages) keeps getting
+// the same JSON as before, from the same handlers.
+//
+// Tags (shared with shared-hardware-lib/AerasProtocol/DeviceWire.h):
+//   r rickshawID   i rideID        s status        p pickupBlock
+//   d destination  y/x lat/lng     k success       t points / event type
+//   m distance     n journal key   c HTTP status   j journalID
+//   e error message, list of events / results     o nearest offer
+//   f location fixes  v further offers  g batched ride / block statuses
+// Telemetry uploads (lib/telemetry.js): b blockID, u uptime, w window,
+//   l loops, h heap, q Wi-Fi, a endpoint histograms
+// Coordinates travel as int32 microdegrees, distances as int32 meters
+// (offers) or float32 meters (completions).
+const msgpack = require('./msgpack');
+
+const MSGPACK = 'application/msgpack';
+const { int32, float32 } = msgpack;
+
+// undefined stays undefined so the handlers' "Missing fields" checks still fire
+const fromMicro = micro => (typeof micro === 'number' ? micro / 1e6 : undefined);
+const nullable = value => (value === undefined ? null : value);
+
+const offerFields = ride => ({
+  i: ride.rideID,
+  p: ride.pickupBlock,
+  d: ride.destination,
+  m: int32(parseFloat(ride.distance) * 1000)
+});
+
+const blockStatusFields = body => ({ s: body.status, i: body.rideID, r: nullable(body.rickshawID) });
+
+const rideStatusFields = ride => ({
+  i: ride.rideID,
+  s: ride.status,
+  r: nullable(ride.rickshawID),
+  p: ride.pickupBlock,
+  d: ride.destination
+});
+
+const RIDE_EVENT_TYPES = { A: 'ACCEPT', P: 'PICKUP', C: 'COMPLETE' };
+
+const completeFields = body => ({
+  k: !!body.success,
+  t: body.points,
+  m: body.distance === undefined ? undefined : float32(parseFloat(body.distance)),
+  s: body.status
+});
+
+// Per route: `request` maps a tagged body to the handler's field names,
+// `response` maps the handler's JSON answer to tags
+const WIRE = {
+  location: {
+    request: m => ({ rickshawID: m.r, lat: fromMicro(m.y), lng: fromMicro(m.x) }),
+    response: body => ({ k: !!body.success })
+  },
+
+  // f: [[y, x, age], ...] oldest first
+  locationBatch: {
+    request: m => ({
+      rickshawID: m.r,
+      fixes: Array.isArray(m.f)
+        ? m.f.map(fix => ({ lat: fromMicro(fix[0]), lng: fromMicro(fix[1]), age: fix[2] }))
+        : undefined
+    }),
+    response: body => ({ k: !!body.success, t: body.applied })
+  },
+
+  // o: the first offer (the rickshaw's match or the nearest), v: the rest
+  // of ?limit= in order; older firmwares only read o
+  pending: {
+    response: body => {
+      const rides = body.rides || [];
+      if (rides.length === 0) return { o: null };
+      const [first, ...rest] = rides.map(offerFields);
+      return rest.length > 0 ? { o: first, v: rest } : { o: first };
+    }
+  },
+
+  // ?blockID=: {s, i, r}. Batches: g: [{i, s, r, p, d}, ...] (?rideIDs=)
+  // or g: [{b, s, i, r}, ...] (?blockIDs=)
+  blockStatus: {
+    response: body => {
+      if (body.rides) return { g: body.rides.map(rideStatusFields) };
+      if (body.blocks) return { g: body.blocks.map(block => ({ b: block.blockID, ...blockStatusFields(block) })) };
+      return blockStatusFields(body);
+    }
+  },
+
+  rideStatus: {
+    response: rideStatusFields
+  },
+
+  accept: {
+    request: m => ({ rideID: m.i, rickshawID: m.r }),
+    response: body => ({ k: !!body.success, i: body.rideID, p: body.pickupBlock, d: body.destination })
+  },
+
+  pickup: {
+    request: m => ({ rideID: m.i }),
+    response: body => ({ k: !!body.success })
+  },
+
+  complete: {
+    request: m => ({ rideID: m.i, dropLat: fromMicro(m.y), dropLng: fromMicro(m.x) }),
+    response: completeFields
+  },
+
+  // l: [[passes, busy avg, busy max, late avg, late max], ...] (us)
+  // h: [free, low watermark, largest block low], q: [rssi, low, reconnects]
+  // a: [[endpoint, [buckets...], failures, max ms], ...]
+  telemetry: {
+    request: m => {
+      const list = value => (Array.isArray(value) ? value : []);
+      const heap = list(m.h);
+      const wifi = list(m.q);
+      return {
+        rickshawID: m.r,
+        blockID: m.b,
+        uptime: m.u,
+        window: m.w,
+        loops: list(m.l).map(list).map(([passes, busyAvgUs, busyMaxUs, lateAvgUs, lateMaxUs]) => ({
+          passes, busyAvgUs, busyMaxUs, lateAvgUs, lateMaxUs
+        })),
+        heap: { free: heap[0], minFree: heap[1], minLargestBlock: heap[2] },
+        wifi: { rssi: wifi[0], minRssi: wifi[1], reconnects: wifi[2] },
+        endpoints: list(m.a).map(list).map(([endpoint, buckets, failures, maxMs]) => ({
+          endpoint, buckets, failures, maxMs
+        }))
+      };
+    },
+    response: body => ({ k: !!body.success })
+  },
+
+  // e: [{n: key, t: 'A'|'P'|'C', i, y, x}] -> e: [{n, c, k, t, m, s}]
+  rideEvents: {
+    request: m => ({
+      rickshawID: m.r,
+      journalID: m.j,
+      events: Array.isArray(m.e)
+        ? m.e.map(event => ({
+          key: event.n,
+          type: RIDE_EVENT_TYPES[event.t],
+          rideID: event.i,
+          dropLat: fromMicro(event.y),
+          dropLng: fromMicro(event.x)
+        }))
+        : undefined
+    }),
+    response: body => ({
+      e: body.results.map(result => {
+        const answer = result.body || {};
+        return { n: result.key, c: result.status, ...completeFields(answer) };
+      })
+    })
+  }
+};
+
+// Route middleware; goes in front of idempotent() so replays are encoded too
+const deviceWire = schema => (req, res, next) => {
+  res.vary('Accept');
+
+  if (req.accepts(['application/json', MSGPACK]) === MSGPACK) {
+    res.json = body => {
+      const tagged = body && body.error !== undefined ? { e: body.error } : schema.response(body);
+      return res.type(MSGPACK).send(msgpack.encode(tagged));
+    };
+  }
+
+  if (Buffer.isBuffer(req.body)) {
+    let message;
+    try {
+      message = msgpack.decode(req.body);
+    } catch (err) {
+      return res.status(400).json({ error: `Invalid MessagePack body: ${err.message}` });
+    }
+    if (!schema.request || !message || typeof message !== 'object') {
+      return res.status(400).json({ error: 'Unexpected MessagePack body' });
+    }
+    req.body = schema.request(message);
+  }
+
+  next();
+};
+
+module.exports = { MSGPACK, WIRE, deviceWire };
@@ -0,0 +1,159 @@
+// AERAS - Dispatch index: pending rides, rickshaw positions, batch assignment
+// Uses the native grid index (native/dispatch, `npm run build:native`)
+// when it has been built and an equivalent plain-JS index otherwise, so
+// the server runs either way. Same API, same ordering: nearest first,
+// equal distances by key.
+const path = require('path');
+
+// Same formula as calculateDistance() in server.js and grid_index.h
+function haversineMeters(lat1, lng1, lat2, lng2) {
+  const rad = Math.PI / 180;
+  const dLat = (lat2 - lat1) * rad;
+  const dLng = (lng2 - lng1) * rad;
+  const a = Math.sin(dLat / 2) * Math.sin(dLat / 2) +
+            Math.cos(lat1 * rad) * Math.cos(lat2 * rad) *
+            Math.sin(dLng / 2) * Math.sin(dLng / 2);
+  return 6371000 * 2 * Math.atan2(Math.sqrt(a), Math.sqrt(1 - a));
+}
+
+function nearestOf(points, keyName, lat, lng, k) {
+  const hits = [];
+  points.forEach((point, key) => {
+    hits.push({ [keyName]: key, meters: haversineMeters(lat, lng, point.lat, point.lng) });
+  });
+  hits.sort((a, b) => a.meters - b.meters || (a[keyName] < b[keyName] ? -1 : 1));
+  return k === undefined ? hits : hits.slice(0, Math.max(0, k));
+}
+
+// Hungarian algorithm, as assignMinCost() in native/dispatch/src/assignment.h.
+// costs[row][col]; returns the column of each row, or -1. Pairs dearer than
+// maxCost are never matched.
+function assignMinCost(costs, rows, cols, maxCost) {
+  const rowToCol = new Array(rows).fill(-1);
+  if (rows === 0 || cols === 0) return rowToCol;
+
+  const transposed = rows > cols;
+  const n = transposed ? cols : rows;
+  const m = transposed ? rows : cols;
+  const forbidden = maxCost * (n + 1) + 1;
+  const cost = (i, j) => {
+    const c = transposed ? costs[j][i] : costs[i][j];
+    return c > maxCost ? forbidden : c;
+  };
+
+  const u = new Array(n + 1).fill(0);
+  const v = new Array(m + 1).fill(0);
+  const owner = new Array(m + 1).fill(0);
+  const way = new Array(m + 1).fill(0);
+
+  for (let i = 1; i <= n; i++) {
+    owner[0] = i;
+    let j0 = 0;
+    const minv = new Array(m + 1).fill(Infinity);
+    const used = new Array(m + 1).fill(false);
+    do {
+      used[j0] = true;
+      const i0 = owner[j0];
+      let delta = Infinity;
+      let j1 = 0;
+      for (let j = 1; j <= m; j++) {
+        if (used[j]) continue;
+        const reduced = cost(i0 - 1, j - 1) - u[i0] - v[j];
+        if (reduced < minv[j]) {
+          minv[j] = reduced;
+          way[j] = j0;
+        }
+        if (minv[j] < delta) {
+          delta = minv[j];
+          j1 = j;
+        }
+      }
+      for (let j = 0; j <= m; j++) {
+        if (used[j]) {
+          u[owner[j]] += delta;
+          v[j] -= delta;
+        } else {
+          minv[j] -= delta;
+        }
+      }
+      j0 = j1;
+    } while (owner[j0] !== 0);
+    do {
+      const j1 = way[j0];
+      owner[j0] = owner[j1];
+      j0 = j1;
+    } while (j0 !== 0);
+  }
+
+  for (let j = 1; j <= m; j++) {
+    if (owner[j] === 0) continue;
+    const row = transposed ? j - 1 : owner[j] - 1;
+    const col = transposed ? owner[j] - 1 : j - 1;
+    if (costs[row][col] <= maxCost) rowToCol[row] = col;
+  }
+  return rowToCol;
+}
+
+// Fallback: linear scans, fine for a handful of rides
+class JsDispatchIndex {
+  constructor() {
+    this.rides = new Map();
+    this.rickshaws = new Map();
+  }
+
+  upsertRide(rideID, lat, lng) { this.rides.set(rideID, { lat, lng }); }
+  removeRide(rideID) { return this.rides.delete(rideID); }
+  clearRides() { this.rides.clear(); }
+  upsertRickshaw(rickshawID, lat, lng) { this.rickshaws.set(rickshawID, { lat, lng }); }
+  removeRickshaw(rickshawID) { return this.rickshaws.delete(rickshawID); }
+
+  rickshawPosition(rickshawID) {
+    const point = this.rickshaws.get(rickshawID);
+    return point ? { lat: point.lat, lng: point.lng } : null;
+  }
+
+  nearestRides(lat, lng, k) { return nearestOf(this.rides, 'rideID', lat, lng, k); }
+  nearestRickshaws(lat, lng, k) { return nearestOf(this.rickshaws, 'rickshawID', lat, lng, k); }
+
+  assignRides(rickshawIDs, { maxMeters = 5000, candidates = 8 } = {}) {
+    const rows = rickshawIDs.filter(id => this.rickshaws.has(id));
+    const positions = rows.map(id => this.rickshaws.get(id));
+    const cols = new Set();
+    positions.forEach(position => {
+      this.nearestRides(position.lat, position.lng, Math.max(1, candidates))
+        .filter(hit => hit.meters <= maxMeters)
+        .forEach(hit => cols.add(hit.rideID));
+    });
+    const rideIDs = [...cols].sort((a, b) => a - b);
+
+    const costs = positions.map(position => rideIDs.map(rideID => {
+      const ride = this.rides.get(rideID);
+      return haversineMeters(position.lat, position.lng, ride.lat, ride.lng);
+    }));
+    const rowToCol = assignMinCost(costs, rows.length, rideIDs.length, maxMeters);
+    const matches = [];
+    rowToCol.forEach((col, row) => {
+      if (col >= 0) matches.push({ rickshawID: rows[row], rideID: rideIDs[col], meters: costs[row][col] });
+    });
+    return matches;
+  }
+
+  stats() {
+    return { rides: this.rides.size, rickshaws: this.rickshaws.size, native: false };
+  }
+}
+
+let native = null;
+try {
+  native = require(path.join(__dirname, '../native/dispatch/build/Release/aeras_dispatch.node'));
+} catch (err) {
+  native = null;  // Not built on this machine
+}
+
+module.exports = {
+  DispatchIndex: native ? native.DispatchIndex : JsDispatchIndex,
+  JsDispatchIndex,
+  assignMinCost,
+  haversineMeters,
+  isNative: !!native
+};
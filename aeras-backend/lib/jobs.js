@@ -0,0 +1,89 @@
+// AERAS - Background maintenance jobs
+// Backups, point expiry and anonymization share the SQLite connection the
+// devices poll through. Run as one statement or one file copy they held it
+// for the whole job, so every device request queued behind them. Here a
+// job is a series of bounded steps (a few hundred rows, or a few dozen
+// backup pages) with a pause after each, and the device queries queued
+// meanwhile run in between. One job runs at a time; the others wait.
+// The admin endpoints answer 202 with the job, and GET /admin/jobs/:id
+// reports its progress.
+
+class JobRunner {
+  constructor({ pauseMs = 20, keep = 20 } = {}) {
+    this.pauseMs = pauseMs;
+    this.keep = keep;       // Finished jobs still reported
+    this.jobs = new Map();  // jobID -> job, oldest first
+    this.steps = new Map(); // jobID -> step, until it finishes
+    this.waiting = [];      // jobIDs
+    this.running = null;
+    this.nextID = 1;
+  }
+
+  // step(job, done) does one bounded chunk of work, may update
+  // job.progress / job.result, then calls done(err, finished)
+  add(type, params, step, result = {}) {
+    const job = {
+      jobID: this.nextID++,
+      type,
+      params,
+      status: 'QUEUED',
+      progress: { done: 0, total: null },
+      result,
+      error: null,
+      queuedAt: new Date().toISOString(),
+      startedAt: null,
+      finishedAt: null
+    };
+    this.jobs.set(job.jobID, job);
+    this.steps.set(job.jobID, step);
+    this.waiting.push(job.jobID);
+    this.prune();
+    if (!this.running) this.runNext();
+    return job;
+  }
+
+  get(jobID) {
+    return this.jobs.get(Number(jobID)) || null;
+  }
+
+  list() {
+    return [...this.jobs.values()].reverse();
+  }
+
+  runNext() {
+    const jobID = this.waiting.shift();
+    this.running = jobID === undefined ? null : this.jobs.get(jobID);
+    if (!this.running) return;
+
+    const job = this.running;
+    const step = this.steps.get(jobID);
+    job.status = 'RUNNING';
+    job.startedAt = new Date().toISOString();
+    console.log(`🧰 Job ${job.jobID} (${job.type}) started`);
+
+    const advance = () => step(job, (err, finished) => {
+      if (err || finished) return this.finish(job, err);
+      setTimeout(advance, this.pauseMs);
+    });
+    advance();
+  }
+
+  finish(job, err) {
+    job.status = err ? 'FAILED' : 'DONE';
+    job.error = err ? err.message : null;
+    job.finishedAt = new Date().toISOString();
+    this.steps.delete(job.jobID);
+    if (err) console.error(`✗ Job ${job.jobID} (${job.type}) failed:`, err.message);
+    else console.log(`✓ Job ${job.jobID} (${job.type}) done`, JSON.stringify(job.result));
+    this.prune();
+    this.runNext();
+  }
+
+  // Forgets the oldest finished jobs beyond `keep`
+  prune() {
+    const finished = [...this.jobs.values()].filter(job => job.finishedAt);
+    finished.slice(0, Math.max(0, finished.length - this.keep)).forEach(job => this.jobs.delete(job.jobID));
+  }
+}
+
+module.exports = { JobRunner };
@@ -0,0 +1,163 @@
+// AERAS - Minimal MessagePack codec for the device wire format
+// Covers what the firmware speaks: nil, bool, ints, float32/64, str, bin,
+// array and map. Numbers wrapped in int32()/float32() are always written
+// with that fixed width, so the devices decode them at a known size.
+
+class FixedInt32 {
+  constructor(value) {
+    this.value = value;
+  }
+}
+
+class FixedFloat32 {
+  constructor(value) {
+    this.value = value;
+  }
+}
+
+const int32 = value => new FixedInt32(value);
+const float32 = value => new FixedFloat32(value);
+
+// ========== ENCODE ==========
+function encode(value) {
+  const chunks = [];
+  const byte = b => chunks.push(Buffer.from([b]));
+  const fixed = (size, write) => {
+    const chunk = Buffer.alloc(size);
+    write(chunk);
+    chunks.push(chunk);
+  };
+
+  const length = (count, fixMask, fixMax, codes) => {
+    if (count <= fixMax) return byte(fixMask | count);
+    if (codes[0] !== undefined && count < 0x100) return fixed(2, b => { b[0] = codes[0]; b.writeUInt8(count, 1); });
+    if (count < 0x10000) return fixed(3, b => { b[0] = codes[1]; b.writeUInt16BE(count, 1); });
+    fixed(5, b => { b[0] = codes[2]; b.writeUInt32BE(count, 1); });
+  };
+
+  const write = (v) => {
+    if (v === null || v === undefined) return byte(0xc0);
+    if (v === true) return byte(0xc3);
+    if (v === false) return byte(0xc2);
+
+    if (v instanceof FixedInt32) {
+      return fixed(5, b => { b[0] = 0xd2; b.writeInt32BE(Math.round(v.value) | 0, 1); });
+    }
+    if (v instanceof FixedFloat32) {
+      return fixed(5, b => { b[0] = 0xca; b.writeFloatBE(v.value, 1); });
+    }
+
+    if (typeof v === 'number') {
+      if (!Number.isInteger(v) || v > 0xffffffff || v < -0x80000000) {
+        return fixed(9, b => { b[0] = 0xcb; b.writeDoubleBE(v, 1); });
+      }
+      if (v >= 0) {
+        if (v < 0x80) return byte(v);
+        if (v < 0x100) return fixed(2, b => { b[0] = 0xcc; b.writeUInt8(v, 1); });
+        if (v < 0x10000) return fixed(3, b => { b[0] = 0xcd; b.writeUInt16BE(v, 1); });
+        return fixed(5, b => { b[0] = 0xce; b.writeUInt32BE(v, 1); });
+      }
+      if (v >= -32) return byte(v & 0xff);
+      if (v >= -0x80) return fixed(2, b => { b[0] = 0xd0; b.writeInt8(v, 1); });
+      if (v >= -0x8000) return fixed(3, b => { b[0] = 0xd1; b.writeInt16BE(v, 1); });
+      return fixed(5, b => { b[0] = 0xd2; b.writeInt32BE(v, 1); });
+    }
+
+    if (typeof v === 'string') {
+      const text = Buffer.from(v, 'utf8');
+      length(text.length, 0xa0, 31, [0xd9, 0xda, 0xdb]);
+      return chunks.push(text);
+    }
+    if (Buffer.isBuffer(v)) {
+      length(v.length, 0, -1, [0xc4, 0xc5, 0xc6]);
+      return chunks.push(v);
+    }
+    if (Array.isArray(v)) {
+      length(v.length, 0x90, 15, [undefined, 0xdc, 0xdd]);
+      return v.forEach(write);
+    }
+    if (typeof v === 'object') {
+      const keys = Object.keys(v).filter(key => v[key] !== undefined);
+      length(keys.length, 0x80, 15, [undefined, 0xde, 0xdf]);
+      return keys.forEach(key => {
+        write(key);
+        write(v[key]);
+      });
+    }
+    throw new TypeError(`Cannot encode ${typeof v}`);
+  };
+
+  write(value);
+  return Buffer.concat(chunks);
+}
+
+// ========== DECODE ==========
+function decode(buffer) {
+  let offset = 0;
+
+  const need = (count) => {
+    if (offset + count > buffer.length) throw new RangeError('Truncated MessagePack');
+  };
+  const take = (count, read) => {
+    need(count);
+    const value = read(offset);
+    offset += count;
+    return value;
+  };
+  const u8 = () => take(1, at => buffer.readUInt8(at));
+  const u16 = () => take(2, at => buffer.readUInt16BE(at));
+  const u32 = () => take(4, at => buffer.readUInt32BE(at));
+  const bytes = (count) => take(count, at => buffer.subarray(at, at + count));
+  const text = (count) => bytes(count).toString('utf8');
+  const list = (count) => Array.from({ length: count }, () => read());
+  const map = (count) => {
+    const object = {};
+    for (let i = 0; i < count; i++) {
+      const key = read();
+      object[key] = read();
+    }
+    return object;
+  };
+
+  const read = () => {
+    const code = u8();
+    if (code < 0x80) return code;
+    if (code < 0x90) return map(code & 0x0f);
+    if (code < 0xa0) return list(code & 0x0f);
+    if (code < 0xc0) return text(code & 0x1f);
+    if (code >= 0xe0) return code - 0x100;
+
+    switch (code) {
+      case 0xc0: return null;
+      case 0xc2: return false;
+      case 0xc3: return true;
+      case 0xc4: return bytes(u8());
+      case 0xc5: return bytes(u16());
+      case 0xc6: return bytes(u32());
+      case 0xca: return take(4, at => buffer.readFloatBE(at));
+      case 0xcb: return take(8, at => buffer.readDoubleBE(at));
+      case 0xcc: return u8();
+      case 0xcd: return u16();
+      case 0xce: return u32();
+      case 0xcf: return Number(take(8, at => buffer.readBigUInt64BE(at)));
+      case 0xd0: return take(1, at => buffer.readInt8(at));
+      case 0xd1: return take(2, at => buffer.readInt16BE(at));
+      case 0xd2: return take(4, at => buffer.readInt32BE(at));
+      case 0xd3: return Number(take(8, at => buffer.readBigInt64BE(at)));
+      case 0xd9: return text(u8());
+      case 0xda: return text(u16());
+      case 0xdb: return text(u32());
+      case 0xdc: return list(u16());
+      case 0xdd: return list(u32());
+      case 0xde: return map(u16());
+      case 0xdf: return map(u32());
+      default: throw new TypeError(`Unsupported MessagePack type 0x${code.toString(16)}`);
+    }
+  };
+
+  const value = read();
+  if (offset !== buffer.length) throw new RangeError('Trailing bytes after MessagePack value');
+  return value;
+}
+
+module.exports = { encode, decode, int32, float32 };
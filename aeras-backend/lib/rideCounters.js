@@ -0,0 +1,138 @@
+// AERAS - Ride counters for the admin dashboard
+// Summary tables kept up to date by triggers on `rides`, so every insert
+// and status change (ride store write-behind, admin edits alike) moves
+// them by one and /admin/stats and /admin/analytics read a handful of
+// rows instead of aggregating the ride history:
+//   ride_status_counts   status     -> rides
+//   ride_block_counts    blockID    -> pickups requested there, rides to it
+//                                      (destinations, TIMEOUTs excluded)
+//   ride_rickshaw_counts rickshawID -> completed rides
+//   ride_hourly_counts   hour       -> rides requested, points awarded
+//                                      (by drop time); 'YYYY-MM-DD HH' UTC
+// The tables are filled from `rides` once, when they are first created.
+
+const hourOf = column => `substr(${column}, 1, 13)`;
+
+// Adds `delta` to table.column at key, creating the row; skipped unless `when`
+function bump(table, keyColumn, key, column, delta, when = '1') {
+  return `INSERT INTO ${table} (${keyColumn}, ${column}) SELECT ${key}, ${delta} WHERE ${when}
+      ON CONFLICT(${keyColumn}) DO UPDATE SET ${column} = ${column} + excluded.${column};`;
+}
+
+const TABLES = [
+  `CREATE TABLE IF NOT EXISTS ride_status_counts (
+    status TEXT PRIMARY KEY,
+    rides INTEGER NOT NULL DEFAULT 0
+  )`,
+  `CREATE TABLE IF NOT EXISTS ride_block_counts (
+    blockID TEXT PRIMARY KEY,
+    pickups INTEGER NOT NULL DEFAULT 0,
+    destinations INTEGER NOT NULL DEFAULT 0
+  )`,
+  `CREATE TABLE IF NOT EXISTS ride_rickshaw_counts (
+    rickshawID TEXT PRIMARY KEY,
+    completed INTEGER NOT NULL DEFAULT 0
+  )`,
+  `CREATE TABLE IF NOT EXISTS ride_hourly_counts (
+    hour TEXT PRIMARY KEY,
+    requested INTEGER NOT NULL DEFAULT 0,
+    points INTEGER NOT NULL DEFAULT 0
+  )`
+];
+
+// Only while ride_status_counts is empty: a new database, or one from
+// before the counters. ride_status_counts goes last - it is the marker.
+const unbuilt = 'NOT EXISTS (SELECT 1 FROM ride_status_counts)';
+const BACKFILL = [
+  `INSERT INTO ride_block_counts (blockID, pickups)
+     SELECT pickupBlock, COUNT(*) FROM rides WHERE ${unbuilt} GROUP BY pickupBlock`,
+  `INSERT INTO ride_block_counts (blockID, destinations)
+     SELECT destination, COUNT(*) FROM rides WHERE status != 'TIMEOUT' AND ${unbuilt} GROUP BY destination
+     ON CONFLICT(blockID) DO UPDATE SET destinations = excluded.destinations`,
+  `INSERT INTO ride_rickshaw_counts (rickshawID, completed)
+     SELECT rickshawID, COUNT(*) FROM rides
+     WHERE status = 'COMPLETED' AND rickshawID IS NOT NULL AND ${unbuilt} GROUP BY rickshawID`,
+  `INSERT INTO ride_hourly_counts (hour, requested)
+     SELECT ${hourOf('requestTime')}, COUNT(*) FROM rides WHERE ${unbuilt} GROUP BY 1`,
+  `INSERT INTO ride_hourly_counts (hour, points)
+     SELECT ${hourOf('dropTime')}, SUM(pointsAwarded) FROM rides
+     WHERE dropTime IS NOT NULL AND ${unbuilt} GROUP BY 1
+     ON CONFLICT(hour) DO UPDATE SET points = excluded.points`,
+  `INSERT INTO ride_status_counts (status, rides)
+     SELECT status, COUNT(*) FROM rides WHERE ${unbuilt} GROUP BY status`
+];
+
+const notTimedOut = row => `(${row}.status != 'TIMEOUT')`;
+const completedBy = row => `${row}.status = 'COMPLETED' AND ${row}.rickshawID IS NOT NULL`;
+
+const TRIGGERS = [
+  `CREATE TRIGGER IF NOT EXISTS ride_counters_insert AFTER INSERT ON rides
+    BEGIN
+      ${bump('ride_status_counts', 'status', 'NEW.status', 'rides', 1)}
+      ${bump('ride_block_counts', 'blockID', 'NEW.pickupBlock', 'pickups', 1)}
+      ${bump('ride_block_counts', 'blockID', 'NEW.destination', 'destinations', notTimedOut('NEW'))}
+      ${bump('ride_rickshaw_counts', 'rickshawID', 'NEW.rickshawID', 'completed', 1, completedBy('NEW'))}
+      ${bump('ride_hourly_counts', 'hour', hourOf('NEW.requestTime'), 'requested', 1)}
+      ${bump('ride_hourly_counts', 'hour', hourOf('NEW.dropTime'), 'points', 'NEW.pointsAwarded', 'NEW.dropTime IS NOT NULL')}
+    END`,
+  `CREATE TRIGGER IF NOT EXISTS ride_counters_status AFTER UPDATE OF status ON rides
+    WHEN OLD.status IS NOT NEW.status
+    BEGIN
+      ${bump('ride_status_counts', 'status', 'OLD.status', 'rides', -1)}
+      ${bump('ride_status_counts', 'status', 'NEW.status', 'rides', 1)}
+      ${bump('ride_block_counts', 'blockID', 'NEW.destination', 'destinations',
+             `${notTimedOut('NEW')} - ${notTimedOut('OLD')}`)}
+    END`,
+  `CREATE TRIGGER IF NOT EXISTS ride_counters_completed AFTER UPDATE OF status, rickshawID ON rides
+    WHEN OLD.status IS NOT NEW.status OR OLD.rickshawID IS NOT NEW.rickshawID
+    BEGIN
+      ${bump('ride_rickshaw_counts', 'rickshawID', 'OLD.rickshawID', 'completed', -1, completedBy('OLD'))}
+      ${bump('ride_rickshaw_counts', 'rickshawID', 'NEW.rickshawID', 'completed', 1, completedBy('NEW'))}
+    END`,
+  `CREATE TRIGGER IF NOT EXISTS ride_counters_points AFTER UPDATE OF pointsAwarded, dropTime ON rides
+    WHEN OLD.pointsAwarded IS NOT NEW.pointsAwarded OR OLD.dropTime IS NOT NEW.dropTime
+    BEGIN
+      ${bump('ride_hourly_counts', 'hour', hourOf('OLD.dropTime'), 'points', '-OLD.pointsAwarded', 'OLD.dropTime IS NOT NULL')}
+      ${bump('ride_hourly_counts', 'hour', hourOf('NEW.dropTime'), 'points', 'NEW.pointsAwarded', 'NEW.dropTime IS NOT NULL')}
+    END`
+];
+
+// Queued on db in order; run inside the schema's db.serialize()
+function createRideCounters(db) {
+  [...TABLES, 'BEGIN TRANSACTION', ...BACKFILL, 'COMMIT', ...TRIGGERS].forEach(sql => db.run(sql));
+}
+
+// Today (UTC, as SQLite's DATE('now')) is the hours from midnight on
+const STATS_SQL = `
+  SELECT
+    (SELECT COALESCE(SUM(rides), 0) FROM ride_status_counts
+      WHERE status IN ('ACCEPTED', 'PICKUP')) AS activeRides,
+    (SELECT COALESCE(SUM(rides), 0) FROM ride_status_counts
+      WHERE status = 'PENDING_REVIEW') AS pendingReviews,
+    (SELECT COALESCE(SUM(points), 0) FROM ride_hourly_counts WHERE hour >= DATE('now')) AS pointsToday,
+    (SELECT COALESCE(SUM(requested), 0) FROM ride_hourly_counts WHERE hour >= DATE('now')) AS ridesToday`;
+
+const TOP_DESTINATIONS_SQL = `
+  SELECT blockID AS destination, destinations AS count
+  FROM ride_block_counts
+  WHERE destinations > 0
+  ORDER BY destinations DESC
+  LIMIT 5`;
+
+const TOP_PULLERS_SQL = `
+  SELECT r.rickshawID, r.pullerName, r.totalPoints, COALESCE(c.completed, 0) AS completedRides
+  FROM rickshaws r
+  LEFT JOIN ride_rickshaw_counts c ON c.rickshawID = r.rickshawID
+  ORDER BY r.totalPoints DESC
+  LIMIT 10`;
+
+// Last 24 hours that saw rides, oldest first
+const RIDES_BY_HOUR_SQL = `
+  SELECT hour, requested, points
+  FROM ride_hourly_counts
+  WHERE hour >= ${hourOf("DATETIME('now', '-23 hours')")}
+  ORDER BY hour`;
+
+module.exports = {
+  createRideCounters, STATS_SQL, TOP_DESTINATIONS_SQL, TOP_PULLERS_SQL, RIDES_BY_HOUR_SQL
+};
@@ -0,0 +1,218 @@
+// AERAS - In-memory active-ride state with write-behind persistence
+// Holds every PENDING/ACCEPTED/PICKUP ride plus the latest ride at each
+// block, so the polled reads (kiosk status, ride status, pending offers)
+// never touch SQLite. Transitions are compare-and-set on the in-memory
+// copy - Node runs them one at a time, so check-then-write is atomic - and
+// the matching UPDATEs are queued and written in one transaction every
+// flushMs. load() rebuilds the state from the database on start.
+// Every ride held also has a version, bumped on each change, that the
+// status endpoints turn into an ETag.
+const ACTIVE_STATUSES = ['PENDING', 'ACCEPTED', 'PICKUP'];
+
+// Same text as SQLite's CURRENT_TIMESTAMP, so memory and rows agree
+function sqlNow() {
+  return new Date().toISOString().replace('T', ' ').slice(0, 19);
+}
+
+class RideStore {
+  constructor(db, { flushMs = 50 } = {}) {
+    this.db = db;
+    this.flushMs = flushMs;
+    this.rides = new Map();          // rideID -> row; active rides and latestByBlock
+    this.latestByBlock = new Map();  // blockID -> rideID
+    this.versions = new Map();       // rideID -> changes seen since load/add
+    this.epoch = Date.now().toString(36);  // Keeps versions from before a restart apart
+    this.queue = [];                 // { sql, params, done }
+    this.flushing = false;
+    this.timer = null;
+    this.drained = [];               // Callbacks waiting for an empty queue
+  }
+
+  // Active rides, then the newest ride at every block that has one
+  load(callback) {
+    const marks = ACTIVE_STATUSES.map(() => '?').join(',');
+    this.db.all(`SELECT * FROM rides WHERE status IN (${marks})`, ACTIVE_STATUSES, (err, active) => {
+      if (err) return callback(err);
+      this.rides.clear();
+      this.latestByBlock.clear();
+      this.versions.clear();
+      active.forEach(ride => this.rides.set(ride.rideID, ride));
+
+      this.db.all(
+        `SELECT r.* FROM locations l
+         JOIN rides r ON r.rideID = (SELECT rideID FROM rides WHERE pickupBlock = l.blockID
+                                     ORDER BY requestTime DESC, rideID DESC LIMIT 1)`,
+        (err, latest) => {
+          if (err) return callback(err);
+          latest.forEach(ride => {
+            this.rides.set(ride.rideID, this.rides.get(ride.rideID) || ride);
+            this.latestByBlock.set(ride.pickupBlock, ride.rideID);
+          });
+          this.rides.forEach((ride, rideID) => this.versions.set(rideID, 1));
+          // Active rides at blocks that are not (or no longer) in locations
+          active.forEach(ride => {
+            const latestID = this.latestByBlock.get(ride.pickupBlock);
+            if (latestID === undefined || latestID < ride.rideID) {
+              this.latestByBlock.set(ride.pickupBlock, ride.rideID);
+            }
+          });
+          callback(null, active.length);
+        }
+      );
+    });
+  }
+
+  // A freshly inserted row
+  add(ride) {
+    const previous = this.get(this.latestByBlock.get(ride.pickupBlock));
+    this.rides.set(ride.rideID, ride);
+    this.latestByBlock.set(ride.pickupBlock, ride.rideID);
+    this.versions.set(ride.rideID, 1);
+    if (previous) this.retire(previous);
+  }
+
+  get(rideID) {
+    return this.rides.get(Number(rideID)) || null;
+  }
+
+  // 0 for rides the store does not hold
+  version(rideID) {
+    return this.versions.get(Number(rideID)) || 0;
+  }
+
+  bump(rideID) {
+    this.versions.set(rideID, this.version(rideID) + 1);
+  }
+
+  // False for blocks the store knows nothing about (no ride since load(),
+  // not marked empty); ask the database for those
+  hasBlock(blockID) {
+    return this.latestByBlock.has(blockID);
+  }
+
+  // The database has no ride at this block; until add() brings one,
+  // latestAtBlock() answers null without asking it again
+  markEmpty(blockID) {
+    if (!this.latestByBlock.has(blockID)) this.latestByBlock.set(blockID, null);
+  }
+
+  latestAtBlock(blockID) {
+    const rideID = this.latestByBlock.get(blockID);
+    return rideID == null ? null : this.rides.get(rideID);
+  }
+
+  active(status) {
+    return [...this.rides.values()].filter(ride => ride.status === status);
+  }
+
+  // rickshawID -> ride, for rickshaws on an ACCEPTED/PICKUP ride
+  busyRickshaws() {
+    const busy = new Map();
+    this.rides.forEach(ride => {
+      if (ride.rickshawID && (ride.status === 'ACCEPTED' || ride.status === 'PICKUP')) {
+        busy.set(ride.rickshawID, ride);
+      }
+    });
+    return busy;
+  }
+
+  // Compare-and-set: applies `changes` when the ride's status is one of
+  // `from` (or `from(ride)` holds) and queues the UPDATE. Returns the
+  // updated ride, or null when it was not in an allowed state.
+  // RideStore.NOW as a value stands for the current timestamp.
+  transition(rideID, from, changes) {
+    const ride = this.get(rideID);
+    if (!ride) return null;
+    const allowed = typeof from === 'function' ? from(ride) : from.includes(ride.status);
+    if (!allowed) return null;
+
+    const now = sqlNow();
+    const columns = Object.keys(changes);
+    columns.forEach(column => {
+      ride[column] = changes[column] === RideStore.NOW ? now : changes[column];
+    });
+    this.bump(ride.rideID);
+    this.persist(
+      `UPDATE rides SET ${columns.map(column => `${column} = ?`).join(', ')} WHERE rideID = ?`,
+      [...columns.map(column => ride[column]), ride.rideID],
+      () => this.retire(ride)  // Reads fall back to the row only once it is written
+    );
+    return ride;
+  }
+
+  // Re-reads a ride changed outside the store (admin edits)
+  reload(rideID, done = () => {}) {
+    this.db.get('SELECT * FROM rides WHERE rideID = ?', [rideID], (err, row) => {
+      if (!err && row && (this.rides.has(row.rideID) || ACTIVE_STATUSES.includes(row.status))) {
+        this.rides.set(row.rideID, row);
+        this.bump(row.rideID);
+        this.retire(row);
+      }
+      done(err);
+    });
+  }
+
+  // Finished rides are only kept while they are the latest at their block
+  retire(ride) {
+    if (ACTIVE_STATUSES.includes(ride.status)) return;
+    if (this.latestByBlock.get(ride.pickupBlock) !== ride.rideID) {
+      this.rides.delete(ride.rideID);
+      this.versions.delete(ride.rideID);
+    }
+  }
+
+  // Queues a write for the next batch; done(err, changes) once it is committed
+  persist(sql, params, done) {
+    this.queue.push({ sql, params, done });
+    this.schedule();
+  }
+
+  schedule() {
+    if (!this.timer) this.timer = setTimeout(() => this.flush(), this.flushMs);
+  }
+
+  flush() {
+    this.timer = null;
+    if (this.flushing) return this.schedule();
+    if (this.queue.length === 0) {
+      this.drained.splice(0).forEach(done => done());
+      return;
+    }
+
+    const batch = this.queue.splice(0);
+    this.flushing = true;
+    this.db.serialize(() => {
+      this.db.run('BEGIN TRANSACTION');
+      batch.forEach(write => this.db.run(write.sql, write.params, function(err) {
+        write.err = err;
+        write.changes = err ? 0 : this.changes;
+        if (err) console.error('✗ Write-behind:', err.message, `(${write.sql.split('\n')[0]})`);
+      }));
+      this.db.run('COMMIT', (err) => {
+        this.flushing = false;
+        if (err) {
+          this.db.run('ROLLBACK');
+          console.error('✗ Write-behind commit failed, retrying:', err.message);
+          this.queue.unshift(...batch);
+        } else {
+          batch.forEach(write => write.done && write.done(write.err || null, write.changes));
+        }
+        this.schedule();
+      });
+    });
+  }
+
+  // done() once every write queued so far is committed
+  drain(done) {
+    this.drained.push(done);
+    this.schedule();
+  }
+
+  pendingWrites() {
+    return this.queue.length;
+  }
+}
+
+RideStore.NOW = Symbol('now');
+
+module.exports = { RideStore, ACTIVE_STATUSES, sqlNow };
@@ -0,0 +1,60 @@
+// AERAS - Prepared-statement cache
+// The polled queries (kiosk status, ride long-poll, location reports,
+// pending rides, idempotency lookups) are prepared once per SQL text and
+// reused, instead of being re-parsed and re-planned on every request.
+// Same callback signatures as db.get/db.all/db.run.
+const MAX_STATEMENTS = 64;  // Beyond this, SQL runs uncached (e.g. one-off admin queries)
+
+class StatementCache {
+  constructor(db) {
+    this.db = db;
+    this.statements = new Map();
+  }
+
+  statement(sql) {
+    let statement = this.statements.get(sql);
+    if (!statement && this.statements.size < MAX_STATEMENTS) {
+      statement = this.db.prepare(sql);
+      this.statements.set(sql, statement);
+    }
+    return statement;
+  }
+
+  get(sql, params, callback) {
+    const statement = this.statement(sql);
+    if (!statement) return this.db.get(sql, params, callback);
+    // Reset so the statement does not hold its read open between polls
+    statement.get(params, (err, row) => statement.reset(() => callback(err, row)));
+  }
+
+  all(sql, params, callback) {
+    const statement = this.statement(sql);
+    if (!statement) return this.db.all(sql, params, callback);
+    statement.all(params, callback);
+  }
+
+  // callback gets this.lastID / this.changes, as with db.run
+  run(sql, params, callback = () => {}) {
+    const statement = this.statement(sql);
+    if (!statement) return this.db.run(sql, params, callback);
+    statement.run(params, function(err) {
+      callback.call(this, err);
+    });
+  }
+
+  size() {
+    return this.statements.size;
+  }
+
+  finalizeAll(done = () => {}) {
+    const statements = [...this.statements.values()];
+    this.statements.clear();
+    let pending = statements.length;
+    if (pending === 0) return done();
+    statements.forEach(statement => statement.finalize(() => {
+      if (--pending === 0) done();
+    }));
+  }
+}
+
+module.exports = { StatementCache };
@@ -0,0 +1,106 @@
+// AERAS - Device performance telemetry
+// Rickshaws and kiosks upload their counters (shared-hardware-lib/
+// AerasTelemetry) every few minutes: a latency histogram per endpoint,
+// busy/late time of their task loops, heap and Wi-Fi watermarks. Each
+// upload covers the window since the previous successful one, so fleet
+// figures are plain sums of the stored histograms.
+
+// Upper bounds (ms) of all but the last, open-ended bucket; same as
+// TELEMETRY_BUCKET_MS on the devices - keep them in step
+const BUCKET_MS = [25, 50, 100, 200, 400, 800, 1600, 3200, 6400];
+const BUCKETS = BUCKET_MS.length + 1;
+const BUCKET_COLUMNS = Array.from({ length: BUCKETS }, (_, i) => `b${i}`);  // telemetry_endpoints
+
+const LOOP_NAMES = ['main', 'net'];
+const MAX_ENDPOINTS = 32;
+
+const count = value => (Number.isFinite(value) && value >= 0 ? Math.round(value) : null);
+const signed = value => (Number.isFinite(value) ? Math.round(value) : null);
+
+// Checks an uploaded report (field names as mapped by WIRE.telemetry);
+// returns { error } or the report with every figure a whole number
+function normalizeReport(body) {
+  const { uptime, window, loops = [], endpoints = [] } = body;
+  const heap = body.heap || {};
+  const wifi = body.wifi || {};
+
+  if (count(uptime) === null || count(window) === null) return { error: 'Missing fields' };
+  if (!Array.isArray(loops) || !Array.isArray(endpoints)) return { error: 'Invalid report' };
+  if (endpoints.length > MAX_ENDPOINTS) {
+    return { error: `At most ${MAX_ENDPOINTS} endpoints per report` };
+  }
+
+  const loop = index => {
+    const figures = loops[index] || {};
+    return {
+      passes: count(figures.passes) || 0,
+      busyAvgUs: count(figures.busyAvgUs) || 0,
+      busyMaxUs: count(figures.busyMaxUs) || 0,
+      lateAvgUs: count(figures.lateAvgUs) || 0,
+      lateMaxUs: count(figures.lateMaxUs) || 0
+    };
+  };
+
+  const normalized = [];
+  for (const endpoint of endpoints) {
+    const buckets = endpoint && Array.isArray(endpoint.buckets) ? endpoint.buckets.map(count) : [];
+    if (buckets.length !== BUCKETS || buckets.includes(null) ||
+        typeof endpoint.endpoint !== 'string' || !endpoint.endpoint) {
+      return { error: 'Invalid endpoint histogram' };
+    }
+    normalized.push({
+      endpoint: endpoint.endpoint.slice(0, 64),
+      buckets,
+      failures: count(endpoint.failures) || 0,
+      maxMs: count(endpoint.maxMs) || 0
+    });
+  }
+
+  return {
+    uptime: count(uptime),
+    window: count(window),
+    loops: LOOP_NAMES.map((_, index) => loop(index)),
+    heap: {
+      free: count(heap.free),
+      minFree: count(heap.minFree),
+      minLargestBlock: count(heap.minLargestBlock) || null  // 0: not sampled yet
+    },
+    wifi: {
+      rssi: signed(wifi.rssi) || null,  // 0: never connected
+      minRssi: signed(wifi.minRssi) || null,
+      reconnects: count(wifi.reconnects) || 0
+    },
+    endpoints: normalized
+  };
+}
+
+// Upper bound (ms) of the bucket holding that share of the answers; null
+// once it falls in the open-ended bucket
+function percentileMs(buckets, share) {
+  const answers = buckets.reduce((sum, n) => sum + n, 0);
+  let seen = 0;
+  for (let i = 0; i < BUCKET_MS.length; i++) {
+    seen += buckets[i];
+    if (seen >= share * answers) return BUCKET_MS[i];
+  }
+  return null;
+}
+
+// Merged histogram -> the figures shown in admin analytics
+function summarizeEndpoint(buckets, failures, maxMs) {
+  const answers = buckets.reduce((sum, n) => sum + n, 0);
+  return {
+    answers,
+    failures,
+    failureRate: answers + failures > 0 ? +(failures / (answers + failures)).toFixed(4) : 0,
+    p50Ms: answers ? percentileMs(buckets, 0.5) : null,
+    p90Ms: answers ? percentileMs(buckets, 0.9) : null,
+    p99Ms: answers ? percentileMs(buckets, 0.99) : null,
+    maxMs,
+    buckets
+  };
+}
+
+module.exports = {
+  BUCKET_MS, BUCKETS, BUCKET_COLUMNS, LOOP_NAMES, normalizeReport, percentileMs, summarizeEndpoint
+};
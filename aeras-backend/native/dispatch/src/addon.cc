@@ -0,0 +1,192 @@
+// AERAS - Native dispatch index (N-API)
+// Keeps pending rides and rickshaw positions in two grid indexes so
+// /ride/pending and the push channel can ask "nearest K" without a table
+// scan, and matches rickshaws to rides in batches. lib/dispatch.js loads
+// this and falls back to plain JS when the addon has not been built.
+#include <napi.h>
+
+#include <string>
+#include <vector>
+
+#include "assignment.h"
+#include "grid_index.h"
+
+namespace {
+
+using RideIndex = aeras::GridIndex<int64_t>;
+using RickshawIndex = aeras::GridIndex<std::string>;
+
+double numberArg(const Napi::CallbackInfo& info, size_t index, const char* name) {
+  if (info.Length() <= index || !info[index].IsNumber()) {
+    throw Napi::TypeError::New(info.Env(), std::string(name) + " must be a number");
+  }
+  return info[index].As<Napi::Number>().DoubleValue();
+}
+
+std::string stringArg(const Napi::CallbackInfo& info, size_t index, const char* name) {
+  if (info.Length() <= index || !info[index].IsString()) {
+    throw Napi::TypeError::New(info.Env(), std::string(name) + " must be a string");
+  }
+  return info[index].As<Napi::String>().Utf8Value();
+}
+
+// Optional k; everything when left out
+size_t limitArg(const Napi::CallbackInfo& info, size_t index, size_t all) {
+  if (info.Length() <= index || info[index].IsUndefined()) return all;
+  double k = numberArg(info, index, "k");
+  return k < 0 ? 0 : size_t(k);
+}
+
+class DispatchIndex : public Napi::ObjectWrap<DispatchIndex> {
+ public:
+  static Napi::Function Define(Napi::Env env) {
+    return DefineClass(env, "DispatchIndex", {
+      InstanceMethod("upsertRide", &DispatchIndex::UpsertRide),
+      InstanceMethod("removeRide", &DispatchIndex::RemoveRide),
+      InstanceMethod("upsertRickshaw", &DispatchIndex::UpsertRickshaw),
+      InstanceMethod("removeRickshaw", &DispatchIndex::RemoveRickshaw),
+      InstanceMethod("rickshawPosition", &DispatchIndex::RickshawPosition),
+      InstanceMethod("nearestRides", &DispatchIndex::NearestRides),
+      InstanceMethod("nearestRickshaws", &DispatchIndex::NearestRickshaws),
+      InstanceMethod("assignRides", &DispatchIndex::AssignRides),
+      InstanceMethod("clearRides", &DispatchIndex::ClearRides),
+      InstanceMethod("stats", &DispatchIndex::Stats),
+    });
+  }
+
+  // new DispatchIndex({ cellMeters })
+  explicit DispatchIndex(const Napi::CallbackInfo& info)
+      : Napi::ObjectWrap<DispatchIndex>(info),
+        rides_(cellMetersOption(info)),
+        rickshaws_(cellMetersOption(info)) {}
+
+ private:
+  static double cellMetersOption(const Napi::CallbackInfo& info) {
+    if (info.Length() > 0 && info[0].IsObject()) {
+      Napi::Value cell = info[0].As<Napi::Object>().Get("cellMeters");
+      if (cell.IsNumber() && cell.As<Napi::Number>().DoubleValue() > 0) {
+        return cell.As<Napi::Number>().DoubleValue();
+      }
+    }
+    return 500.0;
+  }
+
+  Napi::Value UpsertRide(const Napi::CallbackInfo& info) {
+    rides_.upsert(int64_t(numberArg(info, 0, "rideID")), numberArg(info, 1, "lat"),
+                  numberArg(info, 2, "lng"));
+    return info.Env().Undefined();
+  }
+
+  Napi::Value RemoveRide(const Napi::CallbackInfo& info) {
+    return Napi::Boolean::New(info.Env(), rides_.remove(int64_t(numberArg(info, 0, "rideID"))));
+  }
+
+  Napi::Value ClearRides(const Napi::CallbackInfo& info) {
+    rides_.clear();
+    return info.Env().Undefined();
+  }
+
+  Napi::Value UpsertRickshaw(const Napi::CallbackInfo& info) {
+    rickshaws_.upsert(stringArg(info, 0, "rickshawID"), numberArg(info, 1, "lat"),
+                      numberArg(info, 2, "lng"));
+    return info.Env().Undefined();
+  }
+
+  Napi::Value RemoveRickshaw(const Napi::CallbackInfo& info) {
+    return Napi::Boolean::New(info.Env(), rickshaws_.remove(stringArg(info, 0, "rickshawID")));
+  }
+
+  Napi::Value RickshawPosition(const Napi::CallbackInfo& info) {
+    const RickshawIndex::Point* point = rickshaws_.find(stringArg(info, 0, "rickshawID"));
+    if (!point) return info.Env().Null();
+    Napi::Object position = Napi::Object::New(info.Env());
+    position.Set("lat", point->lat);
+    position.Set("lng", point->lng);
+    return position;
+  }
+
+  // nearestRides(lat, lng[, k]) -> [{ rideID, meters }]
+  Napi::Value NearestRides(const Napi::CallbackInfo& info) {
+    auto hits = rides_.nearest(numberArg(info, 0, "lat"), numberArg(info, 1, "lng"),
+                               limitArg(info, 2, rides_.size()));
+    Napi::Array result = Napi::Array::New(info.Env(), hits.size());
+    for (size_t i = 0; i < hits.size(); i++) {
+      Napi::Object hit = Napi::Object::New(info.Env());
+      hit.Set("rideID", double(hits[i].key));
+      hit.Set("meters", hits[i].meters);
+      result.Set(uint32_t(i), hit);
+    }
+    return result;
+  }
+
+  // nearestRickshaws(lat, lng[, k]) -> [{ rickshawID, meters }]
+  Napi::Value NearestRickshaws(const Napi::CallbackInfo& info) {
+    auto hits = rickshaws_.nearest(numberArg(info, 0, "lat"), numberArg(info, 1, "lng"),
+                                   limitArg(info, 2, rickshaws_.size()));
+    Napi::Array result = Napi::Array::New(info.Env(), hits.size());
+    for (size_t i = 0; i < hits.size(); i++) {
+      Napi::Object hit = Napi::Object::New(info.Env());
+      hit.Set("rickshawID", hits[i].key);
+      hit.Set("meters", hits[i].meters);
+      result.Set(uint32_t(i), hit);
+    }
+    return result;
+  }
+
+  // assignRides(rickshawIDs[, { maxMeters, candidates }]) -> [{ rickshawID, rideID, meters }]
+  Napi::Value AssignRides(const Napi::CallbackInfo& info) {
+    if (info.Length() < 1 || !info[0].IsArray()) {
+      throw Napi::TypeError::New(info.Env(), "rickshawIDs must be an array");
+    }
+    Napi::Array ids = info[0].As<Napi::Array>();
+    std::vector<std::string> rickshawIDs;
+    for (uint32_t i = 0; i < ids.Length(); i++) {
+      Napi::Value id = ids.Get(i);
+      if (id.IsString()) rickshawIDs.push_back(id.As<Napi::String>().Utf8Value());
+    }
+
+    double maxMeters = 5000.0;
+    double candidates = 8.0;
+    if (info.Length() > 1 && info[1].IsObject()) {
+      Napi::Object options = info[1].As<Napi::Object>();
+      if (options.Get("maxMeters").IsNumber()) {
+        maxMeters = options.Get("maxMeters").As<Napi::Number>().DoubleValue();
+      }
+      if (options.Get("candidates").IsNumber()) {
+        candidates = std::max(1.0, options.Get("candidates").As<Napi::Number>().DoubleValue());
+      }
+    }
+
+    auto matches = aeras::assignRides(rides_, rickshaws_, rickshawIDs, maxMeters, size_t(candidates));
+    Napi::Array result = Napi::Array::New(info.Env(), matches.size());
+    for (size_t i = 0; i < matches.size(); i++) {
+      Napi::Object match = Napi::Object::New(info.Env());
+      match.Set("rickshawID", matches[i].rickshawID);
+      match.Set("rideID", double(matches[i].rideID));
+      match.Set("meters", matches[i].meters);
+      result.Set(uint32_t(i), match);
+    }
+    return result;
+  }
+
+  Napi::Value Stats(const Napi::CallbackInfo& info) {
+    Napi::Object stats = Napi::Object::New(info.Env());
+    stats.Set("rides", double(rides_.size()));
+    stats.Set("rickshaws", double(rickshaws_.size()));
+    stats.Set("cellMeters", rides_.cellMeters());
+    stats.Set("native", true);
+    return stats;
+  }
+
+  RideIndex rides_;
+  RickshawIndex rickshaws_;
+};
+
+Napi::Object Init(Napi::Env env, Napi::Object exports) {
+  exports.Set("DispatchIndex", DispatchIndex::Define(env));
+  return exports;
+}
+
+}  // namespace
+
+NODE_API_MODULE(aeras_dispatch, Init)
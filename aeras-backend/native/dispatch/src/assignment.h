@@ -0,0 +1,137 @@
+// AERAS - Batch ride assignment
+// Matches available rickshaws to pending rides so the total pickup
+// distance is smallest, instead of every rickshaw chasing its own nearest
+// ride. Solved exactly with the Hungarian algorithm (potentials form,
+// O(n^2 m)) over a rickshaw x ride distance matrix; each rickshaw only
+// brings its few nearest rides as candidates, which keeps the matrix small.
+#pragma once
+
+#include <algorithm>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "grid_index.h"
+
+namespace aeras {
+
+// costs is rows x cols, row-major. Returns the column of each row, or -1.
+// Pairs dearer than maxCost are never matched; the most pairs possible
+// under that limit are matched first, then the cheapest of those.
+inline std::vector<int> assignMinCost(const std::vector<double>& costs, size_t rows, size_t cols,
+                                      double maxCost) {
+  std::vector<int> rowToCol(rows, -1);
+  if (rows == 0 || cols == 0) return rowToCol;
+
+  // The algorithm wants rows <= cols; solve the transpose otherwise
+  bool transposed = rows > cols;
+  size_t n = transposed ? cols : rows;
+  size_t m = transposed ? rows : cols;
+  // Dearer than any set of allowed pairs, so one more match always wins
+  double forbidden = maxCost * double(n + 1) + 1.0;
+  auto cost = [&](size_t i, size_t j) {
+    double c = transposed ? costs[j * cols + i] : costs[i * cols + j];
+    return c > maxCost ? forbidden : c;
+  };
+
+  const double inf = std::numeric_limits<double>::infinity();
+  std::vector<double> u(n + 1, 0.0), v(m + 1, 0.0);
+  std::vector<size_t> owner(m + 1, 0), way(m + 1, 0);  // 1-based; owner[j] = row of column j
+
+  for (size_t i = 1; i <= n; i++) {
+    owner[0] = i;
+    size_t j0 = 0;
+    std::vector<double> minv(m + 1, inf);
+    std::vector<bool> used(m + 1, false);
+    do {
+      used[j0] = true;
+      size_t i0 = owner[j0], j1 = 0;
+      double delta = inf;
+      for (size_t j = 1; j <= m; j++) {
+        if (used[j]) continue;
+        double reduced = cost(i0 - 1, j - 1) - u[i0] - v[j];
+        if (reduced < minv[j]) {
+          minv[j] = reduced;
+          way[j] = j0;
+        }
+        if (minv[j] < delta) {
+          delta = minv[j];
+          j1 = j;
+        }
+      }
+      for (size_t j = 0; j <= m; j++) {
+        if (used[j]) {
+          u[owner[j]] += delta;
+          v[j] -= delta;
+        } else {
+          minv[j] -= delta;
+        }
+      }
+      j0 = j1;
+    } while (owner[j0] != 0);
+    do {
+      size_t j1 = way[j0];
+      owner[j0] = owner[j1];
+      j0 = j1;
+    } while (j0 != 0);
+  }
+
+  for (size_t j = 1; j <= m; j++) {
+    if (owner[j] == 0) continue;
+    size_t i = owner[j] - 1;
+    size_t row = transposed ? j - 1 : i;
+    size_t col = transposed ? i : j - 1;
+    if (costs[row * cols + col] <= maxCost) rowToCol[row] = int(col);
+  }
+  return rowToCol;
+}
+
+struct Match {
+  std::string rickshawID;
+  int64_t rideID;
+  double meters;
+};
+
+// Matches rickshawIDs (in that order; unknown positions are left out) to
+// rides, each rickshaw considering its `candidates` nearest rides within
+// maxMeters. Candidate rides are laid out in rideID order, so the result
+// only depends on the inputs.
+template <typename RideIndex, typename RickshawIndex>
+std::vector<Match> assignRides(const RideIndex& rides, const RickshawIndex& rickshaws,
+                               const std::vector<std::string>& rickshawIDs, double maxMeters,
+                               size_t candidates) {
+  std::vector<std::string> rows;
+  std::vector<typename RickshawIndex::Point> positions;
+  std::vector<int64_t> cols;
+  for (const std::string& id : rickshawIDs) {
+    const auto* position = rickshaws.find(id);
+    if (!position) continue;
+    rows.push_back(id);
+    positions.push_back(*position);
+    for (const auto& hit : rides.nearest(position->lat, position->lng, candidates)) {
+      if (hit.meters <= maxMeters) cols.push_back(hit.key);
+    }
+  }
+  std::sort(cols.begin(), cols.end());
+  cols.erase(std::unique(cols.begin(), cols.end()), cols.end());
+
+  std::vector<double> costs(rows.size() * cols.size());
+  for (size_t j = 0; j < cols.size(); j++) {
+    const auto* ride = rides.find(cols[j]);
+    for (size_t i = 0; i < rows.size(); i++) {
+      costs[i * cols.size() + j] =
+          haversineMeters(positions[i].lat, positions[i].lng, ride->lat, ride->lng);
+    }
+  }
+
+  std::vector<Match> matches;
+  std::vector<int> rowToCol = assignMinCost(costs, rows.size(), cols.size(), maxMeters);
+  for (size_t i = 0; i < rows.size(); i++) {
+    if (rowToCol[i] < 0) continue;
+    size_t j = size_t(rowToCol[i]);
+    matches.push_back(Match{rows[i], cols[j], costs[i * cols.size() + j]});
+  }
+  return matches;
+}
+
+}  // namespace aeras
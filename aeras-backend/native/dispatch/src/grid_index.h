@@ -0,0 +1,194 @@
+// AERAS - Uniform grid index over lat/lng points
+// Points are bucketed into square cells of `cellMeters`; a nearest-K query
+// walks rings of cells outwards from the query cell and stops as soon as
+// no unvisited ring can hold anything closer than the K-th hit so far.
+// Updates are O(1) (move between two cells), so positions can be fed on
+// every location report.
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace aeras {
+
+constexpr double kEarthRadiusMeters = 6371000.0;
+constexpr double kMetersPerDegree = kEarthRadiusMeters * M_PI / 180.0;
+
+// Same formula as calculateDistance() in server.js
+inline double haversineMeters(double lat1, double lng1, double lat2, double lng2) {
+  const double rad = M_PI / 180.0;
+  double dLat = (lat2 - lat1) * rad;
+  double dLng = (lng2 - lng1) * rad;
+  double a = std::sin(dLat / 2) * std::sin(dLat / 2) +
+             std::cos(lat1 * rad) * std::cos(lat2 * rad) * std::sin(dLng / 2) * std::sin(dLng / 2);
+  return kEarthRadiusMeters * 2 * std::atan2(std::sqrt(a), std::sqrt(1 - a));
+}
+
+template <typename Key, typename Hash = std::hash<Key>>
+class GridIndex {
+ public:
+  struct Point {
+    double lat;
+    double lng;
+  };
+
+  struct Hit {
+    Key key;
+    double meters;
+  };
+
+  explicit GridIndex(double cellMeters = 500.0)
+      : cellMeters_(cellMeters), cellDegrees_(cellMeters / kMetersPerDegree) {}
+
+  void upsert(const Key& key, double lat, double lng) {
+    uint64_t cell = cellOf(lat, lng);
+    auto found = points_.find(key);
+    if (found != points_.end()) {
+      if (found->second.cell != cell) {
+        detach(key, found->second.cell);
+        cells_[cell].push_back(key);
+      }
+      found->second = Entry{{lat, lng}, cell};
+      return;
+    }
+    points_.emplace(key, Entry{{lat, lng}, cell});
+    cells_[cell].push_back(key);
+  }
+
+  bool remove(const Key& key) {
+    auto found = points_.find(key);
+    if (found == points_.end()) return false;
+    detach(key, found->second.cell);
+    points_.erase(found);
+    return true;
+  }
+
+  const Point* find(const Key& key) const {
+    auto found = points_.find(key);
+    return found == points_.end() ? nullptr : &found->second.point;
+  }
+
+  size_t size() const { return points_.size(); }
+  double cellMeters() const { return cellMeters_; }
+
+  // Drops every point; the cell size stays
+  void clear() {
+    points_.clear();
+    cells_.clear();
+  }
+
+  template <typename Visit>
+  void forEach(Visit visit) const {
+    for (const auto& entry : points_) visit(entry.first, entry.second.point);
+  }
+
+  // Up to k hits, nearest first; equal distances in key order
+  std::vector<Hit> nearest(double lat, double lng, size_t k) const {
+    std::vector<Hit> hits;
+    if (k == 0 || points_.empty()) return hits;
+    k = std::min(k, points_.size());
+
+    int32_t row = rowOf(lat);
+    int32_t col = colOf(lng);
+    // A point d rings out is at least (d - 1) cell widths away; cells
+    // narrow east-west with latitude, so use the narrower side
+    double ringMeters = cellMeters_ * std::max(std::cos(lat * M_PI / 180.0), 0.01);
+
+    size_t visited = 0;
+    for (int32_t ring = 0;; ring++) {
+      // Far-flung points: scanning every occupied cell is cheaper than the ring
+      if (ring > 0 && size_t(8) * ring > cells_.size()) {
+        hits.clear();
+        forEach([&](const Key& key, const Point& point) {
+          hits.push_back(Hit{key, haversineMeters(lat, lng, point.lat, point.lng)});
+        });
+        return best(hits, k);
+      }
+
+      visitRing(row, col, ring, [&](const std::vector<Key>& keys) {
+        for (const Key& key : keys) {
+          const Point& point = points_.at(key).point;
+          hits.push_back(Hit{key, haversineMeters(lat, lng, point.lat, point.lng)});
+        }
+        visited += keys.size();
+      });
+
+      if (visited == points_.size()) return best(hits, k);
+      if (hits.size() >= k) {
+        best(hits, k);
+        if (hits.back().meters <= ring * ringMeters) return hits;
+      }
+    }
+  }
+
+ private:
+  struct Entry {
+    Point point;
+    uint64_t cell;
+  };
+
+  int32_t rowOf(double lat) const { return int32_t(std::floor(lat / cellDegrees_)); }
+  int32_t colOf(double lng) const { return int32_t(std::floor(lng / cellDegrees_)); }
+
+  static uint64_t cellKey(int32_t row, int32_t col) {
+    return (uint64_t(uint32_t(row)) << 32) | uint32_t(col);
+  }
+
+  uint64_t cellOf(double lat, double lng) const { return cellKey(rowOf(lat), colOf(lng)); }
+
+  void detach(const Key& key, uint64_t cell) {
+    auto bucket = cells_.find(cell);
+    if (bucket == cells_.end()) return;
+    std::vector<Key>& keys = bucket->second;
+    auto it = std::find(keys.begin(), keys.end(), key);
+    if (it != keys.end()) {
+      *it = keys.back();
+      keys.pop_back();
+    }
+    if (keys.empty()) cells_.erase(bucket);
+  }
+
+  // Cells at Chebyshev distance `ring` from (row, col)
+  template <typename Visit>
+  void visitRing(int32_t row, int32_t col, int32_t ring, Visit visit) const {
+    auto cell = [&](int32_t r, int32_t c) {
+      auto bucket = cells_.find(cellKey(r, c));
+      if (bucket != cells_.end()) visit(bucket->second);
+    };
+    if (ring == 0) {
+      cell(row, col);
+      return;
+    }
+    for (int32_t c = col - ring; c <= col + ring; c++) {
+      cell(row - ring, c);
+      cell(row + ring, c);
+    }
+    for (int32_t r = row - ring + 1; r <= row + ring - 1; r++) {
+      cell(r, col - ring);
+      cell(r, col + ring);
+    }
+  }
+
+  static std::vector<Hit>& best(std::vector<Hit>& hits, size_t k) {
+    auto closer = [](const Hit& a, const Hit& b) {
+      return a.meters < b.meters || (a.meters == b.meters && a.key < b.key);
+    };
+    if (hits.size() > k) {
+      std::partial_sort(hits.begin(), hits.begin() + k, hits.end(), closer);
+      hits.resize(k);
+    } else {
+      std::sort(hits.begin(), hits.end(), closer);
+    }
+    return hits;
+  }
+
+  double cellMeters_;
+  double cellDegrees_;
+  std::unordered_map<Key, Entry, Hash> points_;
+  std::unordered_map<uint64_t, std::vector<Key>> cells_;
+};
+
+}  // namespace aeras
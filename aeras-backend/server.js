@@ -1,13 +1,24 @@
 // AERAS Backend Server - FIXED VERSION
 // All test cases 8-12 with proper error handling
+const fs = require('fs');
+const crypto = require('crypto');
 const path = require('path');
 const express = require('express');
 const cors = require('cors');
 const sqlite3 = require('sqlite3').verbose();
+const EventEmitter = require('events');
+const { MSGPACK, WIRE, deviceWire } = require('./lib/deviceWire');
+const { DispatchIndex, isNative: dispatchIsNative } = require('./lib/dispatch');
+const { StatementCache } = require('./lib/statements');
+const { RideStore } = require('./lib/rideStore');
+const telemetry = require('./lib/telemetry');
+const rideCounters = require('./lib/rideCounters');
+const { JobRunner } = require('./lib/jobs');
 const app = express();
 
 app.use(cors());
 app.use(express.json());
+app.use(express.raw({ type: MSGPACK, limit: '16kb' }));  // Device wire format, see lib/deviceWire.js
 
 // ========== DATABASE ==========
 const db = new sqlite3.Database('./aeras.db', (err) => {
@@ -17,9 +28,24 @@ const db = new sqlite3.Database('./aeras.db', (err) => {
     console.log('✓ Database connected');
   }
 });
+db.configure('busyTimeout', 5000);
+
+// Hot-path queries, prepared once (see lib/statements.js)
+const statements = new StatementCache(db);
+
+// Active rides live in memory and are written behind (see lib/rideStore.js)
+const rideStore = new RideStore(db);
 
 // Create schema
 db.serialize(() => {
+  // Storage tuning: WAL so commits append instead of rewriting pages and
+  // readers never wait on a writer; NORMAL sync is still crash-safe in WAL
+  // (only the last commits may be lost on power failure); 16 MB page cache
+  db.run('PRAGMA journal_mode = WAL');
+  db.run('PRAGMA synchronous = NORMAL');
+  db.run('PRAGMA cache_size = -16000');
+  db.run('PRAGMA temp_store = MEMORY');
+  
   // Users
   db.run(`CREATE TABLE IF NOT EXISTS users (
     userID TEXT PRIMARY KEY,
@@ -73,6 +99,21 @@ db.serialize(() => {
     longitude REAL NOT NULL
   )`);
   
+  // Table versions: devices cache the block table and only refetch it
+  // when its version moves. Any change to `locations` bumps it.
+  db.run(`CREATE TABLE IF NOT EXISTS table_versions (
+    tableName TEXT PRIMARY KEY,
+    version INTEGER NOT NULL DEFAULT 1
+  )`);
+  db.run(`INSERT OR IGNORE INTO table_versions (tableName, version) VALUES ('locations', 1)`);
+  ['INSERT', 'UPDATE', 'DELETE'].forEach(event => {
+    db.run(`CREATE TRIGGER IF NOT EXISTS locations_version_${event.toLowerCase()}
+      AFTER ${event} ON locations
+      BEGIN
+        UPDATE table_versions SET version = version + 1 WHERE tableName = 'locations';
+      END`);
+  });
+  
   // Points History (TEST CASE 11)
   db.run(`CREATE TABLE IF NOT EXISTS points_history (
     historyID INTEGER PRIMARY KEY AUTOINCREMENT,
@@ -90,10 +131,69 @@ db.serialize(() => {
   
   
 
-  // Indexes for performance
-  db.run(`CREATE INDEX IF NOT EXISTS idx_rides_status ON rides(status)`);
+  // Location trail: every reported fix, single or batched
+  db.run(`CREATE TABLE IF NOT EXISTS location_history (
+    historyID INTEGER PRIMARY KEY AUTOINCREMENT,
+    rickshawID TEXT NOT NULL,
+    latitude REAL NOT NULL,
+    longitude REAL NOT NULL,
+    recordedAt DATETIME DEFAULT CURRENT_TIMESTAMP,
+    FOREIGN KEY(rickshawID) REFERENCES rickshaws(rickshawID)
+  )`);
+  
+  // Idempotency keys: first answer to each keyed accept/pickup/complete,
+  // returned again when a device replays its journal
+  db.run(`CREATE TABLE IF NOT EXISTS idempotency_keys (
+    idemKey TEXT PRIMARY KEY,
+    endpoint TEXT NOT NULL,
+    statusCode INTEGER NOT NULL,
+    response TEXT NOT NULL,
+    createdAt DATETIME DEFAULT CURRENT_TIMESTAMP
+  )`);
+  
+  // Device telemetry: one row per upload window, its endpoint histograms
+  // alongside (lib/telemetry.js)
+  db.run(`CREATE TABLE IF NOT EXISTS device_telemetry (
+    telemetryID INTEGER PRIMARY KEY AUTOINCREMENT,
+    deviceType TEXT NOT NULL,
+    deviceID TEXT NOT NULL,
+    uptimeS INTEGER,
+    windowS INTEGER,
+    mainPasses INTEGER, mainBusyAvgUs INTEGER, mainBusyMaxUs INTEGER, mainLateAvgUs INTEGER, mainLateMaxUs INTEGER,
+    netPasses INTEGER, netBusyAvgUs INTEGER, netBusyMaxUs INTEGER, netLateAvgUs INTEGER, netLateMaxUs INTEGER,
+    freeHeap INTEGER,
+    minFreeHeap INTEGER,
+    minLargestBlock INTEGER,
+    rssi INTEGER,
+    minRssi INTEGER,
+    wifiReconnects INTEGER,
+    receivedAt DATETIME DEFAULT CURRENT_TIMESTAMP
+  )`);
+  
+  db.run(`CREATE TABLE IF NOT EXISTS telemetry_endpoints (
+    telemetryID INTEGER NOT NULL,
+    endpoint TEXT NOT NULL,
+    ${telemetry.BUCKET_COLUMNS.map(column => `${column} INTEGER NOT NULL`).join(', ')},
+    failures INTEGER NOT NULL,
+    maxMs INTEGER NOT NULL,
+    FOREIGN KEY(telemetryID) REFERENCES device_telemetry(telemetryID)
+  )`);
+  
+  // Dashboard counters, moved by triggers on rides (lib/rideCounters.js)
+  rideCounters.createRideCounters(db);
+  
+  // Indexes for performance, one per access path:
+  //   status filters sorted by time (/ride/pending, /admin/rides?status=,
+  //   busy rickshaws; covers the rickshawID lookup), kiosk status (latest
+  //   ride per block), unfiltered /admin/rides
+  db.run(`DROP INDEX IF EXISTS idx_rides_status`);  // Prefix of idx_rides_status_time
+  db.run(`CREATE INDEX IF NOT EXISTS idx_rides_status_time ON rides(status, requestTime DESC, rickshawID)`);
+  db.run(`CREATE INDEX IF NOT EXISTS idx_rides_block_time ON rides(pickupBlock, requestTime DESC)`);
   db.run(`CREATE INDEX IF NOT EXISTS idx_rides_time ON rides(requestTime DESC)`);
   db.run(`CREATE INDEX IF NOT EXISTS idx_rickshaw_status ON rickshaws(status, isOnline)`);
+  db.run(`CREATE INDEX IF NOT EXISTS idx_location_history ON location_history(rickshawID, recordedAt)`);
+  db.run(`CREATE INDEX IF NOT EXISTS idx_device_telemetry_time ON device_telemetry(receivedAt)`);
+  db.run(`CREATE INDEX IF NOT EXISTS idx_telemetry_endpoints ON telemetry_endpoints(telemetryID)`);
   
   // Insert exact locations from TEST CASE 7
   const locations = [
@@ -110,6 +210,543 @@ db.serialize(() => {
   console.log('✓ Database schema created');
 });
 
+// ========== IDEMPOTENT RIDE EVENTS ==========
+// Rickshaws journal accept/pickup/complete while offline and replay them,
+// possibly more than once. A keyed request runs once; its answer is stored
+// and sent back for every replay. 5xx answers are not stored (retryable).
+const idempotencyInFlight = new Set();
+
+function runIdempotent(key, endpoint, run, done) {
+  statements.get('SELECT statusCode, response FROM idempotency_keys WHERE idemKey = ?', [key], (err, row) => {
+    if (err) {
+      return done(500, { error: err.message }, false);
+    }
+    if (row) {
+      return done(row.statusCode, JSON.parse(row.response), true);
+    }
+    if (idempotencyInFlight.has(key)) {
+      return done(409, { error: 'Request with this key already in progress' }, false);
+    }
+    
+    idempotencyInFlight.add(key);
+    run((statusCode, body) => {
+      if (statusCode >= 500) {
+        idempotencyInFlight.delete(key);
+        return done(statusCode, body, false);
+      }
+      // Answer only once the key is stored - in the same write-behind batch
+      // as the ride change - so a replay cannot slip in between
+      rideStore.persist(
+        'INSERT OR IGNORE INTO idempotency_keys (idemKey, endpoint, statusCode, response) VALUES (?, ?, ?, ?)',
+        [key, endpoint, statusCode, JSON.stringify(body)],
+        () => {
+          idempotencyInFlight.delete(key);
+          done(statusCode, body, false);
+        }
+      );
+    });
+  });
+}
+
+// Stand-in for `res` that hands the handler's answer to a callback
+function capturedResponse(finish) {
+  return {
+    statusCode: 200,
+    status(code) {
+      this.statusCode = code;
+      return this;
+    },
+    json(body) {
+      finish(this.statusCode, body);
+      return this;
+    }
+  };
+}
+
+// Wraps a route handler: requests with an Idempotency-Key header (or an
+// idempotencyKey field) are answered from the key store when replayed
+const idempotent = handler => (req, res) => {
+  const key = req.get('Idempotency-Key') || req.body.idempotencyKey;
+  if (!key) {
+    return handler(req, res);
+  }
+  
+  runIdempotent(key, req.path, finish => handler(req, capturedResponse(finish)),
+    (statusCode, body, replayed) => {
+      if (replayed) res.set('Idempotent-Replay', 'true');
+      res.status(statusCode).json(body);
+    }
+  );
+};
+
+// ========== RIDE STATUS NOTIFICATIONS ==========
+// Every status transition is announced on `ride:<rideID>` so long-poll
+// requests can answer as soon as the ride changes instead of being polled.
+const rideEvents = new EventEmitter();
+rideEvents.setMaxListeners(0);
+
+const LONG_POLL_MAX_SECONDS = 30;
+
+function notifyRideStatus(rideID) {
+  rideEvents.emit(`ride:${rideID}`);
+  refreshDispatchRide(rideID);
+  publishRideStatus(rideID);
+  offerRideNow(rideID);
+  scheduleAssignment();  // An offer may have gone (or come back, on cancel): re-match, then re-offer
+}
+
+const RIDE_STATUS_SQL = 'SELECT rideID, status, rickshawID, pickupBlock, destination FROM rides WHERE rideID = ?';
+
+const LATEST_BLOCK_RIDE_SQL = `SELECT * FROM rides 
+  WHERE pickupBlock = ? 
+  ORDER BY requestTime DESC, rideID DESC 
+  LIMIT 1`;
+
+// Batched /ride/status (?rideIDs= / ?blockIDs=): the ids go in as one JSON
+// array, so any number of them is the same prepared statement
+const STATUS_BATCH_MAX = 16;
+
+const RIDE_STATUSES_SQL = `SELECT rideID, status, rickshawID, pickupBlock, destination FROM rides 
+  WHERE rideID IN (SELECT value FROM json_each(?))`;
+
+// One idx_rides_block_time probe per block
+const LATEST_BLOCK_RIDES_SQL = `SELECT r.* FROM json_each(?) b 
+  JOIN rides r ON r.rideID = (SELECT rideID FROM rides WHERE pickupBlock = b.value 
+                              ORDER BY requestTime DESC, rideID DESC LIMIT 1)`;
+
+function rideStatusOf(ride) {
+  const { status, rickshawID, pickupBlock, destination } = ride;
+  return { rideID: ride.rideID, status, rickshawID, pickupBlock, destination };
+}
+
+// What /ride/<id>/status answers: from the ride store, else the database
+function readRideStatus(rideID, callback) {
+  const ride = rideStore.get(rideID);
+  if (ride) {
+    return callback(null, rideStatusOf(ride));
+  }
+  statements.get(RIDE_STATUS_SQL, [rideID], callback);
+}
+
+// Several rides at once, in the order asked; unknown rides are left out.
+// Only the ones the store does not hold go to the database, in one query.
+function readRideStatuses(rideIDs, callback) {
+  const misses = rideIDs.filter(rideID => !rideStore.get(rideID));
+  const answer = rows => {
+    const byID = new Map(rows.map(row => [row.rideID, row]));
+    callback(null, rideIDs.map(rideID => {
+      const ride = rideStore.get(rideID);
+      return ride ? rideStatusOf(ride) : byID.get(rideID);
+    }).filter(Boolean));
+  };
+  
+  if (misses.length === 0) return answer([]);
+  statements.all(RIDE_STATUSES_SQL, [JSON.stringify(misses)], (err, rows) => {
+    if (err) return callback(err);
+    answer(rows);
+  });
+}
+
+// Weak validator for /ride/<id>/status: changes with every change the
+// store applies to the ride. null for rides only the database has.
+function rideStatusTag(rideID) {
+  const version = rideStore.version(rideID);
+  return version ? `W/"${rideStore.epoch}-${rideID}-${version}"` : null;
+}
+
+// Newest ride at a block (null: none yet); the database is only asked
+// about blocks the store knows nothing of. Known blocks found without a
+// ride are remembered as empty, so idle stands are answered from memory.
+function rememberBlockRide(blockID, row) {
+  if (rideStore.hasBlock(blockID)) return;
+  if (row) {
+    rideStore.add(row);
+  } else if (blocks.has(blockID)) {
+    rideStore.markEmpty(blockID);
+  }
+}
+
+function readLatestBlockRide(blockID, callback) {
+  if (rideStore.hasBlock(blockID)) {
+    return callback(null, rideStore.latestAtBlock(blockID));
+  }
+  statements.get(LATEST_BLOCK_RIDE_SQL, [blockID], (err, row) => {
+    if (!err) rememberBlockRide(blockID, row);
+    callback(err, row || null);
+  });
+}
+
+// readLatestBlockRide() for several blocks: [{ blockID, ...blockStatusOf() }]
+function readLatestBlockRides(blockIDs, callback) {
+  const misses = blockIDs.filter(blockID => !rideStore.hasBlock(blockID));
+  const answer = () => callback(null, blockIDs.map(blockID => ({
+    blockID,
+    ...blockStatusOf(rideStore.latestAtBlock(blockID))
+  })));
+  
+  if (misses.length === 0) return answer();
+  statements.all(LATEST_BLOCK_RIDES_SQL, [JSON.stringify(misses)], (err, rows) => {
+    if (err) return callback(err);
+    const found = new Map(rows.map(row => [row.pickupBlock, row]));
+    misses.forEach(blockID => rememberBlockRide(blockID, found.get(blockID)));
+    answer();
+  });
+}
+
+// Validator for a batch: one weak tag over every ride's store version, so
+// a 304 means none of them changed. null when the store lacks any of them.
+function rideStatusesTag(rideIDs) {
+  const versions = rideIDs.map(rideID => rideStore.version(rideID));
+  if (versions.includes(0)) return null;
+  const hash = crypto.createHash('sha1')
+    .update(rideIDs.map((rideID, i) => `${rideID}.${versions[i]}`).join(','))
+    .digest('base64url')
+    .slice(0, 16);
+  return `W/"${rideStore.epoch}-${hash}"`;
+}
+
+// "a,b,c" -> distinct, non-empty entries; null when there are too many
+function idList(text, parse = id => id) {
+  const ids = [...new Set(String(text).split(',').map(id => id.trim()).filter(Boolean).map(parse))];
+  return ids.length <= STATUS_BATCH_MAX ? ids : null;
+}
+
+// ========== DISPATCH INDEX ==========
+// Pending rides (at their pickup block) and rickshaw positions live in a
+// grid index (native C++ when built, see lib/dispatch.js), so the nearest
+// pending ride is a lookup instead of a join plus a haversine over every
+// pending ride. Rides follow the ride store on each status change,
+// rickshaws each position report.
+const dispatchIndex = new DispatchIndex({ cellMeters: 500 });
+const blocks = new Map();  // blockID -> { blockID, locationName, latitude, longitude }
+
+const kmText = meters => (meters / 1000).toFixed(2);
+
+function loadDispatchIndex() {
+  db.all('SELECT blockID, locationName, latitude, longitude FROM locations', (err, rows) => {
+    if (err) {
+      return console.error('✗ Dispatch index:', err.message);
+    }
+    blocks.clear();
+    rows.forEach(block => blocks.set(block.blockID, block));
+    dispatchIndex.clearRides();
+    rideStore.active('PENDING').forEach(ride => refreshDispatchRide(ride.rideID));
+    
+    db.all('SELECT rickshawID, currentLat, currentLng FROM rickshaws', (err, rickshaws) => {
+      (rickshaws || []).forEach(rickshaw => trackRickshaw(rickshaw.rickshawID, rickshaw.currentLat, rickshaw.currentLng));
+      const stats = dispatchIndex.stats();
+      console.log(`✓ Dispatch index (${dispatchIsNative ? 'native' : 'JS fallback'}): ` +
+                  `${stats.rides} pending rides, ${stats.rickshaws} rickshaws`);
+    });
+  });
+}
+
+function refreshDispatchRide(rideID) {
+  const ride = rideStore.get(rideID);
+  const block = ride && blocks.get(ride.pickupBlock);
+  if (ride && ride.status === 'PENDING' && block) {
+    dispatchIndex.upsertRide(ride.rideID, block.latitude, block.longitude);
+  } else {
+    dispatchIndex.removeRide(Number(rideID));
+  }
+}
+
+function trackRickshaw(rickshawID, lat, lng) {
+  lat = Number(lat);
+  lng = Number(lng);
+  if (rickshawID && Number.isFinite(lat) && Number.isFinite(lng)) {
+    dispatchIndex.upsertRickshaw(String(rickshawID), lat, lng);
+  }
+}
+
+// Pending rides for a rickshaw, as /ride/pending rows: its batch match
+// first, then the nearest rides not held for someone else; k = all if undefined
+function nearestPendingRides(rickshawID, k, callback) {
+  rickshawID = String(rickshawID);
+  const match = assignments.get(rickshawID);
+  const held = heldRideIDs();
+  const position = dispatchIndex.rickshawPosition(rickshawID);
+  const search = k === undefined ? undefined : k + held.size;
+  let nearest = position ? dispatchIndex.nearestRides(position.lat, position.lng, search) : [];
+  nearest = nearest.filter(hit => !held.has(hit.rideID) && !(match && hit.rideID === match.rideID));
+  if (match) {
+    nearest.unshift({ rideID: match.rideID, meters: match.meters });
+  }
+  if (k !== undefined) {
+    nearest = nearest.slice(0, k);
+  }
+  
+  const rides = [];
+  nearest.forEach(hit => {
+    const ride = rideStore.get(hit.rideID);
+    const block = ride && blocks.get(ride.pickupBlock);
+    if (!ride || ride.status !== 'PENDING' || !block) return;
+    const { latitude, longitude, locationName } = block;
+    rides.push({ ...ride, latitude, longitude, locationName, distance: kmText(hit.meters) });
+  });
+  callback(null, rides);
+}
+
+// Queued behind the schema statements
+db.serialize(() => rideStore.load((err, active) => {
+  if (err) {
+    return console.error('✗ Ride store:', err.message);
+  }
+  console.log(`✓ Ride store: ${active} active rides`);
+  loadDispatchIndex();
+}));
+
+// ========== PUSH CHANNEL (Server-Sent Events) ==========
+// Rickshaws (?rickshawID=) and kiosks (?blockID= / ?blockIDs=) keep
+// GET /api/events open and get ride changes pushed instead of polling:
+//   event: offer  nearest pending ride, as in /ride/pending (rickshaws)
+//   event: ride   ride status, as in /ride/<id>/status (the rickshaw on
+//                 it and those offered it, and ?blockIDs= kiosks for
+//                 every ride at their blocks) or
+//                 /ride/status?blockID= (?blockID= kiosks, latest ride)
+// Devices poll again only while the stream is down.
+const PUSH_HEARTBEAT_MS = 15000;
+const OFFER_WATCH_MS = 60000;  // How long a rickshaw shown a ride hears of its changes
+const pushSubscribers = new Set();
+const pushRoutes = new Map();    // 'rickshaw:<id>' / 'block:<id>' -> Set of subscribers
+const rideWatchers = new Map();  // rideID -> Map(rickshawID -> last shown)
+
+function subscribersOf(route) {
+  return pushRoutes.get(route) || [];
+}
+
+function routesOf(subscriber) {
+  if (subscriber.rickshawID) return [`rickshaw:${subscriber.rickshawID}`];
+  if (subscriber.blockIDs) return [...subscriber.blockIDs].map(blockID => `block:${blockID}`);
+  return [`block:${subscriber.blockID}`];
+}
+
+function addSubscriber(subscriber) {
+  pushSubscribers.add(subscriber);
+  routesOf(subscriber).forEach(route => {
+    if (!pushRoutes.has(route)) pushRoutes.set(route, new Set());
+    pushRoutes.get(route).add(subscriber);
+  });
+}
+
+function removeSubscriber(subscriber) {
+  pushSubscribers.delete(subscriber);
+  routesOf(subscriber).forEach(route => {
+    const subscribers = pushRoutes.get(route);
+    if (!subscribers) return;
+    subscribers.delete(subscriber);
+    if (subscribers.size === 0) pushRoutes.delete(route);
+  });
+}
+
+// A rickshaw offered a ride (pushed, or in a /ride/pending answer) hears
+// of that ride's changes for OFFER_WATCH_MS, so a ride change goes to the
+// rickshaws concerned rather than the whole fleet
+function watchRide(rideID, rickshawID) {
+  rideID = Number(rideID);
+  if (!rideWatchers.has(rideID)) rideWatchers.set(rideID, new Map());
+  rideWatchers.get(rideID).set(String(rickshawID), Date.now());
+}
+
+function watchersOf(rideID) {
+  const watchers = rideWatchers.get(Number(rideID));
+  if (!watchers) return [];
+  const now = Date.now();
+  watchers.forEach((since, rickshawID) => {
+    if (now - since > OFFER_WATCH_MS) watchers.delete(rickshawID);
+  });
+  if (watchers.size === 0) rideWatchers.delete(Number(rideID));
+  return [...watchers.keys()];
+}
+
+function blockStatusOf(ride) {
+  if (!ride) return { status: 'IDLE' };
+  return { status: ride.status, rideID: ride.rideID, rickshawID: ride.rickshawID };
+}
+
+function pushEvent(subscriber, name, data) {
+  subscriber.res.write(`event: ${name}\ndata: ${JSON.stringify(data)}\n\n`);
+}
+
+// Sends each of `targets` (rickshaw subscribers) its nearest pending ride,
+// unless that is the ride it was offered last
+function publishOffers(targets) {
+  targets.forEach(sub => {
+    nearestPendingRides(sub.rickshawID, 1, (err, rides) => {
+      if (err || rides.length === 0 || rides[0].rideID === sub.offeredRideID) return;
+      const nearest = rides[0];
+      sub.offeredRideID = nearest.rideID;
+      watchRide(nearest.rideID, sub.rickshawID);
+      pushEvent(sub, 'offer', {
+        rideID: nearest.rideID,
+        pickupBlock: nearest.pickupBlock,
+        destination: nearest.destination,
+        distance: nearest.distance
+      });
+    });
+  });
+}
+
+function offerTo(rickshawIDs) {
+  rickshawIDs.forEach(rickshawID => publishOffers(subscribersOf(`rickshaw:${rickshawID}`)));
+}
+
+// The ride goes to its rickshaw, the rickshaws it was offered to and the
+// kiosks at its block. Once it is no longer pending, the rickshaws it was
+// offered to get their next offer instead.
+function publishRideStatus(rideID) {
+  if (pushSubscribers.size === 0) return;
+  
+  readRideStatus(rideID, (err, ride) => {
+    if (err || !ride) return;
+    
+    const watchers = watchersOf(ride.rideID);
+    const rickshawIDs = new Set(watchers);
+    if (ride.rickshawID) rickshawIDs.add(String(ride.rickshawID));
+    rickshawIDs.forEach(rickshawID => {
+      subscribersOf(`rickshaw:${rickshawID}`).forEach(sub => pushEvent(sub, 'ride', ride));
+    });
+    if (ride.status !== 'PENDING') {
+      rideWatchers.delete(ride.rideID);
+      offerTo(watchers.filter(rickshawID => rickshawID !== String(ride.rickshawID)));
+    }
+    
+    const kiosks = [];
+    subscribersOf(`block:${ride.pickupBlock}`).forEach(sub => {
+      if (sub.blockIDs) {
+        pushEvent(sub, 'ride', ride);
+      } else {
+        kiosks.push(sub);
+      }
+    });
+    if (kiosks.length > 0) {
+      readLatestBlockRide(ride.pickupBlock, (err, latest) => {
+        if (err) return;
+        kiosks.forEach(sub => pushEvent(sub, 'ride', blockStatusOf(latest)));
+      });
+    }
+  });
+}
+
+setInterval(() => {
+  pushSubscribers.forEach(sub => sub.res.write(': ping\n\n'));
+}, PUSH_HEARTBEAT_MS).unref();
+
+// ========== BATCH ASSIGNMENT ==========
+// Instead of every rickshaw chasing its own nearest ride and /ride/accept
+// settling the race, pending rides are matched to available rickshaws for
+// the least total pickup distance (assignRides() in lib/dispatch.js).
+// Changes are batched for ASSIGNMENT_WINDOW_MS before matching; a new
+// ride does not wait for that, it is offered at once to the nearest free
+// rickshaw and re-matched with the batch. Each rickshaw is offered its
+// match first and does not see rides held for others; a match not
+// accepted within ASSIGNMENT_HOLD_MS is no longer held, so an ignored
+// offer cannot strand a ride.
+const ASSIGNMENT_WINDOW_MS = 2000;
+const ASSIGNMENT_REFRESH_MS = 10000;  // Re-match for movement and rickshaws going quiet
+const ASSIGNMENT_HOLD_MS = 30000;
+const ASSIGNMENT_OPTIONS = { maxMeters: 5000, candidates: 8 };
+const SEEKING_TIMEOUT_MS = 30000;  // Since the last /ride/pending poll
+
+const seekingRickshaws = new Map();  // rickshawID -> last /ride/pending poll
+let assignments = new Map();         // rickshawID -> { rideID, meters, since }
+let assignmentTimer = null;
+
+function heldRideIDs() {
+  const now = Date.now();
+  const held = new Set();
+  assignments.forEach(match => {
+    if (now - match.since < ASSIGNMENT_HOLD_MS) held.add(match.rideID);
+  });
+  return held;
+}
+
+function markSeeking(rickshawID) {
+  const known = seekingRickshaws.has(rickshawID);
+  seekingRickshaws.set(rickshawID, Date.now());
+  if (!known) scheduleAssignment();
+}
+
+function heldFor(rickshawID, now) {
+  const match = assignments.get(rickshawID);
+  return match && now - match.since < ASSIGNMENT_HOLD_MS;
+}
+
+function isSeeking(rickshawID, now) {
+  const seen = seekingRickshaws.get(rickshawID);
+  return (seen !== undefined && now - seen <= SEEKING_TIMEOUT_MS) ||
+         pushRoutes.has(`rickshaw:${rickshawID}`);
+}
+
+// A pending ride nobody holds goes to the nearest of its candidate
+// rickshaws that is seeking, not on a ride and not holding a match
+function offerRideNow(rideID) {
+  const ride = rideStore.get(rideID);
+  const block = ride && blocks.get(ride.pickupBlock);
+  if (!ride || ride.status !== 'PENDING' || !block || heldRideIDs().has(ride.rideID)) return;
+  
+  const now = Date.now();
+  const busy = rideStore.busyRickshaws();
+  const free = dispatchIndex.nearestRickshaws(block.latitude, block.longitude, ASSIGNMENT_OPTIONS.candidates)
+    .find(hit => hit.meters <= ASSIGNMENT_OPTIONS.maxMeters && isSeeking(hit.rickshawID, now) &&
+                 !busy.has(hit.rickshawID) && !heldFor(hit.rickshawID, now));
+  if (!free) return;  // Left to the batch
+  
+  assignments.set(free.rickshawID, { rideID: ride.rideID, meters: free.meters, since: now });
+  offerTo([free.rickshawID]);
+}
+
+function scheduleAssignment() {
+  if (assignmentTimer) return;
+  assignmentTimer = setTimeout(() => {
+    assignmentTimer = null;
+    runAssignment();
+  }, ASSIGNMENT_WINDOW_MS);
+}
+
+// Available: polled /ride/pending lately or subscribed to the push
+// channel, and not on a ride. Offers are re-published to the rickshaws
+// whose match changed.
+function runAssignment() {
+  const now = Date.now();
+  const busy = rideStore.busyRickshaws();
+  const available = new Set();
+  seekingRickshaws.forEach((seen, rickshawID) => {
+    if (now - seen > SEEKING_TIMEOUT_MS) {
+      seekingRickshaws.delete(rickshawID);
+    } else {
+      available.add(rickshawID);
+    }
+  });
+  pushRoutes.forEach((subscribers, route) => {
+    if (route.startsWith('rickshaw:')) available.add(route.slice('rickshaw:'.length));
+  });
+  busy.forEach((ride, rickshawID) => available.delete(rickshawID));
+  
+  const next = new Map();
+  const changed = new Set();
+  const matches = available.size > 0 && dispatchIndex.stats().rides > 0
+    ? dispatchIndex.assignRides([...available], ASSIGNMENT_OPTIONS)
+    : [];
+  matches.forEach(match => {
+    const previous = assignments.get(match.rickshawID);
+    const kept = previous && previous.rideID === match.rideID;
+    next.set(match.rickshawID, { rideID: match.rideID, meters: match.meters, since: kept ? previous.since : now });
+    if (!kept) changed.add(match.rickshawID);
+  });
+  assignments.forEach((match, rickshawID) => {
+    if (!next.has(rickshawID)) changed.add(rickshawID);
+  });
+  assignments = next;
+  
+  if (changed.size > 0) {
+    console.log(`🧮 Assignment: ${next.size} of ${available.size} available rickshaws matched`);
+    offerTo(changed);
+  }
+}
+
+setInterval(runAssignment, ASSIGNMENT_REFRESH_MS).unref();
+
 // ========== HELPER FUNCTIONS ==========
 
 function calculateDistance(lat1, lon1, lat2, lon2) {
@@ -175,59 +812,216 @@ app.post('/api/ride/request', (req, res) => {
       }
       
       const rideID = this.lastID;
-      console.log(`✓ Ride created: ID ${rideID}`);
-      
-      // TEST CASE 8d: Set timeout for 60 seconds
-      setTimeout(() => {
-        db.get('SELECT status FROM rides WHERE rideID = ?', [rideID], (err, row) => {
-          if (row && row.status === 'PENDING') {
-            db.run('UPDATE rides SET status = "TIMEOUT" WHERE rideID = ?', [rideID]);
+      db.get('SELECT * FROM rides WHERE rideID = ?', [rideID], (err, ride) => {
+        if (err || !ride) {
+          return res.status(500).json({ error: err ? err.message : 'Ride not stored' });
+        }
+        rideStore.add(ride);
+        console.log(`✓ Ride created: ID ${rideID}`);
+        notifyRideStatus(rideID);
+        
+        // TEST CASE 8d: Set timeout for 60 seconds
+        setTimeout(() => {
+          if (rideStore.transition(rideID, ['PENDING'], { status: 'TIMEOUT' })) {
+            notifyRideStatus(rideID);
             console.log(`⏱ Ride ${rideID} TIMEOUT (60s expired)`);
           }
+        }, 60000);
+        
+        res.json({ 
+          success: true, 
+          rideID: rideID,
+          message: 'Ride request sent' 
         });
-      }, 60000);
-      
-      res.json({ 
-        success: true, 
-        rideID: rideID,
-        message: 'Ride request sent' 
       });
     }
   );
 });
 
 // 2. RIDE STATUS CHECK
-app.get('/api/ride/status', (req, res) => {
+// ?blockID= answers the latest ride of one block. A kiosk serving several
+// asks in one request instead: ?rideIDs=1,2,... -> { rides: [...] } as in
+// /ride/<id>/status, or ?blockIDs=A,B,... -> { blocks: [...] }, at most
+// STATUS_BATCH_MAX of either. Rides the ride store holds are answered from
+// memory, the rest by one query; an all-in-store ride batch carries an ETag.
+app.get('/api/ride/status', deviceWire(WIRE.blockStatus), (req, res) => {
   const { blockID } = req.query;
 
-  if (!blockID) {
-    return res.status(400).json({ error: 'blockID required' });
-  }
+  if (req.query.rideIDs !== undefined) {
+    const rideIDs = idList(req.query.rideIDs, id => parseInt(id));
+    if (!rideIDs || rideIDs.length === 0 || rideIDs.some(rideID => !rideID)) {
+      return res.status(400).json({ error: `1 to ${STATUS_BATCH_MAX} rideIDs required` });
+    }
 
-  db.get(
-    `SELECT * FROM rides 
-     WHERE pickupBlock = ? 
-     ORDER BY requestTime DESC 
-     LIMIT 1`,
-    [blockID],
-    (err, row) => {
+    const tag = rideStatusesTag(rideIDs);
+    res.set('Cache-Control', 'no-cache');
+    if (tag) res.set('ETag', tag);
+    if (tag && req.fresh) {
+      return res.status(304).end();
+    }
+
+    return readRideStatuses(rideIDs, (err, rides) => {
       if (err) {
         return res.status(500).json({ error: err.message });
       }
+      res.json({ rides });
+    });
+  }
+
+  if (req.query.blockIDs !== undefined) {
+    const blockIDs = idList(req.query.blockIDs);
+    if (!blockIDs || blockIDs.length === 0) {
+      return res.status(400).json({ error: `1 to ${STATUS_BATCH_MAX} blockIDs required` });
+    }
 
-      // NO rides → IDLE
-      if (!row) {
-        return res.json({ status: 'IDLE' });
+    return readLatestBlockRides(blockIDs, (err, blocks) => {
+      if (err) {
+        return res.status(500).json({ error: err.message });
       }
+      res.json({ blocks });
+    });
+  }
+
+  if (!blockID) {
+    return res.status(400).json({ error: 'blockID required' });
+  }
+
+  readLatestBlockRide(blockID, (err, row) => {
+    if (err) {
+      return res.status(500).json({ error: err.message });
+    }
+
+    // NO rides → IDLE; otherwise the exact status INCLUDING COMPLETED
+    return res.json(blockStatusOf(row));
+  });
+});
+
+// 2b. PER-RIDE STATUS (long-poll)
+// ?since=<status> holds the request until the ride leaves that status or
+// ?wait=<seconds> expires; without `since` it answers straight away.
+// Answers carry an ETag; If-None-Match with the current one gets a 304
+// without a body (or a lookup, when not parking).
+app.get('/api/ride/:id/status', deviceWire(WIRE.rideStatus), (req, res) => {
+  const rideID = parseInt(req.params.id);
+  const since = req.query.since;
+  const wait = Math.min(parseInt(req.query.wait) || 0, LONG_POLL_MAX_SECONDS);
+
+  if (!rideID) {
+    return res.status(400).json({ error: 'rideID required' });
+  }
+
+  const readRide = (callback) => {
+    readRideStatus(rideID, callback);
+  };
+
+  // Tagged before res.json(), so Express answers 304 for an unchanged ride
+  const tagRide = () => {
+    const tag = rideStatusTag(rideID);
+    res.set('Cache-Control', 'no-cache');
+    if (tag) res.set('ETag', tag);
+    else res.removeHeader('ETag');
+  };
+
+  tagRide();
+  if ((!since || wait === 0) && res.get('ETag') && req.fresh) {
+    return res.status(304).end();
+  }
+
+  readRide((err, ride) => {
+    if (err) {
+      return res.status(500).json({ error: err.message });
+    }
 
-      // Return exact status INCLUDING COMPLETED
-      return res.json({
-        status: row.status,
-        rideID: row.rideID,
-        rickshawID: row.rickshawID
+    if (!ride) {
+      return res.status(404).json({ error: 'Ride not found' });
+    }
+
+    if (!since || ride.status !== since || wait === 0) {
+      return res.json(ride);
+    }
+
+    // Park the request until the ride changes or the wait expires
+    const eventName = `ride:${rideID}`;
+    let timer = null;
+
+    const finish = () => {
+      clearTimeout(timer);
+      rideEvents.removeListener(eventName, finish);
+      req.removeListener('close', abandon);
+
+      readRide((err, latest) => {
+        if (err) {
+          return res.status(500).json({ error: err.message });
+        }
+        tagRide();
+        res.json(latest || ride);
+      });
+    };
+
+    const abandon = () => {
+      clearTimeout(timer);
+      rideEvents.removeListener(eventName, finish);
+    };
+
+    timer = setTimeout(finish, wait * 1000);
+    rideEvents.on(eventName, finish);
+    req.on('close', abandon);
+  });
+});
+
+// 2c. PUSH SUBSCRIPTION (Server-Sent Events, see PUSH CHANNEL above)
+// ?rideID= (rickshaws) / ?rideIDs= (?blockIDs= kiosks): the rides the
+// device is following, so a change it missed while disconnected is sent
+// straight away
+app.get('/api/events', (req, res) => {
+  const { rickshawID, blockID } = req.query;
+  const rideID = parseInt(req.query.rideID);
+  const blockIDs = req.query.blockIDs === undefined ? null : idList(req.query.blockIDs);
+  const rideIDs = (req.query.rideIDs && idList(req.query.rideIDs, id => parseInt(id))) || [];
+  
+  if (!rickshawID && !blockID && !(blockIDs && blockIDs.length > 0)) {
+    return res.status(400).json({ error: 'rickshawID, blockID or blockIDs required' });
+  }
+  
+  res.set({
+    'Content-Type': 'text/event-stream',
+    'Cache-Control': 'no-cache',
+    'Connection': 'keep-alive'
+  });
+  res.flushHeaders();
+  res.write('retry: 5000\n\n');
+  
+  let subscriber = { res, blockID };
+  if (rickshawID) subscriber = { res, rickshawID };
+  else if (blockIDs) subscriber = { res, blockIDs: new Set(blockIDs) };
+  const name = rickshawID || blockID || blockIDs.join(',');
+  addSubscriber(subscriber);
+  console.log(`📡 ${name} subscribed (${pushSubscribers.size} listening)`);
+  
+  // Whatever polling would have shown right now
+  if (rickshawID) {
+    publishOffers([subscriber]);
+    scheduleAssignment();
+    if (rideID) {
+      watchRide(rideID, rickshawID);
+      readRideStatus(rideID, (err, ride) => {
+        if (!err && ride) pushEvent(subscriber, 'ride', ride);
       });
     }
-  );
+  } else if (blockIDs) {
+    readRideStatuses(rideIDs.filter(Boolean), (err, rides) => {
+      if (!err) rides.forEach(ride => pushEvent(subscriber, 'ride', ride));
+    });
+  } else {
+    readLatestBlockRide(blockID, (err, latest) => {
+      if (!err) pushEvent(subscriber, 'ride', blockStatusOf(latest));
+    });
+  }
+  
+  req.on('close', () => {
+    removeSubscriber(subscriber);
+    console.log(`📡 ${name} unsubscribed`);
+  });
 });
 
 
@@ -248,307 +1042,426 @@ app.post('/api/rickshaw/register', (req, res) => {
       if (err) {
         return res.status(500).json({ error: err.message });
       }
+      trackRickshaw(rickshawID, currentLat, currentLng);
       console.log(`✓ ${rickshawID} registered`);
       res.json({ success: true });
     }
   );
 });
 
+// 3b. BLOCK TABLE (devices cache it; ?since=<version> answers 304 when unchanged)
+app.get('/api/locations', (req, res) => {
+  const since = parseInt(req.query.since, 10);
+  
+  statements.get(`SELECT version FROM table_versions WHERE tableName = 'locations'`, [], (err, row) => {
+    if (err) {
+      return res.status(500).json({ error: err.message });
+    }
+    
+    const version = row ? row.version : 0;
+    if (since === version) {
+      return res.status(304).end();
+    }
+    
+    db.all('SELECT blockID, locationName, latitude, longitude FROM locations ORDER BY blockID',
+      (err, rows) => {
+        if (err) {
+          return res.status(500).json({ error: err.message });
+        }
+        // version first: devices read it before streaming the array
+        res.json({ version: version, locations: rows });
+      }
+    );
+  });
+});
+
 // 4. GET PENDING RIDES (TEST CASE 8: Alert distribution with proximity)
-app.get('/api/ride/pending', (req, res) => {
+app.get('/api/ride/pending', deviceWire(WIRE.pending), (req, res) => {
   const { rickshawID } = req.query;
   
   if (!rickshawID) {
     return res.status(400).json({ error: 'rickshawID required' });
   }
   
-  // Get rickshaw location
-  db.get('SELECT currentLat, currentLng FROM rickshaws WHERE rickshawID = ?', 
-    [rickshawID], 
-    (err, rickshaw) => {
-      if (err || !rickshaw) {
-        return res.json({ rides: [] });
-      }
-      
-      // TEST CASE 8a: Get all pending rides with location
-      db.all(
-        `SELECT r.*, l.latitude, l.longitude, l.locationName 
-         FROM rides r 
-         JOIN locations l ON r.pickupBlock = l.blockID 
-         WHERE r.status = 'PENDING' 
-         ORDER BY r.requestTime ASC`,
-        (err, rows) => {
-          if (err) {
-            return res.status(500).json({ error: err.message });
-          }
-          
-          // TEST CASE 8b: Calculate distances and sort by proximity
-          const ridesWithDistance = rows.map(ride => {
-            const distance = calculateDistance(
-              rickshaw.currentLat, rickshaw.currentLng,
-              ride.latitude, ride.longitude
-            );
-            return { 
-              ...ride, 
-              distance: (distance / 1000).toFixed(2) // km
-            };
-          }).sort((a, b) => parseFloat(a.distance) - parseFloat(b.distance));
-          
-          res.json({ rides: ridesWithDistance });
-        }
-      );
+  // TEST CASE 8a/8b: The rickshaw's batch match first, then the other
+  // pending rides by proximity; ?limit=N for just the first N (devices
+  // cache a few to fall back on after a reject)
+  const limit = parseInt(req.query.limit) || undefined;
+  markSeeking(String(rickshawID));
+  nearestPendingRides(rickshawID, limit, (err, rides) => {
+    if (err) {
+      return res.status(500).json({ error: err.message });
     }
-  );
+    rides.forEach(ride => watchRide(ride.rideID, rickshawID));
+    res.json({ rides: rides });
+  });
 });
 
 // 5. ACCEPT RIDE (TEST CASE 8c: First-accept wins with race condition handling)
-app.post('/api/ride/accept', (req, res) => {
+const handleRideAccept = (req, res) => {
   const { rideID, rickshawID } = req.body;
   
   if (!rideID || !rickshawID) {
     return res.status(400).json({ error: 'Missing fields' });
   }
 
-  console.log(`\n🤝 ${rickshawID} attempting to accept ride ${rideID}`);
-
-  db.serialize(() => {
-    db.run('BEGIN TRANSACTION');
+  console.log(`\n🤝 ${rickshawID} attempting to accept ride ${rideID}`);
+
+  // 1-2. Accept only while still pending: compare-and-set in the ride
+  // store, so of two racing accepts exactly one gets through
+  const ride = rideStore.transition(rideID, ['PENDING'], {
+    status: 'ACCEPTED',
+    rickshawID: rickshawID,
+    acceptTime: RideStore.NOW
+  });
+
+  if (!ride) {
+    console.log(`✗ Ride ${rideID} already taken`);
+    return res.json({
+      success: false,
+      message: 'Ride already taken by another puller'
+    });
+  }
+
+  // 3. Update rickshaw status
+  rideStore.persist('UPDATE rickshaws SET status = "ON_RIDE" WHERE rickshawID = ?', [rickshawID]);
+  notifyRideStatus(rideID);
+
+  console.log(`✓ Ride ${rideID} accepted by ${rickshawID}`);
+
+  // 4. Return full ride info for frontend + ESP32 hardware
+  return res.json({
+    success: true,
+    rideID: rideID,
+    pickupBlock: ride.pickupBlock,
+    destination: ride.destination,
+    userLat: ride.userLat,
+    userLng: ride.userLng,
+    message: "Ride accepted"
+  });
+};
+
+app.post('/api/ride/accept', deviceWire(WIRE.accept), idempotent(handleRideAccept));
+
+
+// 6. CONFIRM PICKUP (TEST CASE 9: Status sync)
+const handleRidePickup = (req, res) => {
+  const { rideID } = req.body;
+  
+  if (!rideID) {
+    return res.status(400).json({ error: 'rideID required' });
+  }
+  
+  console.log(`\n🚗 Pickup confirmed for ride ${rideID}`);
+  
+  const ride = rideStore.transition(rideID, ['ACCEPTED'], {
+    status: 'PICKUP',
+    pickupTime: RideStore.NOW
+  });
+  
+  if (!ride) {
+    return res.status(400).json({ error: 'Ride not in accepted state' });
+  }
+  
+  notifyRideStatus(rideID);
+  
+  console.log(`✓ Pickup confirmed`);
+  res.json({ success: true });
+};
+
+app.post('/api/ride/pickup', deviceWire(WIRE.pickup), idempotent(handleRidePickup));
+
+// 7. COMPLETE RIDE (TEST CASE 7: GPS verification + Point allocation)
+const handleRideComplete = (req, res) => {
+  const { rideID, dropLat, dropLng } = req.body;
+  
+  if (!rideID || dropLat === undefined || dropLng === undefined) {
+    return res.status(400).json({ error: 'Missing fields' });
+  }
+  
+  console.log(`\n🏁 Completing ride ${rideID}`);
+  console.log(`   Drop location: ${dropLat}, ${dropLng}`);
+  
+  // Get ride with destination coordinates
+  const ride = rideStore.get(rideID);
+  if (!ride || (ride.status !== 'ACCEPTED' && ride.status !== 'PICKUP')) {
+    return res.status(400).json({ error: 'Ride not in progress' });
+  }
+  const target = blocks.get(ride.destination);
+  if (!target) {
+    return res.status(404).json({ error: 'Destination block not found' });
+  }
+  
+  // TEST CASE 7: Calculate distance from destination
+  const distanceFromDest = calculateDistance(
+    dropLat, dropLng, 
+    target.latitude, target.longitude
+  );
+  
+  console.log(`   Target: ${target.locationName} (${target.latitude}, ${target.longitude})`);
+  console.log(`   Distance from destination: ${distanceFromDest.toFixed(2)} m`);
+  
+  // TEST CASE 7: Calculate points
+  const points = calculatePoints(distanceFromDest);
+  const status = distanceFromDest <= 100 ? 'COMPLETED' : 'PENDING_REVIEW';
+  
+  console.log(`   Points awarded: ${points}`);
+  console.log(`   Status: ${status}`);
+  
+  if (status === 'PENDING_REVIEW') {
+    console.log(`   ⚠ Distance > 100m - Requires admin review`);
+  }
+  
+  // Update ride
+  rideStore.transition(rideID, ['ACCEPTED', 'PICKUP'], {
+    status: status,
+    dropTime: RideStore.NOW,
+    dropLat: dropLat,
+    dropLng: dropLng,
+    dropDistance: distanceFromDest,
+    pointsAwarded: points
+  });
+  
+  // TEST CASE 11: Award points
+  if (points > 0) {
+    rideStore.persist(
+      'UPDATE rickshaws SET totalPoints = totalPoints + ?, status = "AVAILABLE" WHERE rickshawID = ?', 
+      [points, ride.rickshawID]
+    );
+    
+    rideStore.persist(
+      `INSERT INTO points_history (rickshawID, rideID, pointsEarned, transactionType, notes) 
+       VALUES (?, ?, ?, 'EARNED', ?)`,
+      [ride.rickshawID, ride.rideID, points, `Ride completed - ${distanceFromDest.toFixed(1)}m from target`]
+    );
+  } else {
+    rideStore.persist('UPDATE rickshaws SET status = "AVAILABLE" WHERE rickshawID = ?', [ride.rickshawID]);
+  }
+  
+  notifyRideStatus(rideID);
+  
+  console.log(`✓ Ride completed`);
+  
+  res.json({ 
+    success: true, 
+    points: points,
+    distance: distanceFromDest.toFixed(2),
+    status: status
+  });
+};
+
+app.post('/api/ride/complete', deviceWire(WIRE.complete), idempotent(handleRideComplete));
 
-    // 1. Check if the ride is still pending
-    db.get(
-      'SELECT * FROM rides WHERE rideID = ?',
-      [rideID],
-      (err, ride) => {
-        if (err) {
-          db.run('ROLLBACK');
-          return res.status(500).json({ error: err.message });
-        }
+// 7b. JOURNALED RIDE EVENTS (store-and-forward from the rickshaws)
+// Events run in order through the same handlers as the single endpoints,
+// keyed <rickshawID>:<journalID>:<key>. The batch stops at the first 5xx
+// so a later event never overtakes a failed earlier one; the device
+// retries the rest.
+const RIDE_EVENT_BATCH_MAX = 16;
+const RIDE_EVENT_HANDLERS = {
+  ACCEPT: ['/api/ride/accept', handleRideAccept],
+  PICKUP: ['/api/ride/pickup', handleRidePickup],
+  COMPLETE: ['/api/ride/complete', handleRideComplete]
+};
 
-        if (!ride || ride.status !== 'PENDING') {
-          db.run('ROLLBACK');
-          console.log(`✗ Ride ${rideID} already taken`);
-          return res.json({
-            success: false,
-            message: 'Ride already taken by another puller'
-          });
+app.post('/api/ride/events', deviceWire(WIRE.rideEvents), (req, res) => {
+  const { rickshawID, journalID = 0, events } = req.body;
+  
+  if (!rickshawID || !Array.isArray(events) || events.length === 0) {
+    return res.status(400).json({ error: 'Missing fields' });
+  }
+  if (events.length > RIDE_EVENT_BATCH_MAX) {
+    return res.status(413).json({ error: `At most ${RIDE_EVENT_BATCH_MAX} events per batch` });
+  }
+  
+  const results = [];
+  let replays = 0;
+  
+  const runEvent = (index) => {
+    if (index === events.length) {
+      console.log(`📝 ${rickshawID}: ${results.length}/${events.length} journaled events applied (${replays} replays)`);
+      return res.json({ results: results });
+    }
+    
+    const event = events[index];
+    const route = RIDE_EVENT_HANDLERS[event.type];
+    if (!route || event.key === undefined) {
+      results.push({ key: event.key, status: 400, body: { error: 'Invalid event' } });
+      return runEvent(index + 1);
+    }
+    
+    const eventReq = { body: { ...event, rickshawID: rickshawID } };
+    runIdempotent(`${rickshawID}:${journalID}:${event.key}`, route[0],
+      finish => route[1](eventReq, capturedResponse(finish)),
+      (statusCode, body, replayed) => {
+        if (replayed) replays++;
+        results.push({ key: event.key, status: statusCode, body: body });
+        if (statusCode >= 500) {
+          return res.json({ results: results });
         }
-
-        // 2. Accept ride (atomic)
-        db.run(
-          `UPDATE rides 
-           SET status = 'ACCEPTED',
-               rickshawID = ?,
-               acceptTime = CURRENT_TIMESTAMP
-           WHERE rideID = ? AND status = 'PENDING'`,
-          [rickshawID, rideID],
-          function(err) {
-            if (err) {
-              db.run('ROLLBACK');
-              return res.status(500).json({ error: err.message });
-            }
-
-            if (this.changes === 0) {
-              db.run('ROLLBACK');
-              return res.json({ success: false, message: 'Race condition' });
-            }
-
-            // 3. Update rickshaw status
-            db.run(
-              'UPDATE rickshaws SET status = "ON_RIDE" WHERE rickshawID = ?',
-              [rickshawID]
-            );
-
-            // 4. Commit the transaction
-            db.run('COMMIT');
-
-            console.log(`✓ Ride ${rideID} accepted by ${rickshawID}`);
-
-            // 5. Return full ride info for frontend + ESP32 hardware
-            return res.json({
-              success: true,
-              rideID: rideID,
-              pickupBlock: ride.pickupBlock,
-              destination: ride.destination,
-              userLat: ride.userLat,
-              userLng: ride.userLng,
-              message: "Ride accepted"
-            });
-          }
-        );
+        runEvent(index + 1);
       }
     );
-  });
+  };
+  
+  runEvent(0);
 });
 
-
-// 6. CONFIRM PICKUP (TEST CASE 9: Status sync)
-app.post('/api/ride/pickup', (req, res) => {
-  const { rideID } = req.body;
+// 8. UPDATE RICKSHAW LOCATION (TEST CASE 9: Real-time sync)
+app.post('/api/rickshaw/location', deviceWire(WIRE.location), (req, res) => {
+  const { rickshawID, lat, lng } = req.body;
   
-  if (!rideID) {
-    return res.status(400).json({ error: 'rideID required' });
+  if (!rickshawID || lat === undefined || lng === undefined) {
+    return res.status(400).json({ error: 'Missing fields' });
   }
   
-  console.log(`\n🚗 Pickup confirmed for ride ${rideID}`);
-  
-  db.run(
-    `UPDATE rides 
-     SET status = 'PICKUP', 
-         pickupTime = CURRENT_TIMESTAMP 
-     WHERE rideID = ? AND status = 'ACCEPTED'`,
-    [rideID],
-    function(err) {
+  statements.run(
+    'UPDATE rickshaws SET currentLat = ?, currentLng = ?, lastUpdated = CURRENT_TIMESTAMP WHERE rickshawID = ?',
+    [lat, lng, rickshawID],
+    (err) => {
       if (err) {
         return res.status(500).json({ error: err.message });
       }
-      
-      if (this.changes === 0) {
-        return res.status(400).json({ error: 'Ride not in accepted state' });
-      }
-      
-      console.log(`✓ Pickup confirmed`);
+      statements.run('INSERT INTO location_history (rickshawID, latitude, longitude) VALUES (?, ?, ?)',
+        [rickshawID, lat, lng]);
+      trackRickshaw(rickshawID, lat, lng);
       res.json({ success: true });
     }
   );
 });
 
-// 7. COMPLETE RIDE (TEST CASE 7: GPS verification + Point allocation)
-app.post('/api/ride/complete', (req, res) => {
-  const { rideID, dropLat, dropLng } = req.body;
+// 8b. BATCHED LOCATION UPDATE
+// Fixes buffered on a poor link, oldest first. Devices have no wall clock,
+// so each fix carries its age in seconds at send time.
+const LOCATION_BATCH_MAX = 64;
+
+app.post('/api/rickshaw/location/batch', deviceWire(WIRE.locationBatch), (req, res) => {
+  const { rickshawID, fixes } = req.body;
   
-  if (!rideID || dropLat === undefined || dropLng === undefined) {
+  if (!rickshawID || !Array.isArray(fixes) || fixes.length === 0) {
     return res.status(400).json({ error: 'Missing fields' });
   }
+  if (fixes.length > LOCATION_BATCH_MAX) {
+    return res.status(413).json({ error: `At most ${LOCATION_BATCH_MAX} fixes per batch` });
+  }
+  const valid = fixes.every(fix => typeof fix.lat === 'number' && typeof fix.lng === 'number');
+  if (!valid) {
+    return res.status(400).json({ error: 'Invalid fix' });
+  }
   
-  console.log(`\n🏁 Completing ride ${rideID}`);
-  console.log(`   Drop location: ${dropLat}, ${dropLng}`);
+  const ageOf = fix => `-${Math.max(0, Math.round(Number(fix.age) || 0))} seconds`;
+  const newest = fixes[fixes.length - 1];
   
-  // Get ride with destination coordinates
-  db.get(
-    `SELECT r.*, l.latitude as destLat, l.longitude as destLng, l.locationName 
-     FROM rides r 
-     JOIN locations l ON r.destination = l.blockID 
-     WHERE r.rideID = ?`,
-    [rideID],
-    (err, ride) => {
+  db.serialize(() => {
+    db.run('BEGIN TRANSACTION');
+    
+    const stmt = db.prepare(
+      `INSERT INTO location_history (rickshawID, latitude, longitude, recordedAt)
+       VALUES (?, ?, ?, DATETIME('now', ?))`
+    );
+    fixes.forEach(fix => stmt.run([rickshawID, fix.lat, fix.lng, ageOf(fix)]));
+    stmt.finalize();
+    
+    db.run(
+      `UPDATE rickshaws SET currentLat = ?, currentLng = ?, lastUpdated = DATETIME('now', ?)
+       WHERE rickshawID = ?`,
+      [newest.lat, newest.lng, ageOf(newest), rickshawID]
+    );
+    
+    db.run('COMMIT', (err) => {
       if (err) {
+        db.run('ROLLBACK');
         return res.status(500).json({ error: err.message });
       }
-      
-      if (!ride) {
-        return res.status(404).json({ error: 'Ride not found' });
-      }
-      
-      // TEST CASE 7: Calculate distance from destination
-      const distanceFromDest = calculateDistance(
-        dropLat, dropLng, 
-        ride.destLat, ride.destLng
-      );
-      
-      console.log(`   Target: ${ride.locationName} (${ride.destLat}, ${ride.destLng})`);
-      console.log(`   Distance from destination: ${distanceFromDest.toFixed(2)} m`);
-      
-      // TEST CASE 7: Calculate points
-      const points = calculatePoints(distanceFromDest);
-      const status = distanceFromDest <= 100 ? 'COMPLETED' : 'PENDING_REVIEW';
-      
-      console.log(`   Points awarded: ${points}`);
-      console.log(`   Status: ${status}`);
-      
-      if (status === 'PENDING_REVIEW') {
-        console.log(`   ⚠ Distance > 100m - Requires admin review`);
-      }
-      
-      // Update ride
-      db.run(
-        `UPDATE rides 
-         SET status = ?, 
-             dropTime = CURRENT_TIMESTAMP, 
-             dropLat = ?, 
-             dropLng = ?, 
-             dropDistance = ?,
-             pointsAwarded = ? 
-         WHERE rideID = ?`,
-        [status, dropLat, dropLng, distanceFromDest, points, rideID],
-        (err) => {
-          if (err) {
-            return res.status(500).json({ error: err.message });
-          }
-          
-          // TEST CASE 11: Award points
-          if (points > 0) {
-            db.run(
-              'UPDATE rickshaws SET totalPoints = totalPoints + ?, status = "AVAILABLE" WHERE rickshawID = ?', 
-              [points, ride.rickshawID]
-            );
-            
-            db.run(
-              `INSERT INTO points_history (rickshawID, rideID, pointsEarned, transactionType, notes) 
-               VALUES (?, ?, ?, 'EARNED', ?)`,
-              [ride.rickshawID, rideID, points, `Ride completed - ${distanceFromDest.toFixed(1)}m from target`]
-            );
-          } else {
-            db.run('UPDATE rickshaws SET status = "AVAILABLE" WHERE rickshawID = ?', [ride.rickshawID]);
-          }
-          
-          console.log(`✓ Ride completed`);
-          
-          res.json({ 
-            success: true, 
-            points: points,
-            distance: distanceFromDest.toFixed(2),
-            status: status
-          });
-        }
-      );
-    }
-  );
+      trackRickshaw(rickshawID, newest.lat, newest.lng);
+      console.log(`📍 ${rickshawID}: ${fixes.length} buffered fixes applied`);
+      res.json({ success: true, applied: fixes.length });
+    });
+  });
 });
 
-// 8. UPDATE RICKSHAW LOCATION (TEST CASE 9: Real-time sync)
-app.post('/api/rickshaw/location', (req, res) => {
-  const { rickshawID, lat, lng } = req.body;
+// 8c. DEVICE TELEMETRY
+// Every 5 min from each rickshaw and kiosk; see lib/telemetry.js
+const TELEMETRY_KEEP_DAYS = 7;
+const TELEMETRY_PRUNE_MS = 60 * 60 * 1000;
+
+const telemetryHandler = (deviceType, idField) => (req, res) => {
+  const deviceID = req.body[idField];
+  const report = telemetry.normalizeReport(req.body);
   
-  if (!rickshawID || lat === undefined || lng === undefined) {
+  if (!deviceID) {
     return res.status(400).json({ error: 'Missing fields' });
   }
+  if (report.error) {
+    return res.status(400).json({ error: report.error });
+  }
   
-  db.run(
-    'UPDATE rickshaws SET currentLat = ?, currentLng = ?, lastUpdated = CURRENT_TIMESTAMP WHERE rickshawID = ?',
-    [lat, lng, rickshawID],
-    (err) => {
+  const [main, net] = report.loops;
+  db.serialize(() => {
+    db.run('BEGIN TRANSACTION');
+    
+    db.run(
+      `INSERT INTO device_telemetry (deviceType, deviceID, uptimeS, windowS,
+         mainPasses, mainBusyAvgUs, mainBusyMaxUs, mainLateAvgUs, mainLateMaxUs,
+         netPasses, netBusyAvgUs, netBusyMaxUs, netLateAvgUs, netLateMaxUs,
+         freeHeap, minFreeHeap, minLargestBlock, rssi, minRssi, wifiReconnects)
+       VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)`,
+      [deviceType, deviceID, report.uptime, report.window,
+        main.passes, main.busyAvgUs, main.busyMaxUs, main.lateAvgUs, main.lateMaxUs,
+        net.passes, net.busyAvgUs, net.busyMaxUs, net.lateAvgUs, net.lateMaxUs,
+        report.heap.free, report.heap.minFree, report.heap.minLargestBlock,
+        report.wifi.rssi, report.wifi.minRssi, report.wifi.reconnects]
+    );
+    
+    const stmt = db.prepare(
+      `INSERT INTO telemetry_endpoints (telemetryID, endpoint, ${telemetry.BUCKET_COLUMNS.join(', ')}, failures, maxMs)
+       VALUES (last_insert_rowid(), ?, ${telemetry.BUCKET_COLUMNS.map(() => '?').join(', ')}, ?, ?)`
+    );
+    report.endpoints.forEach(entry => stmt.run([entry.endpoint, ...entry.buckets, entry.failures, entry.maxMs]));
+    stmt.finalize();
+    
+    db.run('COMMIT', (err) => {
       if (err) {
+        db.run('ROLLBACK');
         return res.status(500).json({ error: err.message });
       }
       res.json({ success: true });
-    }
-  );
-});
+    });
+  });
+};
+
+app.post('/api/rickshaw/telemetry', deviceWire(WIRE.telemetry), telemetryHandler('rickshaw', 'rickshawID'));
+app.post('/api/kiosk/telemetry', deviceWire(WIRE.telemetry), telemetryHandler('kiosk', 'blockID'));
+
+setInterval(() => {
+  const cutoff = `-${TELEMETRY_KEEP_DAYS} days`;
+  db.serialize(() => {
+    db.run(
+      `DELETE FROM telemetry_endpoints WHERE telemetryID IN
+         (SELECT telemetryID FROM device_telemetry WHERE receivedAt < DATETIME('now', ?))`,
+      [cutoff]
+    );
+    db.run(`DELETE FROM device_telemetry WHERE receivedAt < DATETIME('now', ?)`, [cutoff]);
+  });
+}, TELEMETRY_PRUNE_MS).unref();
 
 // ========== ADMIN ENDPOINTS (TEST CASE 10) ==========
 
 // 9. ADMIN DASHBOARD STATS
 app.get('/api/admin/stats', (req, res) => {
-  const stats = {};
-  
-  db.get('SELECT COUNT(*) as count FROM rides WHERE status IN ("ACCEPTED", "PICKUP")', (err, row) => {
-    stats.activeRides = row ? row.count : 0;
+  // Ride figures from the counters; rickshaws is small enough to count
+  db.get(rideCounters.STATS_SQL, (err, counts) => {
+    if (err) {
+      return res.status(500).json({ error: err.message });
+    }
     
     db.get('SELECT COUNT(*) as count FROM rickshaws WHERE isOnline = 1', (err, row) => {
-      stats.onlineRickshaws = row ? row.count : 0;
-      
-      db.get('SELECT COUNT(*) as count FROM rides WHERE status = "PENDING_REVIEW"', (err, row) => {
-        stats.pendingReviews = row ? row.count : 0;
-        
-        db.get('SELECT SUM(pointsAwarded) as total FROM rides WHERE DATE(dropTime) = DATE("now")', (err, row) => {
-          stats.pointsToday = row ? row.total || 0 : 0;
-          
-          db.get('SELECT COUNT(*) as count FROM rides WHERE DATE(requestTime) = DATE("now")', (err, row) => {
-            stats.ridesToday = row ? row.count : 0;
-            
-            res.json(stats);
-          });
-        });
+      res.json({
+        activeRides: counts.activeRides,
+        onlineRickshaws: row ? row.count : 0,
+        pendingReviews: counts.pendingReviews,
+        pointsToday: counts.pointsToday,
+        ridesToday: counts.ridesToday
       });
     });
   });
@@ -605,6 +1518,7 @@ app.post('/api/admin/adjust-points', (req, res) => {
       }
       
       db.run('UPDATE rickshaws SET totalPoints = totalPoints + ? WHERE rickshawID = ?', [pointDiff, ride.rickshawID]);
+      rideStore.reload(rideID, () => notifyRideStatus(rideID));
       
       db.run(
         `INSERT INTO points_history (rickshawID, rideID, pointsEarned, transactionType, notes) 
@@ -619,34 +1533,136 @@ app.post('/api/admin/adjust-points', (req, res) => {
   });
 });
 
-// 12. ADMIN ANALYTICS (TEST CASE 10c)
-app.get('/api/admin/analytics', (req, res) => {
-  const analytics = {};
+// 11b. ADMIN ADD/UPDATE BLOCK (picked up by devices on their next boot)
+app.post('/api/admin/locations', (req, res) => {
+  const { blockID, locationName, latitude, longitude } = req.body;
+  
+  if (!blockID || !locationName || typeof latitude !== 'number' || typeof longitude !== 'number') {
+    return res.status(400).json({ error: 'Missing fields' });
+  }
+  
+  db.run(
+    `INSERT INTO locations (blockID, locationName, latitude, longitude) VALUES (?, ?, ?, ?)
+     ON CONFLICT(blockID) DO UPDATE SET
+       locationName = excluded.locationName,
+       latitude = excluded.latitude,
+       longitude = excluded.longitude`,
+    [blockID, locationName, latitude, longitude],
+    (err) => {
+      if (err) {
+        return res.status(500).json({ error: err.message });
+      }
+      
+      loadDispatchIndex();  // Pending rides at this block may have moved
+      
+      db.get(`SELECT version FROM table_versions WHERE tableName = 'locations'`, (err, row) => {
+        console.log(`📍 Block ${blockID} saved (table v${row ? row.version : '?'})`);
+        res.json({ success: true, version: row ? row.version : null });
+      });
+    }
+  );
+});
+
+// Device performance over the last day: merged endpoint histograms, the
+// devices lowest on heap, the worst loop stalls and Wi-Fi
+const TELEMETRY_ANALYTICS_WINDOW = '-1 day';
+const POOR_LINK_RSSI = -75;  // dBm, as in the rickshaw's location batching
+
+function readTelemetryAnalytics(callback) {
+  const since = [TELEMETRY_ANALYTICS_WINDOW];
+  const result = {};
   
-  db.all(
-    `SELECT destination, COUNT(*) as count 
-     FROM rides 
-     WHERE status != 'TIMEOUT' 
-     GROUP BY destination 
-     ORDER BY count DESC 
-     LIMIT 5`,
-    (err, rows) => {
-      analytics.topDestinations = rows || [];
+  db.get(
+    `SELECT COUNT(DISTINCT deviceType || ':' || deviceID) as devices, COUNT(*) as uploads
+     FROM device_telemetry WHERE receivedAt >= DATETIME('now', ?)`,
+    since,
+    (err, row) => {
+      result.devicesReporting = row ? row.devices : 0;
+      result.uploads = row ? row.uploads : 0;
       
       db.all(
-        `SELECT rickshawID, pullerName, totalPoints, 
-                (SELECT COUNT(*) FROM rides WHERE rickshawID = rickshaws.rickshawID AND status = 'COMPLETED') as completedRides
-         FROM rickshaws 
-         ORDER BY totalPoints DESC 
-         LIMIT 10`,
+        `SELECT t.deviceType, e.endpoint,
+                ${telemetry.BUCKET_COLUMNS.map(column => `SUM(e.${column}) as ${column}`).join(', ')},
+                SUM(e.failures) as failures, MAX(e.maxMs) as maxMs
+         FROM telemetry_endpoints e JOIN device_telemetry t ON t.telemetryID = e.telemetryID
+         WHERE t.receivedAt >= DATETIME('now', ?)
+         GROUP BY t.deviceType, e.endpoint
+         ORDER BY t.deviceType, e.endpoint`,
+        since,
         (err, rows) => {
-          analytics.topPullers = rows || [];
+          result.endpoints = (rows || []).map(row => ({
+            deviceType: row.deviceType,
+            endpoint: row.endpoint,
+            ...telemetry.summarizeEndpoint(telemetry.BUCKET_COLUMNS.map(column => row[column]), row.failures, row.maxMs)
+          }));
           
-          res.json(analytics);
+          db.all(
+            `SELECT deviceType, deviceID, MIN(minFreeHeap) as minFreeHeap,
+                    MIN(minLargestBlock) as minLargestBlock, MIN(freeHeap) as lowestFreeHeap
+             FROM device_telemetry WHERE receivedAt >= DATETIME('now', ?) AND minFreeHeap IS NOT NULL
+             GROUP BY deviceType, deviceID
+             ORDER BY minFreeHeap ASC
+             LIMIT 5`,
+            since,
+            (err, rows) => {
+              result.lowestHeap = rows || [];
+              
+              db.all(
+                `SELECT deviceType, deviceID,
+                        MAX(mainLateMaxUs) as mainLateMaxUs, MAX(mainBusyMaxUs) as mainBusyMaxUs,
+                        MAX(netLateMaxUs) as netLateMaxUs, MAX(netBusyMaxUs) as netBusyMaxUs
+                 FROM device_telemetry WHERE receivedAt >= DATETIME('now', ?)
+                 GROUP BY deviceType, deviceID
+                 ORDER BY MAX(MAX(mainLateMaxUs), MAX(netLateMaxUs)) DESC
+                 LIMIT 5`,
+                since,
+                (err, rows) => {
+                  result.worstLoops = rows || [];
+                  
+                  // Reconnects count since boot: the highest seen per device
+                  db.get(
+                    `SELECT ROUND(AVG(rssi)) as averageRssi, MIN(minRssi) as lowestRssi,
+                            SUM(CASE WHEN minRssi < ${POOR_LINK_RSSI} THEN 1 ELSE 0 END) as poorLinkDevices,
+                            SUM(reconnects) as reconnects
+                     FROM (SELECT AVG(rssi) as rssi, MIN(minRssi) as minRssi, MAX(wifiReconnects) as reconnects
+                           FROM device_telemetry WHERE receivedAt >= DATETIME('now', ?)
+                           GROUP BY deviceType, deviceID)`,
+                    since,
+                    (err, row) => {
+                      result.wifi = row || {};
+                      callback(result);
+                    }
+                  );
+                }
+              );
+            }
+          );
         }
       );
     }
   );
+}
+
+// 12. ADMIN ANALYTICS (TEST CASE 10c)
+app.get('/api/admin/analytics', (req, res) => {
+  const analytics = {};
+  
+  db.all(rideCounters.TOP_DESTINATIONS_SQL, (err, rows) => {
+    analytics.topDestinations = rows || [];
+    
+    db.all(rideCounters.TOP_PULLERS_SQL, (err, rows) => {
+      analytics.topPullers = rows || [];
+      
+      db.all(rideCounters.RIDES_BY_HOUR_SQL, (err, rows) => {
+        analytics.ridesByHour = rows || [];
+        
+        readTelemetryAnalytics((telemetryAnalytics) => {
+          analytics.telemetry = telemetryAnalytics;
+          res.json(analytics);
+        });
+      });
+    });
+  });
 });
 
 // TEST CASE 8e: Puller Cancellation
@@ -660,30 +1676,23 @@ app.post('/api/ride/cancel', (req, res) => {
   console.log(`\n❌ Rickshaw ${rickshawID} cancelling ride ${rideID}`);
   
   // Update ride back to PENDING
-  db.run(
-    `UPDATE rides 
-     SET status = 'PENDING', 
-         rickshawID = NULL, 
-         acceptTime = NULL 
-     WHERE rideID = ? AND rickshawID = ? AND status IN ('ACCEPTED', 'PICKUP')`,
-    [rideID, rickshawID],
-    function(err) {
-      if (err) {
-        return res.status(500).json({ error: err.message });
-      }
-      
-      if (this.changes === 0) {
-        return res.status(400).json({ error: 'Cannot cancel ride' });
-      }
-      
-      // Update rickshaw status
-      db.run('UPDATE rickshaws SET status = "AVAILABLE" WHERE rickshawID = ?', [rickshawID]);
-      
-      console.log(`✓ Ride ${rideID} returned to PENDING - Re-alerting other pullers`);
-      
-      res.json({ success: true, message: 'Ride cancelled, re-alerting others' });
-    }
+  const ride = rideStore.transition(
+    rideID,
+    ride => ride.rickshawID === rickshawID && (ride.status === 'ACCEPTED' || ride.status === 'PICKUP'),
+    { status: 'PENDING', rickshawID: null, acceptTime: null }
   );
+  
+  if (!ride) {
+    return res.status(400).json({ error: 'Cannot cancel ride' });
+  }
+  
+  // Update rickshaw status
+  rideStore.persist('UPDATE rickshaws SET status = "AVAILABLE" WHERE rickshawID = ?', [rickshawID]);
+  notifyRideStatus(rideID);
+  
+  console.log(`✓ Ride ${rideID} returned to PENDING - Re-alerting other pullers`);
+  
+  res.json({ success: true, message: 'Ride cancelled, re-alerting others' });
 });
 
 // TEST CASE 11b: Point Redemption
@@ -734,71 +1743,126 @@ app.post('/api/points/redeem', (req, res) => {
   });
 });
 
+// ========== MAINTENANCE JOBS ==========
+// Run in the background in bounded steps (lib/jobs.js); each endpoint
+// answers 202 with the queued job, GET /api/admin/jobs/:id follows it
+const jobs = new JobRunner();
+const MAINTENANCE_BATCH_KEYS = 500;  // Row keys walked per step
+const BACKUP_PAGES_PER_STEP = 64;    // 256 KB at the default page size
+
+// Same text as CURRENT_TIMESTAMP columns, so they compare correctly
+function cutoffBefore(days) {
+  const cutoff = new Date(Date.now() - days * 24 * 3600 * 1000);
+  return cutoff.toISOString().replace('T', ' ').slice(0, 19);
+}
+
+// Walks each phase's table by integer key, MAINTENANCE_BATCH_KEYS keys
+// per step: phase.maxKey is SQL for the highest key, phase.batch(from, to,
+// done) handles the keys in (from, to]. Progress counts keys walked.
+function keyRangeSteps(phases) {
+  let ends = null;
+  let phase = 0;
+  let cursor = 0;
+  
+  const skipWalked = () => {
+    while (phase < phases.length && cursor >= ends[phase]) {
+      phase++;
+      cursor = 0;
+    }
+    return phase >= phases.length;
+  };
+  
+  return (job, done) => {
+    if (!ends) {
+      const columns = phases.map((p, i) => `(${p.maxKey}) AS end${i}`).join(', ');
+      return db.get(`SELECT ${columns}`, (err, row) => {
+        if (err) return done(err);
+        ends = phases.map((p, i) => row[`end${i}`] || 0);
+        job.progress.total = ends.reduce((sum, end) => sum + end, 0);
+        done(null, skipWalked());
+      });
+    }
+    
+    const from = cursor;
+    const to = Math.min(cursor + MAINTENANCE_BATCH_KEYS, ends[phase]);
+    phases[phase].batch(from, to, (err) => {
+      if (err) return done(err);
+      job.progress.done += to - from;
+      cursor = to;
+      done(null, skipWalked());
+    });
+  };
+}
+
+app.get('/api/admin/jobs', (req, res) => {
+  res.json({ jobs: jobs.list() });
+});
+
+app.get('/api/admin/jobs/:id', (req, res) => {
+  const job = jobs.get(req.params.id);
+  if (!job) {
+    return res.status(404).json({ error: 'Job not found' });
+  }
+  res.json(job);
+});
+
+const jobQueued = (res, job) => res.status(202).json({ success: true, jobID: job.jobID, job });
+
 // TEST CASE 11e: Expire Old Points (Run periodically)
+// Each step sums the EARNED points in one key range of points_history per
+// rickshaw and books them off in one write-behind transaction
 app.post('/api/admin/expire-points', (req, res) => {
   const expiryDays = req.body.days || 180;
-  const expiryDate = new Date();
-  expiryDate.setDate(expiryDate.getDate() - expiryDays);
-  
-  console.log(`\n⏰ Expiring points older than ${expiryDate.toISOString()}`);
-  
-  // Find expired point transactions
-  db.all(
-    `SELECT h.rickshawID, SUM(h.pointsEarned) as expiredPoints
-     FROM points_history h
-     WHERE h.transactionType = 'EARNED' 
-     AND h.transactionDate < ?
-     AND NOT EXISTS (
-       SELECT 1 FROM points_history h2 
-       WHERE h2.historyID = h.historyID 
-       AND h2.transactionType = 'EXPIRED'
-     )
-     GROUP BY h.rickshawID`,
-    [expiryDate.toISOString()],
-    (err, rows) => {
-      if (err) {
-        return res.status(500).json({ error: err.message });
-      }
-      
-      if (!rows || rows.length === 0) {
-        return res.json({ success: true, expired: 0 });
-      }
-      
-      let totalExpired = 0;
-      
-      rows.forEach(row => {
-        // Deduct expired points
-        db.run(
-          'UPDATE rickshaws SET totalPoints = totalPoints - ? WHERE rickshawID = ?',
-          [row.expiredPoints, row.rickshawID]
-        );
-        
-        // Log expiration
-        db.run(
-          `INSERT INTO points_history (rickshawID, pointsEarned, transactionType, notes) 
-           VALUES (?, ?, 'EXPIRED', ?)`,
-          [row.rickshawID, -row.expiredPoints, `Points older than ${expiryDays} days`]
-        );
+  const cutoff = cutoffBefore(expiryDays);
+  
+  console.log(`\n⏰ Expiring points older than ${cutoff}`);
+  
+  const result = { expired: 0, rickshaws: 0 };
+  const expiredFrom = new Set();
+  
+  const job = jobs.add('expire-points', { days: expiryDays }, keyRangeSteps([{
+    maxKey: 'SELECT MAX(historyID) FROM points_history',
+    batch: (from, to, done) => db.all(
+      `SELECT rickshawID, SUM(pointsEarned) as expiredPoints
+       FROM points_history
+       WHERE historyID > ? AND historyID <= ?
+       AND transactionType = 'EARNED'
+       AND transactionDate < ?
+       GROUP BY rickshawID`,
+      [from, to, cutoff],
+      (err, rows) => {
+        if (err || rows.length === 0) return done(err);
         
-        totalExpired += row.expiredPoints;
-      });
-      
-      console.log(`✓ Expired ${totalExpired} points from ${rows.length} rickshaws`);
-      
-      res.json({ 
-        success: true, 
-        expired: totalExpired,
-        rickshaws: rows.length
-      });
-    }
-  );
+        rows.forEach((row, i) => {
+          // Deduct expired points
+          rideStore.persist(
+            'UPDATE rickshaws SET totalPoints = totalPoints - ? WHERE rickshawID = ?',
+            [row.expiredPoints, row.rickshawID]
+          );
+          
+          // Log expiration
+          rideStore.persist(
+            `INSERT INTO points_history (rickshawID, pointsEarned, transactionType, notes) 
+             VALUES (?, ?, 'EXPIRED', ?)`,
+            [row.rickshawID, -row.expiredPoints, `Points older than ${expiryDays} days`],
+            i === rows.length - 1 ? done : undefined
+          );
+          
+          expiredFrom.add(row.rickshawID);
+          result.expired += row.expiredPoints;
+          result.rickshaws = expiredFrom.size;
+        });
+      }
+    )
+  }]), result);
+  
+  jobQueued(res, job);
 });
 
 // TEST CASE 12b: Database Backup
+// SQLite's online backup, a few pages per step. It reads through the
+// server's own connection, so writes made meanwhile end up in the copy.
 app.post('/api/admin/backup', (req, res) => {
-  const fs = require('fs');
-  const path = require('path');
-  
   const timestamp = new Date().toISOString().replace(/:/g, '-');
   const backupFile = `./backups/aeras-${timestamp}.db`;
   
@@ -807,74 +1871,75 @@ app.post('/api/admin/backup', (req, res) => {
     fs.mkdirSync('./backups');
   }
   
-  // Copy database file
-  fs.copyFile('./aeras.db', backupFile, (err) => {
-    if (err) {
-      console.error('Backup failed:', err);
-      return res.status(500).json({ error: 'Backup failed' });
+  let backup = null;
+  const job = jobs.add('backup', { file: backupFile }, (job, done) => {
+    if (!backup) {
+      // Queued ride writes first, so the copy is at least this recent
+      return rideStore.drain(() => {
+        backup = db.backup(backupFile, (err) => done(err, false));
+      });
     }
     
-    console.log(`✓ Database backed up to ${backupFile}`);
-    
-    res.json({ 
-      success: true, 
-      backup: backupFile,
-      size: fs.statSync(backupFile).size
+    backup.step(BACKUP_PAGES_PER_STEP, (err) => {
+      if (err) return backup.finish(() => done(err));
+      job.progress = { done: backup.pageCount - backup.remaining, total: backup.pageCount };
+      if (!backup.completed) return done(null, false);
+      
+      backup.finish(() => {
+        job.result = { backup: backupFile, size: fs.statSync(backupFile).size };
+        done(null, true);
+      });
     });
   });
+  
+  jobQueued(res, job);
 });
 
 // TEST CASE 12e: Anonymize Old Data
+// users (by rowid), then rides, one key range per write-behind transaction.
+// users has no activity column, so accounts are aged by their creation.
 app.post('/api/admin/anonymize', (req, res) => {
   const ageDays = req.body.days || 365;
-  const cutoffDate = new Date();
-  cutoffDate.setDate(cutoffDate.getDate() - ageDays);
+  const cutoff = cutoffBefore(ageDays);
   
-  console.log(`\n🔒 Anonymizing data older than ${cutoffDate.toISOString()}`);
+  console.log(`\n🔒 Anonymizing data older than ${cutoff}`);
   
-  // Anonymize user data
-  db.run(
-    `UPDATE users 
-     SET name = 'ANONYMIZED', 
-         phoneNumber = NULL 
-     WHERE lastActive < ?`,
-    [cutoffDate.toISOString()],
-    function(err) {
-      if (err) {
-        return res.status(500).json({ error: err.message });
-      }
-      
-      const usersAnonymized = this.changes;
-      
-      // Anonymize ride user data
-      db.run(
+  const result = { usersAnonymized: 0, ridesAnonymized: 0 };
+  const counted = (field, done) => (err, changes) => {
+    if (!err) result[field] += changes;
+    done(err);
+  };
+  
+  const job = jobs.add('anonymize', { days: ageDays }, keyRangeSteps([
+    {
+      maxKey: 'SELECT MAX(rowid) FROM users',
+      batch: (from, to, done) => rideStore.persist(
+        `UPDATE users 
+         SET name = 'ANONYMIZED', 
+             phoneNumber = NULL 
+         WHERE rowid > ? AND rowid <= ? AND createdAt < ? AND name IS NOT 'ANONYMIZED'`,
+        [from, to, cutoff],
+        counted('usersAnonymized', done)
+      )
+    },
+    {
+      maxKey: 'SELECT MAX(rideID) FROM rides',
+      batch: (from, to, done) => rideStore.persist(
         `UPDATE rides 
          SET userID = 'ANON_' || substr(userID, -4)
-         WHERE requestTime < ? AND userID NOT LIKE 'ANON_%'`,
-        [cutoffDate.toISOString()],
-        function(err) {
-          if (err) {
-            return res.status(500).json({ error: err.message });
-          }
-          
-          const ridesAnonymized = this.changes;
-          
-          console.log(`✓ Anonymized ${usersAnonymized} users, ${ridesAnonymized} rides`);
-          
-          res.json({ 
-            success: true, 
-            usersAnonymized,
-            ridesAnonymized
-          });
-        }
-      );
+         WHERE rideID > ? AND rideID <= ? AND requestTime < ? AND userID NOT LIKE 'ANON_%'`,
+        [from, to, cutoff],
+        counted('ridesAnonymized', done)
+      )
     }
-  );
+  ]), result);
+  
+  jobQueued(res, job);
 });
 
 // ========== START SERVER ==========
 const PORT = process.env.PORT || 3000;
-app.listen(PORT, () => {
+const server = app.listen(PORT, () => {
   console.log('\n╔════════════════════════════════════════════╗');
   console.log('║   AERAS Backend Server - FIXED VERSION    ║');
   console.log('╠════════════════════════════════════════════╣');
@@ -887,4 +1952,15 @@ app.listen(PORT, () => {
   console.log('║   ✓ TC11: Point management                ║');
   console.log('║   ✓ TC12: Database design                 ║');
   console.log('╚════════════════════════════════════════════╝\n');
-});
\ No newline at end of file
+});
+
+// Write-behind: commit the queued ride writes before exiting
+['SIGINT', 'SIGTERM'].forEach(signal => process.on(signal, () => {
+  console.log(`\n🛑 ${signal}: writing ${rideStore.pendingWrites()} queued changes`);
+  rideStore.drain(() => db.close(() => process.exit(0)));
+}));
+
+// Devices keep one socket open and reuse it every few seconds; Node's 5s
+// default would close it between polls and force a new handshake each time
+server.keepAliveTimeout = 65000;
+server.headersTimeout = 66000;
\ No newline at end of file
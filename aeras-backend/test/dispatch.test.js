@@ -0,0 +1,162 @@
+// AERAS - Dispatch index checks (`npm test`)
+// assignMinCost() against brute force, ties by key, and the native index
+// against the JS one when it has been built.
+const test = require('node:test');
+const assert = require('node:assert');
+const { DispatchIndex, JsDispatchIndex, assignMinCost, haversineMeters, isNative } = require('../lib/dispatch');
+
+// Small deterministic PRNG so a failure reproduces
+function random(seed) {
+  let state = seed >>> 0;
+  return () => {
+    state = (state * 1664525 + 1013904223) >>> 0;
+    return state / 4294967296;
+  };
+}
+
+// Best over every assignment: most pairs within maxCost, then least cost
+function bruteForce(costs, rows, cols, maxCost) {
+  let best = { matched: -1, total: Infinity };
+  const usedCols = new Array(cols).fill(false);
+  const walk = (row, matched, total) => {
+    if (row === rows) {
+      if (matched > best.matched || (matched === best.matched && total < best.total)) {
+        best = { matched, total };
+      }
+      return;
+    }
+    walk(row + 1, matched, total);  // Row left unmatched
+    for (let col = 0; col < cols; col++) {
+      if (usedCols[col] || costs[row][col] > maxCost) continue;
+      usedCols[col] = true;
+      walk(row + 1, matched + 1, total + costs[row][col]);
+      usedCols[col] = false;
+    }
+  };
+  walk(0, 0, 0);
+  return best;
+}
+
+function scoreOf(costs, rowToCol, cols, maxCost) {
+  const seen = new Set();
+  let matched = 0;
+  let total = 0;
+  rowToCol.forEach((col, row) => {
+    if (col < 0) return;
+    assert.ok(col < cols, `row ${row} got column ${col} of ${cols}`);
+    assert.ok(!seen.has(col), `column ${col} assigned twice`);
+    assert.ok(costs[row][col] <= maxCost, `row ${row} matched over maxCost`);
+    seen.add(col);
+    matched++;
+    total += costs[row][col];
+  });
+  return { matched, total };
+}
+
+test('assignMinCost matches brute force on small matrices', () => {
+  const next = random(1);
+  for (let round = 0; round < 500; round++) {
+    const rows = Math.floor(next() * 6);
+    const cols = Math.floor(next() * 6);
+    const maxCost = 20 + Math.floor(next() * 80);
+    // Integer costs, some over maxCost, many equal
+    const costs = Array.from({ length: rows }, () =>
+      Array.from({ length: cols }, () => Math.floor(next() * 120)));
+
+    const rowToCol = assignMinCost(costs, rows, cols, maxCost);
+    assert.strictEqual(rowToCol.length, rows);
+    const got = scoreOf(costs, rowToCol, cols, maxCost);
+    const want = bruteForce(costs, rows, cols, maxCost);
+    assert.deepStrictEqual(got, want, `round ${round}: ${JSON.stringify({ costs, maxCost })}`);
+  }
+});
+
+function tieChecks(Index) {
+  const index = new Index();
+  [42, 7, 19, 3].forEach(rideID => index.upsertRide(rideID, 23.8103, 90.4125));
+  index.upsertRide(5, 23.8200, 90.4125);
+  assert.deepStrictEqual(index.nearestRides(23.8103, 90.4125, 5).map(hit => hit.rideID),
+                         [3, 7, 19, 42, 5]);
+
+  ['rk-9', 'rk-10', 'rk-2'].forEach(id => index.upsertRickshaw(id, 23.8103, 90.4125));
+  assert.deepStrictEqual(index.nearestRickshaws(23.8103, 90.4125).map(hit => hit.rickshawID),
+                         ['rk-10', 'rk-2', 'rk-9']);
+}
+
+test('equal distances are ordered by key (JS)', () => tieChecks(JsDispatchIndex));
+test('equal distances are ordered by key (native)', { skip: !isNative && 'addon not built' },
+     () => tieChecks(DispatchIndex));
+
+function sameHits(got, want, keyName, context) {
+  assert.deepStrictEqual(got.map(hit => hit[keyName]), want.map(hit => hit[keyName]), context);
+  got.forEach((hit, i) => assert.ok(Math.abs(hit.meters - want[i].meters) < 1e-6, context));
+}
+
+test('native index answers as the JS one', { skip: !isNative && 'addon not built' }, () => {
+  const next = random(2);
+  for (let round = 0; round < 50; round++) {
+    const js = new JsDispatchIndex();
+    const native = new DispatchIndex();
+    // Within ~3 km of the city centre, snapped so some points coincide
+    const point = () => [23.80 + Math.round(next() * 300) / 10000,
+                         90.40 + Math.round(next() * 300) / 10000];
+
+    const rides = 1 + Math.floor(next() * 40);
+    for (let rideID = 1; rideID <= rides; rideID++) {
+      const [lat, lng] = point();
+      js.upsertRide(rideID, lat, lng);
+      native.upsertRide(rideID, lat, lng);
+    }
+    const rickshawIDs = [];
+    for (let i = 0; i < 1 + Math.floor(next() * 8); i++) {
+      const [lat, lng] = point();
+      rickshawIDs.push(`rk-${i}`);
+      js.upsertRickshaw(`rk-${i}`, lat, lng);
+      native.upsertRickshaw(`rk-${i}`, lat, lng);
+    }
+
+    const context = `round ${round}`;
+    for (let q = 0; q < 10; q++) {
+      const [lat, lng] = point();
+      const k = Math.floor(next() * 12);
+      sameHits(native.nearestRides(lat, lng, k), js.nearestRides(lat, lng, k), 'rideID', context);
+      sameHits(native.nearestRickshaws(lat, lng), js.nearestRickshaws(lat, lng), 'rickshawID', context);
+    }
+
+    const options = { maxMeters: 500 + Math.floor(next() * 2500), candidates: 1 + Math.floor(next() * 8) };
+    const got = native.assignRides(rickshawIDs, options);
+    const want = js.assignRides(rickshawIDs, options);
+    assert.deepStrictEqual(got.map(m => [m.rickshawID, m.rideID]),
+                           want.map(m => [m.rickshawID, m.rideID]), context);
+  }
+});
+
+test('clearRides keeps the cell size', { skip: !isNative && 'addon not built' }, () => {
+  const next = random(3);
+  const index = new DispatchIndex({ cellMeters: 120 });
+  const fill = () => {
+    const rides = new Map();
+    for (let rideID = 1; rideID <= 60; rideID++) {
+      const point = { lat: 23.80 + next() * 0.03, lng: 90.40 + next() * 0.03 };
+      rides.set(rideID, point);
+      index.upsertRide(rideID, point.lat, point.lng);
+    }
+    return rides;
+  };
+
+  fill();
+  index.clearRides();
+  assert.strictEqual(index.stats().rides, 0);
+  assert.strictEqual(index.stats().cellMeters, 120);
+
+  const rides = fill();
+  for (let q = 0; q < 20; q++) {
+    const lat = 23.80 + next() * 0.03;
+    const lng = 90.40 + next() * 0.03;
+    const want = [...rides]
+      .map(([rideID, point]) => ({ rideID, meters: haversineMeters(lat, lng, point.lat, point.lng) }))
+      .sort((a, b) => a.meters - b.meters || a.rideID - b.rideID)
+      .slice(0, 7);
+    sameHits(index.nearestRides(lat, lng, 7), want, 'rideID', `query ${q}`);
+  }
+});
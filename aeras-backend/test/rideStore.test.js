@@ -0,0 +1,136 @@
+// AERAS - Ride store checks (`npm test`)
+// Compare-and-set transitions, write-behind batches and what the store
+// keeps, against a stand-in for the sqlite3 Database so no file is touched.
+const test = require('node:test');
+const assert = require('node:assert');
+const { RideStore } = require('../lib/rideStore');
+
+// Runs statements in order, a tick apart, as sqlite3 does under
+// serialize(); failCommits makes that many COMMITs fail first
+class FakeDb {
+  constructor({ failCommits = 0 } = {}) {
+    this.failCommits = failCommits;
+    this.log = [];
+    this.chain = Promise.resolve();
+  }
+
+  serialize(run) {
+    run();
+  }
+
+  run(sql, params, callback) {
+    if (typeof params === 'function') {
+      callback = params;
+      params = [];
+    }
+    this.chain = this.chain.then(() => new Promise(resolve => setImmediate(() => {
+      let err = null;
+      if (sql === 'COMMIT' && this.failCommits > 0) {
+        this.failCommits--;
+        err = new Error('SQLITE_BUSY: database is locked');
+      }
+      this.log.push(err ? `${sql} (failed)` : sql);
+      if (callback) callback.call({ changes: err ? 0 : 1 }, err);
+      resolve();
+    })));
+  }
+}
+
+const quietly = (run) => {
+  const error = console.error;
+  console.error = () => {};
+  return Promise.resolve(run()).finally(() => { console.error = error; });
+};
+
+const drained = store => new Promise(resolve => store.drain(resolve));
+
+function pendingRide(rideID, pickupBlock = 'CUET_CAMPUS') {
+  return { rideID, status: 'PENDING', pickupBlock, destination: 'PAHARTOLI', rickshawID: null };
+}
+
+test('of two racing transitions on one ride exactly one wins', async () => {
+  const db = new FakeDb();
+  const store = new RideStore(db, { flushMs: 1 });
+  store.add(pendingRide(1));
+
+  // Two accepts arriving together, as two requests in one tick
+  const accept = rickshawID => Promise.resolve().then(() =>
+    store.transition(1, ['PENDING'], { status: 'ACCEPTED', rickshawID, acceptTime: RideStore.NOW }));
+  const results = await Promise.all([accept('RK1'), accept('RK2')]);
+
+  assert.strictEqual(results.filter(Boolean).length, 1);
+  assert.strictEqual(store.get(1).rickshawID, 'RK1');
+  assert.strictEqual(store.get(1).status, 'ACCEPTED');
+  assert.strictEqual(store.version(1), 2);
+  assert.strictEqual(store.pendingWrites(), 1);
+
+  await drained(store);
+  assert.deepStrictEqual(db.log.filter(sql => sql.startsWith('UPDATE')),
+                         ['UPDATE rides SET status = ?, rickshawID = ?, acceptTime = ? WHERE rideID = ?']);
+});
+
+test('a failed COMMIT re-queues the batch', async () => {
+  const db = new FakeDb({ failCommits: 1 });
+  const store = new RideStore(db, { flushMs: 1 });
+  store.add(pendingRide(1));
+
+  const committed = [];
+  store.persist('UPDATE rickshaws SET status = "ON_RIDE" WHERE rickshawID = ?', ['RK1'],
+                err => committed.push(err));
+  await quietly(() => drained(store));
+
+  assert.deepStrictEqual(db.log, [
+    'BEGIN TRANSACTION', 'UPDATE rickshaws SET status = "ON_RIDE" WHERE rickshawID = ?',
+    'COMMIT (failed)', 'ROLLBACK',
+    'BEGIN TRANSACTION', 'UPDATE rickshaws SET status = "ON_RIDE" WHERE rickshawID = ?', 'COMMIT'
+  ]);
+  assert.deepStrictEqual(committed, [null]);  // Told once, after the retry committed
+  assert.strictEqual(store.pendingWrites(), 0);
+});
+
+test('retire() keeps only the newest ride per block', async () => {
+  const store = new RideStore(new FakeDb(), { flushMs: 1 });
+  store.add(pendingRide(1));
+  store.transition(1, ['PENDING'], { status: 'COMPLETED' });
+  await drained(store);
+  assert.ok(store.get(1), 'a finished ride is kept while it is the latest at its block');
+
+  store.add(pendingRide(2));
+  assert.strictEqual(store.get(1), null);
+  assert.strictEqual(store.version(1), 0);
+  assert.strictEqual(store.latestAtBlock('CUET_CAMPUS').rideID, 2);
+
+  // Active rides stay whatever is newer, until they finish
+  store.add(pendingRide(3));
+  assert.ok(store.get(2));
+  store.transition(2, ['PENDING'], { status: 'CANCELLED' });
+  assert.ok(store.get(2), 'kept until its UPDATE is written');
+  await drained(store);
+  assert.strictEqual(store.get(2), null);
+  assert.strictEqual(store.latestAtBlock('CUET_CAMPUS').rideID, 3);
+
+  // Other blocks keep their own latest
+  store.add(pendingRide(4, 'NOAPARA'));
+  store.transition(4, ['PENDING'], { status: 'TIMEOUT' });
+  await drained(store);
+  assert.strictEqual(store.latestAtBlock('NOAPARA').rideID, 4);
+});
+
+test('drain() waits for the queued writes to be committed', async () => {
+  const db = new FakeDb({ failCommits: 1 });
+  const store = new RideStore(db, { flushMs: 1 });
+  store.add(pendingRide(1));
+
+  const events = [];
+  store.transition(1, ['PENDING'], { status: 'ACCEPTED', rickshawID: 'RK1' });
+  store.persist('UPDATE rickshaws SET status = "ON_RIDE" WHERE rickshawID = ?', ['RK1'],
+                () => events.push('written'));
+  await quietly(() => drained(store).then(() => events.push('drained')));
+
+  assert.deepStrictEqual(events, ['written', 'drained']);
+  assert.strictEqual(db.log[db.log.length - 1], 'COMMIT');
+  assert.strictEqual(store.pendingWrites(), 0);
+
+  // Nothing queued: answers on the next flush
+  await drained(store);
+});
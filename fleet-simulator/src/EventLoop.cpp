@@ -0,0 +1,110 @@
+/*
+ * AERAS Fleet Simulator - Event loop
+ */
+
+#include "EventLoop.h"
+
+#include <sys/epoll.h>
+#include <unistd.h>
+#include <chrono>
+
+static const int MAX_EVENTS = 256;
+static const int MAX_WAIT_MS = 100;
+
+EventLoop::EventLoop() : epollFd(epoll_create1(EPOLL_CLOEXEC)), now(clockUs()) {}
+
+EventLoop::~EventLoop() {
+  if (epollFd >= 0) close(epollFd);
+}
+
+uint64_t EventLoop::clockUs() {
+  return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// ===== Timers =====
+uint64_t EventLoop::after(uint32_t ms, Callback callback) {
+  uint64_t id = nextTimerID++;
+  timers.push(Timer{clockUs() + ms * 1000ULL, id});
+  timerCallbacks.emplace(id, std::move(callback));
+  return id;
+}
+
+void EventLoop::cancel(uint64_t timerID) {
+  timerCallbacks.erase(timerID);
+}
+
+void EventLoop::every(uint32_t ms, Callback callback) {
+  after(ms, [this, ms, callback] {
+    callback();
+    every(ms, callback);
+  });
+}
+
+void EventLoop::runDueTimers() {
+  while (!timers.empty() && timers.top().dueUs <= now) {
+    uint64_t id = timers.top().id;
+    timers.pop();
+    auto found = timerCallbacks.find(id);
+    if (found == timerCallbacks.end()) continue;  // Cancelled
+    Callback callback = std::move(found->second);
+    timerCallbacks.erase(found);
+    callback();
+  }
+}
+
+// ===== Sockets =====
+// Events carry the fd plus a per-watch generation: a callback may close a
+// socket and a later one reopen the same fd number within one batch, and
+// the old socket's events must not reach the new one
+bool EventLoop::watch(int fd, uint32_t events, IoCallback callback) {
+  epoll_event event = {};
+  event.events = events;
+  event.data.u64 = (nextWatchGeneration++ << 32) | (uint32_t)fd;
+  if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) != 0) return false;
+  watchers[fd] = Watcher{event.data.u64, std::move(callback)};
+  return true;
+}
+
+void EventLoop::modify(int fd, uint32_t events) {
+  auto found = watchers.find(fd);
+  if (found == watchers.end()) return;
+  epoll_event event = {};
+  event.events = events;
+  event.data.u64 = found->second.token;
+  epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &event);
+}
+
+void EventLoop::unwatch(int fd) {
+  epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+  watchers.erase(fd);
+}
+
+// ===== Loop =====
+void EventLoop::run(uint64_t untilMs) {
+  epoll_event events[MAX_EVENTS];
+  stopped = false;
+
+  while (!stopped) {
+    now = clockUs();
+    if (nowMs() >= untilMs) break;
+    runDueTimers();
+
+    int waitMs = MAX_WAIT_MS;
+    if (!timers.empty()) {
+      uint64_t untilDue = timers.top().dueUs > now ? (timers.top().dueUs - now + 999) / 1000 : 0;
+      if (untilDue < (uint64_t)waitMs) waitMs = (int)untilDue;
+    }
+
+    int ready = epoll_wait(epollFd, events, MAX_EVENTS, waitMs);
+    now = clockUs();
+    for (int i = 0; i < ready; i++) {
+      uint64_t token = events[i].data.u64;
+      auto found = watchers.find((int)(uint32_t)token);
+      if (found == watchers.end() || found->second.token != token) continue;
+      // Copy: the callback may unwatch (and erase) itself
+      IoCallback callback = found->second.callback;
+      callback(events[i].events);
+    }
+  }
+}
@@ -0,0 +1,68 @@
+/*
+ * AERAS Fleet Simulator - Event loop
+ * One thread drives every virtual device: sockets are watched with epoll,
+ * timers sit in a min-heap ordered by due time. Callbacks run to
+ * completion and must not block.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <functional>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+
+class EventLoop {
+ public:
+  typedef std::function<void()> Callback;
+  typedef std::function<void(uint32_t events)> IoCallback;  // EPOLLIN/EPOLLOUT/EPOLLERR...
+
+  EventLoop();
+  ~EventLoop();
+
+  // Monotonic, updated once per loop pass (cheap to call from callbacks)
+  uint64_t nowMs() const { return now / 1000; }
+  uint64_t nowUs() const { return now; }
+  // Fresh clock reading, for latency measurements
+  static uint64_t clockUs();
+
+  // One-shot; the id can be passed to cancel() until the timer fired
+  uint64_t after(uint32_t ms, Callback callback);
+  void cancel(uint64_t timerID);
+  // Repeats for the rest of the run, first after ms (devices never stop)
+  void every(uint32_t ms, Callback callback);
+
+  bool watch(int fd, uint32_t events, IoCallback callback);
+  void modify(int fd, uint32_t events);
+  void unwatch(int fd);
+
+  // Runs until stop() or until nowMs() reaches untilMs
+  void run(uint64_t untilMs);
+  void stop() { stopped = true; }
+
+ private:
+  struct Timer {
+    uint64_t dueUs;
+    uint64_t id;
+    bool operator>(const Timer& other) const {
+      return dueUs != other.dueUs ? dueUs > other.dueUs : id > other.id;
+    }
+  };
+
+  struct Watcher {
+    uint64_t token;  // epoll_event data: generation << 32 | fd
+    IoCallback callback;
+  };
+
+  void runDueTimers();
+
+  int epollFd;
+  uint64_t now = 0;
+  bool stopped = false;
+  uint64_t nextTimerID = 1;
+  std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers;
+  std::unordered_map<uint64_t, Callback> timerCallbacks;  // Cancelled timers are erased here
+  uint64_t nextWatchGeneration = 1;
+  std::unordered_map<int, Watcher> watchers;
+};
@@ -0,0 +1,66 @@
+/*
+ * AERAS Fleet Simulator - Run configuration and shared state
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <random>
+#include <string>
+
+#include <BlockTable.h>
+
+#include "EventLoop.h"
+#include "HttpConnection.h"
+#include "LatencyStats.h"
+
+struct FleetConfig {
+  std::string url = "http://localhost:3000/api";
+  uint32_t rickshaws = 100;
+  uint32_t kiosks = 20;
+  uint32_t durationS = 120;
+  uint32_t rampS = 10;              // Device starts are spread over this
+  uint32_t reportS = 10;            // Periodic report; 0 = summary only
+  float speedKmh = 15.0f;           // Rickshaw speed, as speedKmPerHour on the device
+  uint32_t kioskIntervalS = 60;     // Mean time between riders at one kiosk
+  uint32_t acceptDelayMs = 2000;    // Puller reading an offer before ACCEPT
+  bool push = false;                // Hold /events open; poll only while it is down
+  uint32_t seed = 1;
+};
+
+// Ride outcomes as the devices saw them
+struct FleetCounters {
+  uint64_t requested = 0;       // Kiosk got a rideID
+  uint64_t requestFailed = 0;
+  uint64_t acceptedSeen = 0;    // Kiosk saw ACCEPTED
+  uint64_t completedSeen = 0;   // Kiosk saw COMPLETED
+  uint64_t kioskTimeouts = 0;   // No rickshaw within REQUEST_TIMEOUT
+  uint64_t offers = 0;          // Rickshaw shown an offer
+  uint64_t accepts = 0;         // ACCEPT won
+  uint64_t lostRaces = 0;       // ACCEPT answered success:false
+  uint64_t completes = 0;       // COMPLETE answered success:true
+  uint64_t points = 0;
+};
+
+struct Fleet {
+  const FleetConfig& config;
+  EventLoop& loop;
+  const Backend& backend;
+  LatencyStats& stats;
+  const BlockTable& blocks;
+  std::mt19937 random;
+  FleetCounters counters;
+
+  Fleet(const FleetConfig& config, EventLoop& loop, const Backend& backend, LatencyStats& stats,
+        const BlockTable& blocks)
+      : config(config), loop(loop), backend(backend), stats(stats), blocks(blocks),
+        random(config.seed) {}
+
+  // Uniform in [low, high)
+  double uniform(double low, double high) {
+    return std::uniform_real_distribution<double>(low, high)(random);
+  }
+  const BlockInfo& randomBlock() {
+    return blocks.at(std::uniform_int_distribution<int>(0, blocks.size() - 1)(random));
+  }
+};
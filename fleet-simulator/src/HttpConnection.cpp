@@ -0,0 +1,272 @@
+/*
+ * AERAS Fleet Simulator - Non-blocking keep-alive HTTP/1.1 connection
+ */
+
+#include "HttpConnection.h"
+
+#include <errno.h>
+#include <netinet/tcp.h>
+#include <strings.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// ===== Requests =====
+void HttpConnection::request(HttpRequest request) {
+  queue.push_back(std::move(request));
+  if (!active) startNext();
+}
+
+void HttpConnection::startNext() {
+  if (queue.empty()) return;
+  HttpRequest& next = queue.front();
+  active = true;
+  retried = false;
+
+  output.clear();
+  output.reserve(256 + next.body.size());
+  output += next.method + " " + backend.basePath + next.path + " HTTP/1.1\r\n";
+  output += "Host: " + backend.host + "\r\nConnection: keep-alive\r\n";
+  if (accept) output += std::string("Accept: ") + accept + "\r\n";
+  output += next.headers;
+  if (!next.body.empty()) {
+    output += "Content-Type: " + next.contentType + "\r\n";
+    output += "Content-Length: " + std::to_string(next.body.size()) + "\r\n";
+  }
+  output += "\r\n";
+  output += next.body;
+  outputSent = 0;
+
+  startedUs = EventLoop::clockUs();
+  timeoutTimer = loop.after(next.timeoutMs, [this] {
+    timeoutTimer = 0;
+    fail(HTTP_SESSION_ERR_TIMEOUT);
+  });
+
+  if (fd < 0) {
+    if (!openSocket()) fail(HTTP_SESSION_ERR_CONNECT);
+  } else {
+    flushOutput();
+  }
+}
+
+void HttpConnection::close() {
+  if (timeoutTimer) loop.cancel(timeoutTimer);
+  timeoutTimer = 0;
+  queue.clear();
+  active = false;
+  closeSocket();
+}
+
+// ===== Socket =====
+bool HttpConnection::openSocket() {
+  fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (fd < 0) return false;
+  int one = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+  responsesOnSocket = 0;
+  connecting = true;
+  if (connect(fd, (const sockaddr*)&backend.address, sizeof(backend.address)) != 0 &&
+      errno != EINPROGRESS) {
+    closeSocket();
+    return false;
+  }
+  watchedEvents = EPOLLIN | EPOLLOUT;
+  if (!loop.watch(fd, watchedEvents, [this](uint32_t events) { onSocketEvent(events); })) {
+    closeSocket();
+    return false;
+  }
+  return true;
+}
+
+void HttpConnection::closeSocket() {
+  if (fd < 0) return;
+  loop.unwatch(fd);
+  ::close(fd);
+  fd = -1;
+  connecting = false;
+  input.clear();
+  headParsed = false;
+}
+
+void HttpConnection::onSocketEvent(uint32_t events) {
+  if (connecting) {
+    if (!(events & (EPOLLOUT | EPOLLERR | EPOLLHUP))) return;
+    int error = 0;
+    socklen_t length = sizeof(error);
+    getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &length);
+    if (error != 0) {
+      closeSocket();
+      if (active) fail(HTTP_SESSION_ERR_CONNECT);
+      return;
+    }
+    connecting = false;
+    if (active) flushOutput();
+    return;
+  }
+
+  if (events & (EPOLLIN | EPOLLHUP | EPOLLERR)) readInput();
+  if (fd >= 0 && (events & EPOLLOUT) && active && outputSent < output.size()) flushOutput();
+}
+
+void HttpConnection::flushOutput() {
+  while (outputSent < output.size()) {
+    ssize_t sent = send(fd, output.data() + outputSent, output.size() - outputSent, MSG_NOSIGNAL);
+    if (sent > 0) {
+      outputSent += sent;
+      continue;
+    }
+    if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      if (!(watchedEvents & EPOLLOUT)) loop.modify(fd, watchedEvents = EPOLLIN | EPOLLOUT);
+      return;
+    }
+    fail(HTTP_SESSION_ERR_SEND);
+    return;
+  }
+  if (watchedEvents & EPOLLOUT) loop.modify(fd, watchedEvents = EPOLLIN);
+}
+
+void HttpConnection::readInput() {
+  char buffer[4096];
+  while (fd >= 0) {
+    ssize_t received = recv(fd, buffer, sizeof(buffer), 0);
+    if (received > 0) {
+      if (active) input.append(buffer, received);
+      continue;
+    }
+    if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+
+    // Closed by the backend (or reset), possibly right after a whole answer
+    if (!active) {
+      closeSocket();
+      return;
+    }
+    int parsed = parseResponse();
+    if (parsed == PARSE_INCOMPLETE && headParsed && contentLength < 0 && !chunked) {
+      response.body = input.substr(bodyStart);
+      parsed = PARSE_DONE;
+    }
+    if (parsed == PARSE_DONE) {
+      closeAfter = true;
+      finish(response.status);
+    } else {
+      fail(parsed == PARSE_ERROR ? HTTP_SESSION_ERR_PROTOCOL : HTTP_SESSION_ERR_CONNECTION_LOST);
+    }
+    return;
+  }
+
+  if (!active) return;
+  int parsed = parseResponse();
+  if (parsed == PARSE_DONE) finish(response.status);
+  else if (parsed == PARSE_ERROR) fail(HTTP_SESSION_ERR_PROTOCOL);
+}
+
+// ===== Responses =====
+static bool startsWithNoCase(const std::string& line, const char* prefix) {
+  return strncasecmp(line.c_str(), prefix, strlen(prefix)) == 0;
+}
+
+static std::string headerValue(const std::string& line, size_t nameLength) {
+  size_t start = line.find_first_not_of(' ', nameLength);
+  return start == std::string::npos ? "" : line.substr(start);
+}
+
+int HttpConnection::parseResponse() {
+  if (!headParsed) {
+    size_t end = input.find("\r\n\r\n");
+    if (end == std::string::npos) return PARSE_INCOMPLETE;
+    if (input.compare(0, 7, "HTTP/1.") != 0 || input.size() < 12) return PARSE_ERROR;
+    response = HttpResponse();
+    response.status = atoi(input.c_str() + 9);
+    closeAfter = input[7] == '0';
+    chunked = false;
+    contentLength = -1;
+
+    size_t lineStart = input.find("\r\n") + 2;
+    while (lineStart < end) {
+      size_t lineEnd = input.find("\r\n", lineStart);
+      std::string line = input.substr(lineStart, lineEnd - lineStart);
+      if (startsWithNoCase(line, "Content-Length:")) {
+        contentLength = atol(line.c_str() + 15);
+      } else if (startsWithNoCase(line, "Content-Type:")) {
+        response.contentType = headerValue(line, 13);
+      } else if (startsWithNoCase(line, "ETag:")) {
+        response.etag = headerValue(line, 5);
+      } else if (startsWithNoCase(line, "Transfer-Encoding:")) {
+        chunked = line.find("chunked") != std::string::npos;
+      } else if (startsWithNoCase(line, "Connection:")) {
+        closeAfter = startsWithNoCase(headerValue(line, 11), "close");
+      }
+      lineStart = lineEnd + 2;
+    }
+
+    headParsed = true;
+    bodyStart = end + 4;
+    int status = response.status;
+    if (status == 204 || status == 304 || (status >= 100 && status < 200)) {
+      chunked = false;
+      contentLength = 0;
+    }
+  }
+
+  if (chunked) {
+    std::string body;
+    size_t position = bodyStart;
+    while (true) {
+      size_t lineEnd = input.find("\r\n", position);
+      if (lineEnd == std::string::npos) return PARSE_INCOMPLETE;
+      size_t size = strtoul(input.c_str() + position, nullptr, 16);
+      if (size == 0) {
+        // Last chunk, then (trailers and) an empty line
+        if (input.find("\r\n\r\n", lineEnd) == std::string::npos) return PARSE_INCOMPLETE;
+        response.body = std::move(body);
+        return PARSE_DONE;
+      }
+      if (input.size() < lineEnd + 2 + size + 2) return PARSE_INCOMPLETE;
+      body.append(input, lineEnd + 2, size);
+      position = lineEnd + 2 + size + 2;
+    }
+  }
+
+  if (contentLength < 0) return PARSE_INCOMPLETE;  // Until the backend closes
+  if (input.size() - bodyStart < (size_t)contentLength) return PARSE_INCOMPLETE;
+  response.body = input.substr(bodyStart, contentLength);
+  return PARSE_DONE;
+}
+
+void HttpConnection::fail(int status) {
+  // The backend may close an idle keep-alive socket just as it is reused
+  bool nothingRead = !headParsed && input.empty();
+  bool retryable = status == HTTP_SESSION_ERR_CONNECTION_LOST || status == HTTP_SESSION_ERR_SEND;
+  if (retryable && nothingRead && responsesOnSocket > 0 && !retried) {
+    retried = true;
+    closeSocket();
+    outputSent = 0;
+    if (openSocket()) return;
+    status = HTTP_SESSION_ERR_CONNECT;
+  }
+  response = HttpResponse();
+  response.status = status;
+  closeAfter = true;
+  finish(status);
+}
+
+void HttpConnection::finish(int status) {
+  if (timeoutTimer) loop.cancel(timeoutTimer);
+  timeoutTimer = 0;
+
+  HttpRequest done = std::move(queue.front());
+  queue.pop_front();
+  stats.record(done.label, EventLoop::clockUs() - startedUs, status);
+
+  if (status > 0) responsesOnSocket++;
+  if (closeAfter || status < 0) closeSocket();
+  input.clear();
+  headParsed = false;
+  closeAfter = false;
+  active = false;
+
+  if (done.done) done.done(response);
+  if (!active) startNext();
+}
@@ -0,0 +1,119 @@
+/*
+ * AERAS Fleet Simulator - Non-blocking keep-alive HTTP/1.1 connection
+ * The simulator's counterpart of HttpSession: one socket per session,
+ * requests queued and answered in order, one retry on a fresh socket when
+ * a reused keep-alive socket turns out to be dead. Every answer (or
+ * failure) is recorded in LatencyStats under the request's label.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <netinet/in.h>
+#include <deque>
+#include <functional>
+#include <string>
+
+#include <HttpErrors.h>  // HttpResponse::status on failure, as HttpSession's
+
+#include "EventLoop.h"
+#include "LatencyStats.h"
+
+struct Backend {
+  sockaddr_in address;
+  std::string host;       // Host header
+  std::string basePath;   // e.g. "/api"
+};
+
+struct HttpResponse {
+  int status;
+  std::string contentType;
+  std::string etag;
+  std::string body;
+
+  bool is(const char* mediaType) const { return contentType.compare(0, strlen(mediaType), mediaType) == 0; }
+};
+
+typedef std::function<void(const HttpResponse&)> ResponseCallback;
+
+struct HttpRequest {
+  const char* label;      // Stats key, e.g. "GET /ride/pending"
+  std::string method;
+  std::string path;       // Appended to Backend::basePath
+  std::string body;
+  std::string contentType;
+  std::string headers;    // Extra header lines, each ending in \r\n
+  uint32_t timeoutMs;
+  ResponseCallback done;  // May be empty (fire-and-forget)
+};
+
+// Replays a response body for the JSON parsers in BackendMessages.h
+class BodyStream : public Stream {
+ public:
+  explicit BodyStream(const std::string& body) : body(body) { setTimeout(0); }
+
+  int available() override { return int(body.size() - position); }
+  int read() override { return position < body.size() ? (uint8_t)body[position++] : -1; }
+  int peek() override { return position < body.size() ? (uint8_t)body[position] : -1; }
+  size_t write(uint8_t) override { return 0; }
+
+ private:
+  const std::string& body;
+  size_t position = 0;
+};
+
+class HttpConnection {
+ public:
+  HttpConnection(EventLoop& loop, const Backend& backend, LatencyStats& stats, const char* accept)
+      : loop(loop), backend(backend), stats(stats), accept(accept) {}
+  ~HttpConnection() { close(); }
+
+  HttpConnection(const HttpConnection&) = delete;
+  HttpConnection& operator=(const HttpConnection&) = delete;
+
+  void request(HttpRequest request);
+  size_t queued() const { return queue.size(); }
+  // Drops the request in flight (its callback never runs) and the queue,
+  // like HttpSession::close()
+  void close();
+
+ private:
+  void startNext();
+  bool openSocket();
+  void closeSocket();
+  void onSocketEvent(uint32_t events);
+  void flushOutput();
+  void readInput();
+  enum { PARSE_INCOMPLETE, PARSE_DONE, PARSE_ERROR };
+  int parseResponse();
+  void finish(int status);
+  void fail(int status);
+
+  EventLoop& loop;
+  const Backend& backend;
+  LatencyStats& stats;
+  const char* accept;
+
+  std::deque<HttpRequest> queue;  // front() is in flight while active
+  bool active = false;
+  bool retried = false;
+
+  int fd = -1;
+  bool connecting = false;
+  uint32_t watchedEvents = 0;
+  uint16_t responsesOnSocket = 0;
+  uint64_t startedUs = 0;
+  uint64_t timeoutTimer = 0;
+
+  std::string output;
+  size_t outputSent = 0;
+
+  // Response being read
+  std::string input;
+  bool headParsed = false;
+  bool chunked = false;
+  bool closeAfter = false;
+  long contentLength = -1;
+  size_t bodyStart = 0;
+  HttpResponse response;
+};
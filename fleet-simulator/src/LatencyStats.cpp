@@ -0,0 +1,90 @@
+/*
+ * AERAS Fleet Simulator - Per-endpoint latency and throughput
+ */
+
+#include "LatencyStats.h"
+
+#include <stdio.h>
+#include <algorithm>
+
+void LatencyStats::record(const char* label, uint64_t latencyUs, int status) {
+  Series& entry = series[label];
+  entry.latencies.push_back((uint32_t)std::min<uint64_t>(latencyUs, UINT32_MAX));
+
+  for (Counts* counts : {&entry.total, &entry.window}) {
+    counts->requests++;
+    if (status < 0) counts->failures++;
+    else if (status == 304) counts->notModified++;
+    else if (status >= 500) counts->serverErrors++;
+    else if (status >= 400) counts->clientErrors++;
+  }
+}
+
+LatencyStats::Counts& LatencyStats::Counts::operator+=(const Counts& other) {
+  requests += other.requests;
+  notModified += other.notModified;
+  clientErrors += other.clientErrors;
+  serverErrors += other.serverErrors;
+  failures += other.failures;
+  return *this;
+}
+
+// ===== Reports =====
+void LatencyStats::printHeader(const char* title, double seconds) {
+  printf("\n%s (%.0f s)\n", title, seconds);
+  printf("%-28s %9s %8s %8s %8s %8s %8s %7s %6s %6s %6s\n", "endpoint", "requests", "req/s",
+         "p50 ms", "p90 ms", "p99 ms", "max ms", "304", "4xx", "5xx", "fail");
+}
+
+static double percentileMs(const std::vector<uint32_t>& sorted, double fraction) {
+  size_t rank = (size_t)(fraction * (sorted.size() - 1) + 0.5);
+  return sorted[rank] / 1000.0;
+}
+
+// Sorts latencies in place
+void LatencyStats::printRow(const char* label, const Counts& counts,
+                            std::vector<uint32_t>& latencies, double seconds) {
+  if (latencies.empty()) return;
+  std::sort(latencies.begin(), latencies.end());
+  printf("%-28s %9llu %8.1f %8.1f %8.1f %8.1f %8.1f %7llu %6llu %6llu %6llu\n", label,
+         (unsigned long long)counts.requests, counts.requests / seconds,
+         percentileMs(latencies, 0.50), percentileMs(latencies, 0.90),
+         percentileMs(latencies, 0.99), latencies.back() / 1000.0,
+         (unsigned long long)counts.notModified, (unsigned long long)counts.clientErrors,
+         (unsigned long long)counts.serverErrors, (unsigned long long)counts.failures);
+}
+
+void LatencyStats::printWindow(double seconds) {
+  printHeader("Last window", seconds);
+  Counts all;
+  std::vector<uint32_t> allLatencies;
+  for (auto& item : series) {
+    Series& entry = item.second;
+    std::vector<uint32_t> window(entry.latencies.begin() + entry.windowStart, entry.latencies.end());
+    allLatencies.insert(allLatencies.end(), window.begin(), window.end());
+    all += entry.window;
+
+    printRow(item.first.c_str(), entry.window, window, seconds);
+    entry.window = Counts();
+    entry.windowStart = entry.latencies.size();
+  }
+  printRow("(all)", all, allLatencies, seconds);
+  fflush(stdout);
+}
+
+void LatencyStats::printSummary(double seconds) {
+  printHeader("Whole run", seconds);
+  Counts all;
+  std::vector<uint32_t> allLatencies;
+  for (auto& item : series) {
+    Series& entry = item.second;
+    allLatencies.insert(allLatencies.end(), entry.latencies.begin(), entry.latencies.end());
+    all += entry.total;
+
+    // A sorted copy: the window offsets still index arrival order
+    std::vector<uint32_t> latencies = entry.latencies;
+    printRow(item.first.c_str(), entry.total, latencies, seconds);
+  }
+  printRow("(all)", all, allLatencies, seconds);
+  fflush(stdout);
+}
@@ -0,0 +1,49 @@
+/*
+ * AERAS Fleet Simulator - Per-endpoint latency and throughput
+ * Every answered (or failed) request is recorded under its label. The
+ * periodic report covers the requests since the previous one, the summary
+ * the whole run. Latency is from the request being started on its
+ * connection to the last byte of the answer, so it includes the backend's
+ * queueing but not the simulator's own (HttpConnection::queued()).
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <map>
+#include <string>
+#include <vector>
+
+class LatencyStats {
+ public:
+  // status: HTTP code, or HTTP_SESSION_ERR_* when no answer came
+  void record(const char* label, uint64_t latencyUs, int status);
+
+  // Rows for the requests since the previous call, over that many seconds
+  void printWindow(double seconds);
+  void printSummary(double seconds);
+
+ private:
+  struct Counts {
+    uint64_t requests = 0;
+    uint64_t notModified = 0;   // 304
+    uint64_t clientErrors = 0;  // 4xx
+    uint64_t serverErrors = 0;  // 5xx
+    uint64_t failures = 0;      // No answer: connect/send/timeout/protocol
+
+    Counts& operator+=(const Counts& other);
+  };
+
+  struct Series {
+    Counts total;
+    Counts window;
+    std::vector<uint32_t> latencies;  // us, whole run
+    size_t windowStart = 0;           // First entry of the current window
+  };
+
+  static void printHeader(const char* title, double seconds);
+  static void printRow(const char* label, const Counts& counts, std::vector<uint32_t>& latencies,
+                       double seconds);
+
+  std::map<std::string, Series> series;  // Ordered by label for the reports
+};
@@ -0,0 +1,243 @@
+/*
+ * AERAS Fleet Simulator - Server-Sent Events subscription
+ */
+
+#include "PushStream.h"
+
+#include <errno.h>
+#include <netinet/tcp.h>
+#include <strings.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static const char* const SUBSCRIBE_LABEL = "GET /events";
+
+// ===== Subscription =====
+void PushStream::open(const std::string& path, EventCallback eventCallback, StateCallback stateCallback) {
+  if (fd >= 0) return;
+  onEvent = std::move(eventCallback);
+  onState = std::move(stateCallback);
+  startedUs = EventLoop::clockUs();
+
+  fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    fail(HTTP_SESSION_ERR_CONNECT);
+    return;
+  }
+  int one = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+  output = "GET " + backend.basePath + path + " HTTP/1.1\r\n";
+  output += "Host: " + backend.host + "\r\nAccept: text/event-stream\r\nConnection: keep-alive\r\n\r\n";
+  outputSent = 0;
+  connecting = true;
+  if ((connect(fd, (const sockaddr*)&backend.address, sizeof(backend.address)) != 0 &&
+       errno != EINPROGRESS) ||
+      !loop.watch(fd, EPOLLIN | EPOLLOUT, [this](uint32_t events) { onSocketEvent(events); })) {
+    fail(HTTP_SESSION_ERR_CONNECT);
+    return;
+  }
+  armIdleTimer();
+}
+
+void PushStream::close() {
+  if (idleTimer) loop.cancel(idleTimer);
+  idleTimer = 0;
+  if (fd >= 0) {
+    loop.unwatch(fd);
+    ::close(fd);
+  }
+  fd = -1;
+  generation++;
+  connecting = false;
+  opened = false;
+  input.clear();
+  chunked = false;
+  chunkLeft = 0;
+  chunkTrailer = false;
+  text.clear();
+  eventName.clear();
+  eventData.clear();
+}
+
+// Before the answer: the subscription failed. After it: the stream dropped.
+void PushStream::fail(int status) {
+  bool wasOpen = opened;
+  if (!wasOpen) stats.record(SUBSCRIBE_LABEL, EventLoop::clockUs() - startedUs, status);
+  close();
+  if (wasOpen && onState) {
+    StateCallback callback = onState;
+    callback(false);
+  }
+}
+
+void PushStream::armIdleTimer() {
+  if (idleTimer) loop.cancel(idleTimer);
+  idleTimer = loop.after(idleTimeoutMs, [this] {
+    idleTimer = 0;
+    fail(HTTP_SESSION_ERR_TIMEOUT);
+  });
+}
+
+// ===== Socket =====
+void PushStream::onSocketEvent(uint32_t events) {
+  if (connecting) {
+    if (!(events & (EPOLLOUT | EPOLLERR | EPOLLHUP))) return;
+    int error = 0;
+    socklen_t length = sizeof(error);
+    getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &length);
+    if (error != 0) {
+      fail(HTTP_SESSION_ERR_CONNECT);
+      return;
+    }
+    connecting = false;
+    flushOutput();
+    return;
+  }
+
+  if (events & (EPOLLIN | EPOLLHUP | EPOLLERR)) readInput();
+  if (fd >= 0 && (events & EPOLLOUT) && outputSent < output.size()) flushOutput();
+}
+
+void PushStream::flushOutput() {
+  while (outputSent < output.size()) {
+    ssize_t sent = send(fd, output.data() + outputSent, output.size() - outputSent, MSG_NOSIGNAL);
+    if (sent > 0) {
+      outputSent += sent;
+      continue;
+    }
+    if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;  // Still watching EPOLLOUT
+    fail(HTTP_SESSION_ERR_SEND);
+    return;
+  }
+  loop.modify(fd, EPOLLIN);
+}
+
+void PushStream::readInput() {
+  char buffer[4096];
+  bool ended = false;
+  while (true) {
+    ssize_t received = recv(fd, buffer, sizeof(buffer), 0);
+    if (received > 0) {
+      input.append(buffer, received);
+      continue;
+    }
+    if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+    ended = true;  // Closed by the backend (or reset)
+    break;
+  }
+
+  if (!opened) {
+    size_t end = input.find("\r\n\r\n");
+    if (end == std::string::npos) {
+      if (ended) fail(HTTP_SESSION_ERR_CONNECTION_LOST);
+      return;
+    }
+    if (!parseHead(end)) return;
+  }
+  if (input.empty() && !ended) return;
+
+  armIdleTimer();
+  if (!takeBody()) ended = true;  // Last chunk: the backend ended the stream
+  if (!takeLines()) return;       // Closed from a callback
+  if (ended) fail(HTTP_SESSION_ERR_CONNECTION_LOST);
+}
+
+// ===== Stream =====
+static bool startsWithNoCase(const std::string& text, size_t at, const char* prefix) {
+  return strncasecmp(text.c_str() + at, prefix, strlen(prefix)) == 0;
+}
+
+// The answer to GET /events; anything but a 200 ends the subscription.
+// False when the stream is closed.
+bool PushStream::parseHead(size_t end) {
+  int status = input.compare(0, 7, "HTTP/1.") == 0 && end >= 12 ? atoi(input.c_str() + 9)
+                                                                 : HTTP_SESSION_ERR_PROTOCOL;
+  stats.record(SUBSCRIBE_LABEL, EventLoop::clockUs() - startedUs, status);
+  if (status != 200) {
+    close();
+    return false;
+  }
+
+  size_t lineStart = input.find("\r\n") + 2;
+  while (lineStart < end) {
+    size_t lineEnd = input.find("\r\n", lineStart);
+    if (startsWithNoCase(input, lineStart, "Transfer-Encoding:")) {
+      chunked = input.substr(lineStart, lineEnd - lineStart).find("chunked") != std::string::npos;
+    }
+    lineStart = lineEnd + 2;
+  }
+  input.erase(0, end + 4);
+  opened = true;
+  if (onState) {
+    uint32_t current = generation;
+    StateCallback callback = onState;
+    callback(true);
+    if (generation != current) return false;
+  }
+  return true;
+}
+
+// Moves the body bytes received so far into text; false at the last chunk
+bool PushStream::takeBody() {
+  if (!chunked) {
+    text += input;
+    input.clear();
+    return true;
+  }
+  while (true) {
+    if (chunkTrailer) {
+      if (input.size() < 2) return true;
+      input.erase(0, 2);
+      chunkTrailer = false;
+    }
+    if (chunkLeft == 0) {
+      size_t lineEnd = input.find("\r\n");
+      if (lineEnd == std::string::npos) return true;
+      chunkLeft = strtoul(input.c_str(), nullptr, 16);
+      input.erase(0, lineEnd + 2);
+      if (chunkLeft == 0) return false;
+    }
+    size_t take = std::min(chunkLeft, input.size());
+    if (take == 0) return true;
+    text.append(input, 0, take);
+    input.erase(0, take);
+    chunkLeft -= take;
+    if (chunkLeft == 0) chunkTrailer = true;
+  }
+}
+
+static std::string fieldValue(const std::string& line, size_t nameLength) {
+  size_t start = nameLength < line.size() && line[nameLength] == ' ' ? nameLength + 1 : nameLength;
+  return line.substr(start);
+}
+
+// Hands out every event whose closing blank line arrived; "retry:" and
+// ": ping" comment lines are skipped. False when a callback closed the stream.
+bool PushStream::takeLines() {
+  uint32_t current = generation;
+  size_t lineEnd;
+  while ((lineEnd = text.find('\n')) != std::string::npos) {
+    std::string line = text.substr(0, lineEnd);
+    text.erase(0, lineEnd + 1);
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+
+    if (line.compare(0, 6, "event:") == 0) {
+      eventName = fieldValue(line, 6);
+    } else if (line.compare(0, 5, "data:") == 0) {
+      if (!eventData.empty()) eventData += '\n';
+      eventData += fieldValue(line, 5);
+    } else if (line.empty()) {
+      std::string name = eventName.empty() ? "message" : eventName;
+      std::string data = std::move(eventData);
+      eventName.clear();
+      eventData.clear();
+      if (data.empty() || !onEvent) continue;
+      EventCallback callback = onEvent;
+      callback(name, data);
+      if (generation != current) return false;
+    }
+  }
+  return true;
+}
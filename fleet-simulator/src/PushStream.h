@@ -0,0 +1,74 @@
+/*
+ * AERAS Fleet Simulator - Server-Sent Events subscription
+ * The simulator's counterpart of EventStream: holds GET /events open on
+ * its own socket and hands out each pushed event (event: <name> /
+ * data: <json>) as it completes. A stream that stayed silent past the
+ * idle timeout (the backend pings every 15 s) counts as dropped, as on
+ * the devices. The subscription answer is recorded in LatencyStats as
+ * "GET /events".
+ */
+
+#pragma once
+
+#include <functional>
+#include <string>
+
+#include "EventLoop.h"
+#include "HttpConnection.h"
+#include "LatencyStats.h"
+
+class PushStream {
+ public:
+  typedef std::function<void(const std::string& name, const std::string& data)> EventCallback;
+  typedef std::function<void(bool open)> StateCallback;
+
+  PushStream(EventLoop& loop, const Backend& backend, LatencyStats& stats,
+             uint32_t idleTimeoutMs = 40000)
+      : loop(loop), backend(backend), stats(stats), idleTimeoutMs(idleTimeoutMs) {}
+  ~PushStream() { close(); }
+
+  PushStream(const PushStream&) = delete;
+  PushStream& operator=(const PushStream&) = delete;
+
+  // Subscribes to path (appended to Backend::basePath). onState(true) once
+  // the backend took the subscription, onState(false) when that open
+  // stream ends; a subscription that failed is only counted in the stats.
+  void open(const std::string& path, EventCallback onEvent, StateCallback onState);
+  void close();
+  bool isOpen() const { return opened; }
+  bool isConnecting() const { return fd >= 0 && !opened; }
+
+ private:
+  void onSocketEvent(uint32_t events);
+  void flushOutput();
+  void readInput();
+  bool parseHead(size_t end);
+  bool takeBody();
+  bool takeLines();
+  void armIdleTimer();
+  void fail(int status);
+
+  EventLoop& loop;
+  const Backend& backend;
+  LatencyStats& stats;
+  uint32_t idleTimeoutMs;
+  EventCallback onEvent;
+  StateCallback onState;
+
+  int fd = -1;
+  uint32_t generation = 0;  // Bumped by close(), to notice it from a callback
+  bool connecting = false;
+  bool opened = false;
+  uint64_t startedUs = 0;
+  uint64_t idleTimer = 0;
+  std::string output;
+  size_t outputSent = 0;
+
+  std::string input;      // Raw bytes, head then (chunked) body
+  bool chunked = false;
+  size_t chunkLeft = 0;   // Body bytes of the current chunk still to come
+  bool chunkTrailer = false;  // CRLF after a chunk still to skip
+  std::string text;       // De-chunked event stream, up to an incomplete line
+  std::string eventName;
+  std::string eventData;
+};
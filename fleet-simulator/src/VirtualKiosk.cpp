@@ -0,0 +1,216 @@
+/*
+ * AERAS Fleet Simulator - One virtual kiosk
+ */
+
+#include "VirtualKiosk.h"
+
+#include <DeviceWire.h>
+#include <FixedWriter.h>
+
+// Same values as user-side-hardware/src/main.cpp
+static const uint32_t ULTRASONIC_THRESHOLD = 3000;  // Dwell before the card check
+static const uint32_t REQUEST_TIMEOUT = 60000;
+static const uint32_t RIDE_STATUS_POLL_MS = 2000;
+static const uint32_t RIDE_STATUS_TIMEOUT_MS = 3000;
+static const uint32_t BACKEND_TIMEOUT_MS = 5000;
+static const uint32_t PUSH_RECONNECT_MS = 10000;
+// Scripted rider: laser card, then the button
+static const uint32_t CONFIRM_DELAY_MS = 2000;
+
+VirtualKiosk::VirtualKiosk(Fleet& fleet, uint32_t number)
+    : fleet(fleet),
+      block(fleet.blocks.at(number % fleet.blocks.size())),
+      backend(fleet.loop, fleet.backend, fleet.stats, AERAS_WIRE_CONTENT_TYPE),
+      pushChannel(fleet.loop, fleet.backend, fleet.stats) {}
+
+void VirtualKiosk::start() {
+  scheduleArrival();
+  if (fleet.config.push) {
+    connectPushChannel();
+    fleet.loop.every(PUSH_RECONNECT_MS, [this] { connectPushChannel(); });
+  }
+}
+
+bool VirtualKiosk::waitingOnRide() const {
+  return currentState == STATE_WAITING_ACCEPTANCE || currentState == STATE_RIDE_ACCEPTED ||
+         currentState == STATE_RIDE_ACTIVE;
+}
+
+// ===== Rider =====
+void VirtualKiosk::scheduleArrival() {
+  double meanMs = fleet.config.kioskIntervalS * 1000.0;
+  double gapMs = std::exponential_distribution<double>(1.0 / meanMs)(fleet.random);
+  fleet.loop.after((uint32_t)std::min(gapMs, 3600000.0), [this] { onRiderArrived(); });
+}
+
+void VirtualKiosk::onRiderArrived() {
+  if (currentState != STATE_IDLE) return;
+  currentState = STATE_DETECTING;
+  fleet.loop.after(ULTRASONIC_THRESHOLD + CONFIRM_DELAY_MS, [this] { onButtonPressed(); });
+}
+
+void VirtualKiosk::onButtonPressed() {
+  if (currentState != STATE_DETECTING) return;
+  currentState = STATE_REQUEST_SENT;
+  sendRideRequest();
+}
+
+// ===== Backend =====
+void VirtualKiosk::sendRideRequest() {
+  // Any other block will do as the rider's destination
+  const BlockInfo* destination = &fleet.randomBlock();
+  while (fleet.blocks.size() > 1 && destination == &block) destination = &fleet.randomBlock();
+
+  TextBuffer<16> userID;
+  userID.appendf("USER_%d", std::uniform_int_distribution<int>(1000, 9998)(fleet.random));
+
+  JsonBuffer<128> payload;
+  payload.beginObject()
+         .field("blockID", block.blockID)
+         .field("destination", destination->blockID)
+         .field("userID", userID.c_str())
+         .endObject();
+
+  HttpRequest request;
+  request.label = "POST /ride/request";
+  request.method = "POST";
+  request.path = "/ride/request";
+  request.body = payload.c_str();
+  request.contentType = "application/json";
+  request.timeoutMs = BACKEND_TIMEOUT_MS;
+  request.done = [this](const HttpResponse& response) { onRideRequestReply(response); };
+  backend.request(std::move(request));
+}
+
+void VirtualKiosk::onRideRequestReply(const HttpResponse& response) {
+  if (currentState != STATE_REQUEST_SENT) return;
+
+  RideRequestReply reply;
+  BodyStream body(response.body);
+  if (response.status != 200 || !parseRideRequestReply(body, reply) || reply.rideID <= 0) {
+    fleet.counters.requestFailed++;
+    scheduleReset(2000);
+    return;
+  }
+
+  fleet.counters.requested++;
+  currentRideID = reply.rideID;
+  currentState = STATE_WAITING_ACCEPTANCE;
+  uint32_t generation = ++rideGeneration;
+  requestTimeoutTimer = fleet.loop.after(REQUEST_TIMEOUT, [this] {
+    requestTimeoutTimer = 0;
+    onRequestTimeout();
+  });
+  statusPollInFlight = false;
+  fleet.loop.after(RIDE_STATUS_POLL_MS, [this, generation] {
+    if (generation == rideGeneration) checkRideStatus();
+  });
+}
+
+// Every 2 s ("ride-status") from request sent until reset; the ETag makes
+// an unchanged answer a bodiless 304
+void VirtualKiosk::checkRideStatus() {
+  if (!waitingOnRide()) return;
+  uint32_t generation = rideGeneration;
+  fleet.loop.after(RIDE_STATUS_POLL_MS, [this, generation] {
+    if (generation == rideGeneration) checkRideStatus();
+  });
+  // The device's poll blocks its loop, so a slow one delays the next
+  if (statusPollInFlight || pushChannel.isOpen()) return;
+
+  HttpRequest request;
+  request.label = "GET /ride/:id/status";
+  request.method = "GET";
+  request.path = "/ride/" + std::to_string(currentRideID) + "/status";
+  if (!rideStatusTag.empty()) request.headers = "If-None-Match: " + rideStatusTag + "\r\n";
+  request.timeoutMs = RIDE_STATUS_TIMEOUT_MS;
+  request.done = [this, generation](const HttpResponse& response) {
+    if (generation != rideGeneration) return;
+    statusPollInFlight = false;
+    if (response.status != 200 || !response.is(AERAS_WIRE_CONTENT_TYPE)) return;  // 304: unchanged
+
+    RideStatusReply reply;
+    if (!decodeRideStatus((const uint8_t*)response.body.data(), response.body.size(), reply)) return;
+    rideStatusTag = response.etag;
+    applyRideStatus(reply.status);
+  };
+  statusPollInFlight = true;
+  backend.request(std::move(request));
+}
+
+void VirtualKiosk::applyRideStatus(const char* status) {
+  if (!waitingOnRide()) return;
+
+  if (strcmp(status, "ACCEPTED") == 0) {
+    if (currentState == STATE_WAITING_ACCEPTANCE) {
+      currentState = STATE_RIDE_ACCEPTED;
+      fleet.counters.acceptedSeen++;
+      fleet.loop.cancel(requestTimeoutTimer);
+    }
+  } else if (strcmp(status, "PICKUP") == 0) {
+    if (currentState != STATE_RIDE_ACTIVE) {
+      // An ACCEPTED the 2 s poll never saw still counts
+      if (currentState == STATE_WAITING_ACCEPTANCE) fleet.counters.acceptedSeen++;
+      currentState = STATE_RIDE_ACTIVE;
+      fleet.loop.cancel(requestTimeoutTimer);
+    }
+  } else if (strcmp(status, "COMPLETED") == 0) {
+    fleet.counters.completedSeen++;
+    scheduleReset(3000);
+  }
+}
+
+// ===== Push channel =====
+// Every PUSH_RECONNECT_MS while the stream is down (--push only). Names
+// the ride followed, so a change missed while down comes straight away.
+void VirtualKiosk::connectPushChannel() {
+  if (pushChannel.isOpen() || pushChannel.isConnecting()) return;
+
+  TextBuffer<96> path;
+  path.append("/events?blockIDs=").appendUrlEncoded(block.blockID).append("&rideIDs=");
+  if (currentRideID != 0) path.append(currentRideID);
+  pushChannel.open(path.c_str(),
+                   [this](const std::string& name, const std::string& data) { onPushEvent(name, data); },
+                   nullptr);
+}
+
+// Every ride at the block is pushed; other kiosks' rides are ignored
+void VirtualKiosk::onPushEvent(const std::string& name, const std::string& data) {
+  if (name != "ride") return;
+  RideStatusReply reply;
+  BodyStream body(data);
+  if (parseRideStatus(body, reply) && currentRideID != 0 && reply.rideID == currentRideID) {
+    applyRideStatus(reply.status);
+  }
+}
+
+// One-shot, REQUEST_TIMEOUT after the request went out
+void VirtualKiosk::onRequestTimeout() {
+  if (currentState != STATE_WAITING_ACCEPTANCE) return;
+  fleet.counters.kioskTimeouts++;
+  currentState = STATE_TIMEOUT_ERROR;
+  rideGeneration++;  // Stops the status poll
+  resetTimer = fleet.loop.after(5000, [this] { resetSystem(); });
+}
+
+// ===== Reset =====
+void VirtualKiosk::resetSystem() {
+  currentState = STATE_IDLE;
+  currentRideID = 0;
+  rideStatusTag.clear();
+  rideGeneration++;
+  if (requestTimeoutTimer) fleet.loop.cancel(requestTimeoutTimer);
+  if (resetTimer) fleet.loop.cancel(resetTimer);
+  requestTimeoutTimer = 0;
+  resetTimer = 0;
+  scheduleArrival();
+}
+
+void VirtualKiosk::scheduleReset(uint32_t ms) {
+  currentState = STATE_RESETTING;
+  rideGeneration++;
+  resetTimer = fleet.loop.after(ms, [this] {
+    resetTimer = 0;
+    resetSystem();
+  });
+}
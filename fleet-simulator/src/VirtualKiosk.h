@@ -0,0 +1,67 @@
+/*
+ * AERAS Fleet Simulator - One virtual kiosk
+ * The SystemState machine of user-side-hardware with the sensors
+ * scripted: riders arrive at random (exponential gaps averaging
+ * FleetConfig::kioskIntervalS), stand through the 3 s dwell, show the
+ * laser card and press the button, then the kiosk requests the ride and
+ * polls /ride/<id>/status every 2 s with If-None-Match until it completes
+ * or times out. With --push the status comes down /events instead, and
+ * the poll only runs while that is down.
+ */
+
+#pragma once
+
+#include <BackendMessages.h>
+
+#include "Fleet.h"
+#include "PushStream.h"
+
+class VirtualKiosk {
+ public:
+  VirtualKiosk(Fleet& fleet, uint32_t number);
+
+  VirtualKiosk(const VirtualKiosk&) = delete;
+  VirtualKiosk& operator=(const VirtualKiosk&) = delete;
+
+  void start();
+
+ private:
+  enum SystemState {
+    STATE_IDLE,
+    STATE_DETECTING,
+    STATE_WAITING_CONFIRM,
+    STATE_REQUEST_SENT,
+    STATE_WAITING_ACCEPTANCE,
+    STATE_RIDE_ACCEPTED,
+    STATE_RIDE_ACTIVE,
+    STATE_TIMEOUT_ERROR,
+    STATE_RESETTING
+  };
+
+  void scheduleArrival();
+  void onRiderArrived();
+  void onButtonPressed();
+  void sendRideRequest();
+  void onRideRequestReply(const HttpResponse& response);
+  void checkRideStatus();
+  void applyRideStatus(const char* status);
+  void connectPushChannel();
+  void onPushEvent(const std::string& name, const std::string& data);
+  void onRequestTimeout();
+  void resetSystem();
+  void scheduleReset(uint32_t ms);
+  bool waitingOnRide() const;
+
+  Fleet& fleet;
+  const BlockInfo& block;
+  HttpConnection backend;
+  PushStream pushChannel;  // --push: ride changes at the block
+  SystemState currentState = STATE_IDLE;
+
+  long currentRideID = 0;
+  std::string rideStatusTag;
+  bool statusPollInFlight = false;
+  uint64_t requestTimeoutTimer = 0;
+  uint64_t resetTimer = 0;
+  uint32_t rideGeneration = 0;  // Drops late answers for a ride already reset
+};
@@ -0,0 +1,428 @@
+/*
+ * AERAS Fleet Simulator - One virtual rickshaw
+ */
+
+#include "VirtualRickshaw.h"
+
+#include <DeviceWire.h>
+#include <FixedWriter.h>
+
+// Same values as rickshaw-side-hardware (main.cpp / NetTask.cpp); the
+// dead-band, poll spacing and journal replay come from RideSync.h
+static const uint32_t OFFER_POLL_MS = 3000;
+static const uint32_t MOVEMENT_MS = 1000;
+static const uint32_t LOCATION_SAMPLE_MS = 1000;
+static const float ARRIVAL_RADIUS_M = 5.0f;
+static const uint32_t PUSH_RECONNECT_MS = 10000;
+static const uint32_t BACKEND_TIMEOUT_MS = 5000;  // HttpSession default
+
+// Idle rickshaws are parked around a random block
+static const double START_SPREAD_DEGREES = 0.003;  // ~300 m
+
+VirtualRickshaw::VirtualRickshaw(Fleet& fleet, uint32_t number)
+    : fleet(fleet),
+      backend(fleet.loop, fleet.backend, fleet.stats, AERAS_WIRE_CONTENT_TYPE),
+      statusSession(fleet.loop, fleet.backend, fleet.stats, AERAS_WIRE_CONTENT_TYPE),
+      pushChannel(fleet.loop, fleet.backend, fleet.stats) {
+  snprintf(rickshawID, sizeof(rickshawID), "SIM_%05u", (unsigned)number);
+  snprintf(pullerName, sizeof(pullerName), "Sim Puller %u", (unsigned)number);
+
+  const BlockInfo& home = fleet.randomBlock();
+  currentLat = home.lat + fleet.uniform(-START_SPREAD_DEGREES, START_SPREAD_DEGREES);
+  currentLng = home.lng + fleet.uniform(-START_SPREAD_DEGREES, START_SPREAD_DEGREES);
+  journalID = (uint32_t)fleet.random();
+}
+
+void VirtualRickshaw::start() {
+  registerRickshaw();
+  checkBlockTable();
+
+  fleet.loop.every(OFFER_POLL_MS, [this] { checkForRideRequests(); });
+  fleet.loop.every(MOVEMENT_MS, [this] { advanceNavigation(); });
+  fleet.loop.every(LOCATION_SAMPLE_MS, [this] { sendLocationUpdate(); });
+  if (fleet.config.push) {
+    connectPushChannel();
+    fleet.loop.every(PUSH_RECONNECT_MS, [this] { connectPushChannel(); });
+  }
+}
+
+// ===== Ride state =====
+void VirtualRickshaw::clearRide() {
+  onActiveRide = false;
+  pickupConfirmed = false;
+  currentRideID = 0;
+  pickupLocation[0] = '\0';
+  destinationLocation[0] = '\0';
+  lastKnownStatus[0] = '\0';
+  publishRideState();
+}
+
+// NetTask trackRide(): re-arms the long-poll whenever the ride or its
+// last known status changes
+void VirtualRickshaw::publishRideState() {
+  if (currentRideID == trackedRideID && strcmp(lastKnownStatus, sinceStatus) == 0) return;
+
+  trackedRideID = currentRideID;
+  copyText(sinceStatus, lastKnownStatus);
+  if (statusPollInFlight) {
+    statusSession.close();
+    statusPollInFlight = false;
+  }
+  if (statusPollTimer) fleet.loop.cancel(statusPollTimer);
+  statusPollTimer = 0;
+  if (trackedRideID != 0) startRideStatusPoll();
+}
+
+bool VirtualRickshaw::setTarget(const char* blockID) {
+  const BlockInfo* block = fleet.blocks.find(blockID);
+  if (!block) return false;
+  targetLocation = *block;
+  toTarget = geoVector(currentLat, currentLng, targetLocation.lat, targetLocation.lng);
+  return true;
+}
+
+void VirtualRickshaw::showRideOffer(const RideOffer& offer) {
+  // The puller answers the offer on screen before looking at another
+  if (onActiveRide || currentRideID != 0) return;
+
+  fleet.counters.offers++;
+  currentRideID = offer.rideID;
+  lastKnownStatus[0] = '\0';  // New ride - ask for its status straight away
+  copyText(pickupLocation, offer.pickupBlock);
+  copyText(destinationLocation, offer.destination);
+  publishRideState();
+
+  long offeredRideID = currentRideID;
+  fleet.loop.after(fleet.config.acceptDelayMs, [this, offeredRideID] {
+    if (currentRideID == offeredRideID) acceptRide();
+  });
+}
+
+void VirtualRickshaw::acceptRide() {
+  if (currentRideID == 0 || onActiveRide || awaitingBackend) return;
+  journalRideEvent(EVENT_ACCEPT);
+}
+
+void VirtualRickshaw::handleRideStatus(const RideStatusReply& reply) {
+  const char* status = reply.status;
+  copyText(lastKnownStatus, status);
+
+  if (!onActiveRide) {
+    if (strcmp(status, "ACCEPTED") == 0 && strcmp(reply.rickshawID, rickshawID) == 0) {
+      // Our accept, seen by the long-poll before its own answer came back
+      onActiveRide = true;
+      pickupConfirmed = false;
+      setTarget(pickupLocation);
+    } else if (strcmp(status, "PENDING") != 0) {
+      // Offer is gone - accepted by another puller, timed out or cancelled
+      clearRide();
+      return;
+    }
+    publishRideState();
+    return;
+  }
+
+  bool finished = strcmp(status, "COMPLETED") == 0 || strcmp(status, "PENDING_REVIEW") == 0;
+  bool cancelled = strcmp(status, "PENDING") == 0 || strcmp(status, "CANCELLED") == 0;
+  if (strcmp(status, "PICKUP") == 0 && !pickupConfirmed) {
+    pickupConfirmed = true;
+    setTarget(destinationLocation);
+  } else if ((finished || cancelled) && !awaitingBackend) {
+    clearRide();
+    return;
+  }
+  publishRideState();
+}
+
+// ===== Navigation and location =====
+void VirtualRickshaw::advanceNavigation() {
+  if (!onActiveRide) return;
+
+  if (toTarget.meters > ARRIVAL_RADIUS_M) {
+    float metersPerSecond = fleet.config.speedKmh * 1000.0f / 3600.0f;
+    geoMove(currentLat, currentLng, std::min(metersPerSecond, toTarget.meters), toTarget.bearing);
+    toTarget = geoVector(currentLat, currentLng, targetLocation.lat, targetLocation.lng);
+    return;
+  }
+
+  // Arrived: the puller confirms straight away
+  if (awaitingBackend) return;
+  journalRideEvent(pickupConfirmed ? EVENT_COMPLETE : EVENT_PICKUP);
+}
+
+void VirtualRickshaw::sendLocationUpdate() {
+  if (!locationReporter.due(currentLat, currentLng, onActiveRide, nowMs())) return;
+
+  MsgPackBuffer<48> wirePayload;
+  if (!encodeLocation(wirePayload, rickshawID, currentLat, currentLng)) return;
+
+  // Fire-and-forget, queued ahead of the next poll on the same connection
+  HttpRequest request;
+  request.label = "POST /rickshaw/location";
+  request.method = "POST";
+  request.path = "/rickshaw/location";
+  request.body.assign((const char*)wirePayload.data(), wirePayload.length());
+  request.contentType = AERAS_WIRE_CONTENT_TYPE;
+  request.timeoutMs = BACKEND_TIMEOUT_MS;
+  backend.request(std::move(request));
+  locationReporter.reported(currentLat, currentLng, nowMs());
+}
+
+// ===== Boot =====
+void VirtualRickshaw::registerRickshaw() {
+  JsonBuffer<256> payload;
+  payload.beginObject()
+         .field("rickshawID", rickshawID)
+         .field("pullerName", pullerName)
+         .field("phoneNumber", "01712345678")
+         .field("currentLat", currentLat, 6)
+         .field("currentLng", currentLng, 6)
+         .endObject();
+
+  HttpRequest request;
+  request.label = "POST /rickshaw/register";
+  request.method = "POST";
+  request.path = "/rickshaw/register";
+  request.body = payload.c_str();
+  request.contentType = "application/json";
+  request.timeoutMs = BACKEND_TIMEOUT_MS;
+  backend.request(std::move(request));
+  locationReporter.reported(currentLat, currentLng, nowMs());  // Registration carries the position
+}
+
+// The device asks with its cached version and normally gets a 304; the
+// simulator shares the table main.cpp downloaded, so a 200 is not decoded
+void VirtualRickshaw::checkBlockTable() {
+  HttpRequest request;
+  request.label = "GET /locations";
+  request.method = "GET";
+  request.path = "/locations?since=" + std::to_string(fleet.blocks.version());
+  request.timeoutMs = BACKEND_TIMEOUT_MS;
+  backend.request(std::move(request));
+}
+
+// ===== Offers (using /ride/pending) =====
+void VirtualRickshaw::checkForRideRequests() {
+  // The device's poll blocks its task, so two never overlap
+  if (onActiveRide || offerPollInFlight || pushChannel.isOpen()) return;
+
+  TextBuffer<64> requestPath;
+  requestPath.append("/ride/pending?limit=1&rickshawID=").appendUrlEncoded(rickshawID);
+
+  HttpRequest request;
+  request.label = "GET /ride/pending";
+  request.method = "GET";
+  request.path = requestPath.c_str();
+  request.timeoutMs = BACKEND_TIMEOUT_MS;
+  request.done = [this](const HttpResponse& response) {
+    offerPollInFlight = false;
+    if (response.status != 200 || !response.is(AERAS_WIRE_CONTENT_TYPE)) return;
+
+    RideOffer offer;
+    if (decodePendingOffer((const uint8_t*)response.body.data(), response.body.size(), offer)) {
+      showRideOffer(offer);
+    }
+  };
+  offerPollInFlight = true;
+  backend.request(std::move(request));
+}
+
+// ===== Ride status long-poll =====
+void VirtualRickshaw::startRideStatusPoll() {
+  statusPollTimer = 0;
+  if (trackedRideID == 0 || statusPollInFlight) return;
+  // Pushed changes make the long-poll redundant, but a freshly tracked ride
+  // (no status yet) is still asked once
+  if (pushChannel.isOpen() && sinceStatus[0] != '\0') return;
+
+  TextBuffer<96> requestPath;
+  statusPacer.start(requestPath, trackedRideID, sinceStatus, nowMs());
+
+  HttpRequest request;
+  request.label = "GET /ride/:id/status (wait)";
+  request.method = "GET";
+  request.path = requestPath.c_str();
+  request.timeoutMs = StatusPollPacer::STUCK_MS;
+  long watchedRideID = trackedRideID;
+  request.done = [this, watchedRideID](const HttpResponse& response) {
+    statusPollInFlight = false;
+    armRideStatusPoll();
+    if (response.status != 200 || !response.is(AERAS_WIRE_CONTENT_TYPE)) return;
+
+    RideStatusReply reply;
+    if (!decodeRideStatus((const uint8_t*)response.body.data(), response.body.size(), reply)) return;
+    if (watchedRideID != trackedRideID) return;
+    copyText(sinceStatus, reply.status);  // Next poll waits for a change
+    // Answers for a ride the UI already dropped are stale
+    if (watchedRideID == currentRideID) handleRideStatus(reply);
+  };
+  statusPollInFlight = true;
+  statusSession.request(std::move(request));
+}
+
+void VirtualRickshaw::armRideStatusPoll() {
+  if (statusPollTimer || trackedRideID == 0) return;
+  statusPollTimer = fleet.loop.after(statusPacer.nextDelay(nowMs()), [this] { startRideStatusPoll(); });
+}
+
+// ===== Push channel =====
+// Every PUSH_RECONNECT_MS while the stream is down (--push only)
+void VirtualRickshaw::connectPushChannel() {
+  if (pushChannel.isOpen() || pushChannel.isConnecting()) return;
+
+  TextBuffer<96> path;
+  path.append("/events?rickshawID=").appendUrlEncoded(rickshawID);
+  // Its current status comes first, covering changes missed while down
+  if (trackedRideID != 0) path.appendf("&rideID=%ld", trackedRideID);
+  pushChannel.open(path.c_str(),
+                   [this](const std::string& name, const std::string& data) { onPushEvent(name, data); },
+                   [this](bool open) { onPushState(open); });
+}
+
+void VirtualRickshaw::onPushState(bool open) {
+  if (open) {
+    // Offer poll and status long-poll pause while the stream is up
+    if (sinceStatus[0] != '\0' && statusPollInFlight) {
+      statusSession.close();
+      statusPollInFlight = false;
+    }
+    return;
+  }
+  armRideStatusPoll();  // Dropped: back to polling until it is back
+}
+
+void VirtualRickshaw::onPushEvent(const std::string& name, const std::string& data) {
+  BodyStream body(data);
+  if (name == "offer") {
+    RideOffer offer;
+    if (!onActiveRide && parseRideOffer(body, offer)) showRideOffer(offer);
+    return;
+  }
+  if (name != "ride") return;
+
+  // Every change of a ride we were shown is pushed; only the tracked one counts
+  RideStatusReply reply;
+  if (!parseRideStatus(body, reply) || trackedRideID == 0 || reply.rideID != trackedRideID) return;
+  if (strcmp(reply.status, sinceStatus) == 0) return;
+  copyText(sinceStatus, reply.status);
+  if (trackedRideID == currentRideID) handleRideStatus(reply);
+}
+
+// ===== Ride event journal =====
+void VirtualRickshaw::journalRideEvent(EventType type) {
+  journal.push_back(JournalEntry{nextSeq++, type, currentRideID, currentLat, currentLng});
+  awaitingBackend = true;
+
+  // A fresh command from the puller: try right away, whatever the backoff
+  if (journalRetryTimer) fleet.loop.cancel(journalRetryTimer);
+  journalRetryTimer = 0;
+  replay.rush();
+  replayJournal();
+}
+
+void VirtualRickshaw::scheduleJournalRetry() {
+  journalRetryTimer = fleet.loop.after(replay.nextRetry(), [this] {
+    journalRetryTimer = 0;
+    replayJournal();
+  });
+}
+
+void VirtualRickshaw::replayJournal() {
+  if (journalInFlight) return;
+  if (journal.empty()) {
+    replay.rush();
+    return;
+  }
+
+  uint8_t count = replay.beginBatch((uint8_t)std::min<size_t>(journal.size(), JournalReplay::BATCH_SIZE));
+  bool fits = true;
+  MsgPackBuffer<512> wireBatch;
+  beginRideEvents(wireBatch, rickshawID, journalID, count);
+  for (uint8_t i = 0; i < count; i++) {
+    const JournalEntry& entry = journal[i];
+    fits = encodeRideEvent(wireBatch, entry.seq, entry.type, entry.rideID, entry.lat, entry.lng);
+  }
+  if (!fits) {
+    // As NetTask: a send error, retried with backoff
+    replay.endBatch();
+    scheduleJournalRetry();
+    return;
+  }
+
+  HttpRequest request;
+  request.label = "POST /ride/events";
+  request.method = "POST";
+  request.path = "/ride/events";
+  request.body.assign((const char*)wireBatch.data(), wireBatch.length());
+  request.contentType = AERAS_WIRE_CONTENT_TYPE;
+  request.timeoutMs = BACKEND_TIMEOUT_MS;
+  request.done = [this](const HttpResponse& response) { onJournalReply(response); };
+  journalInFlight = true;
+  backend.request(std::move(request));
+}
+
+bool VirtualRickshaw::onJournalResult(const RideEventResult& result, void* context) {
+  VirtualRickshaw& self = *static_cast<VirtualRickshaw*>(context);
+  if (self.replay.batchAnswered()) return false;
+  const JournalEntry& entry = self.journal[self.replay.answered()];
+  if (!self.replay.accept(result, entry.seq)) return false;
+
+  self.onEventResult(entry, result);
+  return true;
+}
+
+void VirtualRickshaw::onJournalReply(const HttpResponse& response) {
+  journalInFlight = false;
+  if (response.status == 200 && response.is(AERAS_WIRE_CONTENT_TYPE)) {
+    decodeRideEventResults((const uint8_t*)response.body.data(), response.body.size(),
+                           onJournalResult, this);
+  }
+  journal.erase(journal.begin(), journal.begin() + replay.answered());
+
+  if (!replay.endBatch()) {
+    scheduleJournalRetry();
+    return;
+  }
+  if (!journal.empty()) replayJournal();
+}
+
+// main.cpp onAcceptResult() / onPickupResult() / onCompleteResult()
+void VirtualRickshaw::onEventResult(const JournalEntry& entry, const RideEventResult& result) {
+  awaitingBackend = false;
+  bool success = result.status == 200 && (entry.type == EVENT_PICKUP || result.success);
+  if (entry.type == EVENT_ACCEPT) {
+    if (success) fleet.counters.accepts++;
+    else if (result.status == 200) fleet.counters.lostRaces++;
+  } else if (entry.type == EVENT_COMPLETE && success) {
+    fleet.counters.completes++;
+    fleet.counters.points += result.complete.points;
+  }
+  if (entry.rideID != currentRideID) return;
+
+  switch (entry.type) {
+    case EVENT_ACCEPT:
+      if (!success) {
+        clearRide();  // Ride taken (or refused): back to waiting for offers
+        return;
+      }
+      if (!onActiveRide) {
+        onActiveRide = true;
+        pickupConfirmed = false;
+        setTarget(pickupLocation);
+      }
+      copyText(lastKnownStatus, "ACCEPTED");  // Re-arms the long-poll from the new status
+      break;
+
+    case EVENT_PICKUP:
+      if (!success || pickupConfirmed) return;
+      pickupConfirmed = true;
+      copyText(lastKnownStatus, "PICKUP");
+      setTarget(destinationLocation);
+      break;
+
+    case EVENT_COMPLETE:
+      clearRide();
+      return;
+  }
+  publishRideState();
+}
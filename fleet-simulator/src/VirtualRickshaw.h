@@ -0,0 +1,115 @@
+/*
+ * AERAS Fleet Simulator - One virtual rickshaw
+ * Runs the jobs of rickshaw-side-hardware's loop() and network task with
+ * the same endpoints, wire format and intervals: offer poll every 3 s,
+ * ride status long-poll on its own connection, location samples every
+ * second behind the dead-band, and accept/pickup/complete sent through
+ * the ride event journal. The dead-band, poll spacing and journal replay
+ * are the firmware's own (RideSync.h); the ride state machine around them
+ * is re-implemented here on the event loop. The puller's part is
+ * scripted: offers are accepted after FleetConfig::acceptDelayMs, pickup
+ * and complete are confirmed on arrival. With --push it holds /events
+ * open and polls only while that is down, as the firmware does; without
+ * it, this is the load of a fleet whose push channel is down.
+ */
+
+#pragma once
+
+#include <deque>
+
+#include <BackendMessages.h>
+#include <Geodesy.h>
+#include <RideSync.h>
+
+#include "Fleet.h"
+#include "PushStream.h"
+
+class VirtualRickshaw {
+ public:
+  VirtualRickshaw(Fleet& fleet, uint32_t number);
+
+  VirtualRickshaw(const VirtualRickshaw&) = delete;
+  VirtualRickshaw& operator=(const VirtualRickshaw&) = delete;
+
+  // setup(): register, block table check, then the periodic jobs
+  void start();
+
+ private:
+  enum EventType : char { EVENT_ACCEPT = 'A', EVENT_PICKUP = 'P', EVENT_COMPLETE = 'C' };
+
+  struct JournalEntry {
+    uint32_t seq;
+    EventType type;
+    long rideID;
+    double lat;
+    double lng;
+  };
+
+  // ===== UI side (main.cpp) =====
+  void clearRide();
+  void publishRideState();
+  bool setTarget(const char* blockID);
+  void showRideOffer(const RideOffer& offer);
+  void acceptRide();
+  void handleRideStatus(const RideStatusReply& reply);
+  void advanceNavigation();
+  void sendLocationUpdate();
+  void onEventResult(const JournalEntry& entry, const RideEventResult& result);
+
+  // ===== Network side (NetTask.cpp) =====
+  void registerRickshaw();
+  void checkBlockTable();
+  void checkForRideRequests();
+  void startRideStatusPoll();
+  void armRideStatusPoll();
+  void onRideStatusReply(const HttpResponse& response);
+  void connectPushChannel();
+  void onPushState(bool open);
+  void onPushEvent(const std::string& name, const std::string& data);
+  void journalRideEvent(EventType type);
+  void replayJournal();
+  void scheduleJournalRetry();
+  void onJournalReply(const HttpResponse& response);
+  static bool onJournalResult(const RideEventResult& result, void* context);
+
+  uint32_t nowMs() const { return (uint32_t)fleet.loop.nowMs(); }  // millis()
+
+  Fleet& fleet;
+  char rickshawID[AERAS_RICKSHAW_ID_LENGTH];
+  char pullerName[24];
+  HttpConnection backend;        // Offers, locations, ride events
+  HttpConnection statusSession;  // Ride status long-poll
+  PushStream pushChannel;        // --push: offers and ride changes
+
+  // Position and navigation
+  double currentLat;
+  double currentLng;
+  BlockInfo targetLocation = {};
+  GeoVector toTarget = {0, 0};
+  LocationReporter locationReporter;
+
+  // Ride as the UI sees it
+  long currentRideID = 0;
+  bool onActiveRide = false;
+  bool pickupConfirmed = false;
+  bool awaitingBackend = false;
+  char pickupLocation[AERAS_BLOCK_ID_LENGTH] = "";
+  char destinationLocation[AERAS_BLOCK_ID_LENGTH] = "";
+  char lastKnownStatus[AERAS_STATUS_LENGTH] = "";
+
+  // What the network side watches
+  long trackedRideID = 0;
+  char sinceStatus[AERAS_STATUS_LENGTH] = "";
+  bool offerPollInFlight = false;
+  bool statusPollInFlight = false;
+  StatusPollPacer statusPacer;
+  uint64_t statusPollTimer = 0;
+
+  // Ride event journal (in RAM: a simulated rickshaw never reboots)
+  uint32_t journalID;
+  uint32_t nextSeq = 1;
+  std::deque<JournalEntry> journal;
+  bool journalInFlight = false;
+  JournalReplay replay;
+  uint64_t journalRetryTimer = 0;
+};
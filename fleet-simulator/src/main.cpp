@@ -0,0 +1,219 @@
+/*
+ * AERAS Fleet Simulator
+ * Drives thousands of virtual rickshaws and kiosks against a running
+ * backend from one thread, using the same endpoints, wire format and
+ * polling intervals as the firmware, and reports latency percentiles and
+ * throughput per endpoint. --push holds the /events push channel open
+ * as the firmware does; without it the fleet polls as while it is down.
+ *
+ *   fleet-simulator [--url http://localhost:3000/api] [--rickshaws 100]
+ *                   [--kiosks 20] [--duration 120] [--ramp 10] [--report 10]
+ *                   [--speed 15] [--kiosk-interval 60] [--accept-delay 2000]
+ *                   [--seed 1] [--push]
+ */
+
+#include <netdb.h>
+#include <signal.h>
+#include <sys/resource.h>
+#include <memory>
+#include <vector>
+
+#include "Fleet.h"
+#include "VirtualKiosk.h"
+#include "VirtualRickshaw.h"
+
+// ===== Command line =====
+static void printUsage() {
+  printf("Usage: fleet-simulator [--url URL] [--rickshaws N] [--kiosks N] [--duration S]\n"
+         "                       [--ramp S] [--report S] [--speed KMH] [--kiosk-interval S]\n"
+         "                       [--accept-delay MS] [--seed N] [--push]\n");
+}
+
+static bool parseArguments(int argc, char** argv, FleetConfig& config) {
+  for (int i = 1; i < argc; i++) {
+    const char* option = argv[i];
+    if (strcmp(option, "--push") == 0) {
+      config.push = true;
+      continue;
+    }
+    if (strcmp(option, "--help") == 0 || i + 1 >= argc) return false;
+    const char* value = argv[++i];
+
+    if (strcmp(option, "--url") == 0) config.url = value;
+    else if (strcmp(option, "--rickshaws") == 0) config.rickshaws = atoi(value);
+    else if (strcmp(option, "--kiosks") == 0) config.kiosks = atoi(value);
+    else if (strcmp(option, "--duration") == 0) config.durationS = atoi(value);
+    else if (strcmp(option, "--ramp") == 0) config.rampS = atoi(value);
+    else if (strcmp(option, "--report") == 0) config.reportS = atoi(value);
+    else if (strcmp(option, "--speed") == 0) config.speedKmh = atof(value);
+    else if (strcmp(option, "--kiosk-interval") == 0) config.kioskIntervalS = atoi(value);
+    else if (strcmp(option, "--accept-delay") == 0) config.acceptDelayMs = atoi(value);
+    else if (strcmp(option, "--seed") == 0) config.seed = atoi(value);
+    else return false;
+  }
+  return config.durationS > 0 && config.kioskIntervalS > 0;
+}
+
+// http://host[:port][/basePath]
+static bool resolveBackend(const std::string& url, Backend& backend) {
+  const std::string scheme = "http://";
+  if (url.compare(0, scheme.size(), scheme) != 0) return false;
+
+  size_t hostStart = scheme.size();
+  size_t pathStart = url.find('/', hostStart);
+  std::string authority = url.substr(hostStart, pathStart - hostStart);
+  backend.basePath = pathStart == std::string::npos ? "" : url.substr(pathStart);
+  while (!backend.basePath.empty() && backend.basePath.back() == '/') backend.basePath.pop_back();
+
+  size_t colon = authority.find(':');
+  std::string host = authority.substr(0, colon);
+  std::string port = colon == std::string::npos ? "80" : authority.substr(colon + 1);
+  backend.host = authority;
+
+  addrinfo hints = {};
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo* found = nullptr;
+  if (getaddrinfo(host.c_str(), port.c_str(), &hints, &found) != 0 || !found) return false;
+  memcpy(&backend.address, found->ai_addr, sizeof(backend.address));
+  freeaddrinfo(found);
+  return true;
+}
+
+// Every device holds one or two sockets
+static void raiseFileLimit(rlim_t wanted) {
+  rlimit limit;
+  if (getrlimit(RLIMIT_NOFILE, &limit) != 0 || limit.rlim_cur >= wanted) return;
+  limit.rlim_cur = std::min(wanted, limit.rlim_max);
+  setrlimit(RLIMIT_NOFILE, &limit);
+  if (limit.rlim_cur < wanted) {
+    printf("⚠ Open file limit %llu is below the %llu sockets this fleet may need\n",
+           (unsigned long long)limit.rlim_cur, (unsigned long long)wanted);
+  }
+}
+
+// ===== Block table =====
+static bool addBlock(const BlockInfo& block, void* table) {
+  return static_cast<BlockTable*>(table)->put(block);
+}
+
+// Downloaded once and shared; the devices still ask for it (and get a 304)
+static bool fetchBlockTable(EventLoop& loop, const Backend& backend, LatencyStats& stats,
+                            BlockTable& blocks) {
+  HttpConnection connection(loop, backend, stats, nullptr);
+  bool done = false;
+
+  HttpRequest request;
+  request.label = "GET /locations";
+  request.method = "GET";
+  request.path = "/locations";
+  request.timeoutMs = 10000;
+  request.done = [&](const HttpResponse& response) {
+    done = true;
+    loop.stop();
+    if (response.status != 200) {
+      printf("✗ Block table fetch failed: %d\n", response.status);
+      return;
+    }
+    long version = 0;
+    BodyStream body(response.body);
+    if (parseBlockList(body, version, addBlock, &blocks)) blocks.setVersion(version);
+  };
+  connection.request(std::move(request));
+  loop.run(loop.nowMs() + 15000);
+  return done && blocks.size() > 0;
+}
+
+// ===== Run =====
+static void printOutcomes(const FleetCounters& counters) {
+  printf("\nRides\n");
+  printf("  kiosk requests   %8llu  (%llu failed, %llu timed out waiting)\n",
+         (unsigned long long)counters.requested, (unsigned long long)counters.requestFailed,
+         (unsigned long long)counters.kioskTimeouts);
+  printf("  kiosk saw        %8llu accepted, %llu completed\n",
+         (unsigned long long)counters.acceptedSeen, (unsigned long long)counters.completedSeen);
+  printf("  rickshaw offers  %8llu  (%llu accepts won, %llu lost races)\n",
+         (unsigned long long)counters.offers, (unsigned long long)counters.accepts,
+         (unsigned long long)counters.lostRaces);
+  printf("  completed        %8llu  (%llu points)\n", (unsigned long long)counters.completes,
+         (unsigned long long)counters.points);
+}
+
+static EventLoop* runningLoop = nullptr;
+
+int main(int argc, char** argv) {
+  FleetConfig config;
+  if (!parseArguments(argc, argv, config)) {
+    printUsage();
+    return 2;
+  }
+
+  Backend backend;
+  if (!resolveBackend(config.url, backend)) {
+    printf("✗ Cannot resolve %s (http://host[:port][/path] only)\n", config.url.c_str());
+    return 1;
+  }
+  signal(SIGPIPE, SIG_IGN);
+  int pushSockets = config.push ? 1 : 0;
+  raiseFileLimit((2 + pushSockets) * config.rickshaws + (1 + pushSockets) * config.kiosks + 64);
+
+  EventLoop loop;
+  LatencyStats bootStats;
+  BlockTable blocks;
+  if (!fetchBlockTable(loop, backend, bootStats, blocks)) {
+    printf("✗ No block table from %s\n", config.url.c_str());
+    return 1;
+  }
+  printf("✓ Block table v%ld: %u blocks\n", blocks.version(), blocks.size());
+
+  LatencyStats stats;
+  Fleet fleet(config, loop, backend, stats, blocks);
+
+  std::vector<std::unique_ptr<VirtualRickshaw>> rickshaws;
+  std::vector<std::unique_ptr<VirtualKiosk>> kiosks;
+  for (uint32_t i = 0; i < config.rickshaws; i++) {
+    rickshaws.emplace_back(new VirtualRickshaw(fleet, i + 1));
+  }
+  for (uint32_t i = 0; i < config.kiosks; i++) {
+    kiosks.emplace_back(new VirtualKiosk(fleet, i));
+  }
+
+  // Boots spread evenly over the ramp, rickshaws and kiosks interleaved
+  uint32_t devices = config.rickshaws + config.kiosks;
+  uint32_t startedRickshaws = 0;
+  uint32_t startedKiosks = 0;
+  for (uint32_t i = 0; i < devices; i++) {
+    uint32_t delayMs = (uint64_t)config.rampS * 1000 * i / devices;
+    bool rickshawTurn = startedKiosks == config.kiosks ||
+                        (startedRickshaws < config.rickshaws &&
+                         (uint64_t)startedRickshaws * config.kiosks <=
+                             (uint64_t)startedKiosks * config.rickshaws);
+    if (rickshawTurn) {
+      VirtualRickshaw* rickshaw = rickshaws[startedRickshaws++].get();
+      loop.after(delayMs, [rickshaw] { rickshaw->start(); });
+    } else {
+      VirtualKiosk* kiosk = kiosks[startedKiosks++].get();
+      loop.after(delayMs, [kiosk] { kiosk->start(); });
+    }
+  }
+
+  printf("🛺 %u rickshaws, %u kiosks against %s for %u s (ramp %u s, %s)\n", config.rickshaws,
+         config.kiosks, config.url.c_str(), config.durationS, config.rampS,
+         config.push ? "push channel" : "polling");
+  fflush(stdout);
+
+  if (config.reportS > 0) {
+    loop.every(config.reportS * 1000, [&stats, &config] { stats.printWindow(config.reportS); });
+  }
+
+  runningLoop = &loop;
+  signal(SIGINT, [](int) { runningLoop->stop(); });
+
+  uint64_t startedMs = loop.nowMs();
+  loop.run(startedMs + config.durationS * 1000ULL);
+  double elapsedS = (EventLoop::clockUs() / 1000 - startedMs) / 1000.0;
+
+  stats.printSummary(elapsedS);
+  printOutcomes(fleet.counters);
+  return 0;
+}
@@ -0,0 +1,134 @@
+/*
+ * AERAS Rickshaw Side - Host micro-benchmarks
+ * The per-tick hot paths of the firmware, built for the host by
+ * [env:native]:
+ *
+ *   pio run -e native && .pio/build/native/program
+ *
+ * calculateDistance() turned into geoVector() (single precision, short
+ * range) with geoVectorExact() as the double haversine fallback.
+ */
+
+#include <Arduino.h>
+#include <Bench.h>
+#include <BackendMessages.h>
+#include <BlockTable.h>
+#include <DeviceWire.h>
+#include <FixedWriter.h>
+#include <Geodesy.h>
+#include "../src/Navigation.h"
+
+// A /ride/pending reply as the backend sends it
+static const char PENDING_JSON[] =
+    "{\"success\":true,\"rides\":[{\"rideID\":4821,\"userID\":\"USER_5231\","
+    "\"pickupBlock\":\"CUET_CAMPUS\",\"destination\":\"PAHARTOLI\",\"status\":\"PENDING\","
+    "\"requestTime\":\"2026-10-14 08:15:02\",\"latitude\":22.4633,\"longitude\":91.9714,"
+    "\"distance\":\"0.42\"}]}";
+
+static BlockTable blocks;
+
+// The fleet's four blocks plus generated ones, so lookups see a realistic fill
+static void fillBlocks() {
+  const BlockInfo known[] = {
+    {"CUET_CAMPUS", "CUET Campus", 22.4633, 91.9714},
+    {"PAHARTOLI", "Pahartoli", 22.4725, 91.9845},
+    {"NOAPARA", "Noapara", 22.4580, 91.9920},
+    {"RAOJAN", "Raojan", 22.4520, 91.9650}
+  };
+  for (const BlockInfo& block : known) blocks.put(block);
+
+  for (int i = 0; blocks.size() < BlockTable::CAPACITY / 2; i++) {
+    BlockInfo block = {};
+    snprintf(block.blockID, sizeof(block.blockID), "BLOCK_%02d", i);
+    snprintf(block.locationName, sizeof(block.locationName), "Block %d", i);
+    block.lat = 22.44 + 0.001 * i;
+    block.lng = 91.95 + 0.0015 * i;
+    blocks.put(block);
+  }
+}
+
+static void benchGeodesy() {
+  benchHeader("Geodesy (1.6 km apart)");
+  double lat = 22.4633, lng = 91.9714;
+
+  bench("geoVector", [&] {
+    benchKeep(geoVector(lat, lng, 22.4725, 91.9845));
+  });
+  bench("geoVectorExact", [&] {
+    benchKeep(geoVectorExact(lat, lng, 22.4725, 91.9845));
+  });
+  bench("geoMove", [&] {
+    geoMove(lat, lng, 4.2f, 55.0f);
+    benchKeep(lat);
+  });
+}
+
+static void benchNavigation() {
+  benchHeader("Navigation");
+  const char* targets[] = {"CUET_CAMPUS", "PAHARTOLI", "BLOCK_17", "noapara"};
+  size_t next = 0;
+
+  bench("setTargetLocation", [&] {
+    benchKeep(setTargetLocation(blocks, targets[next++ & 3]));
+  });
+  bench("refreshTargetVector", [&] {
+    refreshTargetVector();
+    benchKeep(toTarget);
+  });
+  bench("BlockTable::find", [&] {
+    benchKeep(blocks.find(targets[next++ & 3]));
+  });
+}
+
+static void benchPendingOffer() {
+  benchHeader("Pending ride parsing");
+  RideOffer offer;
+
+  BenchStream json(PENDING_JSON);
+  bench("parsePendingOffer (JSON)", [&] {
+    json.rewind();
+    benchKeep(parsePendingOffer(json, offer));
+  });
+
+  MsgPackBuffer<96> wire;
+  wire.beginMap(1)
+      .key(WIRE_OFFER).beginMap(4)
+      .key(WIRE_RIDE).int32(4821)
+      .key(WIRE_PICKUP).str("CUET_CAMPUS")
+      .key(WIRE_DESTINATION).str("PAHARTOLI")
+      .key(WIRE_DISTANCE).int32(420);
+  bench("decodePendingOffer (MessagePack)", [&] {
+    benchKeep(decodePendingOffer(wire.data(), wire.length(), offer));
+  });
+}
+
+static void benchPayloads() {
+  benchHeader("Payload serialization");
+
+  MsgPackBuffer<48> wire;
+  bench("encodeLocation (MessagePack)", [&] {
+    benchKeep(encodeLocation(wire, "RICK001", 22.463312, 91.971405));
+  });
+
+  JsonBuffer<192> json;
+  bench("register payload (JSON)", [&] {
+    json.clear();
+    json.beginObject()
+        .field("rickshawID", "RICK001")
+        .field("pullerName", "Abdul Karim")
+        .field("phoneNumber", "01712345678")
+        .field("currentLat", 22.463312, 6)
+        .field("currentLng", 91.971405, 6)
+        .endObject();
+    benchKeep(json.length());
+  });
+}
+
+int main() {
+  fillBlocks();
+  benchGeodesy();
+  benchNavigation();
+  benchPendingOffer();
+  benchPayloads();
+  return 0;
+}
@@ -0,0 +1,54 @@
+/*
+ * AERAS Rickshaw Side - GPS receiver
+ */
+
+#include "GpsSource.h"
+
+#include <TinyGPS++.h>
+#include <SpscQueue.h>
+
+static HardwareSerial& gpsSerial = Serial2;
+static TinyGPSPlus gps;
+
+// ~1 s of NMEA at 9600 baud
+static SpscQueue<uint8_t, 1024> nmeaBytes;
+static volatile uint32_t droppedBytes = 0;
+
+// Runs on the UART event task whenever the driver has received data
+static void onGpsData() {
+  while (gpsSerial.available() > 0) {
+    uint8_t c = gpsSerial.read();
+    if (!nmeaBytes.push(c)) droppedBytes++;
+  }
+}
+
+void startGps() {
+  gpsSerial.setRxBufferSize(512);  // Must be set before begin()
+  gpsSerial.begin(GPS_BAUD_RATE, SERIAL_8N1, GPS_UART_RX_PIN, GPS_UART_TX_PIN);
+  gpsSerial.onReceive(onGpsData);
+}
+
+bool pollGps(GpsFix& fix) {
+  bool updated = false;
+  uint8_t c;
+
+  for (uint16_t fed = 0; fed < GPS_PARSE_BUDGET && nmeaBytes.pop(c); fed++) {
+    // encode() is true at the end of each sentence
+    if (gps.encode(c) && gps.location.isUpdated() && gps.location.isValid()) {
+      updated = true;
+    }
+  }
+  if (!updated) return false;
+
+  fix.lat = gps.location.lat();
+  fix.lng = gps.location.lng();
+  fix.speedKmh = gps.speed.isValid() ? gps.speed.kmph() : 0;
+  fix.course = gps.course.isValid() ? gps.course.deg() : 0;
+  fix.satellites = gps.satellites.isValid() ? gps.satellites.value() : 0;
+  fix.hdop = gps.hdop.isValid() ? gps.hdop.hdop() : 0;
+  return true;
+}
+
+uint32_t gpsDroppedBytes() {
+  return droppedBytes;
+}
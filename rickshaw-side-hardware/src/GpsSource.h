@@ -0,0 +1,37 @@
+/*
+ * AERAS Rickshaw Side - GPS receiver
+ * NMEA bytes are pulled off UART2 by the UART driver's event task
+ * (HardwareSerial::onReceive) into a lock-free ring buffer; the UI loop
+ * feeds a bounded slice of that buffer to TinyGPSPlus on every pass, so
+ * neither side ever waits on the other or on the serial line.
+ *
+ * Only built with -D AERAS_REAL_GPS (see platformio.ini); otherwise the
+ * navigation code is driven by the movement simulator.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+#define GPS_UART_RX_PIN     16
+#define GPS_UART_TX_PIN     17
+#define GPS_BAUD_RATE       9600
+#define GPS_PARSE_BUDGET    256  // Bytes handed to the parser per pollGps()
+
+struct GpsFix {
+  double lat;
+  double lng;
+  float speedKmh;
+  float course;          // Degrees, valid only while moving
+  uint8_t satellites;
+  float hdop;
+};
+
+void startGps();
+
+// UI side: parses what arrived since the last call. True when it produced
+// a new valid position.
+bool pollGps(GpsFix& fix);
+
+// Bytes lost because the parser fell behind (ring buffer full)
+uint32_t gpsDroppedBytes();
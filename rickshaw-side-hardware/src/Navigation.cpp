@@ -0,0 +1,35 @@
+/*
+ * AERAS Rickshaw Side - Navigation state
+ */
+
+#include "Navigation.h"
+
+#include <AerasLog.h>
+
+double currentLat = 22.4633;
+double currentLng = 91.9714;
+
+BlockInfo targetLocation = {"", "", 0, 0};
+GeoVector toTarget = {0, 0};
+
+void refreshTargetVector() {
+  toTarget = geoVector(currentLat, currentLng, targetLocation.lat, targetLocation.lng);
+}
+
+bool setTargetLocation(const BlockTable& blocks, const char* blockID) {
+  logLine("Searching for location: %s", blockID);
+
+  // Rides carry backend blockIDs; one hashed lookup instead of a name scan
+  const BlockInfo* block = blocks.find(blockID);
+  if (!block) {
+    logLine("✗ Could not find location: %s", blockID);
+    return false;
+  }
+
+  targetLocation = *block;
+  refreshTargetVector();
+  logLine("✓ Target set: %s", targetLocation.blockID);
+  logLine("  Coords: %.6f, %.6f", targetLocation.lat, targetLocation.lng);
+  logLine("  Distance: %.1f m", toTarget.meters);
+  return true;
+}
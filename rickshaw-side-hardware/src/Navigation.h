@@ -0,0 +1,31 @@
+/*
+ * AERAS Rickshaw Side - Navigation state
+ * Where the rickshaw is, which block it is driving to and the
+ * distance/bearing between the two. Nothing here touches hardware, so the
+ * native build (platformio.ini [env:native]) links it into the host
+ * benchmarks in bench/.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <BackendMessages.h>
+#include <BlockTable.h>
+#include <Geodesy.h>
+
+// Moved by the simulator, or by GPS fixes when built with AERAS_REAL_GPS
+extern double currentLat;
+extern double currentLng;
+
+// Block being driven to (pickup, then destination)
+extern BlockInfo targetLocation;
+
+// Distance/bearing from the current position to targetLocation. Refreshed
+// once whenever either of them moves; every consumer reads this copy.
+extern GeoVector toTarget;
+
+// Call after currentLat/currentLng changed
+void refreshTargetVector();
+
+// Navigates to blockID; false (target unchanged) when blocks does not know it
+bool setTargetLocation(const BlockTable& blocks, const char* blockID);
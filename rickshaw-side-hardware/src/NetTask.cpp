@@ -0,0 +1,693 @@
+/*
+ * AERAS Rickshaw Side - Network task
+ */
+
+#include "NetTask.h"
+
+#include <WiFi.h>
+#include <HttpSession.h>
+#include <EventStream.h>
+#include <FixedWriter.h>
+#include <AerasLog.h>
+#include <TimerWheel.h>
+#include <DeviceWire.h>
+#include <Telemetry.h>
+#include <WifiLink.h>
+#include <RideSync.h>
+#include "RideJournal.h"
+
+static SpscQueue<NetCommand, 8> commandQueue;
+static SpscQueue<NetEvent, 8> eventQueue;
+static TaskHandle_t netTaskHandle = nullptr;
+static WifiLink* wifiLink = nullptr;  // Run by this task once it is started
+
+// Owned by the network task; the UI loop has its own wheel
+static TimerWheel scheduler;
+
+static const char* rickshawID = "";
+static const char* pullerName = "";
+
+// Both sessions are only ever touched from the network task.
+// One kept-alive socket for request/response calls and a second one that
+// stays parked on the ride status long-poll
+static HttpSession backend;
+static HttpSession statusSession;
+// Third socket: the backend pushes offers and ride changes down it
+static EventStream pushChannel;
+
+static JsonBuffer<192> payload;
+static TextBuffer<96> requestPath;
+
+// Device endpoints use the compact wire format (DeviceWire.h) both ways.
+// Replies are decoded from wireReply in place; one at a time, since only
+// this task reads them.
+static MsgPackBuffer<48> wirePayload;
+static MsgPackBuffer<512> wireBatch;
+static uint8_t wireReply[512];
+
+static size_t readWireReply(HttpSession& session) {
+  return session.readBody(wireReply, sizeof(wireReply));
+}
+
+// ===== What the UI wants watched =====
+static long trackedRideID = 0;  // 0 = nothing offered/active
+static bool onRide = false;
+static char sinceStatus[AERAS_STATUS_LENGTH] = "";
+
+// ===== Ride status long-poll =====
+static StatusPollPacer statusPacer;
+static long watchedRideID = 0;
+static bool statusPollInFlight = false;
+
+// ===== Queues =====
+bool sendNetCommand(const NetCommand& command) {
+  if (!commandQueue.push(command)) return false;
+  if (netTaskHandle) xTaskNotifyGive(netTaskHandle);  // Wake the task early
+  return true;
+}
+
+bool receiveNetEvent(NetEvent& event) {
+  return eventQueue.pop(event);
+}
+
+// The UI drains events every loop pass, so a full queue only lasts a moment
+static void postEvent(const NetEvent& event) {
+  for (int attempt = 0; attempt < 100; attempt++) {
+    if (eventQueue.push(event)) return;
+    vTaskDelay(pdMS_TO_TICKS(10));
+  }
+  logLine("✗ Net: event queue full, dropped event %d", event.type);
+}
+
+static NetEvent makeEvent(NetEventType type, long rideID, int httpCode) {
+  NetEvent event;
+  memset(&event, 0, sizeof(event));
+  event.type = type;
+  event.rideID = rideID;
+  event.httpCode = httpCode;
+  return event;
+}
+
+// ===== Ride status long-poll =====
+// One request is parked on /ride/<id>/status?since=<status>; the backend
+// answers it as soon as the ride changes, so nothing has to be scraped.
+static void stopRideStatusPoll() {
+  scheduler.cancel("status-stuck");
+  if (statusPollInFlight) {
+    statusSession.close();
+    statusPollInFlight = false;
+  }
+}
+
+static void startRideStatusPoll();
+
+static void armRideStatusPoll() {
+  scheduler.after("status-poll", statusPacer.nextDelay(millis()), startRideStatusPoll);
+}
+
+static void onRideStatusPollStuck() {
+  stopRideStatusPoll();
+  armRideStatusPoll();
+}
+
+static void startRideStatusPoll() {
+  if (trackedRideID == 0 || statusPollInFlight) return;
+  // Pushed changes make the long-poll redundant, but a freshly tracked ride
+  // (no status yet) is still asked once: it may have changed before we
+  // started tracking it
+  if (pushChannel.isOpen() && sinceStatus[0] != '\0') return;
+  if (WiFi.status() != WL_CONNECTED) {
+    armRideStatusPoll();
+    return;
+  }
+
+  statusPacer.start(requestPath, trackedRideID, sinceStatus, millis());
+  if (!statusSession.send("GET", requestPath.c_str())) {
+    logLine("✗ Status poll: cannot reach backend");
+    armRideStatusPoll();
+    return;
+  }
+
+  watchedRideID = trackedRideID;
+  statusPollInFlight = true;
+  scheduler.after("status-stuck", StatusPollPacer::STUCK_MS, onRideStatusPollStuck);
+}
+
+// Periodic: picks up the long-poll answer as soon as it starts arriving
+static void checkRideStatusReply() {
+  if (!statusPollInFlight || !statusSession.responseReady()) return;
+
+  int httpCode = statusSession.receive();
+  statusPollInFlight = false;  // Socket stays open for the next poll
+  scheduler.cancel("status-stuck");
+  armRideStatusPoll();
+
+  if (httpCode != 200) {
+    logLine("✗ Status poll error: %d", httpCode);
+    return;
+  }
+
+  NetEvent event = makeEvent(NET_EVT_RIDE_STATUS, watchedRideID, httpCode);
+  bool parsed = statusSession.responseIs(AERAS_WIRE_CONTENT_TYPE)
+                    ? decodeRideStatus(wireReply, readWireReply(statusSession), event.status)
+                    : parseRideStatus(statusSession.body(), event.status);
+  if (parsed) {
+    copyText(sinceStatus, event.status.status);  // Next poll waits for a change
+    postEvent(event);
+  }
+}
+
+// ===== Offers (using /ride/pending) =====
+// The first few offers go to the UI, which falls back on the others after
+// a reject or a lost race. Rides offered recently are remembered so a
+// pushed status change can tell the UI one of them is gone.
+static const uint8_t OFFERED_MEMORY = 8;
+static long offeredRideIDs[OFFERED_MEMORY];
+static uint8_t offeredNext = 0;
+static bool offersOutstanding = false;  // The UI may hold offers
+
+static RideOffer polledOffers[NET_OFFERS_PER_POLL];
+static uint8_t polledCount = 0;
+
+static void rememberOffer(long rideID) {
+  for (long offered : offeredRideIDs) {
+    if (offered == rideID) return;
+  }
+  offeredRideIDs[offeredNext] = rideID;
+  offeredNext = (offeredNext + 1) % OFFERED_MEMORY;
+  offersOutstanding = true;
+}
+
+static bool forgetOffer(long rideID) {
+  for (long& offered : offeredRideIDs) {
+    if (offered == rideID) {
+      offered = 0;
+      return true;
+    }
+  }
+  return false;
+}
+
+static bool collectOffer(const RideOffer& offer, void*) {
+  polledOffers[polledCount++] = offer;
+  return polledCount < NET_OFFERS_PER_POLL;
+}
+
+static void checkForRideRequests() {
+  if (onRide || pushChannel.isOpen() || WiFi.status() != WL_CONNECTED) return;
+
+  requestPath.clear();
+  requestPath.appendf("/ride/pending?limit=%d&rickshawID=", NET_OFFERS_PER_POLL)
+             .appendUrlEncoded(rickshawID);
+  int httpCode = backend.get(requestPath.c_str());
+  if (httpCode != 200) return;
+
+  polledCount = 0;
+  bool parsed = backend.responseIs(AERAS_WIRE_CONTENT_TYPE)
+                    ? decodePendingOffers(wireReply, readWireReply(backend), collectOffer, nullptr)
+                    : parsePendingOffers(backend.body(), collectOffer, nullptr);
+  if (!parsed) return;
+
+  if (polledCount == 0) {
+    if (offersOutstanding) postEvent(makeEvent(NET_EVT_OFFER_GONE, 0, httpCode));
+    offersOutstanding = false;
+    return;
+  }
+  for (uint8_t i = 0; i < polledCount; i++) {
+    NetEvent event = makeEvent(NET_EVT_OFFER, polledOffers[i].rideID, httpCode);
+    event.offer = polledOffers[i];
+    event.offerIndex = i;
+    event.offerCount = polledCount;
+    rememberOffer(event.rideID);
+    postEvent(event);
+  }
+}
+
+// ===== Push channel =====
+// While /events is open, offers and ride changes are pushed; the offer poll
+// and the status long-poll only run while it is down.
+static const uint32_t PUSH_RECONNECT_MS = 10000;
+static bool pushWasOpen = false;
+
+static void connectPushChannel() {
+  if (pushChannel.isOpen() || WiFi.status() != WL_CONNECTED) return;
+
+  requestPath.clear();
+  requestPath.append("/events?rickshawID=").appendUrlEncoded(rickshawID);
+  // Its current status comes first, covering changes missed while down
+  if (trackedRideID != 0) requestPath.appendf("&rideID=%ld", trackedRideID);
+  if (!pushChannel.open(requestPath.c_str())) return;
+
+  logLine("📡 Push channel open - offer/status polling paused");
+  pushWasOpen = true;
+  if (sinceStatus[0] != '\0') stopRideStatusPoll();
+}
+
+static void onPushedOffer() {
+  NetEvent event = makeEvent(NET_EVT_OFFER, 0, 200);
+  if (onRide || !parseRideOffer(pushChannel.data(), event.offer)) return;
+
+  event.rideID = event.offer.rideID;
+  rememberOffer(event.rideID);
+  postEvent(event);
+}
+
+// Every ride change is pushed; the tracked ride's are passed on, and
+// offers the UI holds are dropped once someone else has them
+static void onPushedRideStatus() {
+  NetEvent event = makeEvent(NET_EVT_RIDE_STATUS, trackedRideID, 200);
+  if (!parseRideStatus(pushChannel.data(), event.status)) return;
+
+  long rideID = event.status.rideID;
+  if (rideID != trackedRideID && strcmp(event.status.status, "PENDING") != 0 && forgetOffer(rideID)) {
+    postEvent(makeEvent(NET_EVT_OFFER_GONE, rideID, 200));
+  }
+  if (trackedRideID == 0 || rideID != trackedRideID) return;
+  if (strcmp(event.status.status, sinceStatus) == 0) return;
+
+  copyText(sinceStatus, event.status.status);
+  postEvent(event);
+}
+
+// Periodic: hands pushed events on and notices when the stream dropped
+static void checkPushChannel() {
+  char name[16];
+  while (pushChannel.nextEvent(name, sizeof(name))) {
+    if (strcmp(name, "offer") == 0) {
+      onPushedOffer();
+    } else if (strcmp(name, "ride") == 0) {
+      onPushedRideStatus();
+    }
+    pushChannel.endEvent();
+  }
+
+  if (pushWasOpen && !pushChannel.isOpen()) {
+    pushWasOpen = false;
+    logLine("✗ Push channel dropped - polling until it is back");
+    if (trackedRideID != 0) scheduler.after("status-poll", 0, startRideStatusPoll);
+  }
+}
+
+// ===== Commands =====
+static void trackRide(const NetCommand& command) {
+  onRide = command.onRide;
+
+  if (command.rideID != trackedRideID || strcmp(command.status, sinceStatus) != 0) {
+    trackedRideID = command.rideID;
+    copyText(sinceStatus, command.status);
+    stopRideStatusPoll();  // Re-arm the long-poll from the new status
+    if (trackedRideID != 0) {
+      scheduler.after("status-poll", 0, startRideStatusPoll);
+    } else {
+      scheduler.cancel("status-poll");
+    }
+  }
+}
+
+// ===== Registration =====
+// Repeated on every new WiFi link ("register" job), with the latest
+// position, until the backend has taken it
+static NetCommand registration = {};
+static bool registrationWanted = false;
+static uint32_t registeredOnLink = 0;  // WifiLink::connections() when it was taken
+
+static void registerRickshaw() {
+  if (!registrationWanted || !wifiLink->connected()) return;
+  if (registeredOnLink == wifiLink->connections()) return;
+
+  payload.clear();
+  payload.beginObject()
+         .field("rickshawID", rickshawID)
+         .field("pullerName", pullerName)
+         .field("phoneNumber", "01712345678")
+         .field("currentLat", registration.lat, 6)
+         .field("currentLng", registration.lng, 6)
+         .endObject();
+
+  int httpCode = backend.post("/rickshaw/register", payload.c_str());
+  if (httpCode != 200) {
+    logLine("✗ Registration failed: %d", httpCode);
+    return;
+  }
+  logLine(registeredOnLink ? "✓ Registered again after reconnect" : "✓ Registered with backend");
+  registeredOnLink = wifiLink->connections();
+}
+
+static void requestRegistration(const NetCommand& command) {
+  registration = command;
+  registrationWanted = true;
+  registeredOnLink = 0;
+  registerRickshaw();
+}
+
+// ===== Location reports =====
+// The UI only hands over fixes that left its dead-band. On a good link a
+// lone fix goes out fire-and-forget; on a poor one fixes are held and sent
+// as one /rickshaw/location/batch request (one transaction on the backend).
+static const uint8_t LOCATION_BUFFER_SIZE = 16;     // Oldest fix is dropped when full
+static const uint8_t LOCATION_BATCH_SIZE = 4;       // Poor link: flush at this many
+static const uint32_t LOCATION_MAX_HOLD_MS = 30000; // ...or when the oldest is this old
+static const int8_t POOR_LINK_RSSI = -75;           // dBm
+
+struct LocationFix {
+  double lat;
+  double lng;
+  unsigned long takenAt;
+};
+
+static LocationFix locationFixes[LOCATION_BUFFER_SIZE];
+static uint8_t fixHead = 0;   // Oldest buffered fix
+static uint8_t fixCount = 0;
+static bool lastReportFailed = false;
+
+static const LocationFix& bufferedFix(uint8_t age) {
+  return locationFixes[(fixHead + age) % LOCATION_BUFFER_SIZE];
+}
+
+static void bufferLocation(const NetCommand& command) {
+  if (fixCount == LOCATION_BUFFER_SIZE) {
+    fixHead = (fixHead + 1) % LOCATION_BUFFER_SIZE;
+    fixCount--;
+  }
+  LocationFix& fix = locationFixes[(fixHead + fixCount) % LOCATION_BUFFER_SIZE];
+  fix.lat = command.lat;
+  fix.lng = command.lng;
+  fix.takenAt = millis();
+  fixCount++;
+}
+
+static bool sendSingleLocation() {
+  const LocationFix& fix = bufferedFix(0);
+  if (!encodeLocation(wirePayload, rickshawID, fix.lat, fix.lng)) return false;
+
+  // Fire-and-forget: pipelined ahead of the next poll on the same socket
+  return backend.send("POST", "/rickshaw/location", wirePayload.data(), wirePayload.length(),
+                      AERAS_WIRE_CONTENT_TYPE, true);
+}
+
+static bool sendLocationBatch() {
+  unsigned long now = millis();
+  wireBatch.clear();
+  wireBatch.beginMap(2)
+           .key(WIRE_RICKSHAW).str(rickshawID)
+           .key(WIRE_FIXES).beginArray(fixCount);
+  for (uint8_t i = 0; i < fixCount; i++) {
+    const LocationFix& fix = bufferedFix(i);
+    wireBatch.beginArray(3)
+             .coordinate(fix.lat)
+             .coordinate(fix.lng)
+             .uint32((now - fix.takenAt) / 1000);
+  }
+  if (wireBatch.overflowed()) return false;
+
+  int httpCode = backend.request("POST", "/rickshaw/location/batch", wireBatch.data(),
+                                 wireBatch.length(), AERAS_WIRE_CONTENT_TYPE);
+  if (httpCode != 200) {
+    logLine("✗ Location batch (%u fixes) failed: %d", fixCount, httpCode);
+    return false;
+  }
+  logLine("✓ Location batch: %u fixes", fixCount);
+  return true;
+}
+
+// Runs after every new fix and on the "location-flush" timer
+static void flushLocations() {
+  if (fixCount == 0 || WiFi.status() != WL_CONNECTED) return;
+
+  bool poorLink = lastReportFailed || WiFi.RSSI() < POOR_LINK_RSSI;
+  bool holdExpired = millis() - bufferedFix(0).takenAt >= LOCATION_MAX_HOLD_MS;
+  if (poorLink && fixCount < LOCATION_BATCH_SIZE && !holdExpired) return;
+
+  bool sent = (fixCount == 1 && !poorLink) ? sendSingleLocation() : sendLocationBatch();
+  lastReportFailed = !sent;
+  if (sent) {
+    fixHead = 0;
+    fixCount = 0;
+  }
+}
+
+static void sendLocationUpdate(const NetCommand& command) {
+  registration.lat = command.lat;  // A re-registration carries the latest fix
+  registration.lng = command.lng;
+  bufferLocation(command);
+  flushLocations();
+}
+
+// ===== Ride event journal =====
+// Accept/pickup/complete go into the flash journal first and are sent from
+// there as one /ride/events batch; each one leaves the journal only once
+// the backend answered it (JournalReplay decides). Failed batches back off.
+static RideJournal journal;
+static JournalReplay replay;
+
+static const char* journalEventName(uint8_t type) {
+  switch (type) {
+    case NET_CMD_ACCEPT: return "ACCEPT";
+    case NET_CMD_PICKUP: return "PICKUP";
+    default:             return "COMPLETE";
+  }
+}
+
+// WIRE_EVENT_TYPE values
+static char journalEventTag(uint8_t type) {
+  switch (type) {
+    case NET_CMD_ACCEPT: return 'A';
+    case NET_CMD_PICKUP: return 'P';
+    default:             return 'C';
+  }
+}
+
+static NetEventType journalResultType(uint8_t type) {
+  switch (type) {
+    case NET_CMD_ACCEPT: return NET_EVT_ACCEPTED;
+    case NET_CMD_PICKUP: return NET_EVT_PICKUP;
+    default:             return NET_EVT_COMPLETED;
+  }
+}
+
+static void replayJournal();
+
+static uint32_t scheduleJournalRetry() {
+  uint32_t delay = replay.nextRetry();
+  scheduler.after("journal-replay", delay, replayJournal);
+  return delay;
+}
+
+static bool onJournalResult(const RideEventResult& result, void*) {
+  if (replay.batchAnswered()) return false;
+  const JournalEntry& entry = journal.peek(replay.answered());
+  if (!replay.accept(result, entry.seq)) return false;
+
+  NetEvent event = makeEvent(journalResultType(entry.type), entry.rideID, result.status);
+  event.success = result.status == 200 && (entry.type == NET_CMD_PICKUP || result.success);
+  if (entry.type == NET_CMD_COMPLETE) event.complete = result.complete;
+  postEvent(event);
+  return true;
+}
+
+static void replayJournal() {
+  if (journal.pending() == 0) {
+    replay.rush();
+    return;
+  }
+  if (WiFi.status() != WL_CONNECTED) {
+    scheduleJournalRetry();
+    return;
+  }
+
+  uint8_t count = replay.beginBatch(journal.pending());
+  bool fits = true;
+  beginRideEvents(wireBatch, rickshawID, journal.id(), count);
+  for (uint8_t i = 0; i < count; i++) {
+    const JournalEntry& entry = journal.peek(i);
+    fits = encodeRideEvent(wireBatch, entry.seq, journalEventTag(entry.type), entry.rideID,
+                           entry.lat, entry.lng);
+  }
+
+  int httpCode = !fits ? HTTP_SESSION_ERR_SEND
+                       : backend.request("POST", "/ride/events", wireBatch.data(), wireBatch.length(),
+                                         AERAS_WIRE_CONTENT_TYPE);
+  if (httpCode == 200) {
+    if (backend.responseIs(AERAS_WIRE_CONTENT_TYPE)) {
+      decodeRideEventResults(wireReply, readWireReply(backend), onJournalResult, nullptr);
+    } else {
+      parseRideEventResults(backend.body(), onJournalResult, nullptr);
+    }
+  }
+  journal.acknowledge(replay.answered());
+
+  if (!replay.endBatch()) {
+    uint32_t retryMs = scheduleJournalRetry();
+    logLine("✗ Journal replay failed (%d), %u events waiting, retry in %lu ms",
+            httpCode, journal.pending(), (unsigned long)retryMs);
+    return;
+  }
+
+  logLine("✓ Journal: %u events delivered, %u waiting", replay.answered(), journal.pending());
+  if (journal.pending() > 0) scheduler.after("journal-replay", 0, replayJournal);
+}
+
+static void journalRideEvent(const NetCommand& command) {
+  NetEventType resultType = journalResultType(command.type);
+
+  uint32_t seq;
+  if (!journal.append(command.type, command.rideID, command.lat, command.lng, seq)) {
+    logLine("✗ Journal full - %s for ride %ld not recorded", journalEventName(command.type),
+            command.rideID);
+    postEvent(makeEvent(resultType, command.rideID, NET_ERR_JOURNAL_FULL));
+    return;
+  }
+
+  // A fresh command from the puller: try right away, whatever the backoff
+  scheduler.cancel("journal-replay");
+  replay.rush();
+  replayJournal();
+
+  if (journal.contains(seq)) {
+    logLine("📝 %s for ride %ld journaled (#%lu), will sync when online",
+            journalEventName(command.type), command.rideID, (unsigned long)seq);
+    NetEvent event = makeEvent(resultType, command.rideID, 0);
+    event.queued = true;
+    postEvent(event);
+  }
+}
+
+static void handleCommand(const NetCommand& command) {
+  switch (command.type) {
+    case NET_CMD_TRACK_RIDE: trackRide(command); break;
+    case NET_CMD_REGISTER:   requestRegistration(command); break;
+    case NET_CMD_LOCATION:   sendLocationUpdate(command); break;
+    case NET_CMD_ACCEPT:
+    case NET_CMD_PICKUP:
+    case NET_CMD_COMPLETE:   journalRideEvent(command); break;
+  }
+}
+
+// ===== Telemetry =====
+static const uint32_t TELEMETRY_SAMPLE_MS = 1000;
+static const uint32_t TELEMETRY_UPLOAD_MS = 300000;
+
+static MsgPackBuffer<1536> telemetryReport;
+
+static void sampleTelemetry() {
+  telemetry.sample();
+}
+
+// A failed upload keeps the window growing until the next one gets through
+static void uploadTelemetry() {
+  if (WiFi.status() != WL_CONNECTED) return;
+  if (!telemetry.encode(telemetryReport, WIRE_RICKSHAW, rickshawID)) {
+    logLine("✗ Telemetry report does not fit");
+    return;
+  }
+  int httpCode = backend.request("POST", "/rickshaw/telemetry", telemetryReport.data(),
+                                 telemetryReport.length(), AERAS_WIRE_CONTENT_TYPE);
+  if (httpCode == 200) telemetry.clearWindow();
+  else logLine("✗ Telemetry upload failed: %d", httpCode);
+}
+
+// ===== Block table =====
+static bool addBlock(const BlockInfo& block, void* table) {
+  return static_cast<BlockTable*>(table)->put(block);
+}
+
+// Only runs at boot; static so the spare table does not sit on the stack
+static BlockTable incomingBlocks;
+
+static void syncBlockTable(BlockTable& blocks) {
+  if (WiFi.status() != WL_CONNECTED) return;
+
+  requestPath.clear();
+  requestPath.appendf("/locations?since=%ld", blocks.version());
+  int httpCode = backend.get(requestPath.c_str());
+  if (httpCode == 304) {
+    logLine("✓ Block table v%ld is current", blocks.version());
+    return;
+  }
+  if (httpCode != 200) {
+    logLine("✗ Block table fetch failed: %d", httpCode);
+    return;
+  }
+
+  // Decode into a spare table so a cut-off download keeps the old one
+  long version = 0;
+  incomingBlocks.clear();
+  if (!parseBlockList(backend.body(), version, addBlock, &incomingBlocks) ||
+      incomingBlocks.size() == 0) {
+    logLine("✗ Block table reply unusable");
+    return;
+  }
+  incomingBlocks.setVersion(version);
+  blocks = incomingBlocks;
+
+  if (blocks.save()) {
+    logLine("✓ Block table v%ld: %u blocks (saved)", version, blocks.size());
+  } else {
+    logLine("✗ Block table v%ld not saved to flash", version);
+  }
+}
+
+// ===== Task =====
+static const uint32_t WIFI_LINK_PERIOD_MS = 200;
+static const uint32_t REGISTER_RETRY_MS = 2000;
+
+static void runWifiLink() {
+  wifiLink->run();
+}
+
+// Collects answers to fire-and-forget requests
+static void drainBackend() {
+  backend.poll();
+}
+
+static void netTask(void*) {
+  logLine("✓ Network task running on core %d", xPortGetCoreID());
+
+  scheduler.every("wifi", WIFI_LINK_PERIOD_MS, runWifiLink);
+  scheduler.every("register", REGISTER_RETRY_MS, registerRickshaw);
+  scheduler.every("push-connect", PUSH_RECONNECT_MS, connectPushChannel, true);
+  scheduler.every("push", 50, checkPushChannel);
+  scheduler.every("offer-poll", 3000, checkForRideRequests, true);
+  scheduler.every("status-reply", 50, checkRideStatusReply);
+  scheduler.every("backend-drain", 50, drainBackend);
+  scheduler.every("location-flush", 5000, flushLocations);
+  scheduler.every("telemetry-sample", TELEMETRY_SAMPLE_MS, sampleTelemetry, true);
+  scheduler.every("telemetry-upload", TELEMETRY_UPLOAD_MS, uploadTelemetry);
+  if (journal.pending() > 0) {
+    logLine("📝 %u journaled ride events from before the reboot", journal.pending());
+    scheduler.after("journal-replay", 0, replayJournal);
+  }
+
+  for (;;) {
+    telemetry.loopBegin(LOOP_NET);
+    NetCommand command;
+    while (commandQueue.pop(command)) handleCommand(command);
+
+    scheduler.run();
+
+    // Sleep until the UI sends something or the next timer is due
+    uint32_t sleepMs = scheduler.msUntilNext();
+    telemetry.loopEnd(LOOP_NET, sleepMs);
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(sleepMs));
+  }
+}
+
+void startNetTask(const char* backendUrl, const char* id, const char* name, BlockTable& blocks,
+                  WifiLink& link) {
+  wifiLink = &link;
+  rickshawID = id;
+  pullerName = name;
+  backend.begin(backendUrl);
+  backend.setAccept(AERAS_WIRE_CONTENT_TYPE);
+  backend.setObserver(&telemetry);
+  statusSession.begin(backendUrl, 3000);
+  statusSession.setAccept(AERAS_WIRE_CONTENT_TYPE);
+  statusSession.setObserver(&telemetry);
+  pushChannel.begin(backendUrl);
+  journal.begin();
+
+  syncBlockTable(blocks);
+
+  xTaskCreatePinnedToCore(netTask, "aeras-net", NET_TASK_STACK_SIZE, nullptr,
+                          NET_TASK_PRIORITY, &netTaskHandle, NET_TASK_CORE);
+}
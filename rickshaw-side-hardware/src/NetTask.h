@@ -0,0 +1,84 @@
+/*
+ * AERAS Rickshaw Side - Network task
+ * All backend I/O runs in its own FreeRTOS task pinned to core 0, next to
+ * the WiFi stack. The UI/navigation loop on core 1 only talks to it through
+ * two lock-free queues (commands out, events back), so a slow or dead
+ * backend never stalls the display, the serial console or the movement.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <BackendMessages.h>
+#include <SpscQueue.h>
+#include <BlockTable.h>
+#include <WifiLink.h>
+
+#define NET_TASK_CORE       0
+#define NET_TASK_STACK_SIZE 8192
+#define NET_TASK_PRIORITY   1
+
+// NetEvent::httpCode when a ride event could not even be journaled
+#define NET_ERR_JOURNAL_FULL -20
+
+// Offers asked for per /ride/pending poll (the UI caches them, OfferCache.h)
+#define NET_OFFERS_PER_POLL 4
+
+// ===== UI -> network =====
+enum NetCommandType {
+  NET_CMD_REGISTER,    // lat/lng: announce this rickshaw (again on every new link)
+  NET_CMD_TRACK_RIDE,  // rideID/status/onRide: what the UI is currently showing
+  NET_CMD_LOCATION,    // lat/lng: position report (buffered/batched on a poor link)
+  // Ride events: journaled in flash first, delivered when the link allows
+  NET_CMD_ACCEPT,      // rideID
+  NET_CMD_PICKUP,      // rideID
+  NET_CMD_COMPLETE     // rideID + drop lat/lng
+};
+
+struct NetCommand {
+  NetCommandType type;
+  long rideID;
+  double lat;
+  double lng;
+  bool onRide;                        // NET_CMD_TRACK_RIDE: stop polling offers
+  char status[AERAS_STATUS_LENGTH];   // NET_CMD_TRACK_RIDE: last status seen
+};
+
+// ===== network -> UI =====
+enum NetEventType {
+  NET_EVT_OFFER,        // offer: one pending ride, polled (offerIndex/Count) or pushed
+  NET_EVT_OFFER_GONE,   // rideID: an offer passed on before is taken/withdrawn; 0: all are
+  NET_EVT_RIDE_STATUS,  // status: long-poll answer for the tracked ride
+  NET_EVT_ACCEPTED,     // success: whether the backend gave us the ride
+  NET_EVT_PICKUP,
+  NET_EVT_COMPLETED     // complete: points and drop distance
+};
+
+struct NetEvent {
+  NetEventType type;
+  long rideID;   // Ride the event is about
+  int httpCode;  // Result of the request that produced it (< 0: transport error)
+  bool success;
+  bool queued;   // Ride events: journaled, not delivered yet; the answer follows
+  // NET_EVT_OFFER: place in the polled list and its length (0 for a
+  // pushed offer, which comes on its own)
+  uint8_t offerIndex;
+  uint8_t offerCount;
+  union {
+    RideOffer offer;
+    RideStatusReply status;
+    CompleteReply complete;
+  };
+};
+
+// Brings blocks up to date with the backend (blocking, on the caller's
+// task), then starts the task. The task never touches blocks afterwards,
+// so the UI reads it without locking; link is run (reconnected) by the
+// task from then on. The strings must stay valid for the program's
+// lifetime.
+void startNetTask(const char* backendUrl, const char* rickshawID, const char* pullerName,
+                  BlockTable& blocks, WifiLink& link);
+
+// UI side. sendNetCommand() returns false when the queue is full.
+bool sendNetCommand(const NetCommand& command);
+bool receiveNetEvent(NetEvent& event);
@@ -0,0 +1,88 @@
+/*
+ * AERAS Rickshaw Side - Offer cache
+ */
+
+#include "OfferCache.h"
+
+#include <Geodesy.h>
+
+void OfferCache::clear() {
+  count = 0;
+  preferredRideID = 0;
+}
+
+int OfferCache::find(long rideID) const {
+  for (uint8_t i = 0; i < count; i++) {
+    if (offers[i].offer.rideID == rideID) return i;
+  }
+  return -1;
+}
+
+bool OfferCache::rejected(long rideID) const {
+  for (long id : rejectedRideIDs) {
+    if (id == rideID) return true;
+  }
+  return false;
+}
+
+void OfferCache::removeAt(uint8_t position) {
+  if (offers[position].offer.rideID == preferredRideID) preferredRideID = 0;
+  offers[position] = offers[--count];
+}
+
+void OfferCache::put(const RideOffer& offer, uint8_t index, uint8_t listLength,
+                     const BlockTable& blocks) {
+  bool polled = listLength > 0;
+  if (polled && index == 0) {
+    for (uint8_t i = 0; i < count; i++) offers[i].listed = false;
+    preferredRideID = rejected(offer.rideID) ? 0 : offer.rideID;
+  }
+
+  if (offer.rideID > 0 && !rejected(offer.rideID)) {
+    int position = find(offer.rideID);
+    if (position < 0 && count < CAPACITY) position = count++;
+    if (position >= 0) {
+      CachedOffer& cached = offers[position];
+      cached.offer = offer;
+      cached.listed = true;
+      const BlockInfo* pickup = blocks.find(offer.pickupBlock);
+      cached.located = pickup != nullptr;
+      if (pickup) {
+        cached.pickupLat = pickup->lat;
+        cached.pickupLng = pickup->lng;
+      }
+    }
+  }
+
+  // List complete: whatever it no longer holds is taken or held for others
+  if (polled && index == listLength - 1) {
+    for (uint8_t i = count; i-- > 0;) {
+      if (!offers[i].listed) removeAt(i);
+    }
+  }
+}
+
+void OfferCache::remove(long rideID) {
+  int position = find(rideID);
+  if (position >= 0) removeAt(position);
+}
+
+void OfferCache::reject(long rideID) {
+  remove(rideID);
+  rejectedRideIDs[rejectedNext] = rideID;
+  rejectedNext = (rejectedNext + 1) % REJECTED_MEMORY;
+}
+
+const RideOffer* OfferCache::next(double lat, double lng, long except) {
+  CachedOffer* best = nullptr;
+  for (uint8_t i = 0; i < count; i++) {
+    CachedOffer& cached = offers[i];
+    if (cached.offer.rideID == except) continue;
+    if (cached.located) {
+      cached.offer.distanceKm = geoVector(lat, lng, cached.pickupLat, cached.pickupLng).meters / 1000.0f;
+    }
+    if (cached.offer.rideID == preferredRideID) return &cached.offer;
+    if (!best || cached.offer.distanceKm < best->offer.distanceKm) best = &cached;
+  }
+  return best ? &best->offer : nullptr;
+}
@@ -0,0 +1,58 @@
+/*
+ * AERAS Rickshaw Side - Offer cache
+ * The last few pending rides the backend offered, so that after a REJECT
+ * or a lost accept race the next one is on screen at once instead of
+ * after the next 3 s poll. Each poll replaces the list; pushed offers are
+ * merged in. The backend's first choice (its batch match) is offered
+ * first while it is cached; after that, offers are ranked by the distance
+ * from where the rickshaw is now to their pickup block, recomputed on
+ * every pick, so the ranking follows the rickshaw as it moves.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <BackendMessages.h>
+#include <BlockTable.h>
+
+class OfferCache {
+ public:
+  static const uint8_t CAPACITY = 6;
+  static const uint8_t REJECTED_MEMORY = 8;  // Rejected rides are not offered again
+
+  void clear();
+
+  // index/count: place in a polled /ride/pending list; offers of the
+  // previous list that the new one no longer has are dropped once it is
+  // complete. count 0: a pushed offer on its own.
+  void put(const RideOffer& offer, uint8_t index, uint8_t count, const BlockTable& blocks);
+  void remove(long rideID);
+  void reject(long rideID);
+
+  // Best offer to show from lat/lng (its distanceKm refreshed); nullptr
+  // when none is cached. except: the ride on screen right now.
+  const RideOffer* next(double lat, double lng, long except = 0);
+
+  bool contains(long rideID) const { return find(rideID) >= 0; }
+  uint8_t size() const { return count; }
+
+ private:
+  struct CachedOffer {
+    RideOffer offer;
+    double pickupLat;
+    double pickupLng;
+    bool located;  // Pickup block known: ranked by live distance
+    bool listed;   // Seen in the poll being received
+  };
+
+  bool rejected(long rideID) const;
+  int find(long rideID) const;
+  void removeAt(uint8_t position);
+
+  CachedOffer offers[CAPACITY];
+  uint8_t count = 0;
+  long preferredRideID = 0;  // First of the last poll
+
+  long rejectedRideIDs[REJECTED_MEMORY] = {};
+  uint8_t rejectedNext = 0;
+};
@@ -0,0 +1,77 @@
+/*
+ * AERAS Rickshaw Side - Ride event journal
+ */
+
+#include "RideJournal.h"
+
+#include <Preferences.h>
+
+// NVS keys: "head"/"next" counters and one "e<slot>" blob per ring slot
+static void slotKey(char (&key)[8], uint32_t seq) {
+  snprintf(key, sizeof(key), "e%u", (unsigned)(seq % RideJournal::CAPACITY));
+}
+
+void RideJournal::begin() {
+  Preferences prefs;
+  if (!prefs.begin(RIDE_JOURNAL_NAMESPACE, false)) return;
+
+  journalID = prefs.getUInt("id", 0);
+  if (journalID == 0) {
+    journalID = esp_random() | 1;
+    prefs.putUInt("id", journalID);
+  }
+
+  headSeq = prefs.getUInt("head", 1);
+  nextSeq = prefs.getUInt("next", headSeq);
+  if (nextSeq < headSeq || nextSeq - headSeq > CAPACITY) nextSeq = headSeq;  // Corrupt
+
+  for (uint32_t seq = headSeq; seq < nextSeq; seq++) {
+    char key[8];
+    slotKey(key, seq);
+    JournalEntry& entry = entries[seq % CAPACITY];
+    if (prefs.getBytes(key, &entry, sizeof(entry)) != sizeof(entry) || entry.seq != seq) {
+      nextSeq = seq;  // Keep the intact prefix
+      break;
+    }
+  }
+  prefs.end();
+}
+
+bool RideJournal::append(uint8_t type, long rideID, double lat, double lng, uint32_t& seq) {
+  if (pending() == CAPACITY) return false;
+
+  JournalEntry& entry = entries[nextSeq % CAPACITY];
+  entry.seq = nextSeq;
+  entry.type = type;
+  entry.rideID = rideID;
+  entry.lat = lat;
+  entry.lng = lng;
+
+  // Entry first, then the counter that makes it visible
+  Preferences prefs;
+  if (!prefs.begin(RIDE_JOURNAL_NAMESPACE, false)) return false;
+  char key[8];
+  slotKey(key, nextSeq);
+  bool stored = prefs.putBytes(key, &entry, sizeof(entry)) == sizeof(entry) &&
+                prefs.putUInt("next", nextSeq + 1) > 0;
+  prefs.end();
+  if (!stored) return false;
+
+  seq = nextSeq++;
+  return true;
+}
+
+void RideJournal::acknowledge(uint8_t count) {
+  if (count > pending()) count = pending();
+  if (count == 0) return;
+  headSeq += count;
+  saveCounters();
+}
+
+void RideJournal::saveCounters() {
+  Preferences prefs;
+  if (!prefs.begin(RIDE_JOURNAL_NAMESPACE, false)) return;
+  prefs.putUInt("head", headSeq);
+  prefs.putUInt("next", nextSeq);
+  prefs.end();
+}
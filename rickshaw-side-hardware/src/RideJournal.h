@@ -0,0 +1,53 @@
+/*
+ * AERAS Rickshaw Side - Ride event journal
+ * Accept/pickup/complete are appended here (and to NVS) before anything
+ * is sent, each with a sequence number that, together with the journal's
+ * random ID, is its idempotency key on the backend. Entries leave the journal only once the backend
+ * gave a definitive answer, so a reboot or a dead link never loses one
+ * and replaying one twice is harmless.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+#define RIDE_JOURNAL_NAMESPACE "aeras-journal"
+
+struct JournalEntry {
+  uint32_t seq;
+  uint8_t type;   // NetCommandType of the original command
+  long rideID;
+  double lat;     // Position when the puller issued the command
+  double lng;
+};
+
+class RideJournal {
+ public:
+  static const uint8_t CAPACITY = 16;
+
+  // Restores entries left over from before a reboot
+  void begin();
+
+  // False when CAPACITY entries are still waiting (nothing is overwritten)
+  bool append(uint8_t type, long rideID, double lat, double lng, uint32_t& seq);
+
+  uint8_t pending() const { return nextSeq - headSeq; }
+  // age 0 = oldest pending entry
+  const JournalEntry& peek(uint8_t age) const { return entries[(headSeq + age) % CAPACITY]; }
+  bool contains(uint32_t seq) const { return seq >= headSeq && seq < nextSeq; }
+
+  // Picked once per NVS lifetime, so an erased flash restarting at seq 1
+  // never collides with keys the backend already answered
+  uint32_t id() const { return journalID; }
+
+  // Drops the count oldest entries (answered by the backend)
+  void acknowledge(uint8_t count);
+
+ private:
+  void saveCounters();
+
+  JournalEntry entries[CAPACITY];
+  uint32_t headSeq = 1;  // Oldest unanswered entry
+  uint32_t nextSeq = 1;  // Sequence number of the next append
+  uint32_t journalID = 0;
+};
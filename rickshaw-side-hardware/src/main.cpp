@@ -8,434 +8,351 @@
 #include <Wire.h>
 #include <Adafruit_SSD1306.h>
 #include <WiFi.h>
-#include <HTTPClient.h>
+#include <BackendMessages.h>
+#include <FixedWriter.h>
+#include <AerasLog.h>
+#include <TimerWheel.h>
+#include <OledScreen.h>
+#include <BlockTable.h>
+#include <Geodesy.h>
+#include <Telemetry.h>
+#include <WifiLink.h>
+#include <RideSync.h>
+#include "NetTask.h"
+#include "Navigation.h"
+#include "OfferCache.h"
+#ifdef AERAS_REAL_GPS
+#include "GpsSource.h"
+#endif
 
 // ===== OLED Display =====
 #define SCREEN_WIDTH 128
 #define SCREEN_HEIGHT 64
-Adafruit_SSD1306 display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire);
+Adafruit_SSD1306 display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, -1, OLED_I2C_CLOCK, OLED_I2C_CLOCK);
+OledScreen screen(display);
+
+// Screens whose headers stay on the panel between updates
+enum ScreenLayout {
+  LAYOUT_MESSAGE = 1,
+  LAYOUT_STATUS,
+  LAYOUT_NAVIGATION
+};
 
 // ===== WiFi Configuration =====
 const char* WIFI_SSID = "Wokwi-GUEST";
 const char* WIFI_PASSWORD = "";
 const char* BACKEND_URL = "http://10.172.129.95:3000/api";
+const uint32_t WIFI_BOOT_WAIT_MS = 10000;  // Then boot offline; the link keeps trying
+WifiLink wifiLink;  // Run by the network task once it is started
 
 // ===== Rickshaw Info =====
-String rickshawID = "RICK001";
-String pullerName = "Abdul Karim";
+const char* rickshawID = "RICK001";
+const char* pullerName = "Abdul Karim";
 bool isOnline = true;
 int totalPoints = 0;
 
-// ===== GPS Simulation =====
-struct Location {
-  double lat;
-  double lng;
-  String name;
-};
+// ===== Blocks =====
+// Synced from GET /locations at boot and cached in flash. The built-in
+// set is only used on a first boot without backend (version 0, so the
+// next boot with WiFi downloads the real table).
+BlockTable blockTable;
 
-Location locations[] = {
-  {22.4633, 91.9714, "CUET_CAMPUS"},
-  {22.4725, 91.9845, "PAHARTOLI"},
-  {22.4580, 91.9920, "NOAPARA"},
-  {22.4520, 91.9650, "RAOJAN"}
+const BlockInfo DEFAULT_BLOCKS[] = {
+  {"CUET_CAMPUS", "CUET Campus", 22.4633, 91.9714},
+  {"PAHARTOLI", "Pahartoli", 22.4725, 91.9845},
+  {"NOAPARA", "Noapara", 22.4580, 91.9920},
+  {"RAOJAN", "Raojan", 22.4520, 91.9650}
 };
 
-double currentLat = 22.4633;
-double currentLng = 91.9714;
-
 // ===== Active ride info =====
-String currentRideID = "";
-String pickupLocation = "";
-String destinationLocation = "";
+// Ride state lives in fixed buffers - nothing in the loop allocates
+long currentRideID = 0;  // 0 = no offered/active ride
+char pickupLocation[AERAS_BLOCK_ID_LENGTH] = "";
+char destinationLocation[AERAS_BLOCK_ID_LENGTH] = "";
 bool onActiveRide = false;
 bool pickupConfirmed = false;
 
-// Simulated movement
-Location targetLocation;
+// Offers to fall back on after a reject or a lost race, best first
+OfferCache offerCache;
+void showNextOffer();  // New Ride Request, below
+
+// Simulated movement (position and target: Navigation.h)
 double speedKmPerHour = 15.0;
-unsigned long lastMoveTime = 0;
-unsigned long lastLocationUpdate = 0;
-unsigned long lastRideCheck = 0;
-unsigned long lastStatusCheck = 0;  // NEW: For checking accepted status
+
+// ===== Backend sync =====
+// Backend calls run in the network task (NetTask.cpp), this loop only
+// renders and navigates. lastKnownStatus mirrors the long-poll.
+char lastKnownStatus[AERAS_STATUS_LENGTH] = "";
+bool awaitingBackend = false;  // accept/pickup/complete sent, no answer yet
+const int UI_PERIOD_MS = 100;  // Display/navigation refresh period
+
+// Every periodic job and timed message of the UI loop
+TimerWheel scheduler;
 
 // ===== Helper Functions =====
-void displayMessage(String line1, String line2, String line3 = "") {
-  display.clearDisplay();
-  display.setTextSize(1);
-  display.setTextColor(SSD1306_WHITE);
-  display.setCursor(0, 10);
-  display.println("AERAS SYSTEM");
-  display.println("================");
-  display.setCursor(0, 28);
-  display.println(line1);
-  display.setCursor(0, 40);
-  display.println(line2);
-  if (line3 != "") {
-    display.setCursor(0, 52);
-    display.println(line3);
-  }
-  display.display();
+void drawMessageChrome(Adafruit_SSD1306& panel) {
+  panel.setCursor(0, 10);
+  panel.println("AERAS SYSTEM");
+  panel.println("================");
 }
 
-double calculateDistance(double lat1, double lon1, double lat2, double lon2) {
-  double R = 6371000.0;
-  double dLat = (lat2 - lat1) * PI / 180.0;
-  double dLon = (lon2 - lon1) * PI / 180.0;
-  
-  double a = sin(dLat/2) * sin(dLat/2) +
-             cos(lat1 * PI / 180.0) * cos(lat2 * PI / 180.0) *
-             sin(dLon/2) * sin(dLon/2);
-  
-  double c = 2 * atan2(sqrt(a), sqrt(1-a));
-  return R * c;
+void displayMessage(const char* line1, const char* line2, const char* line3 = "") {
+  screen.useLayout(LAYOUT_MESSAGE, drawMessageChrome);
+  screen.setField(0, 0, 28, line1);
+  screen.setField(1, 0, 40, line2);
+  screen.setField(2, 0, 52, line3);
+  screen.flush();
 }
 
-void setTargetLocation(String locationName) {
-  locationName.toUpperCase();
-  
-  Serial.println("Searching for location: " + locationName);
-  
-  for (int i = 0; i < 4; i++) {
-    bool match = false;
-    
-    if (locations[i].name == locationName) {
-      match = true;
-    }
-    else if (locations[i].name.indexOf(locationName) >= 0) {
-      match = true;
-    }
-    else if (locationName.indexOf("PAHARTOLI") >= 0 && locations[i].name == "PAHARTOLI") {
-      match = true;
-    }
-    else if (locationName.indexOf("CUET") >= 0 && locations[i].name == "CUET_CAMPUS") {
-      match = true;
-    }
-    else if (locationName.indexOf("NOAPARA") >= 0 && locations[i].name == "NOAPARA") {
-      match = true;
-    }
-    else if (locationName.indexOf("RAOJAN") >= 0 && locations[i].name == "RAOJAN") {
-      match = true;
-    }
-    
-    if (match) {
-      targetLocation = locations[i];
-      Serial.println("✓ Target set: " + targetLocation.name);
-      Serial.println("  Coords: " + String(targetLocation.lat, 6) + ", " + String(targetLocation.lng, 6));
-      
-      double dist = calculateDistance(currentLat, currentLng, targetLocation.lat, targetLocation.lng);
-      Serial.println("  Distance: " + String(dist, 1) + " m");
-      return;
-    }
-  }
-  
-  Serial.println("✗ Location not found, trying partial match...");
-  
-  if (locationName.indexOf("PAHAR") >= 0 || locationName.indexOf("Pahar") >= 0) {
-    targetLocation = locations[1];
-    Serial.println("✓ Matched to PAHARTOLI");
-  } else {
-    Serial.println("✗ Could not find location: " + locationName);
-  }
+void drawStatusChrome(Adafruit_SSD1306& panel) {
+  panel.setCursor(0, 10);
+  panel.println("AERAS Rickshaw");
+  panel.println("================");
 }
 
-double calculateBearing(double lat1, double lon1, double lat2, double lon2) {
-  double dLon = (lon2 - lon1) * PI / 180.0;
-  lat1 = lat1 * PI / 180.0;
-  lat2 = lat2 * PI / 180.0;
-  
-  double y = sin(dLon) * cos(lat2);
-  double x = cos(lat1) * sin(lat2) - sin(lat1) * cos(lat2) * cos(dLon);
-  double bearing = atan2(y, x) * 180.0 / PI;
-  
-  return fmod((bearing + 360.0), 360.0);
+void displayStatus(const char* status, const char* message) {
+  TextBuffer<OLED_FIELD_LENGTH> line;
+  
+  screen.useLayout(LAYOUT_STATUS, drawStatusChrome);
+  screen.setField(0, 0, 26, line.appendf("Status: %s", status).c_str());
+  screen.setField(1, 0, 34, message);
+  line.clear();
+  screen.setField(2, 0, 42, line.appendf("Points: %d", totalPoints).c_str());
+  screen.flush();
 }
 
-void displayStatus(String status, String message) {
-  display.clearDisplay();
-  display.setTextSize(1);
-  display.setCursor(0, 10);
-  display.println("AERAS Rickshaw");
-  display.println("================");
-  display.print("Status: ");
-  display.println(status);
-  display.println(message);
-  display.print("Points: ");
-  display.println(totalPoints);
-  display.display();
+// ===== Timed messages =====
+// A message shown with holdDisplay() stays up for its time without a
+// delay(); the navigation screen and new offers wait until it is released.
+bool displayHeld = false;
+TimerCallback afterDisplayHold = nullptr;
+
+void releaseDisplay() {
+  displayHeld = false;
+  TimerCallback next = afterDisplayHold;
+  afterDisplayHold = nullptr;
+  if (next) next();
+}
+
+void holdDisplay(uint32_t ms, TimerCallback then = nullptr) {
+  displayHeld = true;
+  afterDisplayHold = then;
+  scheduler.after("display-hold", ms, releaseDisplay);
+}
+
+void showAvailable() {
+  displayStatus("AVAILABLE", "Waiting for rides");
+}
+
+void showRideReset() {
+  showAvailable();
+  logLine("✓ System reset - Ready for new rides\n");
+}
+
+void clearRide() {
+  onActiveRide = false;
+  pickupConfirmed = false;
+  currentRideID = 0;
+  pickupLocation[0] = '\0';
+  destinationLocation[0] = '\0';
+  lastKnownStatus[0] = '\0';
 }
 
-// ===== Register Rickshaw =====
-void registerRickshaw() {
-  if (WiFi.status() != WL_CONNECTED) return;
+// ===== Network task link =====
+// Tells the network task which ride to long-poll and whether to keep
+// polling offers; sent whenever that picture changes.
+void publishRideState() {
+  static long publishedRideID = -1;
+  static bool publishedOnRide = false;
+  static char publishedStatus[AERAS_STATUS_LENGTH] = "";
+  
+  if (currentRideID == publishedRideID && onActiveRide == publishedOnRide &&
+      strcmp(lastKnownStatus, publishedStatus) == 0) {
+    return;
+  }
   
-  HTTPClient http;
-  String url = String(BACKEND_URL) + "/rickshaw/register";
+  NetCommand command = {};
+  command.type = NET_CMD_TRACK_RIDE;
+  command.rideID = currentRideID;
+  command.onRide = onActiveRide;
+  copyText(command.status, lastKnownStatus);
+  if (!sendNetCommand(command)) return;  // Retried on the next loop pass
   
-  http.begin(url);
-  http.addHeader("Content-Type", "application/json");
+  publishedRideID = currentRideID;
+  publishedOnRide = onActiveRide;
+  copyText(publishedStatus, lastKnownStatus);
+}
+
+bool requestFromNetTask(NetCommandType type) {
+  if (awaitingBackend) {
+    logLine("✗ Still waiting for the backend");
+    return false;
+  }
   
-  String payload = "{";
-  payload += "\"rickshawID\":\"" + rickshawID + "\",";
-  payload += "\"pullerName\":\"" + pullerName + "\",";
-  payload += "\"phoneNumber\":\"01712345678\",";
-  payload += "\"currentLat\":" + String(currentLat, 6) + ",";
-  payload += "\"currentLng\":" + String(currentLng, 6);
-  payload += "}";
+  NetCommand command = {};
+  command.type = type;
+  command.rideID = currentRideID;
+  command.lat = currentLat;
+  command.lng = currentLng;
   
-  int httpCode = http.POST(payload);
-  if (httpCode > 0) {
-    Serial.println("✓ Registered with backend");
+  if (!sendNetCommand(command)) {
+    logLine("✗ Network busy - try again");
+    return false;
   }
-  
-  http.end();
+  awaitingBackend = true;
+  return true;
 }
 
-// ===== NEW: Check if web app accepted a ride =====
-void checkWebAppAcceptance() {
-  if (WiFi.status() != WL_CONNECTED) return;
-  if (onActiveRide) return;  // Already on a ride
-  if (currentRideID == "") return;  // No pending ride to check
-  if (millis() - lastStatusCheck < 2000) return;  // Check every 2 seconds
+// Reacts to a status reported by the backend for currentRideID
+void handleRideStatus(const RideStatusReply& reply) {
+  const char* status = reply.status;
   
-  lastStatusCheck = millis();
+  if (strcmp(status, lastKnownStatus) != 0) {
+    logLine("Status changed: %s -> %s", lastKnownStatus, status);
+    copyText(lastKnownStatus, status);
+  }
   
-  HTTPClient http;
-  String url = String(BACKEND_URL) + "/admin/rides?limit=10";
+  if (!onActiveRide) {
+    if (strcmp(status, "ACCEPTED") == 0 && strcmp(reply.rickshawID, rickshawID) == 0) {
+      // Web app accepted! Take ride details if we don't have them
+      if (pickupLocation[0] == '\0') copyText(pickupLocation, reply.pickupBlock);
+      if (destinationLocation[0] == '\0') copyText(destinationLocation, reply.destination);
+      
+      logLine("\n🌐 WEB APP ACCEPTED RIDE!");
+      logLine("   Ride ID: %ld", currentRideID);
+      logLine("   Pickup: %s", pickupLocation);
+      logLine("   Destination: %s", destinationLocation);
+      
+      onActiveRide = true;
+      pickupConfirmed = false;
+      offerCache.clear();
+      
+      setTargetLocation(blockTable, pickupLocation);
+      
+      displayMessage("Web Accepted!", "Going to pickup", pickupLocation);
+      holdDisplay(2000);
+    }
+    else if (strcmp(status, "PENDING") != 0) {
+      // Offer is gone - accepted by another puller, timed out or cancelled
+      logLine("⚠️ Ride %ld no longer available (%s)", currentRideID, status);
+      offerCache.remove(currentRideID);
+      clearRide();
+      showNextOffer();
+    }
+    return;
+  }
   
-  http.begin(url);
-  int httpCode = http.GET();
+  bool finished = strcmp(status, "COMPLETED") == 0 || strcmp(status, "PENDING_REVIEW") == 0;
+  bool cancelled = strcmp(status, "PENDING") == 0 || strcmp(status, "CANCELLED") == 0;
   
-  if (httpCode == 200) {
-    String response = http.getString();
+  // NEW: Check if pickup was confirmed from web app
+  if (strcmp(status, "PICKUP") == 0 && !pickupConfirmed) {
+    logLine("\n🌐 🌐 🌐 WEB APP CONFIRMED PICKUP! 🌐 🌐 🌐");
+    pickupConfirmed = true;
+    
+    if (destinationLocation[0] == '\0') copyText(destinationLocation, reply.destination);
     
-    // Only look for OUR current pending ride ID
-    String searchString = "\"rideID\":" + currentRideID;
-    int ridePos = response.indexOf(searchString);
+    logLine("🗺️ Setting navigation to DESTINATION...");
+    logLine("   Destination: %s", destinationLocation);
+    setTargetLocation(blockTable, destinationLocation);
     
-    if (ridePos > 0) {
-      // Found our ride, now check its status
-      int statusPos = response.indexOf("\"status\":\"", ridePos);
-      if (statusPos > 0 && statusPos < ridePos + 500) {  // Within same ride object
-        int statusStart = statusPos + 10;
-        int statusEnd = response.indexOf("\"", statusStart);
-        String status = response.substring(statusStart, statusEnd);
-        
-        // Check if assigned to us
-        int rickshawPos = response.indexOf("\"rickshawID\":\"", ridePos);
-        if (rickshawPos > 0 && rickshawPos < ridePos + 500) {
-          int rickStart = rickshawPos + 14;
-          int rickEnd = response.indexOf("\"", rickStart);
-          String assignedRick = response.substring(rickStart, rickEnd);
-          
-          if (assignedRick == rickshawID && status == "ACCEPTED") {
-            // Web app accepted! Extract ride details if we don't have them
-            if (pickupLocation == "") {
-              int pickupPos = response.indexOf("\"pickupBlock\":\"", ridePos);
-              int pickupStart = pickupPos + 15;
-              int pickupEnd = response.indexOf("\"", pickupStart);
-              pickupLocation = response.substring(pickupStart, pickupEnd);
-            }
-            
-            if (destinationLocation == "") {
-              int destPos = response.indexOf("\"destination\":\"", ridePos);
-              int destStart = destPos + 15;
-              int destEnd = response.indexOf("\"", destStart);
-              destinationLocation = response.substring(destStart, destEnd);
-            }
-            
-            Serial.println("\n🌐 WEB APP ACCEPTED RIDE!");
-            Serial.println("   Ride ID: " + currentRideID);
-            Serial.println("   Pickup: " + pickupLocation);
-            Serial.println("   Destination: " + destinationLocation);
-            
-            onActiveRide = true;
-            pickupConfirmed = false;
-            
-            setTargetLocation(pickupLocation);
-            
-            displayMessage("Web Accepted!", "Going to pickup", pickupLocation);
-            delay(2000);
-            
-            return;
-          }
-        }
-      }
+    displayMessage("Web Pickup OK", "Going to dest", destinationLocation);
+    holdDisplay(2000);
+    
+    logLine("\n🚗 DRIVING TO DESTINATION...\n");
+  }
+  // Check if ride was completed (or cancelled) from web app
+  else if (finished || cancelled) {
+    if (finished) {
+      logLine("\n🌐 🌐 🌐 WEB APP COMPLETED RIDE! 🌐 🌐 🌐");
+    } else {
+      logLine("\n🌐 RIDE CANCELLED FROM WEB APP");
     }
+    logLine("   Resetting system...");
+    
+    clearRide();
+    
+    displayStatus("AVAILABLE", "Waiting for rides");
+    logLine("✓ System reset - Ready for new rides\n");
   }
-  
-  http.end();
 }
 
-// ===== NEW: Check for ride status updates (pickup/complete) =====
-void checkRideStatusUpdates() {
-  if (WiFi.status() != WL_CONNECTED) return;
-  if (!onActiveRide) return;  // Only check when on active ride
-  if (currentRideID == "") return;
-  if (millis() - lastStatusCheck < 1500) return;  // Check every 1.5 seconds (faster!)
+// ===== New Ride Request (polled by the network task) =====
+void showRideOffer(const RideOffer& offer) {
+  if (onActiveRide || displayHeld || offer.rideID == currentRideID) return;
   
-  lastStatusCheck = millis();
+  screen.beginFreeform();
+  display.setCursor(0, 0);
+  display.println("NEW RIDE REQUEST");
+  display.println("================");
   
-  HTTPClient http;
-  String url = String(BACKEND_URL) + "/admin/rides?limit=10";
+  display.print("Pickup: ");
+  display.println(offer.pickupBlock);
   
-  http.begin(url);
-  http.setTimeout(3000);
-  int httpCode = http.GET();
+  display.print("Dest: ");
+  display.println(offer.destination);
   
-  if (httpCode == 200) {
-    String response = http.getString();
-    
-    // Look for our current ride
-    String searchString = "\"rideID\":" + currentRideID;
-    int ridePos = response.indexOf(searchString);
-    
-    if (ridePos > 0) {
-      // Check status
-      int statusPos = response.indexOf("\"status\":\"", ridePos);
-      if (statusPos > 0 && statusPos < ridePos + 500) {
-        int statusStart = statusPos + 10;
-        int statusEnd = response.indexOf("\"", statusStart);
-        String status = response.substring(statusStart, statusEnd);
-        
-        // Debug logging
-        static String lastStatus = "";
-        if (status != lastStatus) {
-          Serial.println("Status changed: " + lastStatus + " -> " + status);
-          lastStatus = status;
-        }
-        
-        // NEW: Check if pickup was confirmed from web app
-        if (status == "PICKUP" && !pickupConfirmed) {
-          Serial.println("\n🌐 🌐 🌐 WEB APP CONFIRMED PICKUP! 🌐 🌐 🌐");
-          pickupConfirmed = true;
-          
-          // Extract destination if we don't have it
-          if (destinationLocation == "") {
-            int destPos = response.indexOf("\"destination\":\"", ridePos);
-            if (destPos > 0) {
-              int destStart = destPos + 15;
-              int destEnd = response.indexOf("\"", destStart);
-              destinationLocation = response.substring(destStart, destEnd);
-            }
-          }
-          
-          Serial.println("🗺️ Setting navigation to DESTINATION...");
-          Serial.println("   Destination: " + destinationLocation);
-          setTargetLocation(destinationLocation);
-          
-          displayMessage("Web Pickup OK", "Going to dest", destinationLocation);
-          delay(2000);
-          
-          Serial.println("\n🚗 DRIVING TO DESTINATION...\n");
-        }
-        // Check if ride was completed from web app
-        else if (status == "COMPLETED" && onActiveRide) {
-          Serial.println("\n🌐 🌐 🌐 WEB APP COMPLETED RIDE! 🌐 🌐 🌐");
-          Serial.println("   Resetting system...");
-          
-          onActiveRide = false;
-          pickupConfirmed = false;
-          currentRideID = "";
-          pickupLocation = "";
-          destinationLocation = "";
-          
-          displayStatus("AVAILABLE", "Waiting for rides");
-          Serial.println("✓ System reset - Ready for new rides\n");
-        }
-      }
-    } else {
-      Serial.println("⚠️ Could not find ride " + currentRideID + " in response");
-    }
-  } else {
-    Serial.println("✗ HTTP Error checking status: " + String(httpCode));
-  }
+  display.print("Distance: ");
+  display.print(offer.distanceKm, 2);
+  display.println(" km");
   
-  http.end();
+  display.print("Est.Points: ");
+  if (offer.distanceKm <= 2) display.println("10");
+  else if (offer.distanceKm <= 5) display.println("8-10");
+  else display.println("5-10");
+  
+  display.println("");
+  display.println("ACCEPT or REJECT?");
+  screen.flush();
+  
+  logLine("\n📢 📢 📢 NEW RIDE REQUEST! 📢 📢 📢");
+  logLine("Ride ID: %ld", offer.rideID);
+  logLine("Pickup: %s → Destination: %s", offer.pickupBlock, offer.destination);
+  logLine("Distance: %.2f km", offer.distanceKm);
+  logLine("=====================================");
+  logLine("Type 'ACCEPT' to accept this ride");
+  logLine("Type 'REJECT' to reject this ride");
+  logLine("=====================================\n");
+  
+  currentRideID = offer.rideID;
+  lastKnownStatus[0] = '\0';  // New ride - ask for its status straight away
+  copyText(pickupLocation, offer.pickupBlock);
+  copyText(destinationLocation, offer.destination);
 }
 
-// ===== Check for Ride Requests (using /ride/pending) =====
-void checkForRideRequests() {
-  if (WiFi.status() != WL_CONNECTED) return;
-  if (millis() - lastRideCheck < 3000) return;
-  lastRideCheck = millis();
-  
-  HTTPClient http;
-  String url = String(BACKEND_URL) + "/ride/pending?rickshawID=" + rickshawID;
-  
-  http.begin(url);
-  int httpCode = http.GET();
+// Best cached offer from where we are now, else the idle screen
+void showNextOffer() {
+  const RideOffer* offer = offerCache.next(currentLat, currentLng);
+  if (offer) showRideOffer(*offer);
+  else showAvailable();
+}
+
+void onOfferReceived(const NetEvent& event) {
+  offerCache.put(event.offer, event.offerIndex, event.offerCount, blockTable);
   
-  if (httpCode == 200) {
-    String response = http.getString();
-    
-    if (response.indexOf("\"rides\":[") > 0 && response.indexOf("\"rideID\":") > 0) {
-      int rideIDStart = response.indexOf("\"rideID\":") + 9;
-      int rideIDEnd = response.indexOf(",", rideIDStart);
-      String rideID = response.substring(rideIDStart, rideIDEnd);
-      
-      if (rideID != currentRideID || currentRideID == "") {
-        
-        int pickupStart = response.indexOf("\"pickupBlock\":\"") + 15;
-        int pickupEnd = response.indexOf("\"", pickupStart);
-        String pickup = response.substring(pickupStart, pickupEnd);
-        
-        int destStart = response.indexOf("\"destination\":\"") + 15;
-        int destEnd = response.indexOf("\"", destStart);
-        String dest = response.substring(destStart, destEnd);
-        
-        int distStart = response.indexOf("\"distance\":\"") + 12;
-        int distEnd = response.indexOf("\"", distStart);
-        String distance = response.substring(distStart, distEnd);
-        
-        display.clearDisplay();
-        display.setTextSize(1);
-        display.setCursor(0, 0);
-        display.println("NEW RIDE REQUEST");
-        display.println("================");
-        
-        display.print("Pickup: ");
-        display.println(pickup);
-        
-        display.print("Dest: ");
-        display.println(dest);
-        
-        display.print("Distance: ");
-        display.print(distance);
-        display.println(" km");
-        
-        display.print("Est.Points: ");
-        float dist = distance.toFloat();
-        if (dist <= 2) display.println("10");
-        else if (dist <= 5) display.println("8-10");
-        else display.println("5-10");
-        
-        display.println("");
-        display.println("ACCEPT or REJECT?");
-        display.display();
-        
-        Serial.println("\n📢 📢 📢 NEW RIDE REQUEST! 📢 📢 📢");
-        Serial.println("Ride ID: " + rideID);
-        Serial.println("Pickup: " + pickup + " → Destination: " + dest);
-        Serial.println("Distance: " + distance + " km");
-        Serial.println("=====================================");
-        Serial.println("Type 'ACCEPT' to accept this ride");
-        Serial.println("Type 'REJECT' to reject this ride");
-        Serial.println("=====================================\n");
-        
-        currentRideID = rideID;
-        pickupLocation = pickup;
-        destinationLocation = dest;
-      }
-    }
+  if (event.offerCount == 0) {
+    // Pushed: the backend matched it to us, so it goes up straight away
+    if (offerCache.contains(event.offer.rideID)) showRideOffer(event.offer);
+    return;
   }
+  if (event.offerIndex + 1 < event.offerCount) return;  // Rest of the poll still queued
   
-  http.end();
+  // Poll complete: fill an empty screen, or replace an offer it dropped
+  if (currentRideID == 0 || !offerCache.contains(currentRideID)) {
+    const RideOffer* offer = offerCache.next(currentLat, currentLng);
+    if (offer) showRideOffer(*offer);
+  }
+}
+
+void onOfferGone(long rideID) {
+  if (rideID == 0) offerCache.clear();
+  else offerCache.remove(rideID);
 }
 
 // ===== Accept Ride =====
 void acceptRide() {
-  if (currentRideID == "" || onActiveRide) {
-    Serial.println("✗ No ride to accept or already on ride");
+  if (currentRideID == 0 || onActiveRide) {
+    logLine("✗ No ride to accept or already on ride");
     return;
   }
   
@@ -444,273 +361,314 @@ void acceptRide() {
     return;
   }
   
-  HTTPClient http;
-  String url = String(BACKEND_URL) + "/ride/accept";
-  
-  http.begin(url);
-  http.addHeader("Content-Type", "application/json");
-  http.setTimeout(5000);  // 5 second timeout
-  
-  String payload = "{";
-  payload += "\"rideID\":" + currentRideID + ",";
-  payload += "\"rickshawID\":\"" + rickshawID + "\"";
-  payload += "}";
-  
-  Serial.println("\n🤝 Accepting ride " + currentRideID + "...");
-  int httpCode = http.POST(payload);
+  logLine("\n🤝 Accepting ride %ld...", currentRideID);
+  if (requestFromNetTask(NET_CMD_ACCEPT)) {
+    displayMessage("Accepting...", "Please wait");
+  }
+}
+
+void onAcceptResult(const NetEvent& event) {
+  if (event.queued) {
+    // Only the backend can say whether the ride is ours; its answer follows
+    logLine("📡 Offline - accept saved, waiting for the backend");
+    displayMessage("Accept Saved", "Waiting for network");
+    return;
+  }
   
-  if (httpCode == 200) {
-    String response = http.getString();
-    
-    if (response.indexOf("\"success\":true") > 0) {
-      Serial.println("✓ ✓ ✓ RIDE ACCEPTED! ✓ ✓ ✓");
-      Serial.println("Pickup: " + pickupLocation);
-      Serial.println("Destination: " + destinationLocation);
+  if (event.httpCode == 200) {
+    if (event.success) {
+      logLine("✓ ✓ ✓ RIDE ACCEPTED! ✓ ✓ ✓");
+      logLine("Pickup: %s", pickupLocation);
+      logLine("Destination: %s", destinationLocation);
       
       onActiveRide = true;
       pickupConfirmed = false;
+      offerCache.clear();
+      copyText(lastKnownStatus, "ACCEPTED");  // Re-arms the long-poll from the new status
       
-      Serial.println("\n🚗 Setting navigation to PICKUP location...");
-      setTargetLocation(pickupLocation);
+      logLine("\n🚗 Setting navigation to PICKUP location...");
+      setTargetLocation(blockTable, pickupLocation);
       
       displayMessage("Ride Accepted!", "Going to pickup");
-      delay(2000);
+      holdDisplay(2000);
       
-      Serial.println("\n🗺️ NAVIGATION STARTED - Moving to pickup...\n");
+      logLine("\n🗺️ NAVIGATION STARTED - Moving to pickup...\n");
     } else {
-      Serial.println("✗ Ride already taken by another puller");
-      displayMessage("Ride Taken", "Try another");
-      delay(2000);
-      currentRideID = "";
-      displayStatus("AVAILABLE", "Waiting for rides");
+      logLine("✗ Ride already taken by another puller");
+      displayMessage("Ride Taken", "Next offer...");
+      offerCache.remove(currentRideID);
+      currentRideID = 0;
+      holdDisplay(1000, showNextOffer);
     }
   } else {
-    Serial.println("✗ HTTP Error: " + String(httpCode));
+    logLine("✗ HTTP Error: %d", event.httpCode);
     displayMessage("Accept Failed", "Try again");
-    delay(2000);
+    holdDisplay(2000);
   }
-  
-  http.end();
 }
 
 // ===== Confirm Pickup =====
 void confirmPickup() {
   if (!onActiveRide || pickupConfirmed) {
-    Serial.println("✗ Not at pickup or already confirmed");
+    logLine("✗ Not at pickup or already confirmed");
     return;
   }
   
-  double distanceToPickup = calculateDistance(
-    currentLat, currentLng,
-    targetLocation.lat, targetLocation.lng
-  );
+  float distanceToPickup = toTarget.meters;
   
-  Serial.println("\n📍 Checking pickup location...");
-  Serial.println("   Distance to pickup: " + String(distanceToPickup, 1) + " m");
+  logLine("\n📍 Checking pickup location...");
+  logLine("   Distance to pickup: %.1f m", distanceToPickup);
   
   if (distanceToPickup > 100) {
-    Serial.println("✗ TOO FAR from pickup location!");
-    Serial.println("   You must be within 100m to confirm pickup");
-    Serial.println("   Current distance: " + String(distanceToPickup, 1) + " m");
-    displayMessage("Too Far!", "Distance: " + String((int)distanceToPickup) + "m");
-    delay(2000);
+    logLine("✗ TOO FAR from pickup location!");
+    logLine("   You must be within 100m to confirm pickup");
+    logLine("   Current distance: %.1f m", distanceToPickup);
+    TextBuffer<24> line;
+    line.appendf("Distance: %dm", (int)distanceToPickup);
+    displayMessage("Too Far!", line.c_str());
+    holdDisplay(2000);
     return;
   }
   
-  HTTPClient http;
-  String url = String(BACKEND_URL) + "/ride/pickup";
-  
-  http.begin(url);
-  http.addHeader("Content-Type", "application/json");
-  
-  String payload = "{\"rideID\":" + currentRideID + "}";
-  
-  int httpCode = http.POST(payload);
+  requestFromNetTask(NET_CMD_PICKUP);
+}
+
+void onPickupResult(const NetEvent& event) {
+  if (pickupConfirmed) {
+    // A journaled pickup reached the backend; navigation already moved on
+    if (event.success) logLine("✓ Pickup synced with backend");
+    else logLine("✗ Pickup sync rejected: %d", event.httpCode);
+    return;
+  }
   
-  if (httpCode == 200) {
-    Serial.println("✓ ✓ ✓ PICKUP CONFIRMED! ✓ ✓ ✓");
+  // Offline the pickup is journaled; the puller carries on to the destination
+  if (event.success || event.queued) {
+    logLine(event.queued ? "✓ PICKUP SAVED OFFLINE" : "✓ ✓ ✓ PICKUP CONFIRMED! ✓ ✓ ✓");
     pickupConfirmed = true;
+    copyText(lastKnownStatus, "PICKUP");
     
-    Serial.println("\n🗺️ Setting navigation to DESTINATION...");
-    Serial.println("   Destination: " + destinationLocation);
-    setTargetLocation(destinationLocation);
+    logLine("\n🗺️ Setting navigation to DESTINATION...");
+    logLine("   Destination: %s", destinationLocation);
+    setTargetLocation(blockTable, destinationLocation);
     
-    displayMessage("Pickup OK", "Going to dest");
-    delay(2000);
+    displayMessage("Pickup OK", "Going to dest", event.queued ? "Saved offline" : "");
+    holdDisplay(2000);
     
-    Serial.println("\n🚗 DRIVING TO DESTINATION...\n");
+    logLine("\n🚗 DRIVING TO DESTINATION...\n");
+  } else {
+    logLine("✗ HTTP Error: %d", event.httpCode);
   }
-  
-  http.end();
 }
 
 // ===== Complete Ride =====
 void completeRide() {
   if (!onActiveRide || !pickupConfirmed) {
-    Serial.println("✗ Cannot complete - not on active ride");
+    logLine("✗ Cannot complete - not on active ride");
     return;
   }
   
-  double distanceToTarget = calculateDistance(
-    currentLat, currentLng,
-    targetLocation.lat, targetLocation.lng
-  );
+  float distanceToTarget = toTarget.meters;
   
-  Serial.println("Distance to destination: " + String(distanceToTarget, 2) + " m");
+  logLine("Distance to destination: %.2f m", distanceToTarget);
   
   if (distanceToTarget > 100) {
-    Serial.println("✗ TOO FAR from destination!");
-    Serial.println("  Current: " + String(currentLat, 6) + ", " + String(currentLng, 6));
-    Serial.println("  Target: " + String(targetLocation.lat, 6) + ", " + String(targetLocation.lng, 6));
-    Serial.println("  Must be within 100m for auto-approval");
-    displayMessage("Too Far!", "Distance: " + String((int)distanceToTarget) + "m");
-    delay(3000);
+    logLine("✗ TOO FAR from destination!");
+    logLine("  Current: %.6f, %.6f", currentLat, currentLng);
+    logLine("  Target: %.6f, %.6f", targetLocation.lat, targetLocation.lng);
+    logLine("  Must be within 100m for auto-approval");
+    TextBuffer<24> line;
+    line.appendf("Distance: %dm", (int)distanceToTarget);
+    displayMessage("Too Far!", line.c_str());
+    holdDisplay(3000);
     return;
   }
   
-  HTTPClient http;
-  String url = String(BACKEND_URL) + "/ride/complete";
+  logLine("Completing ride with drop location:");
+  logLine("  Lat: %.6f", currentLat);
+  logLine("  Lng: %.6f", currentLng);
   
-  http.begin(url);
-  http.addHeader("Content-Type", "application/json");
+  requestFromNetTask(NET_CMD_COMPLETE);
+}
+
+void onCompleteResult(const NetEvent& event) {
+  if (event.queued) {
+    logLine("\n📝 RIDE %ld SAVED OFFLINE - points follow once it syncs", event.rideID);
+    displayMessage("Ride Saved", "Points follow", "when online");
+    clearRide();
+    holdDisplay(3000, showRideReset);
+    return;
+  }
   
-  String payload = "{";
-  payload += "\"rideID\":" + currentRideID + ",";
-  payload += "\"dropLat\":" + String(currentLat, 6) + ",";
-  payload += "\"dropLng\":" + String(currentLng, 6);
-  payload += "}";
+  if (!event.success) {
+    logLine("✗ HTTP Error: %d", event.httpCode);
+    return;
+  }
   
-  Serial.println("Completing ride with drop location:");
-  Serial.println("  Lat: " + String(currentLat, 6));
-  Serial.println("  Lng: " + String(currentLng, 6));
+  const CompleteReply& reply = event.complete;
+  int pointsEarned = reply.points;
+  const char* status = reply.status[0] ? reply.status : "COMPLETED";
   
-  int httpCode = http.POST(payload);
+  totalPoints += pointsEarned;
   
-  if (httpCode == 200) {
-    String response = http.getString();
-    Serial.println("Response: " + response);
-    
-    int pointsStart = response.indexOf("\"points\":") + 9;
-    int pointsEnd = response.indexOf(",", pointsStart);
-    if (pointsEnd == -1) pointsEnd = response.indexOf("}", pointsStart);
-    int pointsEarned = response.substring(pointsStart, pointsEnd).toInt();
-    
-    int distStart = response.indexOf("\"distance\":\"") + 12;
-    int distEnd = response.indexOf("\"", distStart);
-    String dropDist = response.substring(distStart, distEnd);
-    
-    String status = "COMPLETED";
-    if (response.indexOf("\"PENDING_REVIEW\"") > 0) {
-      status = "PENDING_REVIEW";
-    }
-    
-    totalPoints += pointsEarned;
-    
-    Serial.println("\n✓ RIDE COMPLETED!");
-    Serial.println("  Status: " + status);
-    Serial.println("  Points Earned: " + String(pointsEarned));
-    Serial.println("  Drop Distance: " + dropDist + " m");
-    Serial.println("  Total Points: " + String(totalPoints));
-    
-    display.clearDisplay();
-    display.setTextSize(1);
-    display.setCursor(0, 0);
-    display.println("RIDE COMPLETED!");
-    display.println("================");
-    
-    if (pointsEarned == 10) {
-      display.println("PERFECT DROP!");
-    } else if (pointsEarned >= 8) {
-      display.println("GREAT DROP!");
-    } else if (pointsEarned >= 5) {
-      display.println("GOOD DROP");
-    } else if (pointsEarned > 0) {
-      display.println("COMPLETED");
-    } else {
-      display.println("UNDER REVIEW");
-    }
-    
-    display.println("");
-    display.print("Points: +");
-    display.println(pointsEarned);
-    display.print("Distance: ");
-    display.print(dropDist);
-    display.println(" m");
-    display.print("Total: ");
-    display.println(totalPoints);
-    display.println("");
-    display.println("Resetting...");
-    display.display();
-    
-    delay(5000);
-    
-    Serial.println("\n🔄 Resetting system for next ride...");
-    onActiveRide = false;
-    pickupConfirmed = false;
-    currentRideID = "";
-    pickupLocation = "";
-    destinationLocation = "";
-    
-    displayStatus("AVAILABLE", "Waiting for rides");
-    Serial.println("✓ System reset - Ready for new rides\n");
+  logLine("\n✓ RIDE COMPLETED!");
+  logLine("  Status: %s", status);
+  logLine("  Points Earned: %d", pointsEarned);
+  logLine("  Drop Distance: %.2f m", reply.distanceMeters);
+  logLine("  Total Points: %d", totalPoints);
+  
+  screen.beginFreeform();
+  display.setCursor(0, 0);
+  display.println("RIDE COMPLETED!");
+  display.println("================");
+  
+  if (pointsEarned == 10) {
+    display.println("PERFECT DROP!");
+  } else if (pointsEarned >= 8) {
+    display.println("GREAT DROP!");
+  } else if (pointsEarned >= 5) {
+    display.println("GOOD DROP");
+  } else if (pointsEarned > 0) {
+    display.println("COMPLETED");
   } else {
-    Serial.println("✗ HTTP Error: " + String(httpCode));
+    display.println("UNDER REVIEW");
   }
   
-  http.end();
+  display.println("");
+  display.print("Points: +");
+  display.println(pointsEarned);
+  display.print("Distance: ");
+  display.print(reply.distanceMeters, 2);
+  display.println(" m");
+  display.print("Total: ");
+  display.println(totalPoints);
+  display.println("");
+  display.println("Resetting...");
+  screen.flush();
+  
+  logLine("\n🔄 Resetting system for next ride...");
+  clearRide();
+  
+  // Summary stays up for 5 s, then back to the idle screen
+  holdDisplay(5000, showRideReset);
 }
 
-// ===== GPS Movement Simulation =====
-void simulateMovement() {
-  if (!onActiveRide) return;
+// A completion journaled while offline finally reached the backend
+void onCompletionSynced(const NetEvent& event) {
+  if (!event.success) {
+    logLine("✗ Ride %ld completion rejected: %d", event.rideID, event.httpCode);
+    return;
+  }
   
-  if (millis() - lastMoveTime > 1000) {
-    double distance = calculateDistance(currentLat, currentLng, targetLocation.lat, targetLocation.lng);
-    
-    if (distance > 5) {
-      double bearing = calculateBearing(currentLat, currentLng, targetLocation.lat, targetLocation.lng);
-      
-      double metersPerSecond = (speedKmPerHour * 1000.0) / 3600.0;
+  totalPoints += event.complete.points;
+  logLine("✓ Ride %ld synced: +%d points (%s), total %d", event.rideID, event.complete.points,
+          event.complete.status, totalPoints);
+  if (!onActiveRide && !displayHeld) showAvailable();
+}
+
+// ===== Events from the network task =====
+void handleNetEvents() {
+  NetEvent event;
+  while (receiveNetEvent(event)) {
+    switch (event.type) {
+      case NET_EVT_OFFER:
+        onOfferReceived(event);
+        break;
       
-      double latDegreesPerMeter = 1.0 / 111320.0;
-      double lngDegreesPerMeter = 1.0 / (111320.0 * cos(currentLat * PI / 180.0));
+      case NET_EVT_OFFER_GONE:
+        // Racing offers only; the one on screen follows its own status
+        onOfferGone(event.rideID);
+        break;
       
-      double bearingRad = bearing * PI / 180.0;
-      double deltaLatMeters = metersPerSecond * cos(bearingRad);
-      double deltaLngMeters = metersPerSecond * sin(bearingRad);
+      case NET_EVT_RIDE_STATUS:
+        // Answers for a ride we already dropped are stale
+        if (event.rideID == currentRideID) handleRideStatus(event.status);
+        break;
       
-      currentLat += deltaLatMeters * latDegreesPerMeter;
-      currentLng += deltaLngMeters * lngDegreesPerMeter;
+      case NET_EVT_ACCEPTED:
+        if (!event.queued) awaitingBackend = false;
+        if (event.rideID == currentRideID) onAcceptResult(event);
+        break;
       
-      Serial.println("📍 Moving to " + targetLocation.name);
-      Serial.println("   Distance: " + String(distance, 1) + " m");
-      Serial.println("   Bearing: " + String((int)bearing) + "°");
-      Serial.println("   Current: " + String(currentLat, 6) + ", " + String(currentLng, 6));
-    } else {
-      Serial.println("\n✓ ✓ ✓ ARRIVED at " + targetLocation.name + " ✓ ✓ ✓");
-      Serial.println("   Final coords: " + String(currentLat, 6) + ", " + String(currentLng, 6));
-      Serial.println("   Target coords: " + String(targetLocation.lat, 6) + ", " + String(targetLocation.lng, 6));
-      Serial.println("   Distance: " + String(distance, 2) + " m");
+      case NET_EVT_PICKUP:
+        awaitingBackend = false;
+        if (event.rideID == currentRideID) onPickupResult(event);
+        break;
       
-      if (!pickupConfirmed) {
-        displayMessage("At Pickup!", "Type: PICKUP");
-        Serial.println("\n🎯 AT PICKUP LOCATION - Type 'PICKUP' to confirm\n");
-      } else {
-        displayMessage("At Destination!", "Type: COMPLETE");
-        Serial.println("\n🏁 AT DESTINATION - Type 'COMPLETE' to finish ride\n");
-      }
+      case NET_EVT_COMPLETED:
+        awaitingBackend = false;
+        if (event.rideID == currentRideID) onCompleteResult(event);
+        else if (!event.queued) onCompletionSynced(event);
+        break;
     }
+  }
+}
+
+// ===== Position source =====
+#ifdef AERAS_REAL_GPS
+// Drains the NMEA ring buffer ("gps" timer); every valid fix moves us
+void readGps() {
+  GpsFix fix;
+  if (!pollGps(fix)) return;
+  
+  currentLat = fix.lat;
+  currentLng = fix.lng;
+  refreshTargetVector();
+}
+#else
+// Simulator: one second of travel straight at the target
+void stepSimulatedPosition() {
+  float metersPerSecond = (speedKmPerHour * 1000.0) / 3600.0;
+  geoMove(currentLat, currentLng, metersPerSecond, toTarget.bearing);
+  refreshTargetVector();
+}
+#endif
+
+// ===== Navigation progress =====
+// Once per second ("movement" timer), whatever moves the position
+void advanceNavigation() {
+  if (!onActiveRide) return;
+  
+  float distance = toTarget.meters;
+  
+  if (distance > 5) {
+    float bearing = toTarget.bearing;
+
+#ifndef AERAS_REAL_GPS
+    stepSimulatedPosition();
+#endif
+    
+    logLine("📍 Moving to %s", targetLocation.blockID);
+    logLine("   Distance: %.1f m", distance);
+    logLine("   Bearing: %d°", (int)bearing);
+    logLine("   Current: %.6f, %.6f", currentLat, currentLng);
+  } else {
+    logLine("\n✓ ✓ ✓ ARRIVED at %s ✓ ✓ ✓", targetLocation.blockID);
+    logLine("   Final coords: %.6f, %.6f", currentLat, currentLng);
+    logLine("   Target coords: %.6f, %.6f", targetLocation.lat, targetLocation.lng);
+    logLine("   Distance: %.2f m", distance);
     
-    lastMoveTime = millis();
+    // A timed message (holdDisplay) keeps the screen until it expires
+    if (!pickupConfirmed) {
+      if (!displayHeld) displayMessage("At Pickup!", "Type: PICKUP");
+      logLine("\n🎯 AT PICKUP LOCATION - Type 'PICKUP' to confirm\n");
+    } else {
+      if (!displayHeld) displayMessage("At Destination!", "Type: COMPLETE");
+      logLine("\n🏁 AT DESTINATION - Type 'COMPLETE' to finish ride\n");
+    }
   }
 }
 
 // ===== Navigation Display =====
+void drawNavigationChrome(Adafruit_SSD1306& panel) {
+  panel.setCursor(0, 8);
+  panel.println("================");
+}
+
 void updateNavigationDisplay() {
-  if (!onActiveRide) return;
+  if (!onActiveRide || displayHeld) return;
   
-  double distance = calculateDistance(currentLat, currentLng, targetLocation.lat, targetLocation.lng);
-  double bearing = calculateBearing(currentLat, currentLng, targetLocation.lat, targetLocation.lng);
+  float distance = toTarget.meters;
+  float bearing = toTarget.bearing;
   
   static unsigned long rideStartTime = 0;
   if (rideStartTime == 0) rideStartTime = millis();
@@ -718,55 +676,40 @@ void updateNavigationDisplay() {
   int minutes = rideDuration / 60;
   int seconds = rideDuration % 60;
   
-  display.clearDisplay();
-  display.setTextSize(1);
-  display.setCursor(0, 0);
+  const char* heading;
+  if (bearing >= 337.5 || bearing < 22.5) heading = "N";
+  else if (bearing >= 22.5 && bearing < 67.5) heading = "NE";
+  else if (bearing >= 67.5 && bearing < 112.5) heading = "E";
+  else if (bearing >= 112.5 && bearing < 157.5) heading = "SE";
+  else if (bearing >= 157.5 && bearing < 202.5) heading = "S";
+  else if (bearing >= 202.5 && bearing < 247.5) heading = "SW";
+  else if (bearing >= 247.5 && bearing < 292.5) heading = "W";
+  else heading = "NW";
   
-  if (!pickupConfirmed) {
-    display.println(">> TO PICKUP <<");
-  } else {
-    display.println(">> TO DESTINATION <<");
-  }
-  
-  display.println("================");
+  // Only fields whose text changed since the last pass are redrawn/sent
+  TextBuffer<OLED_FIELD_LENGTH> line;
+  screen.useLayout(LAYOUT_NAVIGATION, drawNavigationChrome);
   
-  display.print("Now: ");
-  display.print(currentLat, 4);
-  display.print(",");
-  display.println(currentLng, 4);
+  screen.setField(0, 0, 0, pickupConfirmed ? ">> TO DESTINATION <<" : ">> TO PICKUP <<");
   
-  display.print("To: ");
-  display.println(targetLocation.name);
+  screen.setField(1, 0, 16, line.appendf("Now: %.4f,%.4f", currentLat, currentLng).c_str());
   
-  display.print("Dist: ");
-  display.print((int)distance);
-  display.print("m ");
+  line.clear();
+  screen.setField(2, 0, 24, line.append("To: ").append(targetLocation.blockID).c_str());
   
-  if (bearing >= 337.5 || bearing < 22.5) display.print("N");
-  else if (bearing >= 22.5 && bearing < 67.5) display.print("NE");
-  else if (bearing >= 67.5 && bearing < 112.5) display.print("E");
-  else if (bearing >= 112.5 && bearing < 157.5) display.print("SE");
-  else if (bearing >= 157.5 && bearing < 202.5) display.print("S");
-  else if (bearing >= 202.5 && bearing < 247.5) display.print("SW");
-  else if (bearing >= 247.5 && bearing < 292.5) display.print("W");
-  else display.print("NW");
+  line.clear();
+  screen.setField(3, 0, 32, line.appendf("Dist: %dm %s", (int)distance, heading).c_str());
   
-  display.println();
+  line.clear();
+  line.append("Time: ");
+  if (minutes > 0) line.appendf("%dm ", minutes);
+  screen.setField(4, 0, 40, line.appendf("%ds", seconds).c_str());
   
-  display.print("Time: ");
-  if (minutes > 0) {
-    display.print(minutes);
-    display.print("m ");
-  }
-  display.print(seconds);
-  display.println("s");
-  
-  display.print("Est.Points: ");
-  if (distance <= 50) display.println("8-10");
-  else if (distance <= 100) display.println("5-8");
-  else display.println("Review");
+  const char* estimate = distance <= 50 ? "8-10" : distance <= 100 ? "5-8" : "Review";
+  line.clear();
+  screen.setField(5, 0, 48, line.append("Est.Points: ").append(estimate).c_str());
   
-  display.display();
+  screen.flush();
   
   if (distance <= 5) {
     rideStartTime = 0;
@@ -774,143 +717,174 @@ void updateNavigationDisplay() {
 }
 
 // ===== Send Location Update =====
+// Sampled every second; LocationReporter keeps a parked rickshaw quiet
+LocationReporter locationReporter;
+
+void markLocationReported() {
+  locationReporter.reported(currentLat, currentLng, millis());
+}
+
 void sendLocationUpdate() {
-  if (WiFi.status() != WL_CONNECTED) return;
-  if (millis() - lastLocationUpdate < 5000) return;
-  lastLocationUpdate = millis();
-  
-  HTTPClient http;
-  String url = String(BACKEND_URL) + "/rickshaw/location";
-  
-  http.begin(url);
-  http.addHeader("Content-Type", "application/json");
-  
-  String payload = "{";
-  payload += "\"rickshawID\":\"" + rickshawID + "\",";
-  payload += "\"lat\":" + String(currentLat, 6) + ",";
-  payload += "\"lng\":" + String(currentLng, 6);
-  payload += "}";
-  
-  http.POST(payload);
-  http.end();
+  if (!locationReporter.due(currentLat, currentLng, onActiveRide, millis())) return;
+  
+  NetCommand command = {};
+  command.type = NET_CMD_LOCATION;
+  command.lat = currentLat;
+  command.lng = currentLng;
+  // Dropped if the network task is backed up; retried on the next sample
+  if (sendNetCommand(command)) markLocationReported();
 }
 
 // ===== Serial Commands =====
 void handleSerialCommand() {
-  String command = Serial.readStringUntil('\n');
-  command.trim();
-  command.toUpperCase();
+  char line[16];
+  size_t length = Serial.readBytesUntil('\n', line, sizeof(line) - 1);
+  line[length] = '\0';
   
-  if (command == "ACCEPT") {
+  // Trim and upper-case in place
+  while (length > 0 && isspace((unsigned char)line[length - 1])) line[--length] = '\0';
+  char* command = line;
+  while (isspace((unsigned char)*command)) command++;
+  for (char* c = command; *c; c++) *c = toupper((unsigned char)*c);
+  
+  if (strcmp(command, "ACCEPT") == 0) {
     acceptRide();
   }
-  else if (command == "REJECT") {
-    Serial.println("Ride rejected");
-    currentRideID = "";
-    displayStatus("AVAILABLE", "Waiting for rides");
+  else if (strcmp(command, "REJECT") == 0) {
+    logLine("Ride rejected");
+    if (currentRideID != 0 && !onActiveRide) offerCache.reject(currentRideID);
+    currentRideID = 0;
+    showNextOffer();
   }
-  else if (command == "PICKUP") {
+  else if (strcmp(command, "PICKUP") == 0) {
     confirmPickup();
   }
-  else if (command == "COMPLETE") {
+  else if (strcmp(command, "COMPLETE") == 0) {
     completeRide();
   }
-  else if (command == "STATUS") {
-    Serial.println("\n===== RICKSHAW STATUS =====");
-    Serial.println("ID: " + rickshawID);
-    Serial.println("Location: " + String(currentLat, 6) + ", " + String(currentLng, 6));
-    Serial.println("Points: " + String(totalPoints));
-    Serial.println("On Ride: " + String(onActiveRide ? "YES" : "NO"));
+  else if (strcmp(command, "STATUS") == 0) {
+    logLine("\n===== RICKSHAW STATUS =====");
+    logLine("ID: %s", rickshawID);
+    logLine("Location: %.6f, %.6f", currentLat, currentLng);
+#ifdef AERAS_REAL_GPS
+    logLine("GPS bytes dropped: %u", (unsigned)gpsDroppedBytes());
+#endif
+    logLine("Points: %d", totalPoints);
+    logLine("On Ride: %s", onActiveRide ? "YES" : "NO");
     if (onActiveRide) {
-      Serial.println("Pickup Confirmed: " + String(pickupConfirmed ? "YES" : "NO"));
-      Serial.println("Target: " + targetLocation.name);
-      double dist = calculateDistance(currentLat, currentLng, targetLocation.lat, targetLocation.lng);
-      Serial.println("Distance to target: " + String(dist, 1) + " m");
+      logLine("Pickup Confirmed: %s", pickupConfirmed ? "YES" : "NO");
+      logLine("Target: %s", targetLocation.blockID);
+      logLine("Distance to target: %.1f m", toTarget.meters);
     }
-    Serial.println("===========================\n");
+    logLine("----- performance -----");
+    telemetry.printTo(Serial);
+    logLine("===========================\n");
   }
-  else if (command == "HELP") {
-    Serial.println("\n===== COMMANDS =====");
-    Serial.println("ACCEPT   - Accept pending ride");
-    Serial.println("REJECT   - Reject pending ride");
-    Serial.println("PICKUP   - Confirm pickup");
-    Serial.println("COMPLETE - Complete ride");
-    Serial.println("STATUS   - Show status");
-    Serial.println("====================\n");
+  else if (strcmp(command, "HELP") == 0) {
+    logLine("\n===== COMMANDS =====");
+    logLine("ACCEPT   - Accept pending ride");
+    logLine("REJECT   - Reject pending ride");
+    logLine("PICKUP   - Confirm pickup");
+    logLine("COMPLETE - Complete ride");
+    logLine("STATUS   - Show status and performance figures");
+    logLine("====================\n");
+  }
+}
+
+// ===== Periodic jobs =====
+// Long-poll answers, offers and request results from the network task
+void syncWithNetTask() {
+  handleNetEvents();
+  publishRideState();
+}
+
+void printRideDebug() {
+  if (!onActiveRide) return;
+  logLine("\n--- STATUS ---");
+  logLine("Ride ID: %ld", currentRideID);
+  logLine("Pickup Confirmed: %s", pickupConfirmed ? "YES" : "NO");
+  logLine("Target: %s", targetLocation.blockID);
+  logLine("Watching ride status (long-poll)...");
+}
+
+void pollSerial() {
+  if (Serial.available()) {
+    handleSerialCommand();
   }
 }
 
 // ===== Setup =====
 void setup() {
   Serial.begin(115200);
-  delay(1000);
-  Serial.println("\n\n=== AERAS RICKSHAW SIDE ===");
+  logLine("\n\n=== AERAS RICKSHAW SIDE ===");
+  
+  // Associates while the display and GPS come up
+  wifiLink.begin(WIFI_SSID, WIFI_PASSWORD);
   
   if(!display.begin(SSD1306_SWITCHCAPVCC, 0x3C)) {
     Serial.println(F("✗ OLED failed"));
     for(;;);
   }
+  screen.begin();
   
   displayMessage("Rickshaw System", "Initializing...");
+
+#ifdef AERAS_REAL_GPS
+  startGps();
+  logLine("✓ GPS on UART2 (RX %d, TX %d)", GPS_UART_RX_PIN, GPS_UART_TX_PIN);
+#endif
   
-  WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
-  Serial.print("Connecting WiFi");
-  int attempts = 0;
-  while (WiFi.status() != WL_CONNECTED && attempts < 40) {
-    delay(500);
-    Serial.print(".");
-    attempts++;
-  }
-  
-  if (WiFi.status() == WL_CONNECTED) {
-    Serial.println("\n✓ WiFi Connected");
-    Serial.println("IP: " + WiFi.localIP().toString());
+  if (wifiLink.waitConnected(WIFI_BOOT_WAIT_MS)) {
     displayMessage("WiFi Connected", rickshawID);
-    delay(2000);
   } else {
-    Serial.println("\n✗ WiFi Failed");
+    logLine("✗ WiFi not up yet - starting offline, reconnecting in background");
     displayMessage("WiFi Error", "Offline Mode");
-    delay(2000);
   }
   
-  registerRickshaw();
+  if (blockTable.load()) {
+    logLine("✓ Block table v%ld from flash", blockTable.version());
+  } else {
+    for (const BlockInfo& block : DEFAULT_BLOCKS) blockTable.put(block);
+    logLine("Using built-in block table");
+  }
+  
+  // Refreshes blockTable from the backend first when it changed
+  startNetTask(BACKEND_URL, rickshawID, pullerName, blockTable, wifiLink);
+  logLine("✓ %u blocks known", blockTable.size());
+  
+  NetCommand registration = {};
+  registration.type = NET_CMD_REGISTER;
+  registration.lat = currentLat;
+  registration.lng = currentLng;
+  sendNetCommand(registration);
+  markLocationReported();  // Registration carries the position
   
   displayStatus("AVAILABLE", "Waiting for rides");
-  Serial.println("\n=== Rickshaw " + rickshawID + " Ready ===");
-  Serial.println("Location: " + String(currentLat, 6) + ", " + String(currentLng, 6));
-  Serial.println("\n✅ WEB APP SYNC ENABLED");
-  Serial.println("Hardware will detect web app acceptances automatically");
-  Serial.println("\nCommands: ACCEPT, REJECT, PICKUP, COMPLETE, STATUS\n");
+  logLine("\n=== Rickshaw %s Ready ===", rickshawID);
+  logLine("Location: %.6f, %.6f", currentLat, currentLng);
+  logLine("\n✅ WEB APP SYNC ENABLED");
+  logLine("Hardware will detect web app acceptances automatically");
+  logLine("\nCommands: ACCEPT, REJECT, PICKUP, COMPLETE, STATUS\n");
+  
+  scheduler.every("net-sync", 20, syncWithNetTask);
+  scheduler.every("serial", 50, pollSerial);
+  scheduler.every("nav-display", UI_PERIOD_MS, updateNavigationDisplay);
+  scheduler.every("movement", 1000, advanceNavigation);
+#ifdef AERAS_REAL_GPS
+  scheduler.every("gps", 50, readGps);
+#endif
+  scheduler.every("location", 1000, sendLocationUpdate);
+  scheduler.every("debug-status", 5000, printRideDebug);
 }
 
 // ===== Main Loop =====
+// UI/navigation task (loopTask, core 1). All work is a scheduler job, so
+// nothing here ever sleeps past the next due timer.
 void loop() {
-  sendLocationUpdate();
-  
-  if (!onActiveRide) {
-    checkForRideRequests();
-    checkWebAppAcceptance();  // Check if web app accepted
-  } else {
-    // Active ride - check for status updates from web app
-    checkRideStatusUpdates();  // Check for pickup/complete from web app
-    simulateMovement();
-    updateNavigationDisplay();
-    
-    // Debug: Print current state every 5 seconds
-    static unsigned long lastDebug = 0;
-    if (millis() - lastDebug > 5000) {
-      lastDebug = millis();
-      Serial.println("\n--- STATUS ---");
-      Serial.println("Ride ID: " + currentRideID);
-      Serial.println("Pickup Confirmed: " + String(pickupConfirmed ? "YES" : "NO"));
-      Serial.println("Target: " + targetLocation.name);
-      Serial.println("Checking web app status...");
-    }
-  }
-  
-  if (Serial.available()) {
-    handleSerialCommand();
-  }
+  telemetry.loopBegin(LOOP_MAIN);
+  scheduler.run();
   
-  delay(100);
-}
\ No newline at end of file
+  uint32_t sleepMs = scheduler.msUntilNext();
+  telemetry.loopEnd(LOOP_MAIN, sleepMs);
+  vTaskDelay(pdMS_TO_TICKS(sleepMs));
+}
@@ -0,0 +1,84 @@
+// Generated by fixture.js from aeras-backend/lib/msgpack.js - do not edit
+
+#pragma once
+
+#include <stdint.h>
+
+static const uint8_t BACKEND_DECODED[] = {
+    0xde, 0x00, 0x12, 0xa1, 0x69, 0xd2, 0xff, 0xfe, 0x1d, 0xc0, 0xa1, 0x75,
+    0xd2, 0x00, 0x00, 0x00, 0x07, 0xa1, 0x66, 0xca, 0x3f, 0xc0, 0x00, 0x00,
+    0xa1, 0x67, 0xca, 0xbd, 0xcc, 0xcc, 0xcd, 0xa1, 0x64, 0xcb, 0x40, 0x06,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xa1, 0x63, 0xd2, 0x01, 0x56, 0xc3,
+    0x44, 0xa1, 0x6e, 0xc0, 0xa1, 0x62, 0xc3, 0xa1, 0x6b, 0xcc, 0xc8, 0xa1,
+    0x77, 0xcd, 0x01, 0x2c, 0xa1, 0x78, 0xce, 0x00, 0x01, 0x11, 0x70, 0xa1,
+    0x7a, 0xfb, 0xa1, 0x76, 0xd0, 0x9c, 0xa1, 0x79, 0xd1, 0xff, 0x38, 0xa1,
+    0x73, 0xda, 0x01, 0x2c, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78,
+    0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78,
+    0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78,
+    0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78,
+    0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78,
+    0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78,
+    0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78,
+    0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78,
+    0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78,
+    0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78,
+    0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78,
+    0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78,
+    0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78,
+    0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78,
+    0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78,
+    0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78,
+    0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78,
+    0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78,
+    0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78,
+    0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78,
+    0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78,
+    0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78,
+    0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78,
+    0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78,
+    0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78, 0x78,
+    0x78, 0x78, 0x78, 0x78, 0xa1, 0x74, 0xd9, 0x24, 0x43, 0x55, 0x45, 0x54,
+    0x5f, 0x43, 0x41, 0x4d, 0x50, 0x55, 0x53, 0x2d, 0x50, 0x41, 0x48, 0x41,
+    0x52, 0x54, 0x4f, 0x4c, 0x49, 0x2d, 0x4e, 0x4f, 0x41, 0x50, 0x41, 0x52,
+    0x41, 0x2d, 0x52, 0x41, 0x4f, 0x4a, 0x41, 0x4e, 0xa1, 0x61, 0xdc, 0x00,
+    0x14, 0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0xcc, 0x88, 0xcc,
+    0x99, 0xcc, 0xaa, 0xcc, 0xbb, 0xcc, 0xcc, 0xcc, 0xdd, 0xcc, 0xee, 0xcc,
+    0xff, 0xcd, 0x01, 0x10, 0xcd, 0x01, 0x21, 0xcd, 0x01, 0x32, 0xcd, 0x01,
+    0x43, 0xa1, 0x6d, 0xde, 0x00, 0x11, 0xa1, 0x61, 0x00, 0xa1, 0x62, 0x01,
+    0xa1, 0x63, 0x02, 0xa1, 0x64, 0xc0, 0xa1, 0x65, 0x04, 0xa1, 0x66, 0x05,
+    0xa1, 0x67, 0x06, 0xa1, 0x68, 0x07, 0xa1, 0x69, 0x08, 0xa1, 0x6a, 0x09,
+    0xa1, 0x6b, 0x0a, 0xa1, 0x6c, 0x0b, 0xa1, 0x6d, 0x0c, 0xa1, 0x6e, 0x0d,
+    0xa1, 0x6f, 0x0e, 0xa1, 0x70, 0x0f, 0xa1, 0x71, 0x10
+};
+
+static const uint8_t BACKEND_WRITTEN[] = {
+    0x88, 0xa1, 0x72, 0xd2, 0x00, 0x00, 0x12, 0xd5, 0xa1, 0x6c, 0xca, 0x3f,
+    0x00, 0x00, 0x00, 0xa1, 0x63, 0xd2, 0x05, 0x7b, 0x5f, 0x48, 0xa1, 0x6e,
+    0xc0, 0xa1, 0x62, 0xc2, 0xa1, 0x75, 0xd2, 0xff, 0xff, 0xff, 0xff, 0xa1,
+    0x73, 0xda, 0x01, 0x04, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79,
+    0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79,
+    0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79,
+    0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79,
+    0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79,
+    0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79,
+    0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79,
+    0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79,
+    0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79,
+    0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79,
+    0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79,
+    0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79,
+    0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79,
+    0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79,
+    0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79,
+    0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79,
+    0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79,
+    0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79,
+    0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79,
+    0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79,
+    0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79,
+    0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79, 0x79,
+    0xa1, 0x74, 0xd9, 0x2c, 0x43, 0x55, 0x45, 0x54, 0x5f, 0x43, 0x41, 0x4d,
+    0x50, 0x55, 0x53, 0x43, 0x55, 0x45, 0x54, 0x5f, 0x43, 0x41, 0x4d, 0x50,
+    0x55, 0x53, 0x43, 0x55, 0x45, 0x54, 0x5f, 0x43, 0x41, 0x4d, 0x50, 0x55,
+    0x53, 0x43, 0x55, 0x45, 0x54, 0x5f, 0x43, 0x41, 0x4d, 0x50, 0x55, 0x53
+};
@@ -0,0 +1,56 @@
+// AERAS - Writes fixture.h for test_msgpack from the backend's encoder
+// Run after changing aeras-backend/lib/msgpack.js (or the values here):
+//   node test/test_msgpack/fixture.js
+const fs = require('fs');
+const path = require('path');
+const { encode, int32, float32 } = require('../../../aeras-backend/lib/msgpack');
+
+const letters = count => Array.from({ length: count }, (_, i) => String.fromCharCode(97 + i));
+
+// Read back by test_decode_backend_bytes(). 18 entries: a map16
+const decoded = {
+  i: int32(-123456),
+  u: int32(7),                            // int32() even when it is small
+  f: float32(1.5),
+  g: float32(-0.1),
+  d: 2.75,                                // float64
+  c: int32(Math.round(22.4633 * 1e6)),    // Microdegrees
+  n: null,
+  b: true,
+  k: 200,                                 // uint8
+  w: 300,                                 // uint16
+  x: 70000,                               // uint32
+  z: -5,                                  // Negative fixint
+  v: -100,                                // int8
+  y: -200,                                // int16
+  s: 'x'.repeat(300),                     // str16
+  t: 'CUET_CAMPUS-PAHARTOLI-NOAPARA-RAOJAN', // str8
+  a: Array.from({ length: 20 }, (_, i) => i * 17),  // array16
+  m: Object.fromEntries(letters(17).map((key, i) => [key, i === 3 ? null : i]))  // map16
+};
+
+// Rebuilt by test_writer_matches_backend() with MsgPackWriter
+const written = {
+  r: int32(4821),
+  l: float32(0.5),
+  c: int32(Math.round(91.9714 * 1e6)),
+  n: null,
+  b: false,
+  u: int32(-1),
+  s: 'y'.repeat(260),
+  t: 'CUET_CAMPUS'.repeat(4)
+};
+
+function array(name, value) {
+  const bytes = [...encode(value)].map(b => `0x${b.toString(16).padStart(2, '0')}`);
+  const rows = [];
+  for (let i = 0; i < bytes.length; i += 12) rows.push(`    ${bytes.slice(i, i + 12).join(', ')}`);
+  return `static const uint8_t ${name}[] = {\n${rows.join(',\n')}\n};\n`;
+}
+
+fs.writeFileSync(path.join(__dirname, 'fixture.h'),
+  '// Generated by fixture.js from aeras-backend/lib/msgpack.js - do not edit\n\n' +
+  '#pragma once\n\n' +
+  '#include <stdint.h>\n\n' +
+  array('BACKEND_DECODED', decoded) + '\n' +
+  array('BACKEND_WRITTEN', written));
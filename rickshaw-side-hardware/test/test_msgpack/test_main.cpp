@@ -0,0 +1,143 @@
+/*
+ * AERAS - MessagePack round trip against the backend's codec
+ * fixture.h holds bytes from encode() in aeras-backend/lib/msgpack.js
+ * (regenerate with fixture.js); MsgPackReader has to read them back and
+ * MsgPackWriter has to produce them byte for byte:
+ *
+ *   pio test -e native
+ */
+
+#include <Arduino.h>
+#include <MsgPack.h>
+#include <unity.h>
+#include "fixture.h"
+
+void setUp() {}
+void tearDown() {}
+
+static long readLong(MsgPackReader& reader) {
+  long value = 0;
+  TEST_ASSERT_TRUE(reader.readInt(value));
+  return value;
+}
+
+static float readFloat(MsgPackReader& reader) {
+  float value = 0;
+  TEST_ASSERT_TRUE(reader.readFloat(value));
+  return value;
+}
+
+static void test_decode_backend_bytes() {
+  MsgPackReader reader(BACKEND_DECODED, sizeof(BACKEND_DECODED));
+  size_t entries = 0;
+  TEST_ASSERT_TRUE(reader.readMap(entries));
+  TEST_ASSERT_EQUAL(18, entries);
+
+  char tag = 0;
+  char text[320];
+  bool flag = false;
+  double degrees = 0;
+  size_t count = 0;
+  for (size_t i = 0; i < entries; i++) {
+    TEST_ASSERT_TRUE(reader.readKey(tag));
+    switch (tag) {
+      case 'i': TEST_ASSERT_EQUAL(-123456, readLong(reader)); break;
+      case 'u': TEST_ASSERT_EQUAL(7, readLong(reader)); break;
+      case 'f': TEST_ASSERT_EQUAL_FLOAT(1.5f, readFloat(reader)); break;
+      case 'g': TEST_ASSERT_EQUAL_FLOAT(-0.1f, readFloat(reader)); break;
+      case 'd': TEST_ASSERT_EQUAL_FLOAT(2.75f, readFloat(reader)); break;
+      case 'c':
+        TEST_ASSERT_TRUE(reader.readCoordinate(degrees));
+        TEST_ASSERT_DOUBLE_WITHIN(1e-7, 22.4633, degrees);
+        break;
+      case 'n':
+        // A nil field reads as "" where a string is expected
+        TEST_ASSERT_TRUE(reader.readString(text, sizeof(text)));
+        TEST_ASSERT_EQUAL_STRING("", text);
+        break;
+      case 'b':
+        TEST_ASSERT_TRUE(reader.readBool(flag));
+        TEST_ASSERT_TRUE(flag);
+        break;
+      case 'k': TEST_ASSERT_EQUAL(200, readLong(reader)); break;
+      case 'w': TEST_ASSERT_EQUAL(300, readLong(reader)); break;
+      case 'x': TEST_ASSERT_EQUAL(70000, readLong(reader)); break;
+      case 'z': TEST_ASSERT_EQUAL(-5, readLong(reader)); break;
+      case 'v': TEST_ASSERT_EQUAL(-100, readLong(reader)); break;
+      case 'y': TEST_ASSERT_EQUAL(-200, readLong(reader)); break;
+      case 's':
+        TEST_ASSERT_TRUE(reader.readString(text, sizeof(text)));
+        TEST_ASSERT_EQUAL(300, strlen(text));
+        TEST_ASSERT_EQUAL('x', text[0]);
+        TEST_ASSERT_EQUAL('x', text[299]);
+        break;
+      case 't':
+        TEST_ASSERT_TRUE(reader.readString(text, 12));  // Truncated to fit
+        TEST_ASSERT_EQUAL_STRING("CUET_CAMPUS", text);
+        break;
+      case 'a':
+        TEST_ASSERT_TRUE(reader.readArray(count));
+        TEST_ASSERT_EQUAL(20, count);
+        for (size_t item = 0; item < count; item++) TEST_ASSERT_EQUAL(item * 17, readLong(reader));
+        break;
+      case 'm':
+        TEST_ASSERT_TRUE(reader.readMap(count));
+        TEST_ASSERT_EQUAL(17, count);
+        for (size_t entry = 0; entry < count; entry++) {
+          TEST_ASSERT_TRUE(reader.readKey(tag));
+          TEST_ASSERT_EQUAL('a' + entry, tag);
+          if (entry == 3) {
+            TEST_ASSERT_TRUE(reader.isNil());
+          } else {
+            TEST_ASSERT_EQUAL(entry, readLong(reader));
+          }
+        }
+        break;
+      default:
+        TEST_FAIL_MESSAGE("unexpected key");
+    }
+  }
+  TEST_ASSERT_TRUE(reader.ok());
+}
+
+static void test_skip_backend_bytes() {
+  // The whole document, 16-bit containers and strings included
+  MsgPackReader reader(BACKEND_DECODED, sizeof(BACKEND_DECODED));
+  TEST_ASSERT_TRUE(reader.skip());
+  TEST_ASSERT_TRUE(reader.ok());
+
+  // Cut short anywhere, it fails instead of reading past the end
+  for (size_t cut = 0; cut < sizeof(BACKEND_DECODED); cut++) {
+    MsgPackReader truncated(BACKEND_DECODED, cut);
+    TEST_ASSERT_FALSE(truncated.skip());
+    TEST_ASSERT_FALSE(truncated.ok());
+  }
+}
+
+static void test_writer_matches_backend() {
+  char longText[261];
+  memset(longText, 'y', 260);
+  longText[260] = '\0';
+
+  MsgPackBuffer<512> writer;
+  writer.beginMap(8)
+      .key('r').int32(4821)
+      .key('l').float32(0.5f)
+      .key('c').coordinate(91.9714)
+      .key('n').nil()
+      .key('b').boolean(false)
+      .key('u').int32(-1)
+      .key('s').str(longText)
+      .key('t').str("CUET_CAMPUSCUET_CAMPUSCUET_CAMPUSCUET_CAMPUS");
+  TEST_ASSERT_FALSE(writer.overflowed());
+  TEST_ASSERT_EQUAL(sizeof(BACKEND_WRITTEN), writer.length());
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(BACKEND_WRITTEN, writer.data(), sizeof(BACKEND_WRITTEN));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_decode_backend_bytes);
+  RUN_TEST(test_skip_backend_bytes);
+  RUN_TEST(test_writer_matches_backend);
+  return UNITY_END();
+}
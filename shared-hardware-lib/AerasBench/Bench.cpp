@@ -0,0 +1,72 @@
+/*
+ * AERAS - Host micro-benchmarks
+ */
+
+#include "Bench.h"
+
+#include <atomic>
+#include <chrono>
+#include <new>
+
+static std::atomic<uint64_t> allocations(0);
+
+// ===== Allocation counting =====
+#ifdef __GLIBC__
+// Interpose the C allocator; operator new ends up here as well
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* pointer, size_t size);
+
+void* malloc(size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  return __libc_calloc(count, size);
+}
+
+void* realloc(void* pointer, size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  return __libc_realloc(pointer, size);
+}
+}
+#else
+// Elsewhere only C++ allocations are seen
+void* operator new(size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  void* pointer = malloc(size ? size : 1);
+  if (!pointer) throw std::bad_alloc();
+  return pointer;
+}
+
+void operator delete(void* pointer) noexcept {
+  free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+  free(pointer);
+}
+#endif
+
+uint64_t benchAllocations() {
+  return allocations.load(std::memory_order_relaxed);
+}
+
+// ===== Timing and report =====
+uint64_t benchNowNs() {
+  return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void benchHeader(const char* suite) {
+  Serial.printf("\n%s\n", suite);
+  Serial.printf("%-36s %12s %12s %12s\n", "benchmark", "ns/op", "allocs/op", "iterations");
+}
+
+void benchReport(const char* name, const BenchResult& result) {
+  Serial.printf("%-36s %12.1f %12.2f %12llu\n", name, result.nsPerOp, result.allocationsPerOp,
+                (unsigned long long)result.iterations);
+}
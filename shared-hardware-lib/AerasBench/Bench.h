@@ -0,0 +1,82 @@
+/*
+ * AERAS - Host micro-benchmarks
+ * bench("name", [&] { ... }) runs the body in growing batches until a
+ * batch takes BENCH_MIN_BATCH_MS, then reports the best of BENCH_ROUNDS
+ * batches as ns/op, plus heap allocations per op (operator new, and
+ * malloc/calloc/realloc on glibc). Host numbers are for spotting
+ * regressions and comparing variants; the ESP32 is slower in absolute
+ * terms, and much slower at double maths.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+#define BENCH_MIN_BATCH_MS 50
+#define BENCH_ROUNDS       5
+
+struct BenchResult {
+  double nsPerOp;
+  double allocationsPerOp;
+  uint64_t iterations;  // Per round
+};
+
+// Keeps the compiler from dropping a result the benchmark never reads
+template <typename T>
+inline void benchKeep(const T& value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+uint64_t benchNowNs();
+uint64_t benchAllocations();  // Running total since start
+// Table heading, then one row per bench() call
+void benchHeader(const char* suite);
+void benchReport(const char* name, const BenchResult& result);
+
+template <typename Body>
+BenchResult bench(const char* name, Body body) {
+  // logLine() and friends still format, but nothing reaches stdout
+  Serial.setEnabled(false);
+
+  uint64_t iterations = 1;
+  while (true) {
+    uint64_t start = benchNowNs();
+    for (uint64_t i = 0; i < iterations; i++) body();
+    if (benchNowNs() - start >= BENCH_MIN_BATCH_MS * 1000000ULL || iterations >= (1ULL << 40)) break;
+    iterations *= 2;
+  }
+
+  BenchResult best = {0, 0, iterations};
+  for (int round = 0; round < BENCH_ROUNDS; round++) {
+    uint64_t allocations = benchAllocations();
+    uint64_t start = benchNowNs();
+    for (uint64_t i = 0; i < iterations; i++) body();
+    double ns = double(benchNowNs() - start) / double(iterations);
+    if (round == 0 || ns < best.nsPerOp) best.nsPerOp = ns;
+    best.allocationsPerOp = double(benchAllocations() - allocations) / double(iterations);
+  }
+
+  Serial.setEnabled(true);
+  benchReport(name, best);
+  return best;
+}
+
+// Replays a fixed body as a Stream, the way HttpSession::body() hands a
+// reply to the JSON parsers; rewind() before every pass
+class BenchStream : public Stream {
+ public:
+  BenchStream(const char* text) : data((const uint8_t*)text), length(strlen(text)) { setTimeout(0); }
+  BenchStream(const uint8_t* data, size_t length) : data(data), length(length) { setTimeout(0); }
+
+  void rewind() { position = 0; }
+
+  int available() override { return int(length - position); }
+  int read() override { return position < length ? data[position++] : -1; }
+  int peek() override { return position < length ? data[position] : -1; }
+  size_t write(uint8_t) override { return 0; }
+
+ private:
+  const uint8_t* data;
+  size_t length;
+  size_t position = 0;
+};
@@ -0,0 +1,90 @@
+/*
+ * AERAS - Block (location) table
+ */
+
+#include "BlockTable.h"
+
+#include <Preferences.h>
+#include <strings.h>
+
+void BlockTable::clear() {
+  memset(index, 0, sizeof(index));
+  count = 0;
+  tableVersion = 0;
+}
+
+// ===== Index =====
+// FNV-1a over the upper-cased ID, so lookups ignore case like the old matcher
+uint32_t BlockTable::hash(const char* blockID) {
+  uint32_t h = 2166136261UL;
+  for (const char* c = blockID; *c; c++) {
+    h ^= (uint8_t)toupper((unsigned char)*c);
+    h *= 16777619UL;
+  }
+  return h;
+}
+
+uint8_t BlockTable::slotOf(const char* blockID) const {
+  uint8_t slot = hash(blockID) & (SLOTS - 1);
+  // Never more than half full, so an empty slot always ends the probe
+  while (index[slot] != 0 && strcasecmp(blocks[index[slot] - 1].blockID, blockID) != 0) {
+    slot = (slot + 1) & (SLOTS - 1);
+  }
+  return slot;
+}
+
+void BlockTable::rebuildIndex() {
+  memset(index, 0, sizeof(index));
+  for (uint8_t i = 0; i < count; i++) {
+    index[slotOf(blocks[i].blockID)] = i + 1;
+  }
+}
+
+bool BlockTable::put(const BlockInfo& block) {
+  uint8_t slot = slotOf(block.blockID);
+  if (index[slot] != 0) {
+    blocks[index[slot] - 1] = block;
+    return true;
+  }
+  if (count == CAPACITY) return false;
+
+  blocks[count] = block;
+  index[slot] = ++count;
+  return true;
+}
+
+const BlockInfo* BlockTable::find(const char* blockID) const {
+  uint8_t slot = slotOf(blockID);
+  return index[slot] != 0 ? &blocks[index[slot] - 1] : nullptr;
+}
+
+// ===== NVS cache =====
+bool BlockTable::load() {
+  Preferences prefs;
+  if (!prefs.begin(BLOCK_TABLE_NAMESPACE, true)) return false;
+
+  // A firmware with a different BlockInfo layout must not reuse the blob
+  size_t length = prefs.getBytesLength("blocks");
+  bool usable = prefs.getUShort("entry", 0) == sizeof(BlockInfo) && length > 0 &&
+                length % sizeof(BlockInfo) == 0 && length <= sizeof(blocks);
+  if (usable) {
+    prefs.getBytes("blocks", blocks, length);
+    count = length / sizeof(BlockInfo);
+    tableVersion = prefs.getLong("version", 0);
+    rebuildIndex();
+  }
+  prefs.end();
+  return usable;
+}
+
+bool BlockTable::save() const {
+  Preferences prefs;
+  if (!prefs.begin(BLOCK_TABLE_NAMESPACE, false)) return false;
+
+  size_t length = count * sizeof(BlockInfo);
+  bool saved = prefs.putBytes("blocks", blocks, length) == length;
+  saved = saved && prefs.putUShort("entry", sizeof(BlockInfo)) > 0;
+  saved = saved && prefs.putLong("version", tableVersion) > 0;
+  prefs.end();
+  return saved;
+}
@@ -0,0 +1,51 @@
+/*
+ * AERAS - Block (location) table
+ * Copy of the backend's `locations` table, indexed by blockID in an
+ * open-addressing hash so target lookups cost the same however many
+ * blocks the fleet operates. The table is cached in NVS together with the
+ * backend's table version, so it survives reboots and is only downloaded
+ * again when the backend's copy changes.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <BackendMessages.h>
+
+#define BLOCK_TABLE_NAMESPACE "aeras-blocks"  // NVS namespace (max 15 chars)
+
+class BlockTable {
+ public:
+  static const uint8_t CAPACITY = 64;
+  static const uint8_t SLOTS = 128;  // Power of two, at most half full
+
+  BlockTable() { clear(); }
+
+  void clear();
+  // Adds a block or replaces the one with the same blockID; false when full
+  bool put(const BlockInfo& block);
+  // Case-insensitive blockID lookup; nullptr when the block is unknown
+  const BlockInfo* find(const char* blockID) const;
+
+  uint8_t size() const { return count; }
+  const BlockInfo& at(uint8_t position) const { return blocks[position]; }
+
+  // Backend table version this copy matches (0 = built-in / unknown)
+  long version() const { return tableVersion; }
+  void setVersion(long version) { tableVersion = version; }
+
+  // NVS cache; load() leaves the table untouched when nothing usable is stored
+  bool load();
+  bool save() const;
+
+ private:
+  static uint32_t hash(const char* blockID);
+  // Slot holding blockID, or the empty slot where it belongs
+  uint8_t slotOf(const char* blockID) const;
+  void rebuildIndex();
+
+  BlockInfo blocks[CAPACITY];
+  uint8_t index[SLOTS];  // Position + 1 in blocks[], 0 = empty slot
+  uint8_t count;
+  long tableVersion;
+};
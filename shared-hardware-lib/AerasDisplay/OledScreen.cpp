@@ -0,0 +1,106 @@
+/*
+ * AERAS - Incremental SSD1306 rendering
+ */
+
+#include "OledScreen.h"
+
+// Wire's transmit buffer is small on some cores; minus the control byte
+static const uint8_t I2C_CHUNK = 31;
+
+void OledScreen::begin() {
+  Wire.setClock(OLED_I2C_CLOCK);
+  memset(fields, 0, sizeof(fields));
+  display.display();
+  memcpy(panel, display.getBuffer(), sizeof(panel));
+  panelValid = true;
+}
+
+// ===== Layout and fields =====
+bool OledScreen::useLayout(uint8_t layoutId, OledChrome chrome) {
+  if (layoutId == layout && layoutId != OLED_LAYOUT_NONE) return false;
+
+  layout = layoutId;
+  memset(fields, 0, sizeof(fields));
+  display.clearDisplay();
+  display.setTextSize(1);
+  display.setTextColor(SSD1306_WHITE);
+  if (chrome) chrome(display);
+  return true;
+}
+
+void OledScreen::beginFreeform() {
+  useLayout(OLED_LAYOUT_NONE, nullptr);
+}
+
+void OledScreen::setField(uint8_t field, int16_t x, int16_t y, const char* text) {
+  if (field >= OLED_MAX_FIELDS) return;
+  char* last = fields[field];
+  if (strncmp(last, text, OLED_FIELD_LENGTH - 1) == 0) return;
+
+  size_t oldLength = strlen(last);
+  snprintf(last, OLED_FIELD_LENGTH, "%s", text);
+  size_t newLength = strlen(last);
+
+  // Wipe the previous value's cells, then draw the new one
+  int16_t clearWidth = (int16_t)max(oldLength, newLength) * 6;
+  display.fillRect(x, y, min(clearWidth, (int16_t)(WIDTH - x)), 8, SSD1306_BLACK);
+  display.setTextSize(1);
+  display.setTextColor(SSD1306_WHITE);
+  display.setCursor(x, y);
+  display.print(last);
+}
+
+// ===== Transfer =====
+void OledScreen::invalidate() {
+  panelValid = false;
+}
+
+uint8_t OledScreen::flush() {
+  const uint8_t* frame = display.getBuffer();
+
+  if (!panelValid) {
+    display.display();
+    memcpy(panel, frame, sizeof(panel));
+    panelValid = true;
+    return PAGES;
+  }
+
+  uint8_t pagesSent = 0;
+  for (uint8_t page = 0; page < PAGES; page++) {
+    const uint8_t* row = frame + page * WIDTH;
+    uint8_t* shown = panel + page * WIDTH;
+
+    int first = 0;
+    while (first < WIDTH && row[first] == shown[first]) first++;
+    if (first == WIDTH) continue;
+    int last = WIDTH - 1;
+    while (row[last] == shown[last]) last--;
+
+    writePage(page, first, last, row + first);
+    memcpy(shown + first, row + first, last - first + 1);
+    pagesSent++;
+  }
+  return pagesSent;
+}
+
+void OledScreen::writePage(uint8_t page, uint8_t firstColumn, uint8_t lastColumn,
+                           const uint8_t* data) {
+  // Horizontal addressing (set by begin()): window = one page, column span
+  display.ssd1306_command(SSD1306_PAGEADDR);
+  display.ssd1306_command(page);
+  display.ssd1306_command(page);
+  display.ssd1306_command(SSD1306_COLUMNADDR);
+  display.ssd1306_command(firstColumn);
+  display.ssd1306_command(lastColumn);
+
+  size_t remaining = lastColumn - firstColumn + 1;
+  while (remaining > 0) {
+    size_t chunk = min(remaining, (size_t)I2C_CHUNK);
+    Wire.beginTransmission(address);
+    Wire.write((uint8_t)0x40);  // Co = 0, D/C = 1: data stream
+    Wire.write(data, chunk);
+    Wire.endTransmission();
+    data += chunk;
+    remaining -= chunk;
+  }
+}
@@ -0,0 +1,66 @@
+/*
+ * AERAS - Incremental SSD1306 rendering
+ * Keeps a copy of what the panel currently shows and, on flush(), sends
+ * only the pages (and the column span within each page) that changed,
+ * instead of Adafruit_SSD1306::display()'s full 1 KB frame.
+ *
+ * On top of that, screens are split into a static "chrome" (headers,
+ * separators) drawn once per layout change, and text fields that are
+ * only redrawn when their value differs from the last one.
+ * Fields assume text size 1 (6x8 px glyphs).
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <Adafruit_SSD1306.h>
+
+// SSD1306 is specified for I2C fast mode (400 kHz); pass this as both
+// clkDuring and clkAfter to the Adafruit_SSD1306 constructor
+#define OLED_I2C_CLOCK 400000UL
+
+#define OLED_LAYOUT_NONE   0   // Free-form drawing, no cached chrome
+#define OLED_MAX_FIELDS    8
+#define OLED_FIELD_LENGTH  22  // 21 glyphs fit in 128 px
+
+typedef void (*OledChrome)(Adafruit_SSD1306& display);
+
+class OledScreen {
+ public:
+  static const uint8_t WIDTH = 128;
+  static const uint8_t HEIGHT = 64;
+  static const uint8_t PAGES = HEIGHT / 8;
+
+  OledScreen(Adafruit_SSD1306& display, uint8_t i2cAddress = 0x3C)
+    : display(display), address(i2cAddress) {}
+
+  // After display.begin(): pushes one full frame and starts tracking it
+  void begin();
+
+  // Switches to layoutId; clears and draws chrome only when the layout
+  // actually changes. Returns true on a switch (all fields were reset).
+  bool useLayout(uint8_t layoutId, OledChrome chrome);
+  // Free-form screen follows: clears the frame, forgets layout and fields
+  void beginFreeform();
+
+  // Redraws one text line at (x, y) only if it differs from last time
+  void setField(uint8_t field, int16_t x, int16_t y, const char* text);
+
+  // Sends the dirty part of the frame buffer; returns pages written
+  uint8_t flush();
+  // Next flush() resends the whole frame
+  void invalidate();
+
+ private:
+  void writePage(uint8_t page, uint8_t firstColumn, uint8_t lastColumn, const uint8_t* data);
+
+  Adafruit_SSD1306& display;
+  uint8_t address;
+
+  uint8_t panel[WIDTH * PAGES];  // What the SSD1306 RAM holds right now
+  bool panelValid = false;
+
+  uint8_t layout = OLED_LAYOUT_NONE;
+  char fields[OLED_MAX_FIELDS][OLED_FIELD_LENGTH];
+};
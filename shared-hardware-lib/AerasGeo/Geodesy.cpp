@@ -0,0 +1,59 @@
+/*
+ * AERAS - Geodesy
+ */
+
+#include "Geodesy.h"
+
+static const float DEG_TO_RAD_F = 0.017453292519943295f;
+static const float RAD_TO_DEG_F = 57.29577951308232f;
+static const float EARTH_RADIUS_F = (float)GEO_EARTH_RADIUS_M;
+
+static float normalizeBearing(float degrees) {
+  if (degrees < 0) degrees += 360.0f;
+  return degrees >= 360.0f ? degrees - 360.0f : degrees;
+}
+
+GeoVector geoVector(double fromLat, double fromLng, double toLat, double toLng) {
+  // Subtract in double: a float coordinate alone is only ~0.2 m precise
+  float dLat = (float)(toLat - fromLat) * DEG_TO_RAD_F;
+  float dLng = (float)(toLng - fromLng) * DEG_TO_RAD_F;
+  float meanLat = (float)fromLat * DEG_TO_RAD_F + 0.5f * dLat;
+
+  float north = dLat * EARTH_RADIUS_F;
+  float east = dLng * cosf(meanLat) * EARTH_RADIUS_F;
+
+  GeoVector vector;
+  vector.meters = sqrtf(north * north + east * east);
+  if (vector.meters > GEO_FAST_RANGE_M) {
+    return geoVectorExact(fromLat, fromLng, toLat, toLng);
+  }
+  vector.bearing = normalizeBearing(atan2f(east, north) * RAD_TO_DEG_F);
+  return vector;
+}
+
+GeoVector geoVectorExact(double fromLat, double fromLng, double toLat, double toLng) {
+  double lat1 = fromLat * PI / 180.0;
+  double lat2 = toLat * PI / 180.0;
+  double dLat = lat2 - lat1;
+  double dLng = (toLng - fromLng) * PI / 180.0;
+
+  double a = sin(dLat / 2) * sin(dLat / 2) +
+             cos(lat1) * cos(lat2) * sin(dLng / 2) * sin(dLng / 2);
+
+  double y = sin(dLng) * cos(lat2);
+  double x = cos(lat1) * sin(lat2) - sin(lat1) * cos(lat2) * cos(dLng);
+
+  GeoVector vector;
+  vector.meters = (float)(GEO_EARTH_RADIUS_M * 2 * atan2(sqrt(a), sqrt(1 - a)));
+  vector.bearing = normalizeBearing((float)(atan2(y, x) * 180.0 / PI));
+  return vector;
+}
+
+void geoMove(double& lat, double& lng, float meters, float bearing) {
+  float bearingRad = bearing * DEG_TO_RAD_F;
+  float northDegrees = meters * cosf(bearingRad) / (EARTH_RADIUS_F * DEG_TO_RAD_F);
+  float eastDegrees = meters * sinf(bearingRad) /
+                      (EARTH_RADIUS_F * DEG_TO_RAD_F * cosf((float)lat * DEG_TO_RAD_F));
+  lat += northDegrees;
+  lng += eastDegrees;
+}
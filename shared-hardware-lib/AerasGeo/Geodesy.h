@@ -0,0 +1,34 @@
+/*
+ * AERAS - Geodesy
+ * Distance and bearing between two fixes. The ESP32 FPU is single
+ * precision only; double sin/cos/atan2 run in software, so the short-range
+ * path here works in float.
+ *
+ * Below GEO_FAST_RANGE_M, geoVector() uses the equirectangular projection
+ * around the mean latitude (one cosf, one sqrtf, one atan2f). Compared
+ * with double haversine / great-circle initial bearing, for latitudes up
+ * to 60 degrees and ranges of 10 m and more:
+ *   distance: < 0.05 m
+ *   bearing:  < 0.2 degree (meridian convergence; ~0.04 degree at 20 km
+ *             around Chittagong's 22 N)
+ * Longer ranges fall back to geoVectorExact().
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+#define GEO_EARTH_RADIUS_M 6371000.0
+#define GEO_FAST_RANGE_M   20000.0f
+
+struct GeoVector {
+  float meters;
+  float bearing;  // Degrees clockwise from north, [0, 360)
+};
+
+GeoVector geoVector(double fromLat, double fromLng, double toLat, double toLng);
+// Haversine distance and great-circle initial bearing, in double
+GeoVector geoVectorExact(double fromLat, double fromLng, double toLat, double toLng);
+
+// Moves a fix by meters along bearing (flat-earth step, for short moves)
+void geoMove(double& lat, double& lng, float meters, float bearing);
@@ -0,0 +1,106 @@
+/*
+ * AERAS - Host stand-in for the Arduino core
+ * Only what the hardware-free libraries and modules use: Print/Stream,
+ * Serial, millis()/micros() and the integer helpers. Picked up by the
+ * [env:native] builds; the ESP32 environments lib_ignore it and use the
+ * real core. No GPIO, WiFi or display here on purpose: code that needs
+ * those does not belong in a native build.
+ */
+
+#pragma once
+
+#include <ctype.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+
+typedef uint8_t byte;
+
+#define PI 3.1415926535897932384626433832795
+
+#define DEC 10
+#define HEX 16
+#define F(text) (text)
+#define IRAM_ATTR
+
+using std::max;
+using std::min;
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+class Print {
+ public:
+  virtual ~Print() {}
+
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t* buffer, size_t size);
+  size_t write(const char* text) { return text ? write((const uint8_t*)text, strlen(text)) : 0; }
+  size_t write(const char* buffer, size_t size) { return write((const uint8_t*)buffer, size); }
+  virtual void flush() {}
+
+  size_t print(const char* text) { return write(text); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(long value, int base = DEC);
+  size_t print(unsigned long value, int base = DEC);
+  size_t print(int value, int base = DEC) { return print((long)value, base); }
+  size_t print(unsigned int value, int base = DEC) { return print((unsigned long)value, base); }
+  size_t print(double value, int decimals = 2);
+
+  size_t println() { return write("\r\n"); }
+  template <typename T>
+  size_t println(T value) { return print(value) + println(); }
+  template <typename T>
+  size_t println(T value, int format) { return print(value, format) + println(); }
+
+  size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+};
+
+// Same timing rules as the Arduino core: reads give up after the timeout
+// (setTimeout(0) tries exactly once)
+class Stream : public Print {
+ public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+
+  void setTimeout(unsigned long ms) { timeout = ms; }
+  unsigned long getTimeout() const { return timeout; }
+
+  size_t readBytes(char* buffer, size_t length);
+  size_t readBytes(uint8_t* buffer, size_t length) { return readBytes((char*)buffer, length); }
+  // Consumes input up to and including target; false when it never came
+  bool find(const char* target);
+
+ protected:
+  int timedRead();
+
+  unsigned long timeout = 1000;
+};
+
+// stdout; setEnabled(false) swallows output (e.g. logLine() while timing)
+class HostSerial : public Stream {
+ public:
+  void begin(unsigned long) {}
+  void setEnabled(bool enabled) { this->enabled = enabled; }
+
+  int available() override { return 0; }
+  int read() override { return -1; }
+  int peek() override { return -1; }
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t* buffer, size_t size) override;
+  using Print::write;
+
+ private:
+  bool enabled = true;
+};
+
+extern HostSerial Serial;
@@ -0,0 +1,119 @@
+/*
+ * AERAS - Host stand-in for the Arduino core
+ */
+
+#include "Arduino.h"
+
+#include <chrono>
+#include <thread>
+
+HostSerial Serial;
+
+// ===== Time =====
+static const std::chrono::steady_clock::time_point bootTime = std::chrono::steady_clock::now();
+
+unsigned long millis() {
+  return (unsigned long)std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::steady_clock::now() - bootTime).count();
+}
+
+unsigned long micros() {
+  return (unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now() - bootTime).count();
+}
+
+void delay(unsigned long ms) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void delayMicroseconds(unsigned int us) {
+  std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+void yield() {
+  std::this_thread::yield();
+}
+
+// ===== Print =====
+size_t Print::write(const uint8_t* buffer, size_t size) {
+  size_t written = 0;
+  while (written < size && write(buffer[written])) written++;
+  return written;
+}
+
+size_t Print::print(long value, int base) {
+  if (value < 0 && base == DEC) return print('-') + print((unsigned long)-value, base);
+  return print((unsigned long)value, base);
+}
+
+size_t Print::print(unsigned long value, int base) {
+  char text[24];
+  snprintf(text, sizeof(text), base == HEX ? "%lX" : "%lu", value);
+  return write(text);
+}
+
+size_t Print::print(double value, int decimals) {
+  char text[48];
+  snprintf(text, sizeof(text), "%.*f", decimals, value);
+  return write(text);
+}
+
+size_t Print::printf(const char* format, ...) {
+  char text[256];
+  va_list args;
+  va_start(args, format);
+  int length = vsnprintf(text, sizeof(text), format, args);
+  va_end(args);
+  if (length < 0) return 0;
+  return write((const uint8_t*)text, min((size_t)length, sizeof(text) - 1));
+}
+
+// ===== Stream =====
+int Stream::timedRead() {
+  unsigned long start = millis();
+  do {
+    int c = read();
+    if (c >= 0) return c;
+    if (timeout > 0) yield();
+  } while (millis() - start < timeout);
+  return -1;
+}
+
+size_t Stream::readBytes(char* buffer, size_t length) {
+  size_t count = 0;
+  while (count < length) {
+    int c = timedRead();
+    if (c < 0) break;
+    buffer[count++] = (char)c;
+  }
+  return count;
+}
+
+bool Stream::find(const char* target) {
+  size_t length = strlen(target);
+  if (length == 0) return true;
+
+  size_t matched = 0;
+  while (true) {
+    int c = timedRead();
+    if (c < 0) return false;
+    // Fall back to the longest prefix of target that still ends here
+    while (matched > 0 && c != target[matched]) {
+      size_t shorter = matched - 1;
+      while (shorter > 0 && memcmp(target, target + matched - shorter, shorter) != 0) shorter--;
+      matched = shorter;
+    }
+    if (c == target[matched] && ++matched == length) return true;
+  }
+}
+
+// ===== Serial =====
+size_t HostSerial::write(uint8_t c) {
+  if (enabled) fputc(c, stdout);
+  return 1;
+}
+
+size_t HostSerial::write(const uint8_t* buffer, size_t size) {
+  if (enabled) fwrite(buffer, 1, size, stdout);
+  return size;
+}
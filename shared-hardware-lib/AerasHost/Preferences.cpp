@@ -0,0 +1,83 @@
+/*
+ * AERAS - Host stand-in for the ESP32 Preferences (NVS) library
+ */
+
+#include "Preferences.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+typedef std::map<std::string, std::vector<uint8_t>> Namespace;
+
+static std::map<std::string, Namespace>& storage() {
+  static std::map<std::string, Namespace> spaces;
+  return spaces;
+}
+
+bool Preferences::begin(const char* name, bool readOnly) {
+  if (!name || strlen(name) >= sizeof(space)) return false;
+  snprintf(space, sizeof(space), "%s", name);
+  this->readOnly = readOnly;
+  return true;
+}
+
+void Preferences::end() {
+  space[0] = '\0';
+}
+
+size_t Preferences::getBytesLength(const char* key) {
+  if (!space[0]) return 0;
+  Namespace& values = storage()[space];
+  auto found = values.find(key);
+  return found == values.end() ? 0 : found->second.size();
+}
+
+size_t Preferences::getBytes(const char* key, void* buffer, size_t length) {
+  size_t stored = getBytesLength(key);
+  if (stored == 0 || stored > length) return 0;
+  memcpy(buffer, storage()[space][key].data(), stored);
+  return stored;
+}
+
+size_t Preferences::putBytes(const char* key, const void* value, size_t length) {
+  if (!space[0] || readOnly) return 0;
+  const uint8_t* bytes = (const uint8_t*)value;
+  storage()[space][key].assign(bytes, bytes + length);
+  return length;
+}
+
+template <typename T>
+T Preferences::getValue(const char* key, T defaultValue) {
+  T value;
+  return getBytesLength(key) == sizeof(T) && getBytes(key, &value, sizeof(T)) ? value : defaultValue;
+}
+
+template <typename T>
+size_t Preferences::putValue(const char* key, T value) {
+  return putBytes(key, &value, sizeof(T));
+}
+
+uint16_t Preferences::getUShort(const char* key, uint16_t defaultValue) {
+  return getValue(key, defaultValue);
+}
+
+size_t Preferences::putUShort(const char* key, uint16_t value) {
+  return putValue(key, value);
+}
+
+int32_t Preferences::getLong(const char* key, int32_t defaultValue) {
+  return getValue(key, defaultValue);
+}
+
+size_t Preferences::putLong(const char* key, int32_t value) {
+  return putValue(key, value);
+}
+
+uint32_t Preferences::getUInt(const char* key, uint32_t defaultValue) {
+  return getValue(key, defaultValue);
+}
+
+size_t Preferences::putUInt(const char* key, uint32_t value) {
+  return putValue(key, value);
+}
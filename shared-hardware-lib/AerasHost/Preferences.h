@@ -0,0 +1,34 @@
+/*
+ * AERAS - Host stand-in for the ESP32 Preferences (NVS) library
+ * Namespaces live in RAM for the life of the process, so code that caches
+ * in NVS (BlockTable) runs unchanged in a native build.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+class Preferences {
+ public:
+  bool begin(const char* name, bool readOnly = false);
+  void end();
+
+  size_t getBytesLength(const char* key);
+  size_t getBytes(const char* key, void* buffer, size_t length);
+  size_t putBytes(const char* key, const void* value, size_t length);
+  uint16_t getUShort(const char* key, uint16_t defaultValue = 0);
+  size_t putUShort(const char* key, uint16_t value);
+  int32_t getLong(const char* key, int32_t defaultValue = 0);
+  size_t putLong(const char* key, int32_t value);
+  uint32_t getUInt(const char* key, uint32_t defaultValue = 0);
+  size_t putUInt(const char* key, uint32_t value);
+
+ private:
+  template <typename T>
+  T getValue(const char* key, T defaultValue);
+  template <typename T>
+  size_t putValue(const char* key, T value);
+
+  char space[16] = "";  // NVS namespaces are at most 15 characters
+  bool readOnly = false;
+};
@@ -0,0 +1,8 @@
+/*
+ * AERAS - Host stand-in for the Arduino core (see Arduino.h)
+ * ArduinoJson includes this header for its Stream support.
+ */
+
+#pragma once
+
+#include "Arduino.h"
@@ -0,0 +1,84 @@
+/*
+ * AERAS - Server-Sent Events subscription
+ */
+
+#include "EventStream.h"
+
+void EventStream::begin(const char* baseUrl, uint32_t idleTimeout) {
+  idleTimeoutMs = idleTimeout;
+  session.begin(baseUrl, 3000);
+  session.setAccept("text/event-stream");
+}
+
+bool EventStream::open(const char* path) {
+  close();
+  int status = session.request("GET", path);
+  if (status != 200 || !session.responseIs("text/event-stream")) {
+    session.close();
+    return false;
+  }
+  opened = true;
+  lastHeard = millis();
+  return true;
+}
+
+void EventStream::close() {
+  session.close();
+  opened = false;
+  lineLength = 0;
+  skippingLine = false;
+  eventName[0] = '\0';
+}
+
+bool EventStream::isOpen() {
+  if (!opened) return false;
+  if (!session.connected() || millis() - lastHeard > idleTimeoutMs) {
+    close();
+    return false;
+  }
+  return true;
+}
+
+// One complete field line (or the blank line ending an event)
+void EventStream::handleLine() {
+  line[lineLength] = '\0';
+  if (lineLength == 0) {
+    eventName[0] = '\0';
+  } else if (strncmp(line, "event:", 6) == 0) {
+    const char* value = line + 6;
+    while (*value == ' ') value++;
+    snprintf(eventName, sizeof(eventName), "%s", value);
+  }
+  // Comments (": ping"), id: and retry: need nothing
+  lineLength = 0;
+}
+
+bool EventStream::nextEvent(char* name, size_t capacity) {
+  if (!isOpen()) return false;
+
+  Stream& body = session.body();
+  while (body.available() > 0) {
+    int c = body.read();
+    if (c < 0) break;
+    lastHeard = millis();
+
+    if (skippingLine) {
+      if (c == '\n') skippingLine = false;
+      continue;
+    }
+    if (c == '\r') continue;
+    if (c == '\n') {
+      handleLine();
+      continue;
+    }
+    if ((size_t)lineLength + 1 < sizeof(line)) line[lineLength++] = (char)c;
+
+    if (lineLength == 5 && strncmp(line, "data:", 5) == 0) {
+      lineLength = 0;
+      if (body.peek() == ' ') body.read();
+      snprintf(name, capacity, "%s", eventName);
+      return true;
+    }
+  }
+  return false;
+}
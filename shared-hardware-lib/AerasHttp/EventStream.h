@@ -0,0 +1,41 @@
+/*
+ * AERAS - Server-Sent Events subscription
+ * Holds GET /events open on its own keep-alive socket and hands out the
+ * events the backend pushes (event: <name> / data: <json>). Reading never
+ * blocks on an idle stream; a stream that stayed silent past the idle
+ * timeout (the backend pings every 15 s) counts as dropped.
+ */
+
+#pragma once
+
+#include "HttpSession.h"
+
+class EventStream {
+ public:
+  void begin(const char* baseUrl, uint32_t idleTimeoutMs = 40000);
+
+  // Blocks until the backend answered the subscription (or refused it)
+  bool open(const char* path);
+  void close();
+  bool isOpen();
+
+  // True once the "data:" field of an event starts arriving; name gets the
+  // event type. Decode the data straight from data() - it is one line of
+  // JSON - then call endEvent().
+  bool nextEvent(char* name, size_t capacity);
+  Stream& data() { return session.body(); }
+  void endEvent() { skippingLine = true; }
+
+ private:
+  void handleLine();
+
+  HttpSession session;
+  uint32_t idleTimeoutMs = 40000;
+  bool opened = false;
+  unsigned long lastHeard = 0;
+
+  char line[24];          // Field name lines only; data is left in the stream
+  uint8_t lineLength = 0;
+  bool skippingLine = false;
+  char eventName[16] = "";
+};
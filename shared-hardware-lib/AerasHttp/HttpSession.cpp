@@ -0,0 +1,391 @@
+/*
+ * AERAS - Persistent HTTP/1.1 session to the backend
+ */
+
+#include "HttpSession.h"
+
+#include <strings.h>
+
+// ===== Body stream =====
+int HttpBodyStream::available() { return session.bodyAvailable(); }
+
+int HttpBodyStream::read() {
+  if (session.peeked >= 0) {
+    int c = session.peeked;
+    session.peeked = -1;
+    return c;
+  }
+  return session.readBodyByte();
+}
+
+int HttpBodyStream::peek() {
+  if (session.peeked < 0) session.peeked = session.readBodyByte();
+  return session.peeked;
+}
+
+// ===== Setup =====
+void HttpSession::begin(const char* baseUrl, uint32_t timeout) {
+  timeoutMs = timeout;
+
+  const char* hostStart = strstr(baseUrl, "://");
+  hostStart = hostStart ? hostStart + 3 : baseUrl;
+
+  const char* pathStart = strchr(hostStart, '/');
+  if (!pathStart) pathStart = hostStart + strlen(hostStart);
+
+  const char* colon = (const char*)memchr(hostStart, ':', pathStart - hostStart);
+  const char* hostEnd = colon ? colon : pathStart;
+
+  size_t hostLength = min((size_t)(hostEnd - hostStart), sizeof(host) - 1);
+  memcpy(host, hostStart, hostLength);
+  host[hostLength] = '\0';
+  port = colon ? atoi(colon + 1) : 80;
+
+  strncpy(basePath, pathStart, sizeof(basePath) - 1);
+  basePath[sizeof(basePath) - 1] = '\0';
+}
+
+void HttpSession::close() {
+  disconnect(false);
+  lostAnswers = 0;
+}
+
+// Requests still unanswered when the socket goes (Connection: close
+// ahead of them, a read error) were sent but will never be answered
+// here: each is told to the observer as a lost connection, and each
+// awaited one is owed a receive() that returns that error.
+void HttpSession::disconnect(bool reportLost) {
+  client.stop();
+  while (reportLost && queued > 0) {
+    uint8_t slot = queueHead;
+    popRequest();
+    if (observer) observer->onAnswer(observerTags[slot], millis() - sentAt[slot],
+                                     HTTP_SESSION_ERR_CONNECTION_LOST);
+    if (!discardQueue[slot]) lostAnswers++;
+  }
+  queued = 0;
+  queueHead = 0;
+  responsesOnSocket = 0;
+  bodyOpen = false;
+  peeked = -1;
+}
+
+bool HttpSession::ensureConnected() {
+  if (client.connected() && !closeAfterBody) return true;
+
+  disconnect(true);
+  closeAfterBody = false;
+  if (!client.connect(host, port, timeoutMs)) {
+    return false;
+  }
+  client.setNoDelay(true);
+  return true;
+}
+
+// ===== Requests =====
+bool HttpSession::send(const char* method, const char* path, const char* body,
+                       const char* contentType, bool discardResponse) {
+  return send(method, path, (const uint8_t*)body, body ? strlen(body) : 0, contentType,
+              discardResponse);
+}
+
+bool HttpSession::send(const char* method, const char* path, const uint8_t* body,
+                       size_t bodyLength, const char* contentType, bool discardResponse) {
+  // Make room: the oldest fire-and-forget answer may still be outstanding
+  if (queued == MAX_PIPELINE) {
+    if (!discardQueue[queueHead]) return false;
+    dropOldestDiscard();
+  }
+
+  if (queued == 0 && bodyOpen) finishBody();
+  if (queued == 0 && !ensureConnected()) {
+    reportUnsent(method, path, HTTP_SESSION_ERR_CONNECT);
+    return false;
+  }
+
+  char head[256];
+  int headLength = snprintf(head, sizeof(head),
+                            "%s %s%s HTTP/1.1\r\nHost: %s\r\nConnection: keep-alive\r\n",
+                            method, basePath, path, host);
+  if (accept && headLength > 0 && headLength < (int)sizeof(head)) {
+    headLength += snprintf(head + headLength, sizeof(head) - headLength, "Accept: %s\r\n", accept);
+  }
+  if (ifNoneMatch && ifNoneMatch[0] && headLength > 0 && headLength < (int)sizeof(head)) {
+    headLength += snprintf(head + headLength, sizeof(head) - headLength, "If-None-Match: %s\r\n",
+                           ifNoneMatch);
+  }
+  ifNoneMatch = nullptr;
+  if (body && headLength > 0 && headLength < (int)sizeof(head)) {
+    headLength += snprintf(head + headLength, sizeof(head) - headLength,
+                           "Content-Type: %s\r\nContent-Length: %u\r\n",
+                           contentType, (unsigned)bodyLength);
+  }
+  if (headLength <= 0 || headLength + 2 >= (int)sizeof(head)) return false;
+  head[headLength++] = '\r';
+  head[headLength++] = '\n';
+
+  if (client.write((const uint8_t*)head, headLength) != (size_t)headLength ||
+      (bodyLength > 0 && client.write(body, bodyLength) != bodyLength)) {
+    disconnect(true);
+    reportUnsent(method, path, HTTP_SESSION_ERR_SEND);
+    return false;
+  }
+
+  uint8_t slot = (queueHead + queued) % MAX_PIPELINE;
+  discardQueue[slot] = discardResponse;
+  sentAt[slot] = millis();
+  observerTags[slot] = observer ? observer->onSend(method, path) : 0;
+  queued++;
+  return true;
+}
+
+void HttpSession::reportUnsent(const char* method, const char* path, int status) {
+  if (observer) observer->onAnswer(observer->onSend(method, path), 0, status);
+}
+
+int HttpSession::receive() {
+  if (bodyOpen) finishBody();
+  if (lostAnswers > 0) {
+    lostAnswers--;
+    return HTTP_SESSION_ERR_CONNECTION_LOST;
+  }
+
+  while (queued > 0) {
+    uint8_t slot = queueHead;
+    bool discard = discardQueue[slot];
+    popRequest();
+
+    int status = readResponseHead();
+    if (observer) observer->onAnswer(observerTags[slot], millis() - sentAt[slot], status);
+    if (status < 0) {
+      disconnect(true);
+      return status;
+    }
+    if (!discard) return status;
+    finishBody();
+  }
+
+  return HTTP_SESSION_ERR_PROTOCOL;  // Nothing was awaiting an answer
+}
+
+int HttpSession::request(const char* method, const char* path, const char* body,
+                         const char* contentType) {
+  return request(method, path, (const uint8_t*)body, body ? strlen(body) : 0, contentType);
+}
+
+int HttpSession::request(const char* method, const char* path, const uint8_t* body,
+                         size_t length, const char* contentType) {
+  const char* tag = ifNoneMatch;  // send() clears it; the retry needs it again
+  for (int attempt = 0; attempt < 2; attempt++) {
+    bool reused = client.connected() && responsesOnSocket > 0;
+
+    ifNoneMatch = tag;
+    if (!send(method, path, body, length, contentType)) {
+      if (attempt == 0 && reused) continue;
+      return client.connected() ? HTTP_SESSION_ERR_SEND : HTTP_SESSION_ERR_CONNECT;
+    }
+
+    int status = receive();
+    // The backend may close an idle keep-alive socket just as we reuse it
+    if (status == HTTP_SESSION_ERR_CONNECTION_LOST && reused && attempt == 0) continue;
+    return status;
+  }
+  return HTTP_SESSION_ERR_CONNECTION_LOST;
+}
+
+bool HttpSession::responseReady() {
+  poll();
+  if (lostAnswers > 0) return true;
+  if (queued == 0) return false;
+  return client.available() > 0 || !client.connected();
+}
+
+void HttpSession::poll() {
+  while (queued > 0 && discardQueue[queueHead] && client.available() > 0) {
+    dropOldestDiscard();
+  }
+}
+
+void HttpSession::popRequest() {
+  queueHead = (queueHead + 1) % MAX_PIPELINE;
+  queued--;
+}
+
+// Reads and drops exactly one answer, that of the oldest request (a
+// discardResponse one). Unlike receive() it never reads on into the next
+// response, which belongs to a caller still to call receive().
+void HttpSession::dropOldestDiscard() {
+  if (bodyOpen) finishBody();
+  if (queued == 0 || !discardQueue[queueHead]) return;
+
+  uint8_t slot = queueHead;
+  popRequest();
+
+  int status = readResponseHead();
+  if (observer) observer->onAnswer(observerTags[slot], millis() - sentAt[slot], status);
+  if (status < 0) {
+    disconnect(true);
+    return;
+  }
+  finishBody();
+}
+
+// ===== Response parsing =====
+int HttpSession::waitForByte() {
+  unsigned long start = millis();
+  while (!client.available()) {
+    if (!client.connected()) return -1;
+    if (millis() - start > timeoutMs) return -1;
+    delay(1);
+  }
+  return client.read();
+}
+
+int HttpSession::readLine(char* buffer, size_t capacity) {
+  size_t length = 0;
+  while (true) {
+    int c = waitForByte();
+    if (c < 0) return -1;
+    if (c == '\n') break;
+    if (c != '\r' && length + 1 < capacity) buffer[length++] = (char)c;
+  }
+  buffer[length] = '\0';
+  return length;
+}
+
+int HttpSession::readResponseHead() {
+  char line[128];
+
+  if (readLine(line, sizeof(line)) < 0) {
+    return client.connected() ? HTTP_SESSION_ERR_TIMEOUT : HTTP_SESSION_ERR_CONNECTION_LOST;
+  }
+  if (strncmp(line, "HTTP/1.", 7) != 0) return HTTP_SESSION_ERR_PROTOCOL;
+  int status = atoi(line + 9);
+
+  bool keepAlive = line[7] == '1';  // HTTP/1.0 closes by default
+  responseLength = -1;
+  responseType[0] = '\0';
+  responseETag[0] = '\0';
+  chunked = false;
+
+  while (true) {
+    int length = readLine(line, sizeof(line));
+    if (length < 0) return HTTP_SESSION_ERR_TIMEOUT;
+    if (length == 0) break;
+
+    if (strncasecmp(line, "Content-Length:", 15) == 0) {
+      responseLength = atol(line + 15);
+    } else if (strncasecmp(line, "Content-Type:", 13) == 0) {
+      const char* value = line + 13;
+      while (*value == ' ') value++;
+      snprintf(responseType, sizeof(responseType), "%s", value);
+    } else if (strncasecmp(line, "ETag:", 5) == 0) {
+      const char* value = line + 5;
+      while (*value == ' ') value++;
+      snprintf(responseETag, sizeof(responseETag), "%s", value);
+    } else if (strncasecmp(line, "Transfer-Encoding:", 18) == 0) {
+      chunked = strstr(line + 18, "chunked") != nullptr;
+    } else if (strncasecmp(line, "Connection:", 11) == 0) {
+      const char* value = line + 11;
+      while (*value == ' ') value++;
+      keepAlive = strncasecmp(value, "close", 5) != 0;
+    }
+  }
+
+  responsesOnSocket++;
+  closeAfterBody = !keepAlive;
+  bodyOpen = true;
+  peeked = -1;
+  chunkRemaining = 0;
+
+  if (status == 204 || status == 304 || (status >= 100 && status < 200)) {
+    bodyRemaining = 0;
+  } else if (chunked) {
+    bodyRemaining = 1;  // Decided chunk by chunk
+  } else {
+    bodyRemaining = responseLength;  // -1: read until the socket closes
+  }
+  if (bodyRemaining == 0) bodyOpen = false;
+  return status;
+}
+
+int HttpSession::readBodyByte() {
+  if (!bodyOpen) return -1;
+
+  if (chunked && chunkRemaining == 0) {
+    char line[16];
+    if (readLine(line, sizeof(line)) < 0) {
+      bodyOpen = false;
+      return -1;
+    }
+    if (line[0] == '\0' && readLine(line, sizeof(line)) < 0) {  // CRLF after a chunk
+      bodyOpen = false;
+      return -1;
+    }
+    chunkRemaining = strtol(line, nullptr, 16);
+    if (chunkRemaining == 0) {
+      readLine(line, sizeof(line));  // Final CRLF (no trailers expected)
+      bodyOpen = false;
+      return -1;
+    }
+  }
+
+  int c = waitForByte();
+  if (c < 0) {
+    bodyOpen = false;
+    return -1;
+  }
+
+  if (chunked) {
+    // Eat the CRLF closing the chunk now, so available() only turns
+    // positive again once the next chunk starts (event streams idle here)
+    if (--chunkRemaining == 0) {
+      char crlf[4];
+      readLine(crlf, sizeof(crlf));
+    }
+  } else if (bodyRemaining > 0 && --bodyRemaining == 0) {
+    bodyOpen = false;
+  }
+  return c;
+}
+
+int HttpSession::bodyAvailable() {
+  if (peeked >= 0) return 1;
+  if (!bodyOpen) return 0;
+  int waiting = client.available();
+  if (!chunked && bodyRemaining > 0 && waiting > bodyRemaining) return bodyRemaining;
+  return waiting;
+}
+
+void HttpSession::finishBody() {
+  peeked = -1;
+  while (bodyOpen) {
+    if (readBodyByte() < 0) break;
+  }
+  if (closeAfterBody) disconnect(true);
+}
+
+void HttpSession::skipBody() {
+  finishBody();
+}
+
+size_t HttpSession::readBody(uint8_t* buffer, size_t capacity) {
+  size_t length = 0;
+  while (bodyOpen || peeked >= 0) {
+    int c = bodyStream.read();
+    if (c < 0) break;
+    if (length == capacity) {
+      finishBody();
+      return 0;
+    }
+    buffer[length++] = (uint8_t)c;
+  }
+  if (closeAfterBody) disconnect(true);
+  return length;
+}
+
+bool HttpSession::responseIs(const char* mediaType) const {
+  size_t length = strlen(mediaType);
+  return strncasecmp(responseType, mediaType, length) == 0 &&
+         (responseType[length] == '\0' || responseType[length] == ';');
+}
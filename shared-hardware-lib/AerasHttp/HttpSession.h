@@ -0,0 +1,146 @@
+/*
+ * AERAS - Persistent HTTP/1.1 session to the backend
+ * Keeps one keep-alive socket open to BACKEND_URL, reconnects when the
+ * backend drops it and lets several requests be in flight at once
+ * (pipelining). Shared by the rickshaw and user side firmwares.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <WiFiClient.h>
+#include <HttpErrors.h>  // Negative results of receive()/request()
+
+class HttpSession;
+
+// Told about every request a session sends and the answer it gets
+// (telemetry). onSend() returns a tag that comes back with the answer;
+// a request that never got out is answered at once with its error.
+class HttpObserver {
+ public:
+  virtual uint8_t onSend(const char* method, const char* path) = 0;
+  virtual void onAnswer(uint8_t tag, uint32_t latencyMs, int status) = 0;
+};
+
+// Body of the current response, bounded by Content-Length / chunked framing
+class HttpBodyStream : public Stream {
+ public:
+  explicit HttpBodyStream(HttpSession& session) : session(session) { setTimeout(0); }
+
+  int available() override;
+  int read() override;
+  int peek() override;
+  size_t write(uint8_t) override { return 0; }
+
+ private:
+  HttpSession& session;
+};
+
+class HttpSession {
+ public:
+  static const uint8_t MAX_PIPELINE = 4;
+
+  HttpSession() : bodyStream(*this) {}
+
+  // baseUrl like "http://10.172.129.95:3000/api"; paths passed later are
+  // appended to its path part
+  void begin(const char* baseUrl, uint32_t timeoutMs = 5000);
+  void setTimeout(uint32_t ms) { timeoutMs = ms; }
+  // Sent as the Accept header of every request (nullptr: none). Check
+  // responseIs() before decoding: not every endpoint honours it.
+  void setAccept(const char* mediaType) { accept = mediaType; }
+  // Sent as If-None-Match with the next request only (nullptr or "": none);
+  // the backend answers 304 without a body while etag() is unchanged
+  void setIfNoneMatch(const char* tag) { ifNoneMatch = tag; }
+  void setObserver(HttpObserver* requestObserver) { observer = requestObserver; }
+
+  // Blocking request/response; retries once on a fresh socket if a reused
+  // keep-alive socket turns out to be dead. Returns HTTP status or < 0.
+  int request(const char* method, const char* path, const char* body = nullptr,
+              const char* contentType = "application/json");
+  // Binary body of length bytes
+  int request(const char* method, const char* path, const uint8_t* body, size_t length,
+              const char* contentType);
+  int get(const char* path) { return request("GET", path); }
+  int post(const char* path, const char* body) { return request("POST", path, body); }
+
+  // Pipelining: send() only writes the request, receive() reads the next
+  // response in order. discardResponse requests are answered and dropped
+  // automatically (fire-and-forget). Requests the socket went down under
+  // (e.g. behind an answer with Connection: close) are not resent: each
+  // still gets its receive(), returning HTTP_SESSION_ERR_CONNECTION_LOST.
+  bool send(const char* method, const char* path, const char* body = nullptr,
+            const char* contentType = "application/json", bool discardResponse = false);
+  bool send(const char* method, const char* path, const uint8_t* body, size_t length,
+            const char* contentType, bool discardResponse = false);
+  int receive();
+
+  // Non-blocking: true once the next awaited response has started to arrive
+  bool responseReady();
+  // Drains answers to fire-and-forget requests that already arrived
+  void poll();
+
+  // Body of the response returned by the last receive()/request(); feed it
+  // straight to a decoder instead of copying it into a String
+  Stream& body() { return bodyStream; }
+  void skipBody();
+  long contentLength() const { return responseLength; }
+  // Whole body into buffer (for in-place decoders); 0 when it does not fit,
+  // in which case it is skipped
+  size_t readBody(uint8_t* buffer, size_t capacity);
+  // Media type of that response, e.g. responseIs("application/json")
+  bool responseIs(const char* mediaType) const;
+  // ETag of that response ("" without one); copy it before the next request
+  const char* etag() const { return responseETag; }
+
+  uint8_t inFlight() const { return queued + lostAnswers; }
+  bool connected() { return client.connected(); }
+  // Drops the socket and every unanswered request, without reporting them
+  void close();
+
+ private:
+  friend class HttpBodyStream;
+
+  bool ensureConnected();
+  int readResponseHead();
+  int readLine(char* buffer, size_t capacity);
+  int waitForByte();
+  int readBodyByte();
+  int bodyAvailable();
+  void finishBody();
+  void popRequest();
+  void dropOldestDiscard();
+  void disconnect(bool reportLost);
+  void reportUnsent(const char* method, const char* path, int status);
+
+  WiFiClient client;
+  HttpBodyStream bodyStream;
+
+  char host[64] = "";
+  uint16_t port = 80;
+  char basePath[32] = "";
+  uint32_t timeoutMs = 5000;
+  const char* accept = nullptr;
+  const char* ifNoneMatch = nullptr;
+  HttpObserver* observer = nullptr;
+
+  // Requests written but not yet answered, oldest first
+  bool discardQueue[MAX_PIPELINE];
+  unsigned long sentAt[MAX_PIPELINE];
+  uint8_t observerTags[MAX_PIPELINE];
+  uint8_t queueHead = 0;
+  uint8_t queued = 0;
+  uint8_t lostAnswers = 0;    // Awaited requests lost with their socket
+  uint16_t responsesOnSocket = 0;
+
+  // State of the response currently being read
+  bool bodyOpen = false;
+  bool chunked = false;
+  bool closeAfterBody = false;
+  long responseLength = -1;
+  char responseType[32] = "";
+  char responseETag[48] = "";
+  long bodyRemaining = 0;     // -1 = until the backend closes the socket
+  long chunkRemaining = 0;
+  int peeked = -1;
+};
@@ -0,0 +1,251 @@
+/*
+ * AERAS - Backend reply decoding
+ */
+
+#include "BackendMessages.h"
+
+#include <ArduinoJson.h>
+
+// Filtered documents only hold the few fields below (strings included)
+typedef StaticJsonDocument<JSON_OBJECT_SIZE(8)> FilterDocument;
+typedef StaticJsonDocument<JSON_OBJECT_SIZE(8) + 128> ReplyDocument;
+
+static void copyField(char* target, size_t capacity, JsonVariantConst value) {
+  snprintf(target, capacity, "%s", value | "");
+}
+
+// The backend sends some numbers as strings (toFixed), accept both
+static float numberField(JsonVariantConst value) {
+  if (value.is<const char*>()) return atof(value.as<const char*>());
+  return value.as<float>();
+}
+
+static bool decode(Stream& body, ReplyDocument& doc, const FilterDocument& filter) {
+  DeserializationError error = deserializeJson(doc, body, DeserializationOption::Filter(filter));
+  if (error) {
+    Serial.print("✗ JSON decode failed: ");
+    Serial.println(error.c_str());
+    return false;
+  }
+  return true;
+}
+
+bool parsePendingOffer(Stream& body, RideOffer& offer) {
+  memset(&offer, 0, sizeof(offer));
+
+  // Skip to the first array element and decode that object alone
+  if (!body.find("\"rides\":[")) return false;
+  if (body.peek() == ']') return false;
+  return parseRideOffer(body, offer);
+}
+
+bool parseRideOffer(Stream& body, RideOffer& offer) {
+  memset(&offer, 0, sizeof(offer));
+
+  FilterDocument filter;
+  filter["rideID"] = true;
+  filter["pickupBlock"] = true;
+  filter["destination"] = true;
+  filter["distance"] = true;
+
+  ReplyDocument doc;
+  if (!decode(body, doc, filter)) return false;
+
+  offer.rideID = doc["rideID"] | 0L;
+  copyField(offer.pickupBlock, sizeof(offer.pickupBlock), doc["pickupBlock"]);
+  copyField(offer.destination, sizeof(offer.destination), doc["destination"]);
+  offer.distanceKm = numberField(doc["distance"]);
+  return offer.rideID > 0;
+}
+
+bool parseRideStatus(Stream& body, RideStatusReply& reply) {
+  memset(&reply, 0, sizeof(reply));
+
+  FilterDocument filter;
+  filter["rideID"] = true;
+  filter["status"] = true;
+  filter["rickshawID"] = true;
+  filter["pickupBlock"] = true;
+  filter["destination"] = true;
+
+  ReplyDocument doc;
+  if (!decode(body, doc, filter)) return false;
+
+  reply.rideID = doc["rideID"] | 0L;
+  copyField(reply.status, sizeof(reply.status), doc["status"]);
+  copyField(reply.rickshawID, sizeof(reply.rickshawID), doc["rickshawID"]);
+  copyField(reply.pickupBlock, sizeof(reply.pickupBlock), doc["pickupBlock"]);
+  copyField(reply.destination, sizeof(reply.destination), doc["destination"]);
+  return true;
+}
+
+bool parseCompleteReply(Stream& body, CompleteReply& reply) {
+  memset(&reply, 0, sizeof(reply));
+
+  FilterDocument filter;
+  filter["success"] = true;
+  filter["points"] = true;
+  filter["distance"] = true;
+  filter["status"] = true;
+
+  ReplyDocument doc;
+  if (!decode(body, doc, filter)) return false;
+
+  reply.success = doc["success"] | false;
+  reply.points = doc["points"] | 0;
+  reply.distanceMeters = numberField(doc["distance"]);
+  copyField(reply.status, sizeof(reply.status), doc["status"]);
+  return true;
+}
+
+bool parseRideRequestReply(Stream& body, RideRequestReply& reply) {
+  memset(&reply, 0, sizeof(reply));
+
+  FilterDocument filter;
+  filter["success"] = true;
+  filter["rideID"] = true;
+
+  ReplyDocument doc;
+  if (!decode(body, doc, filter)) return false;
+
+  reply.success = doc["success"] | false;
+  reply.rideID = doc["rideID"] | 0L;
+  return true;
+}
+
+bool parseBlockStatus(Stream& body, BlockStatusReply& reply) {
+  memset(&reply, 0, sizeof(reply));
+
+  FilterDocument filter;
+  filter["status"] = true;
+  filter["rideID"] = true;
+
+  ReplyDocument doc;
+  if (!decode(body, doc, filter)) return false;
+
+  copyField(reply.status, sizeof(reply.status), doc["status"]);
+  reply.rideID = doc["rideID"] | 0L;
+  return true;
+}
+
+bool parseSuccessReply(Stream& body, bool& success) {
+  FilterDocument filter;
+  filter["success"] = true;
+
+  ReplyDocument doc;
+  success = false;
+  if (!decode(body, doc, filter)) return false;
+
+  success = doc["success"] | false;
+  return true;
+}
+
+// Skips separators inside an array; returns the first byte of the next
+// element, or ']' at its end
+static int nextArrayElement(Stream& body) {
+  int c = body.peek();
+  while (c == ',' || c == ' ' || c == '\r' || c == '\n') {
+    body.read();
+    c = body.peek();
+  }
+  return c;
+}
+
+bool parsePendingOffers(Stream& body, OfferCallback onOffer, void* context) {
+  if (!body.find("\"rides\":[")) return false;
+
+  while (true) {
+    int c = nextArrayElement(body);
+    if (c == ']') return true;
+    if (c != '{') return false;
+
+    RideOffer offer;
+    if (!parseRideOffer(body, offer)) return false;
+    if (!onOffer(offer, context)) return true;
+  }
+}
+
+bool parseRideStatuses(Stream& body, RideStatusCallback onRide, void* context) {
+  if (!body.find("\"rides\":[")) return false;
+
+  while (true) {
+    int c = nextArrayElement(body);
+    if (c == ']') return true;
+    if (c != '{') return false;
+
+    RideStatusReply reply;
+    if (!parseRideStatus(body, reply)) return false;
+    if (reply.rideID > 0 && !onRide(reply, context)) return true;
+  }
+}
+
+bool parseBlockList(Stream& body, long& version, BlockCallback onBlock, void* context) {
+  version = 0;
+
+  // The backend sends "version" ahead of the array
+  if (!body.find("\"version\":")) return false;
+  while (body.peek() >= '0' && body.peek() <= '9') {
+    version = version * 10 + (body.read() - '0');
+  }
+  if (!body.find("\"locations\":[")) return false;
+
+  FilterDocument filter;
+  filter["blockID"] = true;
+  filter["locationName"] = true;
+  filter["latitude"] = true;
+  filter["longitude"] = true;
+
+  while (true) {
+    int c = nextArrayElement(body);
+    if (c == ']') return true;
+    if (c != '{') return false;
+
+    ReplyDocument doc;
+    if (!decode(body, doc, filter)) return false;
+
+    BlockInfo block;
+    memset(&block, 0, sizeof(block));
+    copyField(block.blockID, sizeof(block.blockID), doc["blockID"]);
+    copyField(block.locationName, sizeof(block.locationName), doc["locationName"]);
+    block.lat = doc["latitude"] | 0.0;
+    block.lng = doc["longitude"] | 0.0;
+
+    if (block.blockID[0] != '\0' && !onBlock(block, context)) return true;
+  }
+}
+
+bool parseRideEventResults(Stream& body, RideEventCallback onResult, void* context) {
+  if (!body.find("\"results\":[")) return false;
+
+  FilterDocument filter;
+  filter["key"] = true;
+  filter["status"] = true;
+  JsonObject bodyFilter = filter.createNestedObject("body");
+  bodyFilter["success"] = true;
+  bodyFilter["points"] = true;
+  bodyFilter["distance"] = true;
+  bodyFilter["status"] = true;
+
+  while (true) {
+    int c = nextArrayElement(body);
+    if (c == ']') return true;
+    if (c != '{') return false;
+
+    ReplyDocument doc;
+    if (!decode(body, doc, filter)) return false;
+
+    RideEventResult result;
+    memset(&result, 0, sizeof(result));
+    result.key = doc["key"] | -1L;
+    result.status = doc["status"] | 0;
+
+    JsonVariantConst reply = doc["body"];
+    result.success = reply["success"] | false;
+    result.complete.success = result.success;
+    result.complete.points = reply["points"] | 0;
+    result.complete.distanceMeters = numberField(reply["distance"]);
+    copyField(result.complete.status, sizeof(result.complete.status), reply["status"]);
+
+    if (!onResult(result, context)) return true;
+  }
+}
@@ -0,0 +1,110 @@
+/*
+ * AERAS - Backend reply decoding
+ * Replies are parsed straight from the HTTP body stream with an ArduinoJson
+ * filter, so only the fields listed here are ever copied into RAM.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+// Sized for the block IDs / statuses the backend uses today, with headroom
+#define AERAS_BLOCK_ID_LENGTH   24
+#define AERAS_STATUS_LENGTH     16
+#define AERAS_RICKSHAW_ID_LENGTH 16
+#define AERAS_BLOCK_NAME_LENGTH 24
+
+// One entry of GET /ride/pending
+struct RideOffer {
+  long rideID;
+  char pickupBlock[AERAS_BLOCK_ID_LENGTH];
+  char destination[AERAS_BLOCK_ID_LENGTH];
+  float distanceKm;
+};
+
+// GET /ride/<id>/status, one entry of GET /ride/status?rideIDs=
+struct RideStatusReply {
+  long rideID;
+  char status[AERAS_STATUS_LENGTH];
+  char rickshawID[AERAS_RICKSHAW_ID_LENGTH];
+  char pickupBlock[AERAS_BLOCK_ID_LENGTH];
+  char destination[AERAS_BLOCK_ID_LENGTH];
+};
+
+// POST /ride/complete
+struct CompleteReply {
+  bool success;
+  int points;
+  float distanceMeters;
+  char status[AERAS_STATUS_LENGTH];
+};
+
+// POST /ride/request
+struct RideRequestReply {
+  bool success;
+  long rideID;
+};
+
+// GET /ride/status?blockID=
+struct BlockStatusReply {
+  char status[AERAS_STATUS_LENGTH];
+  long rideID;
+};
+
+// One entry of GET /locations
+struct BlockInfo {
+  char blockID[AERAS_BLOCK_ID_LENGTH];
+  char locationName[AERAS_BLOCK_NAME_LENGTH];
+  double lat;
+  double lng;
+};
+
+// One entry of the POST /ride/events "results" array
+struct RideEventResult {
+  long key;             // Journal sequence number the event was sent with
+  int status;           // HTTP status its endpoint answered with
+  bool success;         // body.success
+  CompleteReply complete;  // body of a COMPLETE event
+};
+
+// Called for each decoded offer, in the backend's order; return false to
+// stop reading the list
+typedef bool (*OfferCallback)(const RideOffer& offer, void* context);
+
+// Called for each ride of a batched status reply; return false to stop
+typedef bool (*RideStatusCallback)(const RideStatusReply& reply, void* context);
+
+typedef bool (*RideEventCallback)(const RideEventResult& result, void* context);
+
+// Called for each decoded block; return false to stop reading the list
+typedef bool (*BlockCallback)(const BlockInfo& block, void* context);
+
+// Each parser returns false when the body is not valid JSON; missing
+// fields come back zeroed / empty.
+
+// First (nearest) offer of the "rides" array; false when there is none.
+// The rest of the array is left unread in the stream.
+bool parsePendingOffer(Stream& body, RideOffer& offer);
+// Every offer of the "rides" array (?limit= bounds it); false when the body
+// is malformed before the closing ']'
+bool parsePendingOffers(Stream& body, OfferCallback onOffer, void* context);
+// One offer object on its own - the "offer" event of the push channel
+bool parseRideOffer(Stream& body, RideOffer& offer);
+bool parseRideStatus(Stream& body, RideStatusReply& reply);
+// {"rides":[...]} - GET /ride/status?rideIDs=, in the order asked; rides
+// the backend does not know are left out
+bool parseRideStatuses(Stream& body, RideStatusCallback onRide, void* context);
+bool parseCompleteReply(Stream& body, CompleteReply& reply);
+bool parseRideRequestReply(Stream& body, RideRequestReply& reply);
+bool parseBlockStatus(Stream& body, BlockStatusReply& reply);
+// {"success":true|false,...} - POST /ride/accept and friends
+bool parseSuccessReply(Stream& body, bool& success);
+
+// {"version":N,"locations":[...]} - GET /locations. Blocks are decoded one
+// at a time and handed to onBlock, so the whole list is never in RAM.
+// False when the body is malformed before the closing ']'.
+bool parseBlockList(Stream& body, long& version, BlockCallback onBlock, void* context);
+
+// {"results":[...]} - POST /ride/events, decoded one result at a time.
+// Results come back in the order the events were sent.
+bool parseRideEventResults(Stream& body, RideEventCallback onResult, void* context);
@@ -0,0 +1,223 @@
+/*
+ * AERAS - Compact device wire format
+ */
+
+#include "DeviceWire.h"
+
+// Walks one map, handing each tag to readField with the reader positioned
+// on its value. readField returns false for tags it does not know, which
+// are then skipped.
+template <typename FieldReader>
+static bool readFields(MsgPackReader& reader, FieldReader readField) {
+  size_t entries;
+  if (!reader.readMap(entries)) return false;
+  for (size_t i = 0; i < entries; i++) {
+    char tag;
+    if (!reader.readKey(tag)) return false;
+    if (!readField(tag)) reader.skip();
+  }
+  return reader.ok();
+}
+
+static bool logMalformed(const char* what) {
+  Serial.print("✗ Wire decode failed: ");
+  Serial.println(what);
+  return false;
+}
+
+// {i, p, d, m}
+static bool readOffer(MsgPackReader& reader, RideOffer& offer) {
+  memset(&offer, 0, sizeof(offer));
+  return readFields(reader, [&](char field) {
+    long meters;
+    switch (field) {
+      case WIRE_RIDE:        return reader.readInt(offer.rideID);
+      case WIRE_PICKUP:      return reader.readString(offer.pickupBlock, sizeof(offer.pickupBlock));
+      case WIRE_DESTINATION: return reader.readString(offer.destination, sizeof(offer.destination));
+      case WIRE_DISTANCE:
+        if (!reader.readInt(meters)) return false;
+        offer.distanceKm = meters / 1000.0f;
+        return true;
+      default: return false;
+    }
+  });
+}
+
+bool decodePendingOffer(const uint8_t* body, size_t length, RideOffer& offer) {
+  memset(&offer, 0, sizeof(offer));
+  MsgPackReader reader(body, length);
+
+  bool parsed = readFields(reader, [&](char tag) {
+    if (tag != WIRE_OFFER) return false;
+    if (reader.isNil()) return true;
+    return readOffer(reader, offer);
+  });
+  if (!parsed) return logMalformed("pending offer");
+  return offer.rideID > 0;
+}
+
+bool decodePendingOffers(const uint8_t* body, size_t length, OfferCallback onOffer, void* context) {
+  MsgPackReader reader(body, length);
+  bool stopped = false;
+
+  bool parsed = readFields(reader, [&](char tag) {
+    RideOffer offer;
+    if (tag == WIRE_OFFER) {
+      if (reader.isNil()) return true;
+      if (!readOffer(reader, offer)) return false;
+      if (offer.rideID > 0) stopped = !onOffer(offer, context);
+      return true;
+    }
+    if (tag != WIRE_MORE_OFFERS) return false;
+
+    size_t count;
+    if (!reader.readArray(count)) return false;
+    for (size_t i = 0; i < count; i++) {
+      if (stopped) {
+        reader.skip();
+        continue;
+      }
+      if (!readOffer(reader, offer)) return false;
+      if (offer.rideID > 0) stopped = !onOffer(offer, context);
+    }
+    return true;
+  });
+  return parsed || logMalformed("pending offers");
+}
+
+// {i, s, r, p, d}
+static bool readRideStatus(MsgPackReader& reader, RideStatusReply& reply) {
+  memset(&reply, 0, sizeof(reply));
+  return readFields(reader, [&](char field) {
+    switch (field) {
+      case WIRE_RIDE:        return reader.readInt(reply.rideID);
+      case WIRE_STATUS:      return reader.readString(reply.status, sizeof(reply.status));
+      case WIRE_RICKSHAW:    return reader.readString(reply.rickshawID, sizeof(reply.rickshawID));
+      case WIRE_PICKUP:      return reader.readString(reply.pickupBlock, sizeof(reply.pickupBlock));
+      case WIRE_DESTINATION: return reader.readString(reply.destination, sizeof(reply.destination));
+      default: return false;
+    }
+  });
+}
+
+bool decodeRideStatus(const uint8_t* body, size_t length, RideStatusReply& reply) {
+  MsgPackReader reader(body, length);
+  return readRideStatus(reader, reply) || logMalformed("ride status");
+}
+
+bool decodeRideStatuses(const uint8_t* body, size_t length, RideStatusCallback onRide, void* context) {
+  MsgPackReader reader(body, length);
+  bool stopped = false;
+
+  bool parsed = readFields(reader, [&](char tag) {
+    if (tag != WIRE_STATUSES) return false;
+
+    size_t count;
+    if (!reader.readArray(count)) return false;
+    for (size_t i = 0; i < count; i++) {
+      if (stopped) {
+        reader.skip();
+        continue;
+      }
+      RideStatusReply reply;
+      if (!readRideStatus(reader, reply)) return false;
+      if (reply.rideID > 0) stopped = !onRide(reply, context);
+    }
+    return true;
+  });
+  return parsed || logMalformed("ride statuses");
+}
+
+bool decodeBlockStatus(const uint8_t* body, size_t length, BlockStatusReply& reply) {
+  memset(&reply, 0, sizeof(reply));
+  MsgPackReader reader(body, length);
+
+  bool parsed = readFields(reader, [&](char tag) {
+    switch (tag) {
+      case WIRE_STATUS: return reader.readString(reply.status, sizeof(reply.status));
+      case WIRE_RIDE:   return reader.readInt(reply.rideID);
+      default: return false;
+    }
+  });
+  return parsed || logMalformed("block status");
+}
+
+bool decodeRideEventResults(const uint8_t* body, size_t length, RideEventCallback onResult,
+                            void* context) {
+  MsgPackReader reader(body, length);
+  bool stopped = false;
+
+  bool parsed = readFields(reader, [&](char tag) {
+    if (tag != WIRE_EVENTS) return false;
+
+    size_t count;
+    if (!reader.readArray(count)) return false;
+    for (size_t i = 0; i < count; i++) {
+      if (stopped) {
+        reader.skip();  // Results after a refused one are not looked at
+        continue;
+      }
+
+      RideEventResult result;
+      memset(&result, 0, sizeof(result));
+      result.key = -1;
+
+      CompleteReply& complete = result.complete;
+      bool entry = readFields(reader, [&](char field) {
+        long number;
+        switch (field) {
+          case WIRE_KEY:       return reader.readInt(result.key);
+          case WIRE_SUCCESS:   return reader.readBool(result.success);
+          case WIRE_DISTANCE:  return reader.readFloat(complete.distanceMeters);
+          case WIRE_STATUS:    return reader.readString(complete.status, sizeof(complete.status));
+          case WIRE_HTTP_CODE:
+            if (!reader.readInt(number)) return false;
+            result.status = number;
+            return true;
+          case WIRE_POINTS:
+            if (!reader.readInt(number)) return false;
+            complete.points = number;
+            return true;
+          default: return false;
+        }
+      });
+      if (!entry) return false;
+
+      complete.success = result.success;
+      stopped = !onResult(result, context);
+    }
+    return true;
+  });
+  return parsed || logMalformed("ride event results");
+}
+
+bool encodeLocation(MsgPackWriter& out, const char* rickshawID, double lat, double lng) {
+  out.clear();
+  out.beginMap(3)
+     .key(WIRE_RICKSHAW).str(rickshawID)
+     .key(WIRE_LAT).coordinate(lat)
+     .key(WIRE_LNG).coordinate(lng);
+  return !out.overflowed();
+}
+
+void beginRideEvents(MsgPackWriter& out, const char* rickshawID, uint32_t journalID, uint8_t count) {
+  out.clear();
+  out.beginMap(3)
+     .key(WIRE_RICKSHAW).str(rickshawID)
+     .key(WIRE_JOURNAL).uint32(journalID)
+     .key(WIRE_EVENTS).beginArray(count);
+}
+
+bool encodeRideEvent(MsgPackWriter& out, uint32_t seq, char type, long rideID, double lat, double lng) {
+  bool complete = type == 'C';
+  char tag[2] = {type, '\0'};
+  out.beginMap(complete ? 5 : 3)
+     .key(WIRE_KEY).uint32(seq)
+     .key(WIRE_EVENT_TYPE).str(tag)
+     .key(WIRE_RIDE).int32(rideID);
+  if (complete) {
+    out.key(WIRE_LAT).coordinate(lat)
+       .key(WIRE_LNG).coordinate(lng);
+  }
+  return !out.overflowed();
+}
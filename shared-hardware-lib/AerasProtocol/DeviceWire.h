@@ -0,0 +1,78 @@
+/*
+ * AERAS - Compact device wire format
+ * The device endpoints (/rickshaw/location[/batch], /ride/pending,
+ * /ride/status[?rideIDs=], /ride/<id>/status, /ride/accept, /ride/pickup,
+ * /ride/complete, /ride/events) also speak MessagePack with one-letter
+ * keys. Requests go out as AERAS_WIRE_CONTENT_TYPE; replies come back in it
+ * when the session Accepts it. The backend side lives in
+ * aeras-backend/lib/deviceWire.js - keep the tags in step.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include "BackendMessages.h"
+#include "MsgPack.h"
+
+#define AERAS_WIRE_CONTENT_TYPE "application/msgpack"
+
+// Coordinates are int32 microdegrees, offer distances int32 meters and
+// completion distances float32 meters
+enum WireTag : char {
+  WIRE_RICKSHAW    = 'r',
+  WIRE_RIDE        = 'i',
+  WIRE_STATUS      = 's',
+  WIRE_PICKUP      = 'p',
+  WIRE_DESTINATION = 'd',
+  WIRE_LAT         = 'y',
+  WIRE_LNG         = 'x',
+  WIRE_SUCCESS     = 'k',
+  WIRE_POINTS      = 't',
+  WIRE_EVENT_TYPE  = 't',  // "A"ccept, "P"ickup, "C"omplete
+  WIRE_DISTANCE    = 'm',
+  WIRE_KEY         = 'n',  // Journal sequence number
+  WIRE_HTTP_CODE   = 'c',
+  WIRE_JOURNAL     = 'j',
+  WIRE_EVENTS      = 'e',  // Request and reply of /ride/events
+  WIRE_ERROR       = 'e',  // Any other reply: error message
+  WIRE_OFFER       = 'o',
+  WIRE_FIXES       = 'f',  // [[lat, lng, age seconds], ...]
+  WIRE_MORE_OFFERS = 'v',  // Offers after the first one
+  WIRE_STATUSES    = 'g',  // Batched /ride/status reply
+  // Telemetry uploads (see AerasTelemetry/Telemetry.h)
+  WIRE_BLOCK       = 'b',  // Kiosk blockID
+  WIRE_UPTIME      = 'u',
+  WIRE_WINDOW      = 'w',
+  WIRE_LOOPS       = 'l',
+  WIRE_HEAP        = 'h',
+  WIRE_WIFI        = 'q',
+  WIRE_ENDPOINTS   = 'a'
+};
+
+// Decoders work on the whole reply body in RAM and return false when it is
+// malformed; missing fields come back zeroed / empty, as with the JSON
+// parsers in BackendMessages.h.
+
+// {o: {i, p, d, m} | nil}; false when there is no offer
+bool decodePendingOffer(const uint8_t* body, size_t length, RideOffer& offer);
+// {o: {i, p, d, m} | nil, v: [{i, p, d, m}, ...]}, o first
+bool decodePendingOffers(const uint8_t* body, size_t length, OfferCallback onOffer, void* context);
+// {i, s, r, p, d}
+bool decodeRideStatus(const uint8_t* body, size_t length, RideStatusReply& reply);
+// {g: [{i, s, r, p, d}, ...]}, in the order asked
+bool decodeRideStatuses(const uint8_t* body, size_t length, RideStatusCallback onRide, void* context);
+// {s, i, r}
+bool decodeBlockStatus(const uint8_t* body, size_t length, BlockStatusReply& reply);
+// {e: [{n, c, k, t, m, s}, ...]}, results in the order the events were sent
+bool decodeRideEventResults(const uint8_t* body, size_t length, RideEventCallback onResult,
+                            void* context);
+
+// Requests are built into a caller-owned buffer; false when they did not fit
+
+// {r, y, x}: POST /rickshaw/location
+bool encodeLocation(MsgPackWriter& out, const char* rickshawID, double lat, double lng);
+// {r, j, e: [...]}: POST /ride/events, head of a batch of count events
+void beginRideEvents(MsgPackWriter& out, const char* rickshawID, uint32_t journalID, uint8_t count);
+// {n, t, i[, y, x]}: one event of the batch; only a complete ('C') carries
+// the position. False once the batch did not fit.
+bool encodeRideEvent(MsgPackWriter& out, uint32_t seq, char type, long rideID, double lat, double lng);
@@ -0,0 +1,284 @@
+/*
+ * AERAS - Fixed-buffer MessagePack writer and in-place reader
+ */
+
+#include "MsgPack.h"
+
+// ===== MsgPackWriter =====
+void MsgPackWriter::clear() {
+  used = 0;
+  overflow = false;
+}
+
+void MsgPackWriter::put(uint8_t byte) {
+  if (used < capacity) {
+    buffer[used++] = byte;
+  } else {
+    overflow = true;
+  }
+}
+
+void MsgPackWriter::putBig(uint32_t value, uint8_t bytes) {
+  while (bytes-- > 0) put((uint8_t)(value >> (8 * bytes)));
+}
+
+MsgPackWriter& MsgPackWriter::beginMap(uint16_t entries) {
+  if (entries < 16) {
+    put(0x80 | entries);
+  } else {
+    put(0xDE);
+    putBig(entries, 2);
+  }
+  return *this;
+}
+
+MsgPackWriter& MsgPackWriter::beginArray(uint16_t items) {
+  if (items < 16) {
+    put(0x90 | items);
+  } else {
+    put(0xDC);
+    putBig(items, 2);
+  }
+  return *this;
+}
+
+MsgPackWriter& MsgPackWriter::key(char tag) {
+  put(0xA1);
+  put((uint8_t)tag);
+  return *this;
+}
+
+MsgPackWriter& MsgPackWriter::nil() {
+  put(0xC0);
+  return *this;
+}
+
+MsgPackWriter& MsgPackWriter::boolean(bool value) {
+  put(value ? 0xC3 : 0xC2);
+  return *this;
+}
+
+MsgPackWriter& MsgPackWriter::int32(int32_t value) {
+  put(0xD2);
+  putBig((uint32_t)value, 4);
+  return *this;
+}
+
+MsgPackWriter& MsgPackWriter::uint32(uint32_t value) {
+  put(0xCE);
+  putBig(value, 4);
+  return *this;
+}
+
+MsgPackWriter& MsgPackWriter::float32(float value) {
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  put(0xCA);
+  putBig(bits, 4);
+  return *this;
+}
+
+MsgPackWriter& MsgPackWriter::str(const char* text) {
+  if (!text) text = "";
+  size_t size = strlen(text);
+  if (size < 32) {
+    put(0xA0 | size);
+  } else if (size < 256) {
+    put(0xD9);
+    put(size);
+  } else {
+    put(0xDA);
+    putBig(size, 2);
+  }
+  while (*text) put((uint8_t)*text++);
+  return *this;
+}
+
+MsgPackWriter& MsgPackWriter::coordinate(double degrees) {
+  return int32((int32_t)lround(degrees * 1e6));
+}
+
+// ===== MsgPackReader =====
+bool MsgPackReader::fail() {
+  failed = true;
+  return false;
+}
+
+bool MsgPackReader::take(size_t count, const uint8_t*& at) {
+  if (failed || offset + count > length) return fail();
+  at = data + offset;
+  offset += count;
+  return true;
+}
+
+uint32_t MsgPackReader::big(const uint8_t* at, uint8_t bytes) const {
+  uint32_t value = 0;
+  for (uint8_t i = 0; i < bytes; i++) value = (value << 8) | at[i];
+  return value;
+}
+
+bool MsgPackReader::readMap(size_t& entries) {
+  const uint8_t* at;
+  if (!take(1, at)) return false;
+  if ((*at & 0xF0) == 0x80) {
+    entries = *at & 0x0F;
+    return true;
+  }
+  if (*at == 0xDE && take(2, at)) {
+    entries = big(at, 2);
+    return true;
+  }
+  return fail();
+}
+
+bool MsgPackReader::readArray(size_t& items) {
+  const uint8_t* at;
+  if (!take(1, at)) return false;
+  if ((*at & 0xF0) == 0x90) {
+    items = *at & 0x0F;
+    return true;
+  }
+  if (*at == 0xDC && take(2, at)) {
+    items = big(at, 2);
+    return true;
+  }
+  return fail();
+}
+
+bool MsgPackReader::readKey(char& tag) {
+  char text[2];
+  if (!readString(text, sizeof(text))) return false;
+  tag = text[0];
+  return true;
+}
+
+bool MsgPackReader::isNil() {
+  if (failed || offset >= length || data[offset] != 0xC0) return false;
+  offset++;
+  return true;
+}
+
+bool MsgPackReader::readBool(bool& value) {
+  const uint8_t* at;
+  if (!take(1, at)) return false;
+  if (*at != 0xC2 && *at != 0xC3) return fail();
+  value = *at == 0xC3;
+  return true;
+}
+
+bool MsgPackReader::readInt(long& value) {
+  const uint8_t* at;
+  if (!take(1, at)) return false;
+  uint8_t code = *at;
+
+  if (code < 0x80) {
+    value = code;
+  } else if (code >= 0xE0) {
+    value = (int8_t)code;
+  } else {
+    switch (code) {
+      case 0xCC: if (!take(1, at)) return false; value = at[0]; break;
+      case 0xCD: if (!take(2, at)) return false; value = big(at, 2); break;
+      case 0xCE: if (!take(4, at)) return false; value = (long)big(at, 4); break;
+      case 0xD0: if (!take(1, at)) return false; value = (int8_t)at[0]; break;
+      case 0xD1: if (!take(2, at)) return false; value = (int16_t)big(at, 2); break;
+      case 0xD2: if (!take(4, at)) return false; value = (int32_t)big(at, 4); break;
+      default: return fail();
+    }
+  }
+  return true;
+}
+
+bool MsgPackReader::readFloat(float& value) {
+  if (failed || offset >= length) return fail();
+  const uint8_t* at;
+
+  if (data[offset] == 0xCA) {
+    take(1, at);
+    if (!take(4, at)) return false;
+    uint32_t bits = big(at, 4);
+    memcpy(&value, &bits, sizeof(value));
+    return true;
+  }
+  if (data[offset] == 0xCB) {
+    take(1, at);
+    if (!take(8, at)) return false;
+    uint64_t bits = ((uint64_t)big(at, 4) << 32) | big(at + 4, 4);
+    double wide;
+    memcpy(&wide, &bits, sizeof(wide));
+    value = (float)wide;
+    return true;
+  }
+
+  long whole;
+  if (!readInt(whole)) return false;
+  value = (float)whole;
+  return true;
+}
+
+bool MsgPackReader::readString(char* target, size_t capacity) {
+  if (capacity > 0) target[0] = '\0';
+  if (isNil()) return true;
+
+  const uint8_t* at;
+  if (!take(1, at)) return false;
+  size_t size;
+  if ((*at & 0xE0) == 0xA0) {
+    size = *at & 0x1F;
+  } else if (*at == 0xD9 && take(1, at)) {
+    size = at[0];
+  } else if (*at == 0xDA && take(2, at)) {
+    size = big(at, 2);
+  } else {
+    return fail();
+  }
+
+  if (!take(size, at)) return false;
+  if (capacity == 0) return true;
+  size_t copied = min(size, capacity - 1);
+  memcpy(target, at, copied);
+  target[copied] = '\0';
+  return true;
+}
+
+bool MsgPackReader::readCoordinate(double& degrees) {
+  long micro;
+  if (!readInt(micro)) return false;
+  degrees = micro / 1e6;
+  return true;
+}
+
+bool MsgPackReader::skip() {
+  size_t pending = 1;  // Values still to step over; containers add their contents
+  while (pending > 0) {
+    const uint8_t* at;
+    if (!take(1, at)) return false;
+    uint8_t code = *at;
+    pending--;
+
+    size_t payload = 0;
+    if (code < 0x80 || code >= 0xE0 || code == 0xC0 || code == 0xC2 || code == 0xC3) {
+      payload = 0;
+    } else if (code < 0x90) {
+      pending += 2 * (code & 0x0F);
+    } else if (code < 0xA0) {
+      pending += code & 0x0F;
+    } else if (code < 0xC0) {
+      payload = code & 0x1F;
+    } else {
+      switch (code) {
+        case 0xCC: case 0xD0: payload = 1; break;
+        case 0xCD: case 0xD1: payload = 2; break;
+        case 0xCE: case 0xD2: case 0xCA: payload = 4; break;
+        case 0xCF: case 0xD3: case 0xCB: payload = 8; break;
+        case 0xC4: case 0xD9: if (!take(1, at)) return false; payload = at[0]; break;
+        case 0xC5: case 0xDA: if (!take(2, at)) return false; payload = big(at, 2); break;
+        case 0xDC: if (!take(2, at)) return false; pending += big(at, 2); break;
+        case 0xDE: if (!take(2, at)) return false; pending += 2 * big(at, 2); break;
+        default: return fail();  // 32-bit lengths never come from the backend
+      }
+    }
+    if (payload > 0 && !take(payload, at)) return false;
+  }
+  return true;
+}
@@ -0,0 +1,86 @@
+/*
+ * AERAS - Fixed-buffer MessagePack writer and in-place reader
+ * The device wire format (see DeviceWire.h) is MessagePack with one-letter
+ * keys. Numbers are written at a fixed width so every message of a kind
+ * has the same layout; the reader walks a received body where it lies and
+ * only copies out the strings it is asked for.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+class MsgPackWriter {
+ public:
+  MsgPackWriter(uint8_t* buffer, size_t capacity) : buffer(buffer), capacity(capacity) {}
+
+  // Sizes are written up front, so callers count their entries first
+  MsgPackWriter& beginMap(uint16_t entries);
+  MsgPackWriter& beginArray(uint16_t items);
+  MsgPackWriter& key(char tag);  // One-letter key of the following value
+
+  MsgPackWriter& nil();
+  MsgPackWriter& boolean(bool value);
+  MsgPackWriter& int32(int32_t value);
+  MsgPackWriter& uint32(uint32_t value);
+  MsgPackWriter& float32(float value);
+  MsgPackWriter& str(const char* text);
+  // Degrees as int32 microdegrees (~0.11 m resolution)
+  MsgPackWriter& coordinate(double degrees);
+
+  void clear();
+  const uint8_t* data() const { return buffer; }
+  size_t length() const { return used; }
+  bool overflowed() const { return overflow; }
+
+ private:
+  void put(uint8_t byte);
+  void putBig(uint32_t value, uint8_t bytes);
+
+  uint8_t* buffer;
+  size_t capacity;
+  size_t used = 0;
+  bool overflow = false;
+};
+
+template <size_t N>
+class MsgPackBuffer : public MsgPackWriter {
+ public:
+  MsgPackBuffer() : MsgPackWriter(storage, N) {}
+
+ private:
+  uint8_t storage[N];
+};
+
+// Reads values in document order. Every call returns false (and the reader
+// stays failed) on a type mismatch or a truncated body.
+class MsgPackReader {
+ public:
+  MsgPackReader(const uint8_t* data, size_t length) : data(data), length(length) {}
+
+  bool readMap(size_t& entries);
+  bool readArray(size_t& items);
+  // Map keys: the first letter of a string key (others are skipped by the caller)
+  bool readKey(char& tag);
+
+  bool isNil();  // Consumes the nil when there is one
+  bool readBool(bool& value);
+  bool readInt(long& value);     // Any integer width
+  bool readFloat(float& value);  // float32/64 or integer
+  // Copies and NUL-terminates (truncating); nil reads as ""
+  bool readString(char* target, size_t capacity);
+  bool readCoordinate(double& degrees);  // int32 microdegrees
+
+  bool skip();  // One value, containers included
+  bool ok() const { return !failed; }
+
+ private:
+  bool take(size_t count, const uint8_t*& at);
+  uint32_t big(const uint8_t* at, uint8_t bytes) const;
+  bool fail();
+
+  const uint8_t* data;
+  size_t length;
+  size_t offset = 0;
+  bool failed = false;
+};
@@ -0,0 +1,47 @@
+/*
+ * AERAS - Lock-free single-producer / single-consumer ring buffer
+ * Used to pass commands and events between two FreeRTOS tasks without a
+ * mutex: exactly one task may push() and exactly one other task may pop().
+ * Capacity must be a power of two; one slot is never wasted because the
+ * head/tail counters run freely and are masked on access.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+
+template <typename T, size_t CAPACITY>
+class SpscQueue {
+  static_assert(CAPACITY >= 2 && (CAPACITY & (CAPACITY - 1)) == 0,
+                "SpscQueue capacity must be a power of two");
+
+ public:
+  // Producer side. Returns false (and drops item) when the queue is full.
+  bool push(const T& item) {
+    size_t tail = tailIndex.load(std::memory_order_relaxed);
+    if (tail - headIndex.load(std::memory_order_acquire) == CAPACITY) return false;
+    slots[tail & (CAPACITY - 1)] = item;
+    tailIndex.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side. Returns false when there is nothing to read.
+  bool pop(T& item) {
+    size_t head = headIndex.load(std::memory_order_relaxed);
+    if (head == tailIndex.load(std::memory_order_acquire)) return false;
+    item = slots[head & (CAPACITY - 1)];
+    headIndex.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Approximate when called from the producer; exact from the consumer
+  bool empty() const {
+    return headIndex.load(std::memory_order_acquire) == tailIndex.load(std::memory_order_acquire);
+  }
+
+ private:
+  T slots[CAPACITY];
+  std::atomic<size_t> headIndex{0};
+  std::atomic<size_t> tailIndex{0};
+};
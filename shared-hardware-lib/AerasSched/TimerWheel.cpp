@@ -0,0 +1,160 @@
+/*
+ * AERAS - Cooperative timer-wheel scheduler
+ */
+
+#include "TimerWheel.h"
+
+static inline bool tickReached(uint32_t tick, uint32_t now) {
+  return (int32_t)(tick - now) <= 0;
+}
+
+TimerWheel::TimerWheel() {
+  for (uint8_t i = 0; i < MAX_TIMERS; i++) timers[i].active = false;
+  for (uint8_t i = 0; i < SLOTS; i++) slots[i] = TIMER_NONE;
+}
+
+// Global instances are constructed before millis() is usable, so the
+// clock starts with the first timer instead
+void TimerWheel::startClock() {
+  if (clockStarted) return;
+  clockStarted = true;
+  lastRunMs = millis();
+}
+
+// ===== Scheduling =====
+TimerId TimerWheel::every(const char* name, uint32_t periodMs, TimerCallback callback, bool runNow) {
+  return schedule(name, runNow ? 0 : periodMs, periodMs, callback);
+}
+
+TimerId TimerWheel::after(const char* name, uint32_t delayMs, TimerCallback callback) {
+  return schedule(name, delayMs, 0, callback);
+}
+
+TimerId TimerWheel::schedule(const char* name, uint32_t delayMs, uint32_t periodMs,
+                             TimerCallback callback) {
+  startClock();
+
+  TimerId id = find(name);
+  if (id != TIMER_NONE) {
+    unlink(id);
+  } else {
+    for (TimerId i = 0; i < MAX_TIMERS && id == TIMER_NONE; i++) {
+      if (!timers[i].active) id = i;
+    }
+    if (id == TIMER_NONE) {
+      Serial.print("✗ Timer pool full, dropped: ");
+      Serial.println(name);
+      return TIMER_NONE;
+    }
+  }
+
+  uint32_t delayTicks = (delayMs + TICK_MS - 1) / TICK_MS;
+  Timer& timer = timers[id];
+  timer.name = name;
+  timer.callback = callback;
+  timer.period = periodMs ? max((uint32_t)1, (periodMs + TICK_MS / 2) / TICK_MS) : 0;
+  timer.due = nowTick() + max((uint32_t)1, delayTicks);
+  timer.active = true;
+  link(id);
+  return id;
+}
+
+bool TimerWheel::cancel(const char* name) {
+  TimerId id = find(name);
+  if (id == TIMER_NONE) return false;
+  unlink(id);
+  timers[id].active = false;
+  return true;
+}
+
+bool TimerWheel::pending(const char* name) const {
+  return find(name) != TIMER_NONE;
+}
+
+TimerId TimerWheel::find(const char* name) const {
+  for (TimerId i = 0; i < MAX_TIMERS; i++) {
+    if (timers[i].active && strcmp(timers[i].name, name) == 0) return i;
+  }
+  return TIMER_NONE;
+}
+
+// ===== Wheel =====
+uint32_t TimerWheel::nowTick() const {
+  if (!clockStarted) return clockTick;
+  return clockTick + (millis() - lastRunMs + leftoverMs) / TICK_MS;
+}
+
+void TimerWheel::link(TimerId id) {
+  uint8_t slot = timers[id].due & (SLOTS - 1);
+  timers[id].next = slots[slot];
+  slots[slot] = id;
+}
+
+void TimerWheel::unlink(TimerId id) {
+  int8_t* link = &slots[timers[id].due & (SLOTS - 1)];
+  while (*link != TIMER_NONE) {
+    if (*link == id) {
+      *link = timers[id].next;
+      return;
+    }
+    link = &timers[*link].next;
+  }
+}
+
+void TimerWheel::run() {
+  startClock();
+  uint32_t now = millis();
+  leftoverMs += now - lastRunMs;
+  lastRunMs = now;
+
+  uint32_t ticks = leftoverMs / TICK_MS;
+  if (ticks == 0) return;
+  leftoverMs -= ticks * TICK_MS;
+  clockTick += ticks;
+
+  if (ticks >= SLOTS) {
+    // Fell a whole revolution behind (e.g. a slow call): visit every slot once
+    currentTick = clockTick;
+    for (uint8_t slot = 0; slot < SLOTS; slot++) fireDue(slot);
+  } else {
+    while (currentTick != clockTick) {
+      currentTick++;
+      fireDue(currentTick & (SLOTS - 1));
+    }
+  }
+}
+
+void TimerWheel::fireDue(uint8_t slot) {
+  // Callbacks may add or cancel timers, so restart the scan after each one
+  while (true) {
+    TimerId id = slots[slot];
+    while (id != TIMER_NONE && !tickReached(timers[id].due, currentTick)) id = timers[id].next;
+    if (id == TIMER_NONE) return;
+
+    unlink(id);
+    Timer& timer = timers[id];
+    TimerCallback callback = timer.callback;
+
+    if (timer.period) {
+      timer.due += timer.period;
+      // Late by more than a period: skip the missed runs instead of bursting
+      if (tickReached(timer.due, clockTick)) timer.due = clockTick + timer.period;
+      link(id);
+    } else {
+      timer.active = false;
+    }
+
+    if (callback) callback();
+  }
+}
+
+uint32_t TimerWheel::msUntilNext() const {
+  uint32_t now = nowTick();
+  uint32_t best = IDLE_MS;
+  for (TimerId i = 0; i < MAX_TIMERS; i++) {
+    if (!timers[i].active) continue;
+    if (tickReached(timers[i].due, now)) return 0;
+    best = min(best, (timers[i].due - now) * TICK_MS);
+  }
+  return best;
+}
@@ -0,0 +1,69 @@
+/*
+ * AERAS - Cooperative timer-wheel scheduler
+ * Named periodic and one-shot tasks driven from loop() instead of delay()
+ * and hand-rolled millis() checks. Timers live in a fixed pool and are
+ * hashed by due tick into a small wheel, so run() only looks at the slots
+ * that came due. Callbacks run on the caller's task; never block in them,
+ * schedule a continuation with after() instead.
+ *
+ * Not thread-safe: use one TimerWheel per FreeRTOS task.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+typedef void (*TimerCallback)();
+typedef int8_t TimerId;
+
+#define TIMER_NONE -1
+
+class TimerWheel {
+ public:
+  static const uint8_t MAX_TIMERS = 16;
+  static const uint8_t SLOTS = 32;       // Power of two
+  static const uint16_t TICK_MS = 10;    // Scheduling resolution
+  static const uint32_t IDLE_MS = 1000;  // msUntilNext() with nothing scheduled
+
+  TimerWheel();
+
+  // Scheduling a name that is already pending replaces that timer.
+  // Returns TIMER_NONE when the pool is full.
+  TimerId every(const char* name, uint32_t periodMs, TimerCallback callback, bool runNow = false);
+  TimerId after(const char* name, uint32_t delayMs, TimerCallback callback);
+
+  bool cancel(const char* name);
+  bool pending(const char* name) const;
+
+  // Fires everything that came due since the last call
+  void run();
+  // How long the caller may sleep before the next timer is due
+  uint32_t msUntilNext() const;
+
+ private:
+  struct Timer {
+    const char* name;
+    TimerCallback callback;
+    uint32_t due;     // Tick
+    uint32_t period;  // Ticks, 0 = one-shot
+    int8_t next;      // Next timer in the same slot
+    bool active;
+  };
+
+  TimerId schedule(const char* name, uint32_t delayMs, uint32_t periodMs, TimerCallback callback);
+  TimerId find(const char* name) const;
+  void startClock();
+  uint32_t nowTick() const;
+  void link(TimerId id);
+  void unlink(TimerId id);
+  void fireDue(uint8_t slot);
+
+  Timer timers[MAX_TIMERS];
+  int8_t slots[SLOTS];
+
+  uint32_t currentTick = 0;  // Every timer due at or before it has fired
+  uint32_t clockTick = 0;    // Tick of the last run()
+  uint32_t lastRunMs = 0;
+  uint32_t leftoverMs = 0;   // Time since lastRunMs not yet counted as a tick
+  bool clockStarted = false;
+};
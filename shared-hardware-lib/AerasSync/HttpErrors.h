@@ -0,0 +1,14 @@
+/*
+ * AERAS - Transport error codes
+ * Negative statuses for a request that got no HTTP answer. Returned by
+ * HttpSession::receive()/request() on the devices and by the fleet
+ * simulator's HttpConnection, so both report failures alike.
+ */
+
+#pragma once
+
+#define HTTP_SESSION_ERR_CONNECT         -1
+#define HTTP_SESSION_ERR_SEND            -2
+#define HTTP_SESSION_ERR_TIMEOUT         -3
+#define HTTP_SESSION_ERR_CONNECTION_LOST -4
+#define HTTP_SESSION_ERR_PROTOCOL        -5
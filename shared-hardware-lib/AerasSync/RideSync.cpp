@@ -0,0 +1,62 @@
+/*
+ * AERAS - Rickshaw sync decisions
+ */
+
+#include "RideSync.h"
+
+#include <Geodesy.h>
+
+// ===== LocationReporter =====
+bool LocationReporter::due(double lat, double lng, bool onRide, uint32_t nowMs) const {
+  uint32_t interval = onRide ? RIDE_INTERVAL_MS : IDLE_INTERVAL_MS;
+  if (nowMs - lastReportMs < interval) return false;
+  return geoVector(reportedLat, reportedLng, lat, lng).meters >= DEADBAND_M;
+}
+
+void LocationReporter::reported(double lat, double lng, uint32_t nowMs) {
+  reportedLat = lat;
+  reportedLng = lng;
+  lastReportMs = nowMs;
+}
+
+// ===== StatusPollPacer =====
+void StatusPollPacer::start(TextWriter& path, long rideID, const char* sinceStatus, uint32_t nowMs) {
+  startedMs = nowMs;
+  path.clear();
+  path.appendf("/ride/%ld/status?since=", rideID)
+      .appendUrlEncoded(sinceStatus)
+      .appendf("&wait=%d", WAIT_S);
+}
+
+uint32_t StatusPollPacer::nextDelay(uint32_t nowMs) const {
+  uint32_t sinceStart = nowMs - startedMs;
+  return sinceStart >= SPACING_MS ? 0 : SPACING_MS - sinceStart;
+}
+
+// ===== JournalReplay =====
+uint8_t JournalReplay::beginBatch(uint8_t pending) {
+  sentCount = pending < BATCH_SIZE ? pending : BATCH_SIZE;
+  answeredCount = 0;
+  return sentCount;
+}
+
+bool JournalReplay::accept(const RideEventResult& result, uint32_t seq) {
+  if (batchAnswered() || result.key != (long)seq) return false;
+  // Not definitive: the event stays journaled and is sent again
+  if (result.status >= 500 || result.status == 409) return false;
+  answeredCount++;
+  return true;
+}
+
+bool JournalReplay::endBatch() {
+  sentCount = 0;
+  if (answeredCount == 0) return false;
+  rush();
+  return true;
+}
+
+uint32_t JournalReplay::nextRetry() {
+  uint32_t delay = retryMs;
+  retryMs = retryMs * 2 < RETRY_MAX_MS ? retryMs * 2 : RETRY_MAX_MS;
+  return delay;
+}
@@ -0,0 +1,79 @@
+/*
+ * AERAS - Rickshaw sync decisions
+ * When a rickshaw reports its position, when it re-polls its ride's
+ * status and how it replays the ride event journal. No I/O and no timers
+ * here: the caller passes the time in and does the sending, so the
+ * firmware's network task and the fleet simulator take the very same
+ * decisions. Times are millis() values (wrap-safe).
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <BackendMessages.h>
+#include <FixedWriter.h>
+
+// Fixes are sampled every second; one is only reported once it left the
+// dead-band around the last reported one, and no more often than the
+// ride/idle interval. A parked rickshaw therefore sends nothing at all.
+class LocationReporter {
+ public:
+  static constexpr float DEADBAND_M = 15.0f;
+  static const uint32_t RIDE_INTERVAL_MS = 3000;
+  static const uint32_t IDLE_INTERVAL_MS = 30000;
+
+  bool due(double lat, double lng, bool onRide, uint32_t nowMs) const;
+  void reported(double lat, double lng, uint32_t nowMs);
+
+ private:
+  double reportedLat = 0;
+  double reportedLng = 0;
+  uint32_t lastReportMs = 0;
+};
+
+// One request is parked on /ride/<id>/status?since=<status>&wait=WAIT_S;
+// the next one leaves SPACING_MS after the previous one started.
+class StatusPollPacer {
+ public:
+  static const int WAIT_S = 20;            // Seconds the backend may hold a poll
+  static const uint32_t SPACING_MS = 500;  // Between two polls of one ride
+  static const uint32_t STUCK_MS = (WAIT_S + 5) * 1000UL;  // No answer by then: give up
+
+  // Writes the path of a poll leaving now
+  void start(TextWriter& path, long rideID, const char* sinceStatus, uint32_t nowMs);
+  uint32_t nextDelay(uint32_t nowMs) const;
+
+ private:
+  uint32_t startedMs = 0;
+};
+
+// Journaled events go out BATCH_SIZE at a time as one /ride/events batch.
+// Each leaves the journal only on a definitive answer (not 5xx or 409);
+// results arrive in journal order, so the first other one ends the batch.
+// Batches that got nothing answered back off exponentially.
+class JournalReplay {
+ public:
+  static const uint8_t BATCH_SIZE = 8;
+  static const uint32_t RETRY_MIN_MS = 1000;
+  static const uint32_t RETRY_MAX_MS = 60000;
+
+  // Next batch out of the pending entries: how many to send
+  uint8_t beginBatch(uint8_t pending);
+  // Result for entry answered() of the batch, sent with sequence number
+  // seq: true when it is definitive (counted as answered)
+  bool accept(const RideEventResult& result, uint32_t seq);
+  bool batchAnswered() const { return answeredCount >= sentCount; }
+  uint8_t answered() const { return answeredCount; }
+  // Reply handled: false when nothing was answered and a retry is due
+  bool endBatch();
+
+  // A fresh command from the puller, or nothing left: no backoff
+  void rush() { retryMs = RETRY_MIN_MS; }
+  // Delay before the next attempt; doubles up to RETRY_MAX_MS
+  uint32_t nextRetry();
+
+ private:
+  uint8_t sentCount = 0;
+  uint8_t answeredCount = 0;
+  uint32_t retryMs = RETRY_MIN_MS;
+};
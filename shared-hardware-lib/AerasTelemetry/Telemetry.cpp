@@ -0,0 +1,261 @@
+/*
+ * AERAS - On-device performance telemetry
+ */
+
+#include "Telemetry.h"
+
+#include <DeviceWire.h>
+#include <FixedWriter.h>
+#include <WiFi.h>
+#include <esp_heap_caps.h>
+
+const uint16_t TELEMETRY_BUCKET_MS[TELEMETRY_BUCKETS - 1] = {
+  25, 50, 100, 200, 400, 800, 1600, 3200, 6400
+};
+
+DeviceTelemetry telemetry;
+
+// Loop figures are written by their own task and cleared by the uploader
+static portMUX_TYPE loopLock = portMUX_INITIALIZER_UNLOCKED;
+
+DeviceTelemetry::DeviceTelemetry() {
+  memset(loops, 0, sizeof(loops));
+  memset(passStartUs, 0, sizeof(passStartUs));
+  memset(wakeDueUs, 0, sizeof(wakeDueUs));
+}
+
+// ===== Endpoints =====
+// "GET /ride/42/status?since=PENDING&wait=20" -> "GET /ride/:id/status (wait)"
+static void endpointName(const char* method, const char* path, TextWriter& name) {
+  name.append(method).append(' ');
+  const char* c = path;
+  while (*c && *c != '?') {
+    const char* segmentEnd = c + 1;
+    while (*segmentEnd && *segmentEnd != '/' && *segmentEnd != '?') segmentEnd++;
+
+    bool numeric = segmentEnd > c + 1;
+    for (const char* d = c + 1; d < segmentEnd; d++) numeric = numeric && isdigit((unsigned char)*d);
+    if (numeric) {
+      name.append("/:id");
+    } else {
+      for (const char* d = c; d < segmentEnd; d++) name.append(*d);
+    }
+    c = segmentEnd;
+  }
+  if (*c == '?' && (strstr(c, "?wait=") || strstr(c, "&wait="))) name.append(" (wait)");
+}
+
+uint8_t DeviceTelemetry::onSend(const char* method, const char* path) {
+  TextBuffer<TELEMETRY_ENDPOINT_LENGTH> name;
+  endpointName(method, path, name);
+
+  for (uint8_t i = 0; i < endpointCount; i++) {
+    if (strcmp(endpoints[i].name, name.c_str()) == 0) return i + 1;
+  }
+  if (endpointCount == TELEMETRY_MAX_ENDPOINTS) return 0;  // Table full: not tracked
+
+  EndpointStats& endpoint = endpoints[endpointCount];
+  memset(&endpoint, 0, sizeof(endpoint));
+  copyText(endpoint.name, name.c_str());
+  return ++endpointCount;
+}
+
+uint8_t DeviceTelemetry::bucketOf(uint32_t latencyMs) {
+  uint8_t bucket = 0;
+  while (bucket < TELEMETRY_BUCKETS - 1 && latencyMs > TELEMETRY_BUCKET_MS[bucket]) bucket++;
+  return bucket;
+}
+
+void DeviceTelemetry::onAnswer(uint8_t tag, uint32_t latencyMs, int status) {
+  if (tag == 0 || tag > endpointCount) return;
+  EndpointStats& endpoint = endpoints[tag - 1];
+
+  if (status < 0) {
+    if (endpoint.failures < UINT16_MAX) endpoint.failures++;
+    return;
+  }
+  uint16_t& bucket = endpoint.buckets[bucketOf(latencyMs)];
+  if (bucket < UINT16_MAX) bucket++;
+  endpoint.maxMs = max(endpoint.maxMs, (uint16_t)min(latencyMs, (uint32_t)UINT16_MAX));
+}
+
+static uint32_t answersOf(const EndpointStats& endpoint) {
+  uint32_t answers = 0;
+  for (uint16_t count : endpoint.buckets) answers += count;
+  return answers;
+}
+
+static bool usedInWindow(const EndpointStats& endpoint) {
+  return endpoint.failures > 0 || answersOf(endpoint) > 0;
+}
+
+uint16_t DeviceTelemetry::percentileMs(const EndpointStats& endpoint, float share) {
+  uint32_t answers = answersOf(endpoint);
+
+  uint32_t seen = 0;
+  for (uint8_t i = 0; i < TELEMETRY_BUCKETS - 1; i++) {
+    seen += endpoint.buckets[i];
+    if (seen >= share * answers) return TELEMETRY_BUCKET_MS[i];
+  }
+  return 0;
+}
+
+// ===== Loops =====
+void DeviceTelemetry::loopBegin(TelemetryLoop loop) {
+  uint32_t now = micros();
+  portENTER_CRITICAL(&loopLock);
+  passStartUs[loop] = now;
+  if (wakeDueUs[loop] != 0) {
+    // Woken early (task notification) counts as on time
+    int32_t late = (int32_t)(now - wakeDueUs[loop]);
+    uint32_t lateUs = late > 0 ? late : 0;
+    loops[loop].lateMaxUs = max(loops[loop].lateMaxUs, lateUs);
+    loops[loop].lateTotalUs += lateUs;
+    wakeDueUs[loop] = 0;
+  }
+  portEXIT_CRITICAL(&loopLock);
+}
+
+void DeviceTelemetry::loopEnd(TelemetryLoop loop, uint32_t sleepMs) {
+  uint32_t now = micros();
+  portENTER_CRITICAL(&loopLock);
+  uint32_t busyUs = now - passStartUs[loop];
+  loops[loop].passes++;
+  loops[loop].busyMaxUs = max(loops[loop].busyMaxUs, busyUs);
+  loops[loop].busyTotalUs += busyUs;
+  wakeDueUs[loop] = (now + sleepMs * 1000UL) | 1;  // Never 0
+  portEXIT_CRITICAL(&loopLock);
+}
+
+void DeviceTelemetry::snapshotLoops(LoopStats (&target)[TELEMETRY_LOOPS]) const {
+  portENTER_CRITICAL(&loopLock);
+  memcpy(target, loops, sizeof(loops));
+  portEXIT_CRITICAL(&loopLock);
+}
+
+// ===== Heap and Wi-Fi =====
+void DeviceTelemetry::sample() {
+  freeHeap = ESP.getFreeHeap();
+  minFreeHeap = ESP.getMinFreeHeap();  // Kept by the allocator since boot
+  minLargestBlock = min(minLargestBlock, (uint32_t)heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
+
+  bool connected = WiFi.status() == WL_CONNECTED;
+  if (connected) {
+    rssi = WiFi.RSSI();
+    if (minRssi == 0 || rssi < minRssi) minRssi = rssi;
+    if (!wifiWasConnected && wifiEverConnected) wifiReconnects++;
+    wifiEverConnected = true;
+  }
+  wifiWasConnected = connected;
+}
+
+void DeviceTelemetry::clearWindow() {
+  for (uint8_t i = 0; i < endpointCount; i++) {
+    memset(endpoints[i].buckets, 0, sizeof(endpoints[i].buckets));
+    endpoints[i].failures = 0;
+    endpoints[i].maxMs = 0;
+  }
+  portENTER_CRITICAL(&loopLock);
+  memset(loops, 0, sizeof(loops));
+  portEXIT_CRITICAL(&loopLock);
+  minRssi = 0;
+  windowStart = millis();
+}
+
+// ===== Reports =====
+static uint32_t averageUs(uint64_t totalUs, uint32_t passes) {
+  return passes ? (uint32_t)(totalUs / passes) : 0;
+}
+
+static void formatBound(char* text, size_t size, uint16_t boundMs) {
+  if (boundMs) snprintf(text, size, "<=%u", boundMs);
+  else snprintf(text, size, ">%u", TELEMETRY_BUCKET_MS[TELEMETRY_BUCKETS - 2]);
+}
+
+void DeviceTelemetry::printTo(Print& out) const {
+  static const char* const LOOP_NAMES[TELEMETRY_LOOPS] = {"main", "net"};
+
+  out.printf("Uptime: %lu s, window %lu s\n", millis() / 1000, (millis() - windowStart) / 1000);
+
+  LoopStats snapshot[TELEMETRY_LOOPS];
+  snapshotLoops(snapshot);
+  for (uint8_t i = 0; i < TELEMETRY_LOOPS; i++) {
+    const LoopStats& loop = snapshot[i];
+    if (loop.passes == 0) continue;
+    out.printf("Loop %-4s %lu passes, busy avg %lu / max %lu us, late avg %lu / max %lu us\n",
+               LOOP_NAMES[i], (unsigned long)loop.passes,
+               (unsigned long)averageUs(loop.busyTotalUs, loop.passes), (unsigned long)loop.busyMaxUs,
+               (unsigned long)averageUs(loop.lateTotalUs, loop.passes), (unsigned long)loop.lateMaxUs);
+  }
+
+  out.printf("Heap: %lu free, low %lu, largest block low %lu\n", (unsigned long)freeHeap,
+             (unsigned long)minFreeHeap, (unsigned long)(minLargestBlock == UINT32_MAX ? 0 : minLargestBlock));
+  out.printf("WiFi: %d dBm (window low %d), %u reconnects\n", rssi, minRssi, wifiReconnects);
+
+  for (uint8_t i = 0; i < endpointCount; i++) {
+    const EndpointStats& endpoint = endpoints[i];
+    if (!usedInWindow(endpoint)) continue;
+
+    // Bucket bounds; ">6400" once a percentile is in the open bucket
+    char p50[8] = "-";
+    char p99[8] = "-";
+    if (answersOf(endpoint) > 0) {
+      formatBound(p50, sizeof(p50), percentileMs(endpoint, 0.50f));
+      formatBound(p99, sizeof(p99), percentileMs(endpoint, 0.99f));
+    }
+
+    out.printf("  %-31s %5lu ok %4u failed  p50 %s p99 %s max %u ms\n", endpoint.name,
+               (unsigned long)answersOf(endpoint), endpoint.failures, p50, p99, endpoint.maxMs);
+  }
+}
+
+bool DeviceTelemetry::encode(MsgPackWriter& out, char idTag, const char* deviceID) const {
+  uint8_t active = 0;
+  for (uint8_t i = 0; i < endpointCount; i++) {
+    if (usedInWindow(endpoints[i])) active++;
+  }
+
+  LoopStats snapshot[TELEMETRY_LOOPS];
+  snapshotLoops(snapshot);
+
+  out.clear();
+  out.beginMap(7)
+     .key(idTag).str(deviceID)
+     .key(WIRE_UPTIME).uint32(millis() / 1000)
+     .key(WIRE_WINDOW).uint32((millis() - windowStart) / 1000);
+
+  // l: [[passes, busy avg, busy max, late avg, late max], ...] in us, by TelemetryLoop
+  out.key(WIRE_LOOPS).beginArray(TELEMETRY_LOOPS);
+  for (const LoopStats& loop : snapshot) {
+    out.beginArray(5)
+       .uint32(loop.passes)
+       .uint32(averageUs(loop.busyTotalUs, loop.passes))
+       .uint32(loop.busyMaxUs)
+       .uint32(averageUs(loop.lateTotalUs, loop.passes))
+       .uint32(loop.lateMaxUs);
+  }
+
+  // h: [free, low watermark, largest free block low watermark]
+  out.key(WIRE_HEAP).beginArray(3)
+     .uint32(freeHeap)
+     .uint32(minFreeHeap)
+     .uint32(minLargestBlock == UINT32_MAX ? 0 : minLargestBlock);
+
+  // q: [rssi, window low, reconnects]
+  out.key(WIRE_WIFI).beginArray(3)
+     .int32(rssi)
+     .int32(minRssi)
+     .uint32(wifiReconnects);
+
+  // a: [[name, [buckets...], failures, max ms], ...] - endpoints used this window
+  out.key(WIRE_ENDPOINTS).beginArray(active);
+  for (uint8_t i = 0; i < endpointCount; i++) {
+    const EndpointStats& endpoint = endpoints[i];
+    if (!usedInWindow(endpoint)) continue;
+
+    out.beginArray(4).str(endpoint.name).beginArray(TELEMETRY_BUCKETS);
+    for (uint16_t count : endpoint.buckets) out.uint32(count);
+    out.uint32(endpoint.failures).uint32(endpoint.maxMs);
+  }
+  return !out.overflowed();
+}
@@ -0,0 +1,105 @@
+/*
+ * AERAS - On-device performance telemetry
+ * Fixed-size, allocation-free counters for field diagnosis:
+ *   - a latency histogram per backend endpoint, fed by HttpSession as its
+ *     HttpObserver (time from the request being written to the response
+ *     head; failures counted apart)
+ *   - per task loop: busy time of a pass and how late it woke up against
+ *     the sleep it asked for (jitter)
+ *   - free heap / largest free block low watermarks
+ *   - Wi-Fi RSSI and reconnects
+ * Histograms and loop figures cover the current window, i.e. since the
+ * last clearWindow() (a successful upload); watermarks and reconnects
+ * cover the whole uptime. printTo() backs the STATUS serial command,
+ * encode() the low-rate upload to /rickshaw/telemetry or
+ * /kiosk/telemetry.
+ *
+ * Endpoints are only touched by the task that owns the HTTP sessions
+ * (on the rickshaw, the network task); loop figures may come from any
+ * task and are guarded.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <HttpSession.h>
+#include <MsgPack.h>
+
+#define TELEMETRY_MAX_ENDPOINTS    12
+#define TELEMETRY_ENDPOINT_LENGTH  32
+#define TELEMETRY_BUCKETS          10
+
+// Upper bounds (ms) of all but the last, open-ended latency bucket. The
+// backend merges fleet histograms with the same bounds
+// (aeras-backend/lib/telemetry.js) - keep them in step.
+extern const uint16_t TELEMETRY_BUCKET_MS[TELEMETRY_BUCKETS - 1];
+
+enum TelemetryLoop : uint8_t {
+  LOOP_MAIN,  // loop(): UI / sensors
+  LOOP_NET,   // Rickshaw network task
+  TELEMETRY_LOOPS
+};
+
+struct EndpointStats {
+  char name[TELEMETRY_ENDPOINT_LENGTH];  // e.g. "GET /ride/:id/status"
+  uint16_t buckets[TELEMETRY_BUCKETS];   // Answers by latency, saturating
+  uint16_t failures;                     // No answer: connect/send/timeout/protocol
+  uint16_t maxMs;
+};
+
+struct LoopStats {
+  uint32_t passes;
+  uint32_t busyMaxUs;
+  uint64_t busyTotalUs;
+  uint32_t lateMaxUs;   // Woke up this long after the requested sleep
+  uint64_t lateTotalUs;
+};
+
+class DeviceTelemetry : public HttpObserver {
+ public:
+  DeviceTelemetry();
+
+  // HttpObserver: paths are grouped with the query dropped and numeric
+  // segments as ":id"; long-polls (wait=) get an endpoint of their own
+  uint8_t onSend(const char* method, const char* path) override;
+  void onAnswer(uint8_t tag, uint32_t latencyMs, int status) override;
+
+  // Around one pass of a task loop: its jobs, then the sleep until the next
+  void loopBegin(TelemetryLoop loop);
+  void loopEnd(TelemetryLoop loop, uint32_t sleepMs);
+
+  // Heap and Wi-Fi; call about once a second
+  void sample();
+
+  void printTo(Print& out) const;
+  // {r|b: deviceID, u, w, l, h, q, a} - idTag is WIRE_RICKSHAW or WIRE_BLOCK
+  bool encode(MsgPackWriter& out, char idTag, const char* deviceID) const;
+  void clearWindow();
+
+ private:
+  static uint8_t bucketOf(uint32_t latencyMs);
+  // Upper bound of the bucket holding that share of the answers; 0 for
+  // the open-ended last bucket
+  static uint16_t percentileMs(const EndpointStats& endpoint, float share);
+  void snapshotLoops(LoopStats (&target)[TELEMETRY_LOOPS]) const;
+
+  EndpointStats endpoints[TELEMETRY_MAX_ENDPOINTS];
+  uint8_t endpointCount = 0;
+  unsigned long windowStart = 0;
+
+  LoopStats loops[TELEMETRY_LOOPS];
+  uint32_t passStartUs[TELEMETRY_LOOPS];
+  uint32_t wakeDueUs[TELEMETRY_LOOPS];  // 0 = not sleeping
+
+  uint32_t freeHeap = 0;
+  uint32_t minFreeHeap = 0;
+  uint32_t minLargestBlock = UINT32_MAX;
+
+  int8_t rssi = 0;
+  int8_t minRssi = 0;  // Window, while connected
+  bool wifiWasConnected = false;
+  bool wifiEverConnected = false;
+  uint16_t wifiReconnects = 0;
+};
+
+extern DeviceTelemetry telemetry;
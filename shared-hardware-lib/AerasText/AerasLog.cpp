@@ -0,0 +1,18 @@
+/*
+ * AERAS - Allocation-free serial logging
+ */
+
+#include "AerasLog.h"
+
+#include <stdarg.h>
+
+void logLine(const char* format, ...) {
+  char line[AERAS_LOG_LINE_LENGTH];
+
+  va_list args;
+  va_start(args, format);
+  vsnprintf(line, sizeof(line), format, args);
+  va_end(args);
+
+  Serial.println(line);
+}
@@ -0,0 +1,13 @@
+/*
+ * AERAS - Allocation-free serial logging
+ * printf-style lines formatted on the stack instead of "..." + String(x).
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+#define AERAS_LOG_LINE_LENGTH 160
+
+// One line per call (newline appended); longer output is truncated
+void logLine(const char* format, ...) __attribute__((format(printf, 1, 2)));
@@ -0,0 +1,166 @@
+/*
+ * AERAS - Fixed-buffer text, URL and JSON writers
+ */
+
+#include "FixedWriter.h"
+
+#include <stdarg.h>
+
+// ===== TextWriter =====
+TextWriter::TextWriter(char* buffer, size_t capacity) : buffer(buffer), capacity(capacity) {
+  buffer[0] = '\0';
+}
+
+void TextWriter::clear() {
+  used = 0;
+  overflow = false;
+  buffer[0] = '\0';
+}
+
+TextWriter& TextWriter::append(char c) {
+  if (used + 1 < capacity) {
+    buffer[used++] = c;
+    buffer[used] = '\0';
+  } else {
+    overflow = true;
+  }
+  return *this;
+}
+
+TextWriter& TextWriter::append(const char* text) {
+  while (text && *text) append(*text++);
+  return *this;
+}
+
+TextWriter& TextWriter::append(long value) {
+  return appendf("%ld", value);
+}
+
+TextWriter& TextWriter::append(double value, uint8_t decimals) {
+  return appendf("%.*f", decimals, value);
+}
+
+TextWriter& TextWriter::appendf(const char* format, ...) {
+  va_list args;
+  va_start(args, format);
+  int written = vsnprintf(buffer + used, capacity - used, format, args);
+  va_end(args);
+
+  if (written < 0) return *this;
+  if ((size_t)written >= capacity - used) {
+    used = capacity - 1;
+    overflow = true;
+  } else {
+    used += written;
+  }
+  return *this;
+}
+
+TextWriter& TextWriter::appendUrlEncoded(const char* text) {
+  static const char HEX_DIGITS[] = "0123456789ABCDEF";
+  for (; text && *text; text++) {
+    char c = *text;
+    if (isalnum((unsigned char)c) || c == '-' || c == '_' || c == '.' || c == '~') {
+      append(c);
+    } else if (used + 3 < capacity) {
+      append('%');
+      append(HEX_DIGITS[(c >> 4) & 0x0F]);
+      append(HEX_DIGITS[c & 0x0F]);
+    } else {
+      overflow = true;  // Never leave half an escape behind
+    }
+  }
+  return *this;
+}
+
+// ===== JsonWriter =====
+void JsonWriter::clear() {
+  TextWriter::clear();
+  needComma = false;
+}
+
+void JsonWriter::separator(const char* key) {
+  if (needComma) append(',');
+  if (key) {
+    append('"');
+    appendEscaped(key);
+    append("\":");
+  }
+  needComma = true;
+}
+
+void JsonWriter::appendEscaped(const char* text) {
+  for (; text && *text; text++) {
+    char c = *text;
+    if (c == '"' || c == '\\') {
+      append('\\');
+      append(c);
+    } else if ((unsigned char)c < 0x20) {
+      appendf("\\u%04x", c);
+    } else {
+      append(c);
+    }
+  }
+}
+
+JsonWriter& JsonWriter::beginObject(const char* key) {
+  separator(key);
+  append('{');
+  needComma = false;
+  return *this;
+}
+
+JsonWriter& JsonWriter::endObject() {
+  append('}');
+  needComma = true;
+  return *this;
+}
+
+JsonWriter& JsonWriter::beginArray(const char* key) {
+  separator(key);
+  append('[');
+  needComma = false;
+  return *this;
+}
+
+JsonWriter& JsonWriter::endArray() {
+  append(']');
+  needComma = true;
+  return *this;
+}
+
+JsonWriter& JsonWriter::field(const char* key, const char* value) {
+  separator(key);
+  if (!value) {
+    append("null");
+    return *this;
+  }
+  append('"');
+  appendEscaped(value);
+  append('"');
+  return *this;
+}
+
+JsonWriter& JsonWriter::field(const char* key, long value) {
+  separator(key);
+  TextWriter::append(value);
+  return *this;
+}
+
+JsonWriter& JsonWriter::field(const char* key, unsigned long value) {
+  separator(key);
+  appendf("%lu", value);
+  return *this;
+}
+
+JsonWriter& JsonWriter::field(const char* key, bool value) {
+  separator(key);
+  append(value ? "true" : "false");
+  return *this;
+}
+
+JsonWriter& JsonWriter::field(const char* key, double value, uint8_t decimals) {
+  separator(key);
+  TextWriter::append(value, decimals);
+  return *this;
+}
@@ -0,0 +1,83 @@
+/*
+ * AERAS - Fixed-buffer text, URL and JSON writers
+ * Payloads, paths and display lines are built in caller-owned char
+ * buffers instead of Arduino String, so the hot loop never touches the
+ * heap. Writers truncate (and flag overflowed()) rather than allocate.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+class TextWriter {
+ public:
+  TextWriter(char* buffer, size_t capacity);
+
+  TextWriter& append(const char* text);
+  TextWriter& append(char c);
+  TextWriter& append(long value);
+  TextWriter& append(double value, uint8_t decimals);
+  TextWriter& appendf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+  // Query-string safe: everything but [A-Za-z0-9-_.~] is %-escaped
+  TextWriter& appendUrlEncoded(const char* text);
+
+  void clear();
+  const char* c_str() const { return buffer; }
+  size_t length() const { return used; }
+  bool overflowed() const { return overflow; }
+
+ protected:
+  char* buffer;
+  size_t capacity;
+  size_t used = 0;
+  bool overflow = false;
+};
+
+template <size_t N>
+class TextBuffer : public TextWriter {
+ public:
+  TextBuffer() : TextWriter(storage, N) {}
+
+ private:
+  char storage[N];
+};
+
+class JsonWriter : public TextWriter {
+ public:
+  JsonWriter(char* buffer, size_t capacity) : TextWriter(buffer, capacity) {}
+
+  JsonWriter& beginObject(const char* key = nullptr);
+  JsonWriter& endObject();
+  JsonWriter& beginArray(const char* key = nullptr);
+  JsonWriter& endArray();
+
+  JsonWriter& field(const char* key, const char* value);
+  JsonWriter& field(const char* key, int value) { return field(key, (long)value); }
+  JsonWriter& field(const char* key, long value);
+  JsonWriter& field(const char* key, unsigned long value);
+  JsonWriter& field(const char* key, bool value);
+  JsonWriter& field(const char* key, double value, uint8_t decimals);
+
+  void clear();
+
+ private:
+  void separator(const char* key);
+  void appendEscaped(const char* text);
+
+  bool needComma = false;
+};
+
+template <size_t N>
+class JsonBuffer : public JsonWriter {
+ public:
+  JsonBuffer() : JsonWriter(storage, N) {}
+
+ private:
+  char storage[N];
+};
+
+// Bounded strcpy into a fixed char array, always NUL-terminated
+template <size_t N>
+inline void copyText(char (&target)[N], const char* source) {
+  snprintf(target, N, "%s", source ? source : "");
+}
@@ -0,0 +1,135 @@
+/*
+ * AERAS - Wi-Fi connection manager
+ */
+
+#include "WifiLink.h"
+
+#include <Preferences.h>
+#include <WiFi.h>
+#include <AerasLog.h>
+#include <FixedWriter.h>
+
+void WifiLink::begin(const char* networkSsid, const char* networkPassword) {
+  ssid = networkSsid;
+  password = networkPassword;
+
+  // The link is managed here: no reconnects or NVS writes of the core's own
+  WiFi.persistent(false);
+  WiFi.setAutoReconnect(false);
+  WiFi.mode(WIFI_STA);
+
+  apValid = loadAp() && strcmp(ap.ssid, ssid) == 0;
+  attempt();
+}
+
+// ===== Connecting =====
+void WifiLink::attempt() {
+  WiFi.disconnect();
+  attemptStarted = millis();
+  WiFi.config(IPAddress(), IPAddress(), IPAddress());  // DHCP on either path
+
+  if (apValid) {
+    WiFi.begin(ssid, password, ap.channel, ap.bssid);
+    state = LINK_FAST;
+  } else {
+    WiFi.begin(ssid, password);
+    state = LINK_SCAN;
+  }
+}
+
+void WifiLink::onConnected() {
+  bool fast = state == LINK_FAST;
+  state = LINK_UP;
+  backoffMs = BACKOFF_MIN_MS;
+  linksUp++;
+
+  logLine("✓ WiFi up in %lu ms (%s), channel %ld, IP %s", millis() - attemptStarted,
+          fast ? "cached" : "scan", (long)WiFi.channel(), WiFi.localIP().toString().c_str());
+  saveAp();
+}
+
+void WifiLink::run() {
+  bool up = WiFi.status() == WL_CONNECTED;
+  unsigned long now = millis();
+
+  switch (state) {
+    case LINK_IDLE:
+      break;
+
+    case LINK_FAST:
+      if (up) {
+        onConnected();
+      } else if (now - attemptStarted >= FAST_TIMEOUT_MS) {
+        // AP moved, changed channel or DHCP did not answer: full connect
+        logLine("⚠ WiFi cached connect timed out - scanning");
+        apValid = false;
+        attempt();
+      }
+      break;
+
+    case LINK_SCAN:
+      if (up) {
+        onConnected();
+      } else if (now - attemptStarted >= SCAN_TIMEOUT_MS) {
+        logLine("✗ WiFi connect failed - retry in %lu s", (unsigned long)backoffMs / 1000);
+        WiFi.disconnect();
+        retryAt = now + backoffMs;
+        backoffMs = backoffMs * 2 < BACKOFF_MAX_MS ? backoffMs * 2 : BACKOFF_MAX_MS;
+        state = LINK_BACKOFF;
+      }
+      break;
+
+    case LINK_UP:
+      if (!up) {
+        logLine("⚠ WiFi link lost - reconnecting");
+        attempt();
+      }
+      break;
+
+    case LINK_BACKOFF:
+      if ((long)(now - retryAt) >= 0) attempt();
+      break;
+  }
+}
+
+bool WifiLink::waitConnected(uint32_t timeoutMs) {
+  unsigned long started = millis();
+  while (!connected() && millis() - started < timeoutMs) {
+    run();
+    delay(50);
+  }
+  return connected();
+}
+
+// ===== NVS cache =====
+// Units that stored a full lease before have a blob of another size under
+// "lease"; it is left alone and they take the scan path once
+bool WifiLink::loadAp() {
+  Preferences prefs;
+  if (!prefs.begin(WIFI_LINK_NAMESPACE, true)) return false;
+
+  apStored = prefs.getBytesLength("ap") == sizeof(CachedAp) &&
+             prefs.getBytes("ap", &ap, sizeof(CachedAp)) == sizeof(CachedAp);
+  prefs.end();
+  ap.ssid[sizeof(ap.ssid) - 1] = '\0';
+  return apStored && ap.channel != 0;
+}
+
+// Only written when the AP changed, to spare the flash
+void WifiLink::saveAp() {
+  CachedAp current = {};
+  copyText(current.ssid, ssid);
+  memcpy(current.bssid, WiFi.BSSID(), sizeof(current.bssid));
+  current.channel = WiFi.channel();
+
+  apValid = true;
+  if (apStored && memcmp(&current, &ap, sizeof(CachedAp)) == 0) return;
+  ap = current;
+  apStored = false;
+
+  Preferences prefs;
+  if (!prefs.begin(WIFI_LINK_NAMESPACE, false)) return;
+  apStored = prefs.putBytes("ap", &ap, sizeof(CachedAp)) == sizeof(CachedAp);
+  prefs.end();
+  if (!apStored) logLine("✗ WiFi access point not saved to flash");
+}
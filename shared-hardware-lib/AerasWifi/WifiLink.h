@@ -0,0 +1,66 @@
+/*
+ * AERAS - Wi-Fi connection manager
+ * Brings the station link up without blocking and keeps it up:
+ *   - The channel and BSSID of the last connect are kept in NVS. The next
+ *     connect joins that access point directly (no scan), which is what
+ *     gets a unit back online within a second or two of a brownout. The
+ *     address always comes from DHCP: a cached lease may have run out and
+ *     been handed to another device meanwhile.
+ *   - If the fast path does not associate and get an address in time, the
+ *     cache is ignored and a normal scan + DHCP connect follows; every
+ *     connect refreshes the cache.
+ *   - A dropped link is retried in the background with exponential
+ *     backoff. connections() counts links brought up, so callers can redo
+ *     per-link work (registration) once it changes.
+ * begin() only starts associating; run() drives everything and must be
+ * called periodically (from one task only).
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+#define WIFI_LINK_NAMESPACE "aeras-wifi"  // NVS namespace (max 15 chars)
+
+class WifiLink {
+ public:
+  static const uint32_t FAST_TIMEOUT_MS = 3000;   // Cached AP + DHCP
+  static const uint32_t SCAN_TIMEOUT_MS = 15000;  // Scan + DHCP
+  static const uint32_t BACKOFF_MIN_MS = 1000;
+  static const uint32_t BACKOFF_MAX_MS = 60000;
+
+  void begin(const char* ssid, const char* password);
+  // Every 100-250 ms
+  void run();
+  // Runs the link until it is up or timeoutMs passes (boot only)
+  bool waitConnected(uint32_t timeoutMs);
+
+  bool connected() const { return state == LINK_UP; }
+  uint32_t connections() const { return linksUp; }
+
+ private:
+  enum LinkState { LINK_IDLE, LINK_FAST, LINK_SCAN, LINK_UP, LINK_BACKOFF };
+
+  // Access point of the last connect, as stored in NVS
+  struct CachedAp {
+    char ssid[33];
+    uint8_t bssid[6];
+    uint8_t channel;
+  };
+
+  void attempt();
+  void onConnected();
+  bool loadAp();
+  void saveAp();
+
+  const char* ssid = "";
+  const char* password = "";
+  LinkState state = LINK_IDLE;
+  CachedAp ap;
+  bool apValid = false;   // ap is worth a fast connect
+  bool apStored = false;  // ap matches what NVS holds
+  unsigned long attemptStarted = 0;
+  unsigned long retryAt = 0;
+  uint32_t backoffMs = BACKOFF_MIN_MS;
+  uint32_t linksUp = 0;
+};
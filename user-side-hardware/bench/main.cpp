@@ -0,0 +1,84 @@
+/*
+ * AERAS User Side - Host micro-benchmarks
+ * What the kiosk does on every ride-status poll and push event, built for
+ * the host by [env:native]:
+ *
+ *   pio run -e native && .pio/build/native/program
+ */
+
+#include <Arduino.h>
+#include <Bench.h>
+#include <BackendMessages.h>
+#include <DeviceWire.h>
+#include <FixedWriter.h>
+
+// GET /ride/<id>/status and the "ride" push event, as the backend sends them
+static const char RIDE_STATUS_JSON[] =
+    "{\"rideID\":4821,\"status\":\"ACCEPTED\",\"rickshawID\":\"RICK001\","
+    "\"pickupBlock\":\"CUET_CAMPUS\",\"destination\":\"PAHARTOLI\"}";
+static const char BLOCK_STATUS_JSON[] =
+    "{\"status\":\"ACCEPTED\",\"rideID\":4821,\"rickshawID\":\"RICK001\"}";
+
+static void benchRideStatus() {
+  benchHeader("Ride status parsing");
+  RideStatusReply reply;
+
+  BenchStream json(RIDE_STATUS_JSON);
+  bench("parseRideStatus (JSON)", [&] {
+    json.rewind();
+    benchKeep(parseRideStatus(json, reply));
+  });
+
+  MsgPackBuffer<96> wire;
+  wire.beginMap(5)
+      .key(WIRE_RIDE).int32(4821)
+      .key(WIRE_STATUS).str("ACCEPTED")
+      .key(WIRE_RICKSHAW).str("RICK001")
+      .key(WIRE_PICKUP).str("CUET_CAMPUS")
+      .key(WIRE_DESTINATION).str("PAHARTOLI");
+  bench("decodeRideStatus (MessagePack)", [&] {
+    benchKeep(decodeRideStatus(wire.data(), wire.length(), reply));
+  });
+
+  BlockStatusReply block;
+  BenchStream pushed(BLOCK_STATUS_JSON);
+  bench("parseBlockStatus (JSON, push)", [&] {
+    pushed.rewind();
+    benchKeep(parseBlockStatus(pushed, block));
+  });
+}
+
+static void benchPayloads() {
+  benchHeader("Payload serialization");
+
+  JsonBuffer<128> payload;
+  bench("ride request payload (JSON)", [&] {
+    payload.clear();
+    payload.beginObject()
+           .field("blockID", "CUET_CAMPUS")
+           .field("destination", "PAHARTOLI")
+           .field("userID", "USER_5231")
+           .endObject();
+    benchKeep(payload.length());
+  });
+
+  TextBuffer<32> path;
+  bench("ride status path", [&] {
+    path.clear();
+    path.appendf("/ride/%ld/status", 4821L);
+    benchKeep(path.length());
+  });
+
+  TextBuffer<64> query;
+  bench("push path (URL-encoded)", [&] {
+    query.clear();
+    query.append("/events?blockID=").appendUrlEncoded("CUET_CAMPUS");
+    benchKeep(query.length());
+  });
+}
+
+int main() {
+  benchRideStatus();
+  benchPayloads();
+  return 0;
+}
@@ -0,0 +1,169 @@
+/*
+ * AERAS User Side - Buzzer and LED feedback
+ */
+
+#include "Feedback.h"
+
+#include <esp_timer.h>
+
+#define LEDS_BASE 0xFF  // Step keeps the base LEDs
+
+struct FeedbackStep {
+  uint16_t toneHz;  // 0: silent
+  uint16_t ms;
+  uint8_t leds;     // FEEDBACK_LED_* mask, or LEDS_BASE
+};
+
+static const FeedbackStep ONLINE_STEPS[] = {
+  {2000, 100, LEDS_BASE}, {0, 100, LEDS_BASE}, {2000, 100, LEDS_BASE}
+};
+static const FeedbackStep DWELL_DONE_STEPS[] = {
+  {2000, 150, LEDS_BASE}
+};
+static const FeedbackStep VERIFIED_STEPS[] = {
+  {2000, 100, LEDS_BASE}, {0, 100, LEDS_BASE}, {2000, 100, LEDS_BASE}
+};
+static const FeedbackStep REQUEST_SENT_STEPS[] = {
+  {2000, 80, LEDS_BASE}, {0, 100, LEDS_BASE}, {2000, 80, LEDS_BASE}, {0, 100, LEDS_BASE},
+  {2000, 80, LEDS_BASE}
+};
+// Rising pair, yellow blinking along
+static const FeedbackStep ACCEPTED_STEPS[] = {
+  {1500, 100, FEEDBACK_LED_YELLOW}, {0, 100, 0}, {2500, 100, FEEDBACK_LED_YELLOW}
+};
+static const FeedbackStep PICKUP_STEPS[] = {
+  {2500, 100, FEEDBACK_LED_GREEN}, {0, 100, 0}, {2500, 100, FEEDBACK_LED_GREEN}, {0, 100, 0},
+  {2500, 100, FEEDBACK_LED_GREEN}
+};
+static const FeedbackStep COMPLETED_STEPS[] = {
+  {2000, 150, LEDS_BASE}, {0, 100, LEDS_BASE}, {2000, 150, LEDS_BASE}
+};
+static const FeedbackStep TIMEOUT_STEPS[] = {
+  {800, 500, FEEDBACK_LED_RED}
+};
+// Low tone, then red blinking on its own
+static const FeedbackStep ERROR_STEPS[] = {
+  {600, 500, FEEDBACK_LED_RED}, {0, 100, 0}, {0, 100, FEEDBACK_LED_RED}, {0, 100, 0},
+  {0, 100, FEEDBACK_LED_RED}
+};
+
+struct PatternSteps {
+  const FeedbackStep* steps;
+  uint8_t count;
+};
+
+#define STEPS(table) {table, sizeof(table) / sizeof(table[0])}
+
+// In FeedbackPattern order
+static const PatternSteps PATTERNS[FEEDBACK_PATTERN_COUNT] = {
+  {nullptr, 0},  // FEEDBACK_NONE
+  STEPS(ONLINE_STEPS),
+  STEPS(DWELL_DONE_STEPS),
+  STEPS(VERIFIED_STEPS),
+  STEPS(REQUEST_SENT_STEPS),
+  STEPS(ACCEPTED_STEPS),
+  STEPS(PICKUP_STEPS),
+  STEPS(COMPLETED_STEPS),
+  STEPS(TIMEOUT_STEPS),
+  STEPS(ERROR_STEPS)
+};
+
+static uint8_t ledPins[3];
+static esp_timer_handle_t stepTimer = nullptr;
+
+// Posted by the calls below, taken by the timer callback
+static portMUX_TYPE requestLock = portMUX_INITIALIZER_UNLOCKED;
+static int requestedPattern = -1;  // -1: none
+static volatile uint8_t baseLeds = 0;
+static volatile bool playing = false;
+
+// Timer callback only
+static const PatternSteps* current = nullptr;
+static uint8_t stepIndex = 0;
+
+static void showLeds(uint8_t leds) {
+  for (uint8_t i = 0; i < 3; i++) digitalWrite(ledPins[i], leds & (1 << i) ? HIGH : LOW);
+}
+
+static void playTone(uint16_t hz) {
+  if (hz) ledcWriteTone(FEEDBACK_LEDC_CHANNEL, hz);
+  else ledcWrite(FEEDBACK_LEDC_CHANNEL, 0);
+}
+
+// Runs in the esp_timer task: applies a posted request, else the next step
+static void onStepTimer(void*) {
+  portENTER_CRITICAL(&requestLock);
+  int pattern = requestedPattern;
+  requestedPattern = -1;
+  portEXIT_CRITICAL(&requestLock);
+
+  if (pattern >= 0) {
+    current = &PATTERNS[pattern];
+    stepIndex = 0;
+  } else if (current) {
+    stepIndex++;
+  }
+
+  if (!current || stepIndex >= current->count) {
+    current = nullptr;
+    playing = false;
+    playTone(0);
+    showLeds(baseLeds);
+    return;
+  }
+
+  const FeedbackStep& step = current->steps[stepIndex];
+  playing = true;
+  playTone(step.toneHz);
+  showLeds(step.leds == LEDS_BASE ? baseLeds : step.leds);
+  esp_timer_start_once(stepTimer, step.ms * 1000ULL);
+}
+
+// Has the callback run now. If it is running already, its own re-arm
+// fails and this immediate run takes over.
+static void kick() {
+  esp_timer_stop(stepTimer);  // Fails harmlessly when not armed
+  esp_timer_start_once(stepTimer, 0);
+}
+
+void startFeedback(uint8_t buzzerPin, uint8_t yellowPin, uint8_t redPin, uint8_t greenPin) {
+  ledPins[0] = yellowPin;
+  ledPins[1] = redPin;
+  ledPins[2] = greenPin;
+  for (uint8_t pin : ledPins) pinMode(pin, OUTPUT);
+  showLeds(0);
+
+  ledcSetup(FEEDBACK_LEDC_CHANNEL, 2000, FEEDBACK_LEDC_RESOLUTION);
+  ledcAttachPin(buzzerPin, FEEDBACK_LEDC_CHANNEL);
+  ledcWrite(FEEDBACK_LEDC_CHANNEL, 0);
+
+  esp_timer_create_args_t args = {};
+  args.callback = onStepTimer;
+  args.dispatch_method = ESP_TIMER_TASK;
+  args.name = "feedback";
+  esp_timer_create(&args, &stepTimer);
+}
+
+void playFeedback(FeedbackPattern pattern) {
+  if (!stepTimer || pattern < 0 || pattern >= FEEDBACK_PATTERN_COUNT) return;
+
+  portENTER_CRITICAL(&requestLock);
+  requestedPattern = pattern;
+  portEXIT_CRITICAL(&requestLock);
+  playing = pattern != FEEDBACK_NONE;
+  kick();
+}
+
+void stopFeedback() {
+  playFeedback(FEEDBACK_NONE);
+}
+
+void setFeedbackLeds(uint8_t leds) {
+  baseLeds = leds;
+  // A playing pattern shows the new base with its next base step, or when it ends
+  if (stepTimer && !playing) kick();
+}
+
+bool feedbackPlaying() {
+  return playing;
+}
@@ -0,0 +1,49 @@
+/*
+ * AERAS User Side - Buzzer and LED feedback
+ * Patterns (tone + LED steps) come from a table and are played by an
+ * esp_timer one-shot, re-armed for each step: tone lengths stay exact
+ * even while the loop is stuck in an HTTP call, and nothing in the loop
+ * waits for them. The buzzer is driven by an LEDC PWM channel, so steps
+ * can have a pitch rather than a plain on/off.
+ * The status LEDs have a base state (setFeedbackLeds); a pattern may
+ * light others for its steps and the base is restored when it ends.
+ * Only the timer callback touches the pins; the calls below just post a
+ * request to it, so they are safe from any task.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+#define FEEDBACK_LEDC_CHANNEL     0
+#define FEEDBACK_LEDC_RESOLUTION  10  // Bits; tones are played at 50% duty
+
+// Status LEDs, as bits of a mask
+#define FEEDBACK_LED_YELLOW  0x01
+#define FEEDBACK_LED_RED     0x02
+#define FEEDBACK_LED_GREEN   0x04
+
+enum FeedbackPattern {
+  FEEDBACK_NONE,           // Silence; back to the base LEDs
+  FEEDBACK_ONLINE,         // WiFi up at boot
+  FEEDBACK_DWELL_DONE,     // Stood long enough
+  FEEDBACK_VERIFIED,       // Laser card seen
+  FEEDBACK_REQUEST_SENT,
+  FEEDBACK_ACCEPTED,
+  FEEDBACK_PICKUP,
+  FEEDBACK_COMPLETED,
+  FEEDBACK_TIMEOUT,
+  FEEDBACK_ERROR,
+  FEEDBACK_PATTERN_COUNT
+};
+
+void startFeedback(uint8_t buzzerPin, uint8_t yellowPin, uint8_t redPin, uint8_t greenPin);
+
+// Replaces whatever pattern is still playing
+void playFeedback(FeedbackPattern pattern);
+// Cancels the pattern playing (on a state change that makes it stale)
+void stopFeedback();
+// LEDs lit while no pattern overrides them; applied at once when idle
+void setFeedbackLeds(uint8_t leds);
+
+bool feedbackPlaying();
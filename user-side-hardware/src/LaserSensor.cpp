@@ -0,0 +1,175 @@
+/*
+ * AERAS User Side - Laser card detection on the LDR
+ */
+
+#include "LaserSensor.h"
+
+#include <driver/adc.h>
+#include <driver/i2s.h>
+
+#define FRAME_SAMPLES      (LASER_SAMPLE_RATE * LASER_FRAME_MS / 1000)
+#define DMA_BUFFERS        4
+#define DMA_STALL_FRAMES   5   // Empty reads before falling back to analogRead()
+#define ONESHOT_SAMPLES    4   // analogRead()s averaged into a fallback frame
+#define ADC_FULL_SCALE     4095.0f
+
+static const float BASELINE_ALPHA = (float)LASER_FRAME_MS / LASER_BASELINE_MS;
+
+static uint8_t pin = 0;
+static bool dmaRunning = false;
+static uint16_t samples[FRAME_SAMPLES];  // Laser task only
+
+// Laser task only
+static float baseline = -1;  // < 0: no frame yet
+static float noise = 0;      // Mean deviation from the baseline
+static uint32_t offFrames = 0;   // Frames since the level left the baseline
+static uint32_t overFrames = 0;  // Frames over the threshold, in a row
+static bool risenFast = false;
+static bool counted = false;     // This pulse was reported already
+
+// Published by the laser task, taken by pollLaser()
+static portMUX_TYPE readingLock = portMUX_INITIALIZER_UNLOCKED;
+static LaserReading published = {};
+static uint32_t cardsSeen = 0;
+
+// Loop task only
+static uint32_t cardsTaken = 0;
+
+static bool startDma(adc1_channel_t channel) {
+  i2s_config_t config = {};
+  config.mode = (i2s_mode_t)(I2S_MODE_MASTER | I2S_MODE_RX | I2S_MODE_ADC_BUILT_IN);
+  config.sample_rate = LASER_SAMPLE_RATE;
+  config.bits_per_sample = I2S_BITS_PER_SAMPLE_16BIT;
+  config.channel_format = I2S_CHANNEL_FMT_ONLY_LEFT;
+  config.communication_format = I2S_COMM_FORMAT_STAND_I2S;
+  config.dma_buf_count = DMA_BUFFERS;
+  config.dma_buf_len = FRAME_SAMPLES;
+
+  if (i2s_driver_install(I2S_NUM_0, &config, 0, nullptr) != ESP_OK) return false;
+  if (i2s_set_adc_mode(ADC_UNIT_1, channel) != ESP_OK || i2s_adc_enable(I2S_NUM_0) != ESP_OK) {
+    i2s_driver_uninstall(I2S_NUM_0);
+    return false;
+  }
+  return true;
+}
+
+static void stopDma() {
+  i2s_adc_disable(I2S_NUM_0);
+  i2s_driver_uninstall(I2S_NUM_0);
+  dmaRunning = false;
+  Serial.println("⚠ LDR DMA delivers nothing - sampling with analogRead()");
+}
+
+// Next averaged frame; false when DMA had nothing this time
+static bool readFrame(uint16_t& level) {
+  if (!dmaRunning) {
+    vTaskDelay(pdMS_TO_TICKS(LASER_FRAME_MS));
+    uint32_t sum = 0;
+    for (uint8_t i = 0; i < ONESHOT_SAMPLES; i++) sum += analogRead(pin);
+    level = sum / ONESHOT_SAMPLES;
+    return true;
+  }
+
+  static uint8_t emptyReads = 0;
+  size_t bytes = 0;
+  i2s_read(I2S_NUM_0, samples, sizeof(samples), &bytes, pdMS_TO_TICKS(LASER_FRAME_MS * 4));
+  size_t count = bytes / sizeof(samples[0]);
+  if (count == 0) {
+    if (++emptyReads >= DMA_STALL_FRAMES) stopDma();
+    return false;
+  }
+  emptyReads = 0;
+
+  uint32_t sum = 0;
+  for (size_t i = 0; i < count; i++) sum += samples[i] & 0x0FFF;  // Top bits: channel
+  level = sum / count;
+  return true;
+}
+
+static void detect(uint16_t level) {
+  if (baseline < 0) baseline = level;
+  float margin = max((float)LASER_MARGIN_MIN, LASER_MARGIN_NOISE * noise);
+  float threshold = min(baseline + margin, ADC_FULL_SCALE);
+
+  if (level < baseline - margin) {
+    // Much darker (a shadow, a relearned laser gone): start over from here
+    baseline = level;
+    offFrames = 0;
+  } else if (level < baseline + margin / 2) {
+    offFrames = 0;
+    baseline += (level - baseline) * BASELINE_ALPHA;
+    noise += (fabsf(level - baseline) - noise) * BASELINE_ALPHA;
+  } else if (++offFrames * LASER_FRAME_MS >= LASER_RELEARN_MS) {
+    baseline = level;
+    noise = 0;
+    offFrames = 0;
+  }
+
+  bool seen = false;
+  if (level >= threshold) {
+    if (overFrames == 0) risenFast = offFrames * LASER_FRAME_MS <= LASER_RISE_MS;
+    overFrames++;
+    if (!counted && risenFast && overFrames * LASER_FRAME_MS >= LASER_HOLD_MS) {
+      counted = true;
+      seen = true;
+    }
+  } else {
+    overFrames = 0;
+    counted = false;
+  }
+
+  portENTER_CRITICAL(&readingLock);
+  published.level = level;
+  published.baseline = baseline;
+  published.threshold = threshold;
+  published.dma = dmaRunning;
+  if (seen) cardsSeen++;
+  portEXIT_CRITICAL(&readingLock);
+}
+
+static void laserTask(void*) {
+  while (true) {
+    uint16_t level;
+    if (readFrame(level)) detect(level);
+  }
+}
+
+void startLaserSensor(uint8_t ldrPin) {
+  pin = ldrPin;
+  pinMode(pin, INPUT);
+
+  // I2S samples ADC1 only (GPIO 32-39)
+  int8_t channel = digitalPinToAnalogChannel(pin);
+  if (channel >= 0 && channel < ADC1_CHANNEL_MAX) {
+    adc1_config_width(ADC_WIDTH_BIT_12);
+    adc1_config_channel_atten((adc1_channel_t)channel, ADC_ATTEN_DB_11);
+    dmaRunning = startDma((adc1_channel_t)channel);
+  }
+  if (!dmaRunning) Serial.println("⚠ LDR DMA unavailable - sampling with analogRead()");
+
+  xTaskCreatePinnedToCore(laserTask, "aeras-laser", LASER_TASK_STACK_SIZE, nullptr,
+                          LASER_TASK_PRIORITY, nullptr, LASER_TASK_CORE);
+}
+
+void readLaser(LaserReading& reading) {
+  portENTER_CRITICAL(&readingLock);
+  reading = published;
+  portEXIT_CRITICAL(&readingLock);
+}
+
+bool pollLaser(LaserReading& reading) {
+  portENTER_CRITICAL(&readingLock);
+  reading = published;
+  uint32_t seen = cardsSeen;
+  portEXIT_CRITICAL(&readingLock);
+
+  if (seen == cardsTaken) return false;
+  cardsTaken = seen;
+  return true;
+}
+
+void resetLaser() {
+  portENTER_CRITICAL(&readingLock);
+  cardsTaken = cardsSeen;
+  portEXIT_CRITICAL(&readingLock);
+}
@@ -0,0 +1,54 @@
+/*
+ * AERAS User Side - Laser card detection on the LDR
+ * The LDR is sampled continuously by the ADC into DMA buffers (I2S0 in
+ * built-in ADC mode), so the loop never calls analogRead(). A task on
+ * core 0 averages each buffer into one frame and runs the detector:
+ *  - a slow rolling baseline follows the ambient light (sun, dusk,
+ *    clouds), and the frame-to-frame noise around it;
+ *  - the threshold sits LASER_MARGIN_NOISE noise widths, and at least
+ *    LASER_MARGIN_MIN counts, above the baseline instead of at a fixed
+ *    3000;
+ *  - a card is a pulse: the level leaves the baseline, is over the
+ *    threshold within LASER_RISE_MS and stays there LASER_HOLD_MS. Slow
+ *    drifts are taken up by the baseline, blips end before the hold.
+ * The baseline holds still while the level is off it, so a laser never
+ * raises its own threshold; a level that stays off it for
+ * LASER_RELEARN_MS (lights switched on) becomes the new baseline.
+ * Where DMA delivers nothing (ADC2 pins, the simulator) the task samples
+ * with analogRead() at the same frame rate instead.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+#define LASER_SAMPLE_RATE   8000  // Hz, conversions into the DMA buffers
+#define LASER_FRAME_MS      20    // One averaged frame per DMA buffer
+#define LASER_BASELINE_MS   3000  // Time constant of the ambient baseline
+#define LASER_RELEARN_MS    5000
+#define LASER_MARGIN_MIN    250   // ADC counts (0-4095)
+#define LASER_MARGIN_NOISE  6
+#define LASER_RISE_MS       200
+#define LASER_HOLD_MS       120
+
+#define LASER_TASK_CORE       0
+#define LASER_TASK_STACK_SIZE 3072
+#define LASER_TASK_PRIORITY   1
+
+struct LaserReading {
+  uint16_t level;      // Last frame
+  uint16_t baseline;
+  uint16_t threshold;
+  bool dma;            // false: sampled by analogRead()
+};
+
+void startLaserSensor(uint8_t ldrPin);
+
+// True once for each card seen since the last call or resetLaser();
+// reading gets the detector's current state either way
+bool pollLaser(LaserReading& reading);
+// The current state only; a card seen stays for pollLaser()
+void readLaser(LaserReading& reading);
+
+// Forgets cards seen so far, so only one shown from now on counts
+void resetLaser();
@@ -0,0 +1,120 @@
+/*
+ * AERAS User Side - Ultrasonic presence sensing
+ */
+
+#include "UltrasonicPresence.h"
+
+static uint8_t trigger = 0;
+static uint8_t echo = 0;
+static uint16_t enterDistance = 0;
+static uint16_t exitDistance = 0;
+
+// Written by the echo interrupt
+static volatile uint32_t echoRiseUs = 0;
+static volatile uint32_t echoWidthUs = 0;
+static volatile bool echoDone = false;
+
+static uint32_t triggeredAt = 0;
+static bool awaitingEcho = false;
+
+static uint16_t readings[RANGE_WINDOW];
+static uint8_t readingCount = 0;
+static uint8_t readingHead = 0;
+static bool present = false;
+
+static void IRAM_ATTR onEchoEdge() {
+  uint32_t now = micros();
+  if (digitalRead(echo) == HIGH) {
+    echoRiseUs = now;
+  } else if (echoRiseUs != 0) {
+    echoWidthUs = now - echoRiseUs;
+    echoDone = true;
+  }
+}
+
+static void fireTrigger() {
+  echoRiseUs = 0;
+  echoDone = false;
+  digitalWrite(trigger, HIGH);
+  delayMicroseconds(10);
+  digitalWrite(trigger, LOW);
+  triggeredAt = millis();
+  awaitingEcho = true;
+}
+
+static void addReading(uint16_t cm) {
+  readings[readingHead] = cm;
+  readingHead = (readingHead + 1) % RANGE_WINDOW;
+  if (readingCount < RANGE_WINDOW) readingCount++;
+}
+
+// Collects a finished (or timed-out) echo; true when a reading was added
+static bool collectEcho() {
+  if (!awaitingEcho) return false;
+
+  if (echoDone) {
+    uint32_t width = echoWidthUs;
+    // Sound travels ~0.034 cm/us, there and back
+    addReading(width > ECHO_MAX_US ? RANGE_NONE : (uint16_t)(width * 0.034f / 2));
+  } else if (millis() - triggeredAt >= ECHO_TIMEOUT_MS) {
+    addReading(RANGE_NONE);
+  } else {
+    return false;
+  }
+  awaitingEcho = false;
+  return true;
+}
+
+static uint16_t medianReading() {
+  uint16_t sorted[RANGE_WINDOW];
+  memcpy(sorted, readings, sizeof(sorted));
+  for (uint8_t i = 1; i < RANGE_WINDOW; i++) {
+    uint16_t value = sorted[i];
+    uint8_t j = i;
+    for (; j > 0 && sorted[j - 1] > value; j--) sorted[j] = sorted[j - 1];
+    sorted[j] = value;
+  }
+  return sorted[RANGE_WINDOW / 2];
+}
+
+void startRanging(uint8_t trigPin, uint8_t echoPin, uint16_t enterCm, uint16_t exitCm) {
+  trigger = trigPin;
+  echo = echoPin;
+  enterDistance = enterCm;
+  exitDistance = exitCm;
+
+  pinMode(trigger, OUTPUT);
+  digitalWrite(trigger, LOW);
+  pinMode(echo, INPUT);
+  attachInterrupt(digitalPinToInterrupt(echo), onEchoEdge, CHANGE);
+  resetPresence();
+}
+
+PresenceEvent pollPresence(uint16_t& distanceCm) {
+  bool added = collectEcho();
+  if (!awaitingEcho && millis() - triggeredAt >= RANGE_PERIOD_MS) fireTrigger();
+
+  distanceCm = readingCount == RANGE_WINDOW ? medianReading() : RANGE_NONE;
+  if (!added || readingCount < RANGE_WINDOW) return PRESENCE_NONE;
+
+  if (!present && distanceCm <= enterDistance) {
+    present = true;
+    return PRESENCE_ARRIVED;
+  }
+  if (present && distanceCm > exitDistance) {
+    present = false;
+    return PRESENCE_LEFT;
+  }
+  return PRESENCE_NONE;
+}
+
+void resetPresence() {
+  // An echo still pending (or finished) from before is stale; the next
+  // poll fires a fresh trigger
+  awaitingEcho = false;
+  echoDone = false;
+  echoRiseUs = 0;
+  readingCount = 0;
+  readingHead = 0;
+  present = false;
+}
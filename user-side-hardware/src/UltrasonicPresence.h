@@ -0,0 +1,35 @@
+/*
+ * AERAS User Side - Ultrasonic presence sensing
+ * The HC-SR04 echo pulse is timed by a GPIO interrupt on both edges, so a
+ * reading never busy-waits the loop the way pulseIn() did. Each poll
+ * collects the previous echo and fires the next trigger. The last
+ * RANGE_WINDOW readings are median-filtered, and presence has hysteresis
+ * (enter at or below enterCm, leave above exitCm), so one stray or lost
+ * echo cannot end a 3-second dwell.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+#define RANGE_WINDOW       5      // Readings in the median (odd)
+#define RANGE_PERIOD_MS    50     // Minimum gap between triggers
+#define ECHO_TIMEOUT_MS    40     // HC-SR04 holds echo ~38 ms with nothing in range
+#define ECHO_MAX_US        30000  // Longer echoes count as "nothing in range"
+#define RANGE_NONE         0xFFFF // Median with no echo
+
+enum PresenceEvent {
+  PRESENCE_NONE,     // No change
+  PRESENCE_ARRIVED,
+  PRESENCE_LEFT
+};
+
+void startRanging(uint8_t trigPin, uint8_t echoPin, uint16_t enterCm, uint16_t exitCm);
+
+// Call every RANGE_PERIOD_MS or so. distanceCm gets the filtered distance
+// (RANGE_NONE without an echo, or before the window has filled).
+PresenceEvent pollPresence(uint16_t& distanceCm);
+
+// Forget readings and presence, so someone still standing there is
+// reported as a fresh arrival
+void resetPresence();
@@ -8,13 +8,26 @@
 #include <Adafruit_GFX.h>
 #include <Adafruit_SSD1306.h>
 #include <WiFi.h>
-#include <HTTPClient.h>
+#include <HttpSession.h>
+#include <EventStream.h>
+#include <BackendMessages.h>
+#include <DeviceWire.h>
+#include <FixedWriter.h>
+#include <AerasLog.h>
+#include <TimerWheel.h>
+#include <OledScreen.h>
+#include <Telemetry.h>
+#include <WifiLink.h>
+#include "UltrasonicPresence.h"
+#include "LaserSensor.h"
+#include "Feedback.h"
 
 // ===== PIN DEFINITIONS =====
 #define TRIG_PIN 5
 #define ECHO_PIN 18
 #define LDR_PIN 34
 #define BUTTON_PIN 25
+#define BUTTON2_PIN 26  // Second destination; pulled down, so it may stay unwired
 #define LED_YELLOW 2
 #define LED_RED 4
 #define LED_GREEN 15
@@ -24,16 +37,36 @@
 #define SCREEN_WIDTH 128
 #define SCREEN_HEIGHT 64
 #define OLED_RESET -1
-Adafruit_SSD1306 display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, OLED_RESET);
+Adafruit_SSD1306 display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, OLED_RESET, OLED_I2C_CLOCK, OLED_I2C_CLOCK);
+OledScreen screen(display);
+
+#define LAYOUT_MESSAGE 1
 
 // ===== WIFI & BACKEND =====
 const char* ssid = "Wokwi-GUEST";
 const char* password = "";
 const char* backendURL = "http://10.172.129.95:3000/api";
+const uint32_t WIFI_BOOT_WAIT_MS = 10000;  // Then start offline; the link keeps trying
+WifiLink wifiLink;  // Cached fast connect, background reconnects ("wifi")
+HttpSession backend;  // Kept-alive socket shared by every backend call
+EventStream pushChannel;  // Ride changes at our blocks, pushed by the backend
+
+// ===== STATIONS =====
+// One board serves a whole stand: each station is a destination button
+// and the block it picks up from (stations may share a block). Sensors,
+// screen and LEDs are shared - one rider at a time stands, shows the
+// card and confirms, and the button pressed picks the station.
+struct Station {
+  const char* blockID;
+  const char* destination;
+  uint8_t buttonPin;
+};
 
-// ===== LOCATION INFO =====
-const char* blockID = "CUET_CAMPUS";
-const char* destination = "PAHARTOLI";  // User chooses this block
+Station stations[] = {
+  {"CUET_CAMPUS", "PAHARTOLI", BUTTON_PIN},
+  {"CUET_CAMPUS", "NOAPARA", BUTTON2_PIN}
+};
+const uint8_t STATION_COUNT = sizeof(stations) / sizeof(stations[0]);
 
 // ===== STATE MACHINE =====
 enum SystemState {
@@ -45,7 +78,8 @@ enum SystemState {
   STATE_WAITING_ACCEPTANCE,
   STATE_RIDE_ACCEPTED,
   STATE_RIDE_ACTIVE,
-  STATE_TIMEOUT_ERROR
+  STATE_TIMEOUT_ERROR,
+  STATE_RESETTING      // Result on screen, reset already scheduled
 };
 
 SystemState currentState = STATE_IDLE;
@@ -54,51 +88,101 @@ SystemState currentState = STATE_IDLE;
 unsigned long ultrasonicStartTime = 0;
 unsigned long requestSentTime = 0;
 unsigned long lastButtonTime = 0;
-unsigned long lastStatusCheck = 0;
-unsigned long lastLEDBlink = 0;
 const int DEBOUNCE_DELAY = 200;
 const int ULTRASONIC_THRESHOLD = 3000; // 3 seconds
+const int DISTANCE_SCALE = 4;          // Scale to ~16m range (HC-SR04 is 4m)
+const int PRESENCE_ENTER_CM = 1000;    // TEST CASE 1: within 10m (scaled)
+const int PRESENCE_EXIT_CM = 1100;     // Hysteresis before "user left" (scaled)
 const int REQUEST_TIMEOUT = 60000;     // 60 seconds
 
+// Periodic jobs, timeouts and show-message-then-reset continuations
+TimerWheel scheduler;
+
+// Timer callbacks defined further down
+void showWaitTime();
+void onRequestTimeout();
+
 // ===== FLAGS =====
 bool ultrasonicTriggered = false;
 bool privilegeVerified = false;
 bool requestSent = false;
-String currentRideID = "";
+long currentRideID = 0;  // 0 = no ride requested
 
-// ===== HELPER FUNCTIONS =====
+// ===== RIDES =====
+// The ride on screen (currentRideID) plus rides already picked up: once
+// the rider has boarded the kiosk is free for the next one, and follows
+// the earlier rides until they end. All of them go in one batched
+// /ride/status poll.
+const uint8_t MAX_RIDES = 6;
+const uint32_t PICKUP_HOLD_MS = 5000;  // "Rickshaw Here!" stays up this long
+
+struct TrackedRide {
+  long rideID;  // 0: free
+  uint8_t station;
+  char status[AERAS_STATUS_LENGTH];
+  bool listed;  // In the last batch reply
+};
 
-void displayMessage(String line1, String line2, String line3 = "") {
-  display.clearDisplay();
-  display.setTextSize(1);
-  display.setTextColor(SSD1306_WHITE);
-  display.setCursor(0, 10);
-  display.println("AERAS SYSTEM");
-  display.println("================");
-  display.setCursor(0, 28);
-  display.println(line1);
-  display.setCursor(0, 40);
-  display.println(line2);
-  if (line3 != "") {
-    display.setCursor(0, 52);
-    display.println(line3);
+TrackedRide rides[MAX_RIDES];
+TextBuffer<48> rideStatusTag;  // ETag of the last batch polled; unchanged polls get a 304
+
+TrackedRide* findRide(long rideID) {
+  for (TrackedRide& ride : rides) {
+    if (rideID != 0 && ride.rideID == rideID) return &ride;
   }
-  display.display();
+  return nullptr;
 }
 
-void beep(int times, int duration = 100) {
-  for (int i = 0; i < times; i++) {
-    digitalWrite(BUZZER_PIN, HIGH);
-    delay(duration);
-    digitalWrite(BUZZER_PIN, LOW);
-    if (i < times - 1) delay(100);
+bool trackRide(long rideID, uint8_t station) {
+  for (TrackedRide& ride : rides) {
+    if (ride.rideID != 0) continue;
+    ride.rideID = rideID;
+    ride.station = station;
+    copyText(ride.status, "PENDING");
+    ride.listed = true;
+    return true;
   }
+  return false;
+}
+
+bool rideSlotFree() {
+  for (TrackedRide& ride : rides) {
+    if (ride.rideID == 0) return true;
+  }
+  return false;
+}
+
+// Still worth following: not yet completed, timed out or cancelled
+bool rideUnderway(const char* status) {
+  return strcmp(status, "PENDING") == 0 || strcmp(status, "ACCEPTED") == 0 ||
+         strcmp(status, "PICKUP") == 0;
+}
+
+// ===== HELPER FUNCTIONS =====
+
+void drawMessageChrome(Adafruit_SSD1306& panel) {
+  panel.setCursor(0, 10);
+  panel.println("AERAS SYSTEM");
+  panel.println("================");
+}
+
+// Header stays on the panel; only lines that changed are redrawn and sent
+void displayMessage(const char* line1, const char* line2, const char* line3 = "") {
+  screen.useLayout(LAYOUT_MESSAGE, drawMessageChrome);
+  screen.setField(0, 0, 28, line1);
+  screen.setField(1, 0, 40, line2);
+  screen.setField(2, 0, 52, line3);
+  screen.flush();
 }
 
+// Base state of the status LEDs; feedback patterns flash over it
 void setLEDs(bool yellow, bool red, bool green) {
-  digitalWrite(LED_YELLOW, yellow ? HIGH : LOW);
-  digitalWrite(LED_RED, red ? HIGH : LOW);
-  digitalWrite(LED_GREEN, green ? HIGH : LOW);
+  setFeedbackLeds((yellow ? FEEDBACK_LED_YELLOW : 0) | (red ? FEEDBACK_LED_RED : 0) |
+                  (green ? FEEDBACK_LED_GREEN : 0));
+}
+
+void showReadyMessage() {
+  displayMessage("System Ready", "Stand on block", "for 3+ seconds");
 }
 
 void resetSystem() {
@@ -109,81 +193,72 @@ void resetSystem() {
   requestSent = false;
   ultrasonicStartTime = 0;
   requestSentTime = 0;
-  currentRideID = "";
   
+  // A ride picked up is followed on in the background; any other is dropped
+  TrackedRide* ride = findRide(currentRideID);
+  if (ride && strcmp(ride->status, "PICKUP") != 0) ride->rideID = 0;
+  currentRideID = 0;
+  resetPresence();  // Someone still on the block starts a fresh dwell
+  
+  // Jobs that belong to the ride on screen
+  scheduler.cancel("wait-display");
+  scheduler.cancel("request-timeout");
+  scheduler.cancel("ready-message");
+  scheduler.cancel("reset");
+  
+  stopFeedback();
   setLEDs(false, false, false);
-  displayMessage("System Ready", "Stand on block", "for 3+ seconds");
-  delay(1000);
+  showReadyMessage();
+}
+
+void scheduleReset(uint32_t ms) {
+  currentState = STATE_RESETTING;
+  scheduler.after("reset", ms, resetSystem);
 }
 
 // ===== BACKEND COMMUNICATION =====
-bool sendRideRequest() {
+bool sendRideRequest(const Station& station) {
   if (WiFi.status() != WL_CONNECTED) {
     Serial.println("✗ WiFi not connected");
     return false;
   }
   
-  HTTPClient http;
-  String url = String(backendURL) + "/ride/request";
+  TextBuffer<16> userID;
+  userID.appendf("USER_%ld", random(1000, 9999));
   
-  http.begin(url);
-  http.addHeader("Content-Type", "application/json");
-  http.setTimeout(5000);
+  JsonBuffer<128> payload;
+  payload.beginObject()
+         .field("blockID", station.blockID)
+         .field("destination", station.destination)
+         .field("userID", userID.c_str())
+         .endObject();
   
-  String payload = "{";
-  payload += "\"blockID\":\"" + String(blockID) + "\",";
-  payload += "\"destination\":\"" + String(destination) + "\",";
-  payload += "\"userID\":\"USER_" + String(random(1000, 9999)) + "\"";
-  payload += "}";
+  logLine("Sending: %s", payload.c_str());
   
-  Serial.println("Sending: " + payload);
-  
-  int httpCode = http.POST(payload);
+  int httpCode = backend.post("/ride/request", payload.c_str());
   bool success = false;
   
-  if (httpCode == 200) {
-    String response = http.getString();
-    Serial.println("Response: " + response);
-    
-    // Extract ride ID
-    int rideIDStart = response.indexOf("\"rideID\":") + 9;
-    if (rideIDStart > 8) {
-      int rideIDEnd = response.indexOf(",", rideIDStart);
-      if (rideIDEnd == -1) rideIDEnd = response.indexOf("}", rideIDStart);
-      currentRideID = response.substring(rideIDStart, rideIDEnd);
-      Serial.println("Ride ID: " + currentRideID);
+  RideRequestReply reply;
+  if (httpCode == 200 && parseRideRequestReply(backend.body(), reply)) {
+    if (reply.rideID > 0) {
+      currentRideID = reply.rideID;
+      logLine("Ride ID: %ld", currentRideID);
       success = true;
     }
   } else {
-    Serial.println("HTTP Error: " + String(httpCode));
+    logLine("HTTP Error: %d", httpCode);
   }
   
-  http.end();
   return success;
 }
 
 // ===== TEST CASE 1: ULTRASONIC DETECTION =====
+// Echoes are timed by interrupt and median-filtered (UltrasonicPresence.h);
+// this only reacts to presence changes and runs the 3 s dwell
 void checkUltrasonicSensor() {
-  // Trigger pulse
-  digitalWrite(TRIG_PIN, LOW);
-  delayMicroseconds(2);
-  digitalWrite(TRIG_PIN, HIGH);
-  delayMicroseconds(10);
-  digitalWrite(TRIG_PIN, LOW);
-  
-  // Measure echo
-  long duration = pulseIn(ECHO_PIN, HIGH, 30000); // 30ms timeout
-  if (duration == 0) {
-    // No echo received - out of range
-    if (ultrasonicStartTime > 0) {
-      Serial.println("Person moved away - resetting timer");
-      ultrasonicStartTime = 0;
-    }
-    return;
-  }
-  
-  long distanceCm = duration * 0.034 / 2;
-  long scaledDistance = distanceCm * 4; // Scale to ~16m range (HC-SR04 is 4m)
+  uint16_t distanceCm;
+  PresenceEvent event = pollPresence(distanceCm);
+  long scaledDistance = distanceCm == RANGE_NONE ? -1 : (long)distanceCm * DISTANCE_SCALE;
   
   // Debug output every 2 seconds
   static unsigned long lastDebug = 0;
@@ -194,193 +269,399 @@ void checkUltrasonicSensor() {
     lastDebug = millis();
   }
   
-  // TEST CASE 1: Check if within 10m (1000cm)
-  if (scaledDistance > 0 && scaledDistance <= 1000) {
-    if (ultrasonicStartTime == 0) {
-      ultrasonicStartTime = millis();
-      currentState = STATE_DETECTING;
-      Serial.println("✓ Person detected - waiting 3 seconds...");
-      displayMessage("User Detected!", "Stay for 3 sec", "Distance: " + String(scaledDistance) + "cm");
-    }
-    
-    // Check if 3 seconds elapsed
-    unsigned long elapsed = millis() - ultrasonicStartTime;
-    if (elapsed >= ULTRASONIC_THRESHOLD && !ultrasonicTriggered) {
-      ultrasonicTriggered = true;
-      currentState = STATE_PRIVILEGE_CHECK;
-      displayMessage("Time Complete!", "Show laser card", "to LDR sensor");
-      beep(1, 150);
-      Serial.println("✓ Ultrasonic trigger SUCCESS!");
-      Serial.println("   Distance: " + String(scaledDistance) + " cm");
-      Serial.println("   Time: " + String(elapsed) + " ms");
-    }
-  } else {
+  if (event == PRESENCE_ARRIVED) {
+    ultrasonicStartTime = millis();
+    currentState = STATE_DETECTING;
+    Serial.println("✓ Person detected - waiting 3 seconds...");
+    scheduler.cancel("ready-message");
+    TextBuffer<24> line;
+    line.appendf("Distance: %ldcm", scaledDistance);
+    displayMessage("User Detected!", "Stay for 3 sec", line.c_str());
+  } else if (event == PRESENCE_LEFT) {
     // Person moved out of range
     if (ultrasonicStartTime > 0 && !ultrasonicTriggered) {
       Serial.println("⚠ Person moved away - resetting");
       ultrasonicStartTime = 0;
       currentState = STATE_IDLE;
       displayMessage("User Left", "Stand again", "for 3+ seconds");
-      delay(1000);
-      displayMessage("System Ready", "Stand on block", "for 3+ seconds");
+      scheduler.after("ready-message", 1000, showReadyMessage);
     }
+    return;
+  }
+  
+  // Check if 3 seconds elapsed
+  if (ultrasonicStartTime == 0) return;
+  unsigned long elapsed = millis() - ultrasonicStartTime;
+  if (elapsed >= ULTRASONIC_THRESHOLD && !ultrasonicTriggered) {
+    ultrasonicTriggered = true;
+    currentState = STATE_PRIVILEGE_CHECK;
+    resetLaser();  // Only a card shown from now on counts
+    displayMessage("Time Complete!", "Show laser card", "to LDR sensor");
+    playFeedback(FEEDBACK_DWELL_DONE);
+    Serial.println("✓ Ultrasonic trigger SUCCESS!");
+    logLine("   Distance: %ld cm", scaledDistance);
+    logLine("   Time: %lu ms", elapsed);
   }
 }
 
 // ===== TEST CASE 2: LDR + LASER VERIFICATION =====
+// The LDR is sampled and judged in the background against the ambient
+// light (LaserSensor.h); this only takes the "card seen" event
 void checkPrivilegeVerification() {
-  int ldrValue = analogRead(LDR_PIN);
+  LaserReading reading;
+  bool cardSeen = pollLaser(reading);
   
   // Debug every 500ms
   static unsigned long lastLDRDebug = 0;
   if (millis() - lastLDRDebug > 500) {
-    Serial.print("LDR Value: ");
-    Serial.println(ldrValue);
+    logLine("LDR Value: %d (ambient %d, threshold %d)", reading.level, reading.baseline,
+            reading.threshold);
     lastLDRDebug = millis();
   }
   
-  // TEST CASE 2: Detect laser (threshold adjusted for environment)
-  // Wokwi simulation: ~4000-4095 with laser
-  // Real hardware: May need calibration (2500-3500)
-  if (ldrValue > 3000) {
-    if (!privilegeVerified) {
-      privilegeVerified = true;
-      currentState = STATE_WAITING_CONFIRM;
-      displayMessage("Verified!", "Press button", "to confirm ride");
-      beep(2, 100);
-      Serial.println("✓ Privilege verified!");
-      Serial.println("   LDR Value: " + String(ldrValue));
-    }
+  // TEST CASE 2: Detect laser
+  if (cardSeen && !privilegeVerified) {
+    privilegeVerified = true;
+    currentState = STATE_WAITING_CONFIRM;
+    displayMessage("Verified!", "Press button", "to confirm ride");
+    playFeedback(FEEDBACK_VERIFIED);
+    Serial.println("✓ Privilege verified!");
+    logLine("   LDR Value: %d over threshold %d", reading.level, reading.threshold);
   }
 }
 
 // ===== TEST CASE 3: BUTTON CONFIRMATION =====
-void checkButtonPress() {
-  int buttonState = digitalRead(BUTTON_PIN);
+void confirmRide(uint8_t station) {
+  if (!rideSlotFree()) {
+    displayMessage("Kiosk Busy!", "Too many rides", "Try again soon");
+    playFeedback(FEEDBACK_ERROR);
+    Serial.println("✗ No ride slot free");
+    scheduleReset(2000);
+    return;
+  }
   
-  if (buttonState == HIGH) {
+  // Send ride request
+  if (sendRideRequest(stations[station])) {
+    trackRide(currentRideID, station);
+    requestSent = true;
+    requestSentTime = millis();
+    currentState = STATE_WAITING_ACCEPTANCE;
+    setLEDs(false, false, false); // ALL OFF while waiting
+    displayMessage("Request Sent!", "Waiting for", "rickshaw...");
+    playFeedback(FEEDBACK_REQUEST_SENT);
+    scheduler.every("wait-display", 1000, showWaitTime);
+    scheduler.after("request-timeout", REQUEST_TIMEOUT, onRequestTimeout);
+    Serial.println("✓ Request sent to backend");
+    Serial.println("⏳ Waiting for rickshaw acceptance (60s timeout)...");
+  } else {
+    displayMessage("Error!", "Check WiFi", "Try again");
+    playFeedback(FEEDBACK_ERROR);
+    Serial.println("✗ Request failed");
+    scheduleReset(2000);
+  }
+}
+
+// The first station whose button is down gets the ride
+void checkButtonPress() {
+  for (uint8_t i = 0; i < STATION_COUNT; i++) {
+    int buttonState = digitalRead(stations[i].buttonPin);
+    if (buttonState != HIGH) continue;
+    
     // Debounce check
     if (millis() - lastButtonTime > DEBOUNCE_DELAY) {
       lastButtonTime = millis();
-      
-      Serial.println("🔘 Button pressed - Sending request...");
-      
-      // Send ride request
-      if (sendRideRequest()) {
-        requestSent = true;
-        requestSentTime = millis();
-        currentState = STATE_WAITING_ACCEPTANCE;
-        setLEDs(false, false, false); // ALL OFF while waiting
-        displayMessage("Request Sent!", "Waiting for", "rickshaw...");
-        beep(3, 80);
-        Serial.println("✓ Request sent to backend");
-        Serial.println("⏳ Waiting for rickshaw acceptance (60s timeout)...");
-      } else {
-        displayMessage("Error!", "Check WiFi", "Try again");
-        beep(1, 500);
-        Serial.println("✗ Request failed");
-        delay(2000);
-        resetSystem();
-      }
+      logLine("🔘 Button pressed (%s) - Sending request...", stations[i].destination);
+      confirmRide(i);
     }
+    return;
   }
 }
 
 // ===== TEST CASE 4 & 5: LED STATUS + RIDE MONITORING =====
+// Status of the ride on screen
+void showRideStatus(const char* status) {
+  if (currentState != STATE_WAITING_ACCEPTANCE && currentState != STATE_RIDE_ACCEPTED &&
+      currentState != STATE_RIDE_ACTIVE) {
+    return;
+  }
+  
+  if (strcmp(status, "ACCEPTED") == 0) {
+    // TEST CASE 4b: Yellow LED - Rickshaw accepted (ONLY NOW, not before!)
+    if (currentState == STATE_WAITING_ACCEPTANCE) {
+      currentState = STATE_RIDE_ACCEPTED;
+      scheduler.cancel("wait-display");
+      scheduler.cancel("request-timeout");
+      setLEDs(true, false, false); // Yellow ON - rickshaw is coming!
+      displayMessage("Ride Accepted!", "Rickshaw coming", "Please wait...");
+      playFeedback(FEEDBACK_ACCEPTED);
+      Serial.println("✓ Status: ACCEPTED - Yellow LED ON (rickshaw coming)");
+    }
+  }
+  else if (strcmp(status, "PICKUP") == 0) {
+    // TEST CASE 4d: Green LED - Rickshaw arrived at your location
+    if (currentState != STATE_RIDE_ACTIVE) {
+      currentState = STATE_RIDE_ACTIVE;
+      scheduler.cancel("wait-display");
+      scheduler.cancel("request-timeout");
+      setLEDs(false, false, true); // Green ON - rickshaw is here!
+      displayMessage("Rickshaw Here!", "Have a safe", "journey!");
+      playFeedback(FEEDBACK_PICKUP);
+      Serial.println("✓ Status: PICKUP - Green LED ON (rickshaw arrived)");
+      // Rider on board: free the kiosk, follow the ride in the background
+      scheduleReset(PICKUP_HOLD_MS);
+    }
+  }
+  else if (strcmp(status, "COMPLETED") == 0) {
+    // Ride completed - show message and reset
+    displayMessage("Ride Complete", "Thank you!", "Resetting...");
+    playFeedback(FEEDBACK_COMPLETED);
+    Serial.println("✓ Ride completed - Resetting system...");
+    scheduleReset(3000);
+  }
+}
+
+// Status of any of our rides, pushed or polled; rides of other kiosks at
+// the same blocks are ignored
+void applyRideStatus(const RideStatusReply& reply) {
+  TrackedRide* ride = findRide(reply.rideID);
+  if (!ride) return;
+  
+  ride->listed = true;
+  bool changed = strcmp(ride->status, reply.status) != 0;
+  copyText(ride->status, reply.status);
+  
+  if (ride->rideID == currentRideID) {
+    showRideStatus(reply.status);
+    return;
+  }
+  if (!changed) return;
+  
+  logLine("🛺 Ride %ld to %s: %s", ride->rideID, stations[ride->station].destination, ride->status);
+  if (!rideUnderway(ride->status)) ride->rideID = 0;
+}
+
+bool onRideStatus(const RideStatusReply& reply, void*) {
+  applyRideStatus(reply);
+  return true;
+}
+
+// Runs every 2 s ("ride-status") while rides are followed, but only asks
+// the backend while the push channel is down. One request for all of
+// them, with the last ETag, so while nothing changes the answer is a
+// bodiless 304.
 void checkRideStatus() {
-  if (WiFi.status() != WL_CONNECTED) return;
+  if (WiFi.status() != WL_CONNECTED || pushChannel.isOpen()) return;
+  
+  TextBuffer<128> path;
+  path.append("/ride/status?rideIDs=");
+  uint8_t count = 0;
+  for (TrackedRide& ride : rides) {
+    if (ride.rideID == 0) continue;
+    if (count++ > 0) path.append(',');
+    path.append(ride.rideID);
+    ride.listed = false;
+  }
+  if (count == 0) return;
   
-  // Check every 2 seconds
-  if (millis() - lastStatusCheck < 2000) return;
-  lastStatusCheck = millis();
+  backend.setTimeout(3000);
+  backend.setIfNoneMatch(rideStatusTag.c_str());
+  int httpCode = backend.get(path.c_str());
+  backend.setTimeout(5000);
+  if (httpCode == 304) return;  // Unchanged since the last poll
   
-  HTTPClient http;
-  String url = String(backendURL) + "/ride/status?blockID=" + String(blockID);
+  // Compact wire reply when the backend speaks it, JSON otherwise
+  bool parsed = false;
+  if (httpCode == 200 && backend.responseIs(AERAS_WIRE_CONTENT_TYPE)) {
+    uint8_t body[96 * MAX_RIDES];
+    parsed = decodeRideStatuses(body, backend.readBody(body, sizeof(body)), onRideStatus, nullptr);
+  } else if (httpCode == 200) {
+    parsed = parseRideStatuses(backend.body(), onRideStatus, nullptr);
+  }
+  if (!parsed) return;
   
-  http.begin(url);
-  http.setTimeout(3000);
-  int httpCode = http.GET();
+  rideStatusTag.clear();
+  rideStatusTag.append(backend.etag());
   
-  if (httpCode == 200) {
-    String response = http.getString();
-    
-    // Parse status
-    if (response.indexOf("\"ACCEPTED\"") > 0) {
-      // TEST CASE 4b: Yellow LED - Rickshaw accepted (ONLY NOW, not before!)
-      if (currentState == STATE_WAITING_ACCEPTANCE) {
-        currentState = STATE_RIDE_ACCEPTED;
-        setLEDs(true, false, false); // Yellow ON - rickshaw is coming!
-        displayMessage("Ride Accepted!", "Rickshaw coming", "Please wait...");
-        beep(2, 100);
-        Serial.println("✓ Status: ACCEPTED - Yellow LED ON (rickshaw coming)");
-      }
-    }
-    else if (response.indexOf("\"PICKUP\"") > 0) {
-      // TEST CASE 4d: Green LED - Rickshaw arrived at your location
-      if (currentState != STATE_RIDE_ACTIVE) {
-        currentState = STATE_RIDE_ACTIVE;
-        setLEDs(false, false, true); // Green ON - rickshaw is here!
-        displayMessage("Rickshaw Here!", "Have a safe", "journey!");
-        beep(3, 100);
-        Serial.println("✓ Status: PICKUP - Green LED ON (rickshaw arrived)");
-      }
-    }
-    else if (response.indexOf("\"COMPLETED\"") > 0) {
-      // Ride completed - show message and reset
-      displayMessage("Ride Complete", "Thank you!", "Resetting...");
-      beep(2, 150);
-      Serial.println("✓ Ride completed - Resetting system...");
-      delay(3000);
-      resetSystem();
+  // Left out of the reply: the backend no longer knows the ride
+  for (TrackedRide& ride : rides) {
+    if (ride.rideID != 0 && !ride.listed && ride.rideID != currentRideID) {
+      logLine("✗ Ride %ld unknown to the backend - dropped", ride.rideID);
+      ride.rideID = 0;
     }
   }
+}
+
+// ===== PUSH CHANNEL =====
+// Every 10 s ("push-connect") while the stream is down. Subscribes to
+// every station's block (the backend drops repeats) and names the rides
+// followed, so changes missed while the stream was down come straight away.
+void connectPushChannel() {
+  if (WiFi.status() != WL_CONNECTED || pushChannel.isOpen()) return;
   
-  http.end();
+  TextBuffer<192> path;
+  path.append("/events?blockIDs=");
+  for (uint8_t i = 0; i < STATION_COUNT; i++) {
+    if (i > 0) path.append(',');
+    path.appendUrlEncoded(stations[i].blockID);
+  }
+  path.append("&rideIDs=");
+  uint8_t count = 0;
+  for (TrackedRide& ride : rides) {
+    if (ride.rideID == 0) continue;
+    if (count++ > 0) path.append(',');
+    path.append(ride.rideID);
+  }
+  if (pushChannel.open(path.c_str())) {
+    Serial.println("📡 Push channel open - ride status polling paused");
+  }
+}
+
+// Every 50 ms ("push")
+void checkPushChannel() {
+  char name[16];
+  while (pushChannel.nextEvent(name, sizeof(name))) {
+    RideStatusReply reply;
+    if (strcmp(name, "ride") == 0 && parseRideStatus(pushChannel.data(), reply)) {
+      applyRideStatus(reply);
+    }
+    pushChannel.endEvent();
+  }
 }
 
 // ===== TIMEOUT CHECKER =====
-void checkTimeout() {
-  if (currentState == STATE_WAITING_ACCEPTANCE) {
-    unsigned long waitTime = millis() - requestSentTime;
-    
-    // Show waiting time on display
-    if (millis() - lastLEDBlink > 1000) {
-      lastLEDBlink = millis();
-      int secondsWaiting = waitTime / 1000;
-      displayMessage("Waiting...", "Time: " + String(secondsWaiting) + "s", "Max: 60s");
+// Show waiting time on display (every second while waiting)
+void showWaitTime() {
+  if (currentState != STATE_WAITING_ACCEPTANCE) return;
+  
+  int secondsWaiting = (millis() - requestSentTime) / 1000;
+  TextBuffer<24> line;
+  line.appendf("Time: %ds", secondsWaiting);
+  displayMessage("Waiting...", line.c_str(), "Max: 60s");
+}
+
+// One-shot, REQUEST_TIMEOUT after the request went out
+void onRequestTimeout() {
+  if (currentState != STATE_WAITING_ACCEPTANCE) return;
+  
+  currentState = STATE_TIMEOUT_ERROR;
+  scheduler.cancel("wait-display");
+  setLEDs(false, true, false); // Red ON
+  displayMessage("TIMEOUT!", "No rickshaw", "available");
+  playFeedback(FEEDBACK_TIMEOUT);
+  Serial.println("✗ TIMEOUT after 60 seconds");
+  scheduler.after("reset", 5000, resetSystem);
+}
+
+// ===== WIFI =====
+// Every 200 ms ("wifi")
+void runWifiLink() {
+  wifiLink.run();
+}
+
+// ===== TELEMETRY =====
+const uint32_t TELEMETRY_SAMPLE_MS = 1000;
+const uint32_t TELEMETRY_UPLOAD_MS = 300000;
+
+MsgPackBuffer<1536> telemetryReport;
+
+void sampleTelemetry() {
+  telemetry.sample();
+}
+
+// Every 5 min ("telemetry-upload"); a failed upload keeps the window growing.
+// Reported under the first station's block.
+void uploadTelemetry() {
+  if (WiFi.status() != WL_CONNECTED) return;
+  if (!telemetry.encode(telemetryReport, WIRE_BLOCK, stations[0].blockID)) {
+    Serial.println("✗ Telemetry report does not fit");
+    return;
+  }
+  int httpCode = backend.request("POST", "/kiosk/telemetry", telemetryReport.data(),
+                                 telemetryReport.length(), AERAS_WIRE_CONTENT_TYPE);
+  if (httpCode == 200) telemetry.clearWindow();
+  else logLine("✗ Telemetry upload failed: %d", httpCode);
+}
+
+// ===== SERIAL COMMANDS =====
+// Every 50 ms ("serial")
+void pollSerial() {
+  if (!Serial.available()) return;
+  
+  char line[16];
+  size_t length = Serial.readBytesUntil('\n', line, sizeof(line) - 1);
+  line[length] = '\0';
+  while (length > 0 && isspace((unsigned char)line[length - 1])) line[--length] = '\0';
+  for (char* c = line; *c; c++) *c = toupper((unsigned char)*c);
+  
+  if (strcmp(line, "STATUS") == 0) {
+    Serial.println("\n===== KIOSK STATUS =====");
+    for (uint8_t i = 0; i < STATION_COUNT; i++) {
+      logLine("Station %d: %s -> %s", i, stations[i].blockID, stations[i].destination);
     }
-    
-    // Check for timeout
-    if (waitTime > REQUEST_TIMEOUT) {
-      currentState = STATE_TIMEOUT_ERROR;
-      setLEDs(false, true, false); // Red ON
-      displayMessage("TIMEOUT!", "No rickshaw", "available");
-      beep(1, 500);
-      Serial.println("✗ TIMEOUT after 60 seconds");
-      delay(5000);
-      resetSystem();
+    logLine("State: %d, ride %ld", currentState, currentRideID);
+    for (TrackedRide& ride : rides) {
+      if (ride.rideID != 0) logLine("Ride %ld (station %d): %s", ride.rideID, ride.station, ride.status);
     }
+    logLine("Push channel: %s", pushChannel.isOpen() ? "open" : "down");
+    LaserReading laser;
+    readLaser(laser);
+    logLine("LDR: %d, ambient %d, threshold %d (%s)", laser.level, laser.baseline, laser.threshold,
+            laser.dma ? "DMA" : "analogRead");
+    Serial.println("----- performance -----");
+    telemetry.printTo(Serial);
+    Serial.println("========================\n");
+  } else {
+    Serial.println("Commands: STATUS");
+  }
+}
+
+// ===== STATE MACHINE =====
+// Input polling every 50 ms ("sensors"); backend polls, timeouts and
+// resets are their own timers
+void runStateMachine() {
+  switch (currentState) {
+    case STATE_IDLE:
+    case STATE_DETECTING:
+      checkUltrasonicSensor();
+      break;
+    
+    case STATE_PRIVILEGE_CHECK:
+      checkPrivilegeVerification();
+      break;
+    
+    case STATE_WAITING_CONFIRM:
+      checkButtonPress();
+      break;
+    
+    case STATE_WAITING_ACCEPTANCE:
+    case STATE_RIDE_ACCEPTED:
+    case STATE_RIDE_ACTIVE:
+      // "ride-status" / "request-timeout" timers
+      break;
+    
+    case STATE_REQUEST_SENT:
+    case STATE_TIMEOUT_ERROR:
+    case STATE_RESETTING:
+      // Waiting for the scheduled reset
+      break;
   }
 }
 
 // ===== SETUP =====
 void setup() {
   Serial.begin(115200);
-  delay(1000);
   Serial.println("\n\n=== AERAS USER SIDE SYSTEM ===");
   
+  // Associates while the sensors and display come up
+  wifiLink.begin(ssid, password);
+  
   // Pin modes
-  pinMode(TRIG_PIN, OUTPUT);
-  pinMode(ECHO_PIN, INPUT);
-  pinMode(LDR_PIN, INPUT);
-  pinMode(BUTTON_PIN, INPUT);
-  pinMode(LED_YELLOW, OUTPUT);
-  pinMode(LED_RED, OUTPUT);
-  pinMode(LED_GREEN, OUTPUT);
-  pinMode(BUZZER_PIN, OUTPUT);
-  
-  // Initialize LEDs OFF
-  setLEDs(false, false, false);
+  startRanging(TRIG_PIN, ECHO_PIN, PRESENCE_ENTER_CM / DISTANCE_SCALE, PRESENCE_EXIT_CM / DISTANCE_SCALE);
+  startLaserSensor(LDR_PIN);  // Sampled by DMA from here on
+  for (const Station& station : stations) pinMode(station.buttonPin, INPUT_PULLDOWN);
+  
+  // Buzzer (LEDC) and status LEDs, all OFF; patterns play from a timer
+  startFeedback(BUZZER_PIN, LED_YELLOW, LED_RED, LED_GREEN);
   
   // Initialize OLED
   if (!display.begin(SSD1306_SWITCHCAPVCC, 0x3C)) {
@@ -393,37 +674,27 @@ void setup() {
     }
   }
   
-  display.clearDisplay();
-  display.setTextSize(1);
-  display.setTextColor(SSD1306_WHITE);
+  screen.begin();
   displayMessage("AERAS System", "Initializing...", "Please wait");
   
-  // Connect WiFi
-  WiFi.begin(ssid, password);
-  Serial.print("Connecting to WiFi");
-  int attempts = 0;
-  while (WiFi.status() != WL_CONNECTED && attempts < 40) {
-    delay(500);
-    Serial.print(".");
-    attempts++;
-  }
-  
-  if (WiFi.status() == WL_CONNECTED) {
-    Serial.println("\n✓ WiFi Connected");
-    Serial.println("IP: " + WiFi.localIP().toString());
+  if (wifiLink.waitConnected(WIFI_BOOT_WAIT_MS)) {
     displayMessage("WiFi Connected", "System Ready", "");
-    beep(2, 100);
+    playFeedback(FEEDBACK_ONLINE);
   } else {
-    Serial.println("\n✗ WiFi Failed - Offline Mode");
+    Serial.println("✗ WiFi not up yet - Offline Mode, reconnecting in background");
     displayMessage("WiFi Error", "Check network", "");
-    beep(1, 500);
+    playFeedback(FEEDBACK_ERROR);
   }
   
-  delay(2000);
+  backend.begin(backendURL);
+  backend.setAccept(AERAS_WIRE_CONTENT_TYPE);
+  backend.setObserver(&telemetry);
+  pushChannel.begin(backendURL);
   
   Serial.println("\n=== SYSTEM READY ===");
-  Serial.println("Block ID: " + String(blockID));
-  Serial.println("Destination: " + String(destination));
+  for (const Station& station : stations) {
+    logLine("Station: %s -> %s (button GPIO %d)", station.blockID, station.destination, station.buttonPin);
+  }
   Serial.println("\nTest Cases Active:");
   Serial.println("1. Ultrasonic: Stand within 10m for 3+ sec");
   Serial.println("2. LDR: Direct laser at sensor");
@@ -431,39 +702,23 @@ void setup() {
   Serial.println("4. LEDs: Watch status indicators");
   Serial.println("5. OLED: Check display updates\n");
   
-  resetSystem();
+  scheduler.every("wifi", 200, runWifiLink);
+  scheduler.every("sensors", 50, runStateMachine);
+  scheduler.every("ride-status", 2000, checkRideStatus);
+  scheduler.every("push-connect", 10000, connectPushChannel, true);
+  scheduler.every("push", 50, checkPushChannel);
+  scheduler.every("serial", 50, pollSerial);
+  scheduler.every("telemetry-sample", TELEMETRY_SAMPLE_MS, sampleTelemetry, true);
+  scheduler.every("telemetry-upload", TELEMETRY_UPLOAD_MS, uploadTelemetry);
+  scheduleReset(2000);  // Leave the WiFi message up for 2 s
 }
 
 // ===== MAIN LOOP =====
 void loop() {
-  switch (currentState) {
-    case STATE_IDLE:
-    case STATE_DETECTING:
-      checkUltrasonicSensor();
-      break;
-      
-    case STATE_PRIVILEGE_CHECK:
-      checkPrivilegeVerification();
-      break;
-      
-    case STATE_WAITING_CONFIRM:
-      checkButtonPress();
-      break;
-      
-    case STATE_WAITING_ACCEPTANCE:
-      checkRideStatus();
-      checkTimeout();
-      break;
-      
-    case STATE_RIDE_ACCEPTED:
-    case STATE_RIDE_ACTIVE:
-      checkRideStatus();
-      break;
-      
-    case STATE_TIMEOUT_ERROR:
-      // Handled in checkTimeout()
-      break;
-  }
+  telemetry.loopBegin(LOOP_MAIN);
+  scheduler.run();
   
-  delay(50); // Small delay to prevent CPU overload
-}
\ No newline at end of file
+  uint32_t sleepMs = scheduler.msUntilNext();
+  telemetry.loopEnd(LOOP_MAIN, sleepMs);
+  delay(sleepMs);  // Idle until the next timer is due
+}